@@ -1,4 +1,5 @@
 #include "a2s_query.h"
+#include "selfstats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,6 +22,18 @@ static const uint8_t a2s_info_request[] = {
     'Q', 'u', 'e', 'r', 'y', 0x00
 };
 
+size_t a2s_build_info_request(const uint8_t *challenge, uint8_t *buffer, size_t size) {
+    size_t len = sizeof(a2s_info_request) + (challenge ? 4 : 0);
+    if (size < len) {
+        return 0;
+    }
+    memcpy(buffer, a2s_info_request, sizeof(a2s_info_request));
+    if (challenge) {
+        memcpy(buffer + sizeof(a2s_info_request), challenge, 4);
+    }
+    return len;
+}
+
 int a2s_query_init(const char *host, uint16_t port) {
     if (sockfd >= 0) {
         return 0; // Already initialized
@@ -95,15 +108,17 @@ server_status_t a2s_parse_server_status(const char *server_name, const char *map
     char map_lower[MAX_MAP_NAME];
 
     // Convert to lowercase for case-insensitive matching
-    for (int i = 0; server_name[i] && i < MAX_SERVER_NAME - 1; i++) {
-        name_lower[i] = tolower(server_name[i]);
+    int n = 0;
+    for (; server_name[n] && n < MAX_SERVER_NAME - 1; n++) {
+        name_lower[n] = tolower(server_name[n]);
     }
-    name_lower[MAX_SERVER_NAME - 1] = '\0';
+    name_lower[n] = '\0';
 
-    for (int i = 0; map_name[i] && i < MAX_MAP_NAME - 1; i++) {
-        map_lower[i] = tolower(map_name[i]);
+    n = 0;
+    for (; map_name[n] && n < MAX_MAP_NAME - 1; n++) {
+        map_lower[n] = tolower(map_name[n]);
     }
-    map_lower[MAX_MAP_NAME - 1] = '\0';
+    map_lower[n] = '\0';
 
     if (strstr(name_lower, "lobby") || strstr(map_lower, "lobby")) {
         return SERVER_STATUS_LOBBY;
@@ -130,84 +145,16 @@ const char* a2s_status_string(server_status_t status) {
     }
 }
 
-int a2s_query_info(a2s_info_t *info) {
-    if (sockfd < 0) {
-        return -1;
-    }
-
-    // Send A2S_INFO request
-    ssize_t sent = sendto(sockfd, a2s_info_request, sizeof(a2s_info_request), 0,
-                         (struct sockaddr*)&server_addr, sizeof(server_addr));
-    if (sent < 0) {
-        return -1;
-    }
-
-    // Receive response
-    uint8_t buffer[4096];
-    struct sockaddr_in from_addr;
-    socklen_t from_len = sizeof(from_addr);
-
-    ssize_t received = recvfrom(sockfd, buffer, sizeof(buffer), 0,
-                                (struct sockaddr*)&from_addr, &from_len);
-    if (received < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // Timeout - server not responding
-            return -2;
-        }
-        return -1;
-    }
-
-    // Verify response header (0xFF 0xFF 0xFF 0xFF)
-    if (received < 5 || buffer[0] != 0xFF || buffer[1] != 0xFF ||
-        buffer[2] != 0xFF || buffer[3] != 0xFF) {
-        return -1;
-    }
-
-    uint8_t response_type = buffer[4];
-
-    // Handle challenge response (some servers require this)
-    if (response_type == A2S_CHALLENGE_RESPONSE) {
-        if (received < 9) {
-            return -1;
-        }
-
-        // Extract challenge number (bytes 5-8)
-        uint32_t challenge;
-        memcpy(&challenge, &buffer[5], 4);
-
-        // Resend request with challenge
-        uint8_t challenge_request[sizeof(a2s_info_request) + 4];
-        memcpy(challenge_request, a2s_info_request, sizeof(a2s_info_request));
-        memcpy(&challenge_request[sizeof(a2s_info_request)], &challenge, 4);
-
-        sent = sendto(sockfd, challenge_request, sizeof(challenge_request), 0,
-                     (struct sockaddr*)&server_addr, sizeof(server_addr));
-        if (sent < 0) {
-            return -1;
-        }
-
-        // Receive actual response
-        received = recvfrom(sockfd, buffer, sizeof(buffer), 0,
-                           (struct sockaddr*)&from_addr, &from_len);
-        if (received < 0) {
-            return -1;
-        }
-
-        response_type = buffer[4];
-    }
-
-    // Parse A2S_INFO response
-    if (response_type != A2S_INFO_RESPONSE) {
+int a2s_parse_info(const uint8_t *buffer, size_t len, a2s_info_t *info) {
+    // Validate minimum packet size
+    int received = (len > INT32_MAX) ? INT32_MAX : (int)len;
+    if (received < 10 || buffer[0] != 0xFF || buffer[1] != 0xFF ||
+        buffer[2] != 0xFF || buffer[3] != 0xFF || buffer[4] != A2S_INFO_RESPONSE) {
         return -1;
     }
 
     int offset = 5; // Skip header and response type
 
-    // Validate minimum packet size
-    if (received < 10) {
-        return -1;
-    }
-
     // Parse protocol version
     if (offset >= received) {
         return -1;
@@ -292,6 +239,98 @@ int a2s_query_info(a2s_info_t *info) {
     return 0;
 }
 
+// Receive a datagram from addr, discarding late replies from other targets
+static ssize_t recv_from_target(const struct sockaddr_in *addr, uint8_t *buffer, size_t size) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        struct sockaddr_in from_addr;
+        socklen_t from_len = sizeof(from_addr);
+
+        selfstats_count_syscalls(1);
+        ssize_t received = recvfrom(sockfd, buffer, size, 0,
+                                    (struct sockaddr*)&from_addr, &from_len);
+        if (received < 0) {
+            return received;
+        }
+        if (from_addr.sin_port == addr->sin_port &&
+            from_addr.sin_addr.s_addr == addr->sin_addr.s_addr) {
+            return received;
+        }
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+
+static int query_info(const struct sockaddr_in *addr, a2s_info_t *info) {
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    // Send A2S_INFO request
+    selfstats_count_syscalls(1);
+    ssize_t sent = sendto(sockfd, a2s_info_request, sizeof(a2s_info_request), 0,
+                         (const struct sockaddr*)addr, sizeof(*addr));
+    if (sent < 0) {
+        return -1;
+    }
+
+    // Receive response
+    uint8_t buffer[4096];
+    ssize_t received = recv_from_target(addr, buffer, sizeof(buffer));
+    if (received < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // Timeout - server not responding
+            return -2;
+        }
+        return -1;
+    }
+
+    // Verify response header (0xFF 0xFF 0xFF 0xFF)
+    if (received < 5 || buffer[0] != 0xFF || buffer[1] != 0xFF ||
+        buffer[2] != 0xFF || buffer[3] != 0xFF) {
+        return -1;
+    }
+
+    uint8_t response_type = buffer[4];
+
+    // Handle challenge response (some servers require this)
+    if (response_type == A2S_CHALLENGE_RESPONSE) {
+        if (received < 9) {
+            return -1;
+        }
+
+        // Resend request with the challenge number (bytes 5-8)
+        uint8_t challenge_request[sizeof(a2s_info_request) + 4];
+        size_t request_len = a2s_build_info_request(&buffer[5], challenge_request,
+                                                    sizeof(challenge_request));
+
+        selfstats_count_syscalls(1);
+        sent = sendto(sockfd, challenge_request, request_len, 0,
+                     (const struct sockaddr*)addr, sizeof(*addr));
+        if (sent < 0) {
+            return -1;
+        }
+
+        // Receive actual response
+        received = recv_from_target(addr, buffer, sizeof(buffer));
+        if (received < 5) {
+            return -1;
+        }
+    }
+
+    return a2s_parse_info(buffer, (size_t)received, info);
+}
+
+int a2s_query_info(a2s_info_t *info) {
+    return query_info(&server_addr, info);
+}
+
+int a2s_query_info_port(uint16_t port, a2s_info_t *info) {
+    struct sockaddr_in addr = server_addr;
+    addr.sin_port = htons(port);
+    return query_info(&addr, info);
+}
+
 void a2s_query_cleanup(void) {
     if (sockfd >= 0) {
         close(sockfd);
@@ -2,6 +2,7 @@
 #define A2S_QUERY_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <netinet/in.h>
 
 #define A2S_INFO_REQUEST 0x54
@@ -44,6 +45,16 @@ int a2s_query_init(const char *host, uint16_t port);
 // Query server info using A2S_INFO protocol
 int a2s_query_info(a2s_info_t *info);
 
+// Query another port on the configured host (e.g. a second local instance)
+int a2s_query_info_port(uint16_t port, a2s_info_t *info);
+
+// Write an A2S_INFO request into buffer, with the 4-byte challenge from a
+// 0x41 reply appended when given. Returns its length, 0 if size is too small.
+size_t a2s_build_info_request(const uint8_t *challenge, uint8_t *buffer, size_t size);
+
+// Decode an A2S_INFO response datagram (header included) into info
+int a2s_parse_info(const uint8_t *buffer, size_t len, a2s_info_t *info);
+
 // Determine server status from server name or map
 server_status_t a2s_parse_server_status(const char *server_name, const char *map_name);
 
@@ -0,0 +1,527 @@
+/*
+ * Alert rule engine
+ * Rules from the config file are compiled once into a flat plan grouped by
+ * collector, so a tick only walks the rules whose metric just refreshed.
+ * The per-tick state machine (threshold, rate, "for" duration and clear
+ * level for hysteresis) lives in a compact hot array; names and action
+ * targets are only touched when a rule changes state.
+ */
+
+#define _GNU_SOURCE
+#include "alerts.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define MAX_LINE 512
+#define MAX_ENV 256
+
+extern char **environ;
+
+typedef enum { OP_GT, OP_GE, OP_LT, OP_LE } alert_op_t;
+typedef enum { ACTION_NONE, ACTION_EXEC, ACTION_FIFO } alert_action_t;
+
+// Everything evaluated per tick
+typedef struct {
+    uint8_t metric;
+    uint8_t op;
+    uint8_t is_rate;
+    uint8_t has_clear;
+    uint8_t state;                 // alert_state_t
+    uint8_t has_prev;              // Rate rules: prev_value/prev_ms are set
+    double threshold;
+    double clear;
+    int64_t hold_ms;
+    int64_t since_ms;              // Condition first held (pending)
+    double prev_value;
+    int64_t prev_ms;
+} rule_t;
+
+// Only needed on transitions and lookups
+typedef struct {
+    char name[ALERTS_MAX_NAME];
+    uint8_t action;
+    char target[ALERTS_MAX_TARGET];
+} rule_info_t;
+
+static rule_t plan[ALERTS_MAX_RULES];
+static rule_info_t info[ALERTS_MAX_RULES];
+static int rule_count = 0;
+
+// The rule set being replaced by alerts_load(), for carrying state over
+static rule_t old_plan[ALERTS_MAX_RULES];
+static rule_info_t old_info[ALERTS_MAX_RULES];
+
+// plan[source_begin[s] .. source_begin[s + 1]) belong to metric source s
+static int source_begin[METRIC_SOURCE_COUNT + 1];
+
+static int actions_enabled = 1;
+
+// memory.max behind the built-in cgroup RAM rule, 0 while there is none
+static uint64_t memory_limit = 0;
+static int cgroup_rule_builtin = 0;
+
+static const char *op_names[] = { ">", ">=", "<", "<=" };
+
+void alerts_reset(void) {
+    rule_count = 0;
+    cgroup_rule_builtin = 0;
+    memset(source_begin, 0, sizeof(source_begin));
+}
+
+void alerts_set_actions(int enabled) {
+    actions_enabled = enabled;
+}
+
+static const char *skip_space(const char *p) {
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    return p;
+}
+
+// Copy the next whitespace-delimited word into out, returns the rest
+static const char *next_word(const char *p, char *out, size_t size) {
+    p = skip_space(p);
+    size_t len = 0;
+    while (*p && !isspace((unsigned char)*p)) {
+        if (len + 1 < size) {
+            out[len++] = *p;
+        }
+        p++;
+    }
+    out[len] = '\0';
+    return p;
+}
+
+static int parse_number(const char *word, double *out) {
+    char *end;
+    errno = 0;
+    double v = strtod(word, &end);
+    if (end == word || *end != '\0' || errno != 0 || isnan(v)) {
+        return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+// Same units as config_parse_interval(): a plain number is milliseconds
+static int parse_duration(const char *word, int64_t *out_ms) {
+    char *end;
+    errno = 0;
+    double v = strtod(word, &end);
+    if (end == word || errno != 0 || !isfinite(v) || v < 0) {
+        return -1;
+    }
+
+    double scale;
+    if (strcmp(end, "ms") == 0 || *end == '\0') {
+        scale = 1;
+    } else if (strcmp(end, "s") == 0) {
+        scale = 1000;
+    } else if (strcmp(end, "m") == 0) {
+        scale = 60 * 1000;
+    } else if (strcmp(end, "h") == 0) {
+        scale = 3600 * 1000;
+    } else {
+        return -1;
+    }
+    *out_ms = (int64_t)(v * scale);
+    return 0;
+}
+
+static int find_metric(const char *name) {
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        if (strcmp(metrics_desc((metric_id_t)id)->name, name) == 0) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+#define FAIL(...) do { snprintf(error, error_size, __VA_ARGS__); return -1; } while (0)
+
+int alerts_compile(const char *text, char *error, size_t error_size) {
+    rule_t rule = { 0 };
+    rule_info_t rinfo = { 0 };
+    char word[ALERTS_MAX_TARGET];
+
+    if (rule_count >= ALERTS_MAX_RULES) {
+        FAIL("too many rules (max %d)", ALERTS_MAX_RULES);
+    }
+
+    // <name>:
+    const char *p = skip_space(text);
+    const char *colon = strchr(p, ':');
+    size_t name_len = colon ? (size_t)(colon - p) : 0;
+    while (name_len && isspace((unsigned char)p[name_len - 1])) {
+        name_len--;
+    }
+    if (!colon || name_len == 0 || name_len >= ALERTS_MAX_NAME) {
+        FAIL("expected '<name>: <condition>'");
+    }
+    memcpy(rinfo.name, p, name_len);
+    if (alerts_find(rinfo.name) >= 0) {
+        FAIL("duplicate rule '%s'", rinfo.name);
+    }
+
+    // <metric> or rate(<metric>)
+    p = next_word(colon + 1, word, sizeof(word));
+    char *metric = word;
+    if (strncmp(word, "rate(", 5) == 0) {
+        size_t len = strlen(word);
+        if (word[len - 1] != ')') {
+            FAIL("unterminated rate(");
+        }
+        word[len - 1] = '\0';
+        metric = word + 5;
+        rule.is_rate = 1;
+    }
+    int id = find_metric(metric);
+    if (id < 0) {
+        FAIL("unknown metric '%s'", metric);
+    }
+    rule.metric = (uint8_t)id;
+
+    // <op> <value>
+    p = next_word(p, word, sizeof(word));
+    int op = -1;
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(word, op_names[i]) == 0) {
+            op = i;
+        }
+    }
+    if (op < 0) {
+        FAIL("expected one of > >= < <=, got '%s'", word);
+    }
+    rule.op = (uint8_t)op;
+
+    p = next_word(p, word, sizeof(word));
+    if (parse_number(word, &rule.threshold) < 0) {
+        FAIL("bad threshold '%s'", word);
+    }
+
+    // Optional clauses in any order; exec takes the rest of the line
+    for (;;) {
+        p = next_word(p, word, sizeof(word));
+        if (!word[0]) {
+            break;
+        }
+        if (strcmp(word, "for") == 0) {
+            p = next_word(p, word, sizeof(word));
+            if (parse_duration(word, &rule.hold_ms) < 0) {
+                FAIL("bad duration '%s'", word);
+            }
+        } else if (strcmp(word, "clear") == 0) {
+            p = next_word(p, word, sizeof(word));
+            if (parse_number(word, &rule.clear) < 0) {
+                FAIL("bad clear level '%s'", word);
+            }
+            int above = (rule.op == OP_GT || rule.op == OP_GE);
+            if (above ? rule.clear > rule.threshold : rule.clear < rule.threshold) {
+                FAIL("clear level must be on the safe side of the threshold");
+            }
+            rule.has_clear = 1;
+        } else if (strcmp(word, "exec") == 0 || strcmp(word, "fifo") == 0) {
+            rinfo.action = (word[0] == 'e') ? ACTION_EXEC : ACTION_FIFO;
+            p = skip_space(p);
+            size_t len = strlen(p);
+            while (len && isspace((unsigned char)p[len - 1])) {
+                len--;
+            }
+            if (len == 0 || len >= sizeof(rinfo.target)) {
+                FAIL("missing or overlong %s target", word);
+            }
+            memcpy(rinfo.target, p, len);
+            break;
+        } else {
+            FAIL("unexpected '%s'", word);
+        }
+    }
+
+    // Keep the plan grouped by source: insert at the end of this source's run
+    metric_source_t source = metrics_desc((metric_id_t)id)->source;
+    int at = source_begin[source + 1];
+    memmove(&plan[at + 1], &plan[at], (size_t)(rule_count - at) * sizeof(plan[0]));
+    memmove(&info[at + 1], &info[at], (size_t)(rule_count - at) * sizeof(info[0]));
+    plan[at] = rule;
+    info[at] = rinfo;
+    rule_count++;
+    for (int s = source + 1; s <= METRIC_SOURCE_COUNT; s++) {
+        source_begin[s]++;
+    }
+    return 0;
+}
+
+static void remove_rule(int index) {
+    metric_source_t source = metrics_desc((metric_id_t)plan[index].metric)->source;
+    memmove(&plan[index], &plan[index + 1], (size_t)(rule_count - index - 1) * sizeof(plan[0]));
+    memmove(&info[index], &info[index + 1], (size_t)(rule_count - index - 1) * sizeof(info[0]));
+    rule_count--;
+    for (int s = source + 1; s <= METRIC_SOURCE_COUNT; s++) {
+        source_begin[s]--;
+    }
+}
+
+// (Re)build the cgroup RAM rule for the current limit, clearing 5% below
+static void build_cgroup_rule(void) {
+    char rule[128];
+    char error[128];
+    double bytes = (double)memory_limit * 0.9;
+    snprintf(rule, sizeof(rule), "%s: cgroup_memory_bytes > %.0f clear %.0f",
+             ALERTS_CGROUP_RAM_DANGER, bytes, bytes * 0.95);
+    cgroup_rule_builtin = alerts_compile(rule, error, sizeof(error)) == 0;
+}
+
+void alerts_set_memory_limit(uint64_t bytes) {
+    if (bytes == memory_limit) {
+        return;
+    }
+    int existing = alerts_find(ALERTS_CGROUP_RAM_DANGER);
+    if (existing >= 0 && !cgroup_rule_builtin) {
+        memory_limit = bytes;
+        return; // The config's own rule stays as written
+    }
+    if (existing >= 0) {
+        remove_rule(existing);
+        cgroup_rule_builtin = 0;
+    }
+    memory_limit = bytes;
+    if (memory_limit > 0) {
+        build_cgroup_rule();
+    }
+}
+
+// Same metric, operator, levels and duration: the rule means what it did
+static int same_condition(const rule_t *a, const rule_t *b) {
+    return a->metric == b->metric && a->op == b->op && a->is_rate == b->is_rate &&
+           a->has_clear == b->has_clear && a->threshold == b->threshold &&
+           (!a->has_clear || a->clear == b->clear) && a->hold_ms == b->hold_ms;
+}
+
+// Rules that survive a reload unchanged keep their state, "for" timer and
+// rate history, so a firing rule neither fires again nor loses its resolve
+static void carry_state(int old_count) {
+    for (int i = 0; i < rule_count; i++) {
+        for (int j = 0; j < old_count; j++) {
+            if (strcmp(info[i].name, old_info[j].name) != 0) {
+                continue;
+            }
+            if (same_condition(&plan[i], &old_plan[j])) {
+                plan[i].state = old_plan[j].state;
+                plan[i].since_ms = old_plan[j].since_ms;
+                plan[i].has_prev = old_plan[j].has_prev;
+                plan[i].prev_value = old_plan[j].prev_value;
+                plan[i].prev_ms = old_plan[j].prev_ms;
+            }
+            break;
+        }
+    }
+}
+
+int alerts_load(const char *path) {
+    double ram_danger_gb = ALERTS_DEFAULT_RAM_DANGER_GB;
+    char error[128];
+
+    int old_count = rule_count;
+    memcpy(old_plan, plan, (size_t)old_count * sizeof(plan[0]));
+    memcpy(old_info, info, (size_t)old_count * sizeof(info[0]));
+    alerts_reset();
+
+    FILE *fp = path ? fopen(path, "r") : NULL;
+    if (fp) {
+        char line[MAX_LINE];
+        int line_no = 0;
+        while (fgets(line, sizeof(line), fp)) {
+            line_no++;
+            const char *p = skip_space(line);
+            if (strncmp(p, "ALERT=", 6) == 0) {
+                if (alerts_compile(p + 6, error, sizeof(error)) < 0) {
+                    fprintf(stderr, "%s:%d: %s\n", path, line_no, error);
+                }
+            } else if (strncmp(p, "RAM_DANGER_THRESHOLD=", 21) == 0) {
+                ram_danger_gb = atof(p + 21);
+            }
+        }
+        fclose(fp);
+    }
+
+    if (alerts_find(ALERTS_RAM_DANGER) < 0 && ram_danger_gb > 0) {
+        // Clear 5% below the threshold so the bar does not flicker at the edge
+        char rule[128];
+        double kb = ram_danger_gb * 1024 * 1024;
+        snprintf(rule, sizeof(rule), "%s: memory_used_kb > %.0f clear %.0f",
+                 ALERTS_RAM_DANGER, kb, kb * 0.95);
+        alerts_compile(rule, error, sizeof(error));
+    }
+
+    if (alerts_find(ALERTS_CGROUP_RAM_DANGER) < 0 && memory_limit > 0) {
+        build_cgroup_rule();
+    }
+
+    carry_state(old_count);
+    return rule_count;
+}
+
+static void run_exec(const rule_info_t *ri, const char *state, double value) {
+    static char *envp[MAX_ENV];
+    char name_var[ALERTS_MAX_NAME + 16];
+    char state_var[32];
+    char value_var[64];
+
+    snprintf(name_var, sizeof(name_var), "EMON_ALERT=%s", ri->name);
+    snprintf(state_var, sizeof(state_var), "EMON_ALERT_STATE=%s", state);
+    snprintf(value_var, sizeof(value_var), "EMON_ALERT_VALUE=%g", value);
+
+    int n = 0;
+    envp[n++] = name_var;
+    envp[n++] = state_var;
+    envp[n++] = value_var;
+    for (char **e = environ; *e && n < MAX_ENV - 1; e++) {
+        envp[n++] = *e;
+    }
+    envp[n] = NULL;
+
+    char *argv[] = { "/bin/sh", "-c", (char *)ri->target, NULL };
+    pid_t pid;
+    posix_spawn(&pid, "/bin/sh", NULL, NULL, argv, envp);
+}
+
+static void write_fifo(const rule_info_t *ri, const char *state, double value, int64_t now_ms) {
+    // Non-blocking: with no reader attached the event is dropped
+    int fd = open(ri->target, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    char line[128];
+    int len = snprintf(line, sizeof(line), "%ld %s %s %g\n", (long)now_ms, ri->name, state, value);
+    if (len > 0 && write(fd, line, (size_t)len) < 0) {
+        // Full pipe: the reader is behind, drop rather than block the tick
+    }
+    close(fd);
+}
+
+static void transition(int index, int firing, double value, int64_t now_ms) {
+    const rule_info_t *ri = &info[index];
+    const char *state = firing ? "firing" : "resolved";
+
+    if (!actions_enabled || ri->action == ACTION_NONE) {
+        return;
+    }
+    if (ri->action == ACTION_EXEC) {
+        run_exec(ri, state, value);
+    } else {
+        write_fifo(ri, state, value, now_ms);
+    }
+}
+
+static int holds(alert_op_t op, double x, double threshold) {
+    switch (op) {
+    case OP_GT: return x > threshold;
+    case OP_GE: return x >= threshold;
+    case OP_LT: return x < threshold;
+    default:    return x <= threshold;
+    }
+}
+
+int alerts_evaluate(const double *values, int sources, int64_t now_ms) {
+    int changes = 0;
+
+    // Reap finished hooks
+    while (waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+
+    for (int source = 0; source < METRIC_SOURCE_COUNT; source++) {
+        if (!(sources & (1 << source))) {
+            continue;
+        }
+
+        for (int i = source_begin[source]; i < source_begin[source + 1]; i++) {
+            rule_t *r = &plan[i];
+            double x = values[r->metric];
+            if (isnan(x)) {
+                r->has_prev = 0;
+                continue;
+            }
+
+            if (r->is_rate) {
+                int64_t dt = now_ms - r->prev_ms;
+                int have_prev = r->has_prev && dt > 0;
+                double prev = r->prev_value;
+                r->prev_value = x;
+                r->prev_ms = now_ms;
+                r->has_prev = 1;
+                if (!have_prev) {
+                    continue;
+                }
+                x = (x - prev) * 1000.0 / (double)dt;
+            }
+
+            int cond = holds((alert_op_t)r->op, x, r->threshold);
+            switch ((alert_state_t)r->state) {
+            case ALERT_OK:
+                if (!cond) {
+                    break;
+                }
+                r->since_ms = now_ms;
+                r->state = ALERT_PENDING;
+                // A zero "for" fires at once
+                // fall through
+            case ALERT_PENDING:
+                if (!cond) {
+                    r->state = ALERT_OK;
+                } else if (now_ms - r->since_ms >= r->hold_ms) {
+                    r->state = ALERT_FIRING;
+                    transition(i, 1, x, now_ms);
+                    changes++;
+                }
+                break;
+            case ALERT_FIRING: {
+                int above = (r->op == OP_GT || r->op == OP_GE);
+                int resolved = !r->has_clear ? !cond : above ? x < r->clear : x > r->clear;
+                if (resolved) {
+                    r->state = ALERT_OK;
+                    transition(i, 0, x, now_ms);
+                    changes++;
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    return changes;
+}
+
+int alerts_count(void) {
+    return rule_count;
+}
+
+int alerts_find(const char *name) {
+    for (int i = 0; i < rule_count; i++) {
+        if (strcmp(info[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *alerts_name(int rule) {
+    return (rule >= 0 && rule < rule_count) ? info[rule].name : NULL;
+}
+
+alert_state_t alerts_state(int rule) {
+    return (rule >= 0 && rule < rule_count) ? (alert_state_t)plan[rule].state : ALERT_OK;
+}
+
+double alerts_threshold(int rule) {
+    return (rule >= 0 && rule < rule_count) ? plan[rule].threshold : NAN;
+}
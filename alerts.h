@@ -0,0 +1,58 @@
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ALERTS_MAX_RULES 512
+#define ALERTS_MAX_NAME 48
+#define ALERTS_MAX_TARGET 256
+
+// Built-in rule behind the RAM bar's danger colouring, unless the config
+// defines its own rule of the same name
+#define ALERTS_RAM_DANGER "ram_danger"
+#define ALERTS_DEFAULT_RAM_DANGER_GB 12.0
+
+// Built-in rule for the RAM bar inside a memory-limited cgroup: 90% of
+// memory.max, rebuilt when the limit changes unless the config defines it
+#define ALERTS_CGROUP_RAM_DANGER "cgroup_ram_danger"
+
+typedef enum {
+    ALERT_OK,
+    ALERT_PENDING,                 // Condition holds, waiting out "for"
+    ALERT_FIRING
+} alert_state_t;
+
+// Drop all rules and their state
+void alerts_reset(void);
+
+// Compile one rule (the value of an ALERT= line):
+//   <name>: <metric|rate(metric)> <op> <value> [for <n>[ms|s|m|h]] [clear <value>]
+//           [exec <command> | fifo <path>]
+// Returns -1 and a message in error on a syntax error.
+int alerts_compile(const char *rule, char *error, size_t error_size);
+
+// Load ALERT= and RAM_DANGER_THRESHOLD= lines from a config file (NULL or
+// missing file: built-in rules only). Bad rules are reported on stderr and
+// skipped; returns the number of rules loaded. Rules whose name and
+// condition are unchanged keep their state across a reload.
+int alerts_load(const char *path);
+
+// The server cgroup's memory.max in bytes (0: unlimited or unknown)
+void alerts_set_memory_limit(uint64_t bytes);
+
+// Evaluate the rules of every source in sources (metrics_record() bitmask)
+// against values[METRIC_COUNT]. Returns the number of state changes.
+int alerts_evaluate(const double *values, int sources, int64_t now_ms);
+
+// Run exec hooks and FIFO writes on transitions (on by default)
+void alerts_set_actions(int enabled);
+
+// Rule lookup and state
+int alerts_count(void);
+int alerts_find(const char *name);
+const char *alerts_name(int rule);
+alert_state_t alerts_state(int rule);
+double alerts_threshold(int rule);
+
+#endif // ALERTS_H
@@ -0,0 +1,162 @@
+/*
+ * Benchmark: process discovery as the PID count grows
+ * Usage: ./bench_process_scan [--max N] [--root DIR]
+ *
+ * Generates synthetic procfs trees (see procfs_gen.h) of increasing size
+ * and times process_find_all_by_name() over each, with the full scan and
+ * with the miss cache. The cached strategy is reported for its first scan
+ * and for steady state, once unrelated PIDs have been learned. Without
+ * --root the trees go to $TMPDIR and are removed afterwards; with --root
+ * an existing tree (e.g. from gen_procfs) is measured as is.
+ */
+
+#define _GNU_SOURCE
+#include "../process_monitor.h"
+#include "../selfstats.h"
+#include "procfs_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+
+#define SERVERS 2
+#define WARM_SCANS 2
+
+static const int sizes[] = { 1000, 10000, 25000, 50000, 100000 };
+#define SIZE_COUNT (int)(sizeof(sizes) / sizeof(sizes[0]))
+
+typedef struct {
+    uint64_t ns;
+    uint64_t syscalls;
+    uint64_t opens;
+    int instances;
+} scan_t;
+
+static scan_t scan_once(void) {
+    process_info_t list[MAX_SERVER_INSTANCES];
+    selfstats_span_t span;
+    selfstats_timer_t timer;
+
+    selfstats_begin(&span);
+    int found = process_find_all_by_name("EnshroudedServer", list, MAX_SERVER_INSTANCES);
+    selfstats_end(SELFSTATS_PROCESS, &span);
+    selfstats_read(SELFSTATS_PROCESS, &timer);
+
+    scan_t scan = { timer.last_ns, timer.last_syscalls, timer.last_opens, found };
+    return scan;
+}
+
+static void print_row(long pids, const char *strategy, const scan_t *scan) {
+    printf("%ld,%s,%.3f,%llu,%llu,%d\n", pids, strategy, scan->ns / 1e6,
+           (unsigned long long)scan->syscalls, (unsigned long long)scan->opens,
+           scan->instances);
+}
+
+// Average of repeated scans once the cache (if any) is warm
+static scan_t scan_average(int scans) {
+    scan_t total = { 0, 0, 0, 0 };
+    for (int i = 0; i < scans; i++) {
+        scan_t scan = scan_once();
+        total.ns += scan.ns;
+        total.syscalls += scan.syscalls;
+        total.opens += scan.opens;
+        total.instances = scan.instances;
+    }
+    total.ns /= (uint64_t)scans;
+    total.syscalls /= (uint64_t)scans;
+    total.opens /= (uint64_t)scans;
+    return total;
+}
+
+static long count_pids(const char *root) {
+    DIR *dir = opendir(root);
+    if (!dir) {
+        return -1;
+    }
+    long count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (isdigit((unsigned char)entry->d_name[0])) {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static int measure(const char *root, long pids) {
+    process_monitor_set_proc_root(root);
+    int scans = (pids >= 50000) ? 3 : 10;
+
+    process_monitor_set_scan_mode(PROCESS_SCAN_FULL);
+    scan_t full = scan_average(scans);
+    print_row(pids, "full", &full);
+
+    process_monitor_set_scan_mode(PROCESS_SCAN_CACHED);
+    scan_t first = scan_once();
+    print_row(pids, "cached_first", &first);
+    for (int i = 1; i < WARM_SCANS; i++) {
+        scan_once();
+    }
+    scan_t steady = scan_average(scans);
+    print_row(pids, "cached_steady", &steady);
+    fflush(stdout);
+
+    process_monitor_cleanup();
+
+    // Both strategies must find the same servers
+    if (full.instances != steady.instances || first.instances != steady.instances) {
+        fprintf(stderr, "%s: full scan found %d instances, cached %d/%d\n", root,
+                full.instances, first.instances, steady.instances);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long max_pids = 10000;
+    const char *root = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_pids = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--max N] [--root DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("pids,strategy,scan_ms,syscalls,opens,instances\n");
+
+    if (root) {
+        return measure(root, count_pids(root)) < 0 ? 1 : 0;
+    }
+
+    const char *tmp = getenv("TMPDIR");
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s/emon-procfs-XXXXXX", tmp ? tmp : "/tmp");
+    if (!mkdtemp(dir)) {
+        perror(dir);
+        return 1;
+    }
+
+    // Trees are deterministic, so each size regrows the previous one
+    int status = 0;
+    for (int i = 0; i < SIZE_COUNT && sizes[i] <= max_pids; i++) {
+        if (procfs_generate(dir, sizes[i], SERVERS) < 0) {
+            perror(dir);
+            status = 1;
+            break;
+        }
+        if (measure(dir, sizes[i]) < 0) {
+            status = 1;
+            break;
+        }
+    }
+
+    procfs_remove(dir);
+    return status;
+}
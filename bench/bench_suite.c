@@ -0,0 +1,367 @@
+/*
+ * Benchmark suite: every parser and collector against captured fixtures
+ * Usage: ./bench_suite [--fixtures DIR] [--proc-root DIR] [--scale N] [filter]
+ *
+ * Collectors read the fixture procfs tree through their proc root setters,
+ * so runs are repeatable across machines and commits. One CSV line per
+ * benchmark on stdout:
+ *   benchmark,iterations,ns_per_op,allocs_per_op,syscalls_per_op
+ * Allocations are counted by interposing malloc; syscalls come from the
+ * same accounting as the overhead panel (selfstats).
+ */
+
+#define _GNU_SOURCE
+#include "../system_monitor.h"
+#include "../process_monitor.h"
+#include "../psi_monitor.h"
+#include "../cgroup_monitor.h"
+#include "../disk_monitor.h"
+#include "../a2s_query.h"
+#include "../formatting.h"
+#include "../log_tail.h"
+#include "../log_events.h"
+#include "../selfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// glibc's own allocator, reached past our interposers
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static uint64_t allocations = 0;
+
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+#define MAX_FIXTURE 16384
+#define MAX_FIXTURE_PATH 512
+
+typedef struct {
+    char data[MAX_FIXTURE];
+    size_t len;
+} fixture_t;
+
+static char fixture_dir[256] = "fixtures";
+static char proc_root[MAX_FIXTURE_PATH];
+static int custom_root = 0;
+
+static fixture_t stat_file, meminfo_file, vmstat_file, pressure_file;
+static fixture_t diskstats_file, cmdline_file, a2s_file, server_log;
+
+// Keeps results observable so the loops are not optimized away
+static volatile uint64_t sink;
+
+static int load_fixture(fixture_t *f, const char *base, const char *name) {
+    char path[MAX_FIXTURE_PATH + 64];
+    snprintf(path, sizeof(path), "%s/%s", base, name);
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Missing fixture %s\n", path);
+        return -1;
+    }
+    f->len = fread(f->data, 1, sizeof(f->data) - 1, fp);
+    f->data[f->len] = '\0';
+    fclose(fp);
+    return 0;
+}
+
+// Parsers (in-memory fixtures)
+
+static void run_format_bytes(void) {
+    char buf[32];
+    format_bytes(9412236, buf, sizeof(buf));
+    sink += (uint8_t)buf[0];
+}
+
+static void run_a2s_parse_info(void) {
+    a2s_info_t info;
+    sink += a2s_parse_info((const uint8_t *)a2s_file.data, a2s_file.len, &info);
+}
+
+static void run_parse_cpu_lines(void) {
+    static cpu_times_t aggregate;
+    static cpu_core_times_t cores;
+    sink += system_monitor_parse_cpu_lines(stat_file.data, stat_file.len, &aggregate, &cores);
+}
+
+static void run_parse_meminfo(void) {
+    system_stats_t stats;
+    sink += system_monitor_parse_meminfo(meminfo_file.data, meminfo_file.len, &stats);
+}
+
+static void run_parse_vmstat(void) {
+    system_stats_t stats;
+    sink += system_monitor_parse_vmstat(vmstat_file.data, vmstat_file.len, &stats);
+}
+
+static void run_psi_parse(void) {
+    psi_resource_t resource;
+    sink += psi_parse(pressure_file.data, &resource);
+}
+
+static void run_parse_diskstats(void) {
+    disk_counters_t counters;
+    sink += disk_parse_diskstats(diskstats_file.data, diskstats_file.len, "nvme0n1p2",
+                                 0, 0, &counters);
+}
+
+static void run_parse_query_port(void) {
+    sink += process_parse_query_port_arg(cmdline_file.data);
+}
+
+static void count_line(const char *line, size_t len, void *ctx) {
+    (void)line;
+    (void)ctx;
+    sink += len;
+}
+
+static void match_line(const char *line, size_t len, void *ctx) {
+    (void)ctx;
+    sink += log_events_match(line, len);
+}
+
+// Splitting writes NULs over the newlines, so each op starts from a fresh copy
+static void run_log_split(void) {
+    static char work[MAX_FIXTURE];
+    size_t consumed;
+    memcpy(work, server_log.data, server_log.len);
+    sink += log_tail_split(work, server_log.len, count_line, NULL, &consumed);
+}
+
+static void run_log_scan(void) {
+    static char work[MAX_FIXTURE];
+    size_t consumed;
+    memcpy(work, server_log.data, server_log.len);
+    sink += log_tail_split(work, server_log.len, match_line, NULL, &consumed);
+}
+
+// Collectors (fixture procfs through the proc root)
+
+static void run_system_get_stats(void) {
+    static system_stats_t stats;
+    sink += system_monitor_get_stats(&stats);
+}
+
+static void run_psi_get_stats(void) {
+    psi_stats_t stats;
+    sink += psi_monitor_get_stats(&stats);
+}
+
+static void run_cgroup_get_stats(void) {
+    static cgroup_stats_t stats;
+    sink += cgroup_monitor_get_stats(&stats);
+}
+
+static void run_process_find_all(void) {
+    static process_info_t list[MAX_SERVER_INSTANCES];
+    sink += process_find_all_by_name("EnshroudedServer", list, MAX_SERVER_INSTANCES);
+}
+
+static void run_process_get_memory(void) {
+    uint64_t rss_kb = 0;
+    sink += process_get_memory(4120, &rss_kb);
+}
+
+typedef struct {
+    const char *name;
+    long iterations;
+    void (*run)(void);
+} bench_t;
+
+static const bench_t benches[] = {
+    { "format_bytes",           2000000, run_format_bytes },
+    { "a2s_parse_info",         2000000, run_a2s_parse_info },
+    { "system_parse_cpu_lines",  500000, run_parse_cpu_lines },
+    { "system_parse_meminfo",    500000, run_parse_meminfo },
+    { "system_parse_vmstat",     500000, run_parse_vmstat },
+    { "psi_parse",               500000, run_psi_parse },
+    { "disk_parse_diskstats",    500000, run_parse_diskstats },
+    { "process_parse_query_port",2000000, run_parse_query_port },
+    { "log_split_lines",          100000, run_log_split },
+    { "log_scan_events",           20000, run_log_scan },
+    { "system_get_stats",         50000, run_system_get_stats },
+    { "psi_get_stats",           100000, run_psi_get_stats },
+    { "cgroup_get_stats",        100000, run_cgroup_get_stats },
+    { "process_find_all",          5000, run_process_find_all },
+    { "process_get_memory",       50000, run_process_get_memory },
+};
+
+#define BENCH_COUNT (int)(sizeof(benches) / sizeof(benches[0]))
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Syscalls selfstats_syscalls() itself adds between two readings
+static uint64_t probe_cost(void) {
+    uint64_t first = selfstats_syscalls();
+    return selfstats_syscalls() - first;
+}
+
+static void run_bench(const bench_t *b, double scale, uint64_t probe) {
+    long iterations = (long)(b->iterations * scale);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    // Warm-up opens cached descriptors and faults in the fixtures
+    b->run();
+
+    uint64_t allocs_before = allocations;
+    uint64_t syscalls_before = selfstats_syscalls();
+    uint64_t start = now_ns();
+    for (long i = 0; i < iterations; i++) {
+        b->run();
+    }
+    uint64_t elapsed = now_ns() - start;
+    uint64_t syscalls = selfstats_syscalls() - syscalls_before;
+    uint64_t allocs = allocations - allocs_before;
+
+    syscalls = (syscalls > probe) ? syscalls - probe : 0;
+
+    printf("%s,%ld,%.1f,%.2f,%.2f\n", b->name, iterations,
+           (double)elapsed / iterations, (double)allocs / iterations,
+           (double)syscalls / iterations);
+}
+
+// Collectors must read what the fixtures hold, or the numbers mean nothing
+static int check_fixtures(void) {
+    a2s_info_t info;
+    if (a2s_parse_info((const uint8_t *)a2s_file.data, a2s_file.len, &info) < 0 ||
+        info.players != 7 || info.max_players != 16 || strcmp(info.version, "0.8.1.1") != 0) {
+        fprintf(stderr, "a2s_info.bin did not parse as expected\n");
+        return -1;
+    }
+
+    if (log_events_init() < 0) {
+        fprintf(stderr, "log event patterns did not compile\n");
+        return -1;
+    }
+
+    if (custom_root) {
+        return 0;
+    }
+
+    system_stats_t stats;
+    if (system_monitor_get_stats(&stats) < 0 || stats.total_mem_kb != 6147400 ||
+        stats.cpu_count != 8) {
+        fprintf(stderr, "system_monitor did not read the fixture root\n");
+        return -1;
+    }
+
+    process_info_t list[MAX_SERVER_INSTANCES];
+    int count = process_find_all_by_name("EnshroudedServer", list, MAX_SERVER_INSTANCES);
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        if ((list[i].pid == 4120 && list[i].query_port == 15637 && list[i].rss_kb == 9412236) ||
+            (list[i].pid == 5200 && list[i].query_port == 16637)) {
+            found++;
+        }
+    }
+    if (count != 2 || found != 2) {
+        fprintf(stderr, "process scan found %d instances (%d as expected)\n", count, found);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    double scale = 1.0;
+    const char *filter = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fixtures") == 0 && i + 1 < argc) {
+            snprintf(fixture_dir, sizeof(fixture_dir), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "--proc-root") == 0 && i + 1 < argc) {
+            snprintf(proc_root, sizeof(proc_root), "%s", argv[++i]);
+            custom_root = 1;
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atof(argv[++i]);
+            if (scale <= 0.0) {
+                scale = 1.0;
+            }
+        } else if (argv[i][0] != '-') {
+            filter = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--fixtures DIR] [--proc-root DIR] [--scale N] [filter]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    if (!custom_root) {
+        snprintf(proc_root, sizeof(proc_root), "%s/proc", fixture_dir);
+    }
+
+    // Parsers always run on the captured files
+    char captured[MAX_FIXTURE_PATH];
+    snprintf(captured, sizeof(captured), "%s/proc", fixture_dir);
+    if (load_fixture(&stat_file, captured, "stat") < 0 ||
+        load_fixture(&meminfo_file, captured, "meminfo") < 0 ||
+        load_fixture(&vmstat_file, captured, "vmstat") < 0 ||
+        load_fixture(&pressure_file, captured, "pressure/cpu") < 0 ||
+        load_fixture(&diskstats_file, captured, "diskstats") < 0 ||
+        load_fixture(&cmdline_file, captured, "4120/cmdline") < 0 ||
+        load_fixture(&a2s_file, fixture_dir, "a2s_info.bin") < 0 ||
+        load_fixture(&server_log, fixture_dir, "server.log") < 0) {
+        return 1;
+    }
+    for (size_t i = 0; i < cmdline_file.len; i++) {
+        if (cmdline_file.data[i] == '\0') {
+            cmdline_file.data[i] = ' ';
+        }
+    }
+
+    system_monitor_set_proc_root(proc_root);
+    psi_monitor_set_proc_root(proc_root);
+    process_monitor_set_proc_root(proc_root);
+    if (system_monitor_init() < 0 || psi_monitor_init() < 0) {
+        fprintf(stderr, "Cannot read %s\n", proc_root);
+        return 1;
+    }
+
+    char cgroup_dir[MAX_FIXTURE_PATH];
+    snprintf(cgroup_dir, sizeof(cgroup_dir), "%s/cgroup", fixture_dir);
+    cgroup_monitor_set_dir(cgroup_dir);
+
+    if (check_fixtures() < 0) {
+        return 1;
+    }
+
+    uint64_t probe = probe_cost();
+    printf("benchmark,iterations,ns_per_op,allocs_per_op,syscalls_per_op\n");
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        if (filter && !strstr(benches[i].name, filter)) {
+            continue;
+        }
+        run_bench(&benches[i], scale, probe);
+    }
+
+    cgroup_monitor_cleanup();
+    psi_monitor_cleanup();
+    system_monitor_cleanup();
+    return 0;
+}
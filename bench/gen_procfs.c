@@ -0,0 +1,26 @@
+/*
+ * Write a synthetic procfs tree for process discovery benchmarks
+ * Usage: ./gen_procfs DIR COUNT [SERVERS]
+ * Point emon's collectors (or bench_process_scan --root) at DIR afterwards.
+ */
+
+#include "procfs_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s DIR COUNT [SERVERS]\n", argv[0]);
+        return 2;
+    }
+
+    int count = atoi(argv[2]);
+    int servers = (argc > 3) ? atoi(argv[3]) : 2;
+    if (procfs_generate(argv[1], count, servers) < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    printf("%s: %d processes, %d server instances\n", argv[1], count, servers);
+    return 0;
+}
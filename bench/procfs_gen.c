@@ -0,0 +1,216 @@
+/*
+ * Synthetic procfs generator
+ * Writes just the files process_monitor reads, with deterministic contents
+ * so scans over the same N are comparable across commits.
+ */
+
+#define _GNU_SOURCE
+#include "procfs_gen.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define FIRST_PID 300
+#define MAX_GEN_PATH 512
+
+typedef struct {
+    const char *comm;
+    const char *cmdline;       // NUL-separated, as in /proc
+    size_t cmdline_len;
+} proc_kind_t;
+
+#define KIND(comm, cmdline) { comm, cmdline, sizeof(cmdline) - 1 }
+
+// Ordinary build-host load
+static const proc_kind_t plain_kinds[] = {
+    KIND("bash", "-bash\0"),
+    KIND("cc1", "/usr/lib/gcc/x86_64-linux-gnu/13/cc1\0-quiet\0-I\0include\0src/main.c\0-O2\0"),
+    KIND("make", "make\0-j32\0all\0"),
+    KIND("python3", "/usr/bin/python3\0-m\0pytest\0-x\0tests/\0"),
+    KIND("sshd", "sshd: steam@pts/3\0"),
+    KIND("kworker/3:1-eve", ""),
+    KIND("systemd-journal", "/usr/lib/systemd/systemd-journald\0"),
+    KIND("node", "/usr/bin/node\0/srv/app/server.js\0--port\0""8080\0"),
+};
+
+// Wine helpers: comm is truncated, cmdline carries the Windows path
+static const proc_kind_t wine_kinds[] = {
+    KIND("wineserver", "/usr/bin/wineserver\0"),
+    KIND("services.exe", "C:\\windows\\system32\\services.exe\0"),
+    KIND("winedevice.exe", "C:\\windows\\system32\\winedevice.exe\0"),
+    KIND("explorer.exe", "C:\\windows\\system32\\explorer.exe\0/desktop\0"),
+    KIND("plugplay.exe", "C:\\windows\\system32\\plugplay.exe\0"),
+    KIND("svchost.exe", "C:\\windows\\system32\\svchost.exe\0-k\0LocalServiceNetworkRestricted\0"),
+    KIND("SteamService.ex", "C:\\Program Files (x86)\\Steam\\bin\\SteamService.exe\0-service\0"),
+};
+
+#define PLAIN_KINDS (int)(sizeof(plain_kinds) / sizeof(plain_kinds[0]))
+#define WINE_KINDS (int)(sizeof(wine_kinds) / sizeof(wine_kinds[0]))
+
+static int write_file(const char *dir, const char *name, const char *data, size_t len) {
+    char path[MAX_GEN_PATH + 32];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t written = write(fd, data, len);
+    close(fd);
+    return written == (ssize_t)len ? 0 : -1;
+}
+
+static int make_dir(const char *path) {
+    return (mkdir(path, 0755) == 0 || errno == EEXIST) ? 0 : -1;
+}
+
+static int write_process(const char *root, int pid, int ppid, const char *comm,
+                         const char *cmdline, size_t cmdline_len,
+                         unsigned long rss_kb, const unsigned long *sockets, int socket_count) {
+    char dir[MAX_GEN_PATH];
+    snprintf(dir, sizeof(dir), "%s/%d", root, pid);
+    if (make_dir(dir) < 0) {
+        return -1;
+    }
+
+    char buf[1024];
+    int len = snprintf(buf, sizeof(buf), "%s\n", comm);
+    if (write_file(dir, "comm", buf, (size_t)len) < 0 ||
+        write_file(dir, "cmdline", cmdline, cmdline_len) < 0) {
+        return -1;
+    }
+
+    // Fields 1-22, then enough tail that the line looks like the real thing
+    len = snprintf(buf, sizeof(buf),
+                   "%d (%s) S %d %d %d 0 -1 4194560 1223 0 12 0 48 9 0 0 20 0 4 0 %d "
+                   "13221273600 %lu 18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 17 3 0 0 0 0 0\n",
+                   pid, comm, ppid, pid, ppid, 1000 + pid, rss_kb / 4);
+    if (write_file(dir, "stat", buf, (size_t)len) < 0) {
+        return -1;
+    }
+
+    len = snprintf(buf, sizeof(buf),
+                   "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%d\nNgid:\t0\n"
+                   "Pid:\t%d\nPPid:\t%d\nTracerPid:\t0\nUid:\t1000\t1000\t1000\t1000\n"
+                   "Gid:\t1000\t1000\t1000\t1000\nFDSize:\t64\nVmPeak:\t%lu kB\n"
+                   "VmSize:\t%lu kB\nVmHWM:\t%lu kB\nVmRSS:\t%lu kB\nThreads:\t4\n",
+                   comm, pid, pid, ppid, rss_kb * 3, rss_kb * 3, rss_kb, rss_kb);
+    if (write_file(dir, "status", buf, (size_t)len) < 0) {
+        return -1;
+    }
+
+    char fd_dir[MAX_GEN_PATH + 8];
+    snprintf(fd_dir, sizeof(fd_dir), "%s/fd", dir);
+    if (make_dir(fd_dir) < 0) {
+        return -1;
+    }
+    for (int i = 0; i < socket_count; i++) {
+        char link_path[MAX_GEN_PATH + 32];
+        char target[64];
+        snprintf(link_path, sizeof(link_path), "%s/%d", fd_dir, 3 + i);
+        snprintf(target, sizeof(target), "socket:[%lu]", sockets[i]);
+        if (symlink(target, link_path) < 0 && errno != EEXIST) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int procfs_generate(const char *root, int count, int servers) {
+    char path[MAX_GEN_PATH];
+
+    if (count < 0 || servers < 0 || make_dir(root) < 0) {
+        return -1;
+    }
+
+    static const char stat_file[] =
+        "cpu  1823455 3121 402118 48211399 30211 0 18844 2311 0 0\n"
+        "btime 1760000000\n";
+    snprintf(path, sizeof(path), "%s/net", root);
+    if (write_file(root, "stat", stat_file, sizeof(stat_file) - 1) < 0 || make_dir(path) < 0) {
+        return -1;
+    }
+
+    // Roughly one process in eight belongs to some Wine prefix
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int pick = (seed >> 16) & 0x7fff;
+        const proc_kind_t *kind = (pick % 8 == 0)
+            ? &wine_kinds[(pick / 8) % WINE_KINDS]
+            : &plain_kinds[pick % PLAIN_KINDS];
+
+        int pid = FIRST_PID + i;
+        int ppid = (i == 0) ? 1 : FIRST_PID + (int)(pick % (unsigned int)i);
+        if (write_process(root, pid, ppid, kind->comm, kind->cmdline, kind->cmdline_len,
+                          1024 + pick % 65536, NULL, 0) < 0) {
+            return -1;
+        }
+    }
+
+    // Bound sockets: game port and query port per server
+    char udp[256 + 2 * 160 * 16];
+    int udp_len = snprintf(udp, sizeof(udp),
+                           "   sl  local_address rem_address   st tx_queue rx_queue tr "
+                           "tm->when retrnsmt   uid  timeout inode ref pointer drops\n");
+
+    for (int s = 0; s < servers && s < 16; s++) {
+        int launcher = PROCFS_GEN_SERVER_PID + 2 * s;
+        int server = launcher + 1;
+        uint16_t query_port = (uint16_t)(PROCFS_GEN_QUERY_PORT + 1000 * s);
+        unsigned long sockets[2] = { 700000UL + 2 * s, 700000UL + 2 * s + 1 };
+
+        static const char launcher_cmdline[] = "/usr/bin/wine\0EnshroudedServer.exe\0";
+        if (write_process(root, launcher, 1, "wine", launcher_cmdline,
+                          sizeof(launcher_cmdline) - 1, 21000, NULL, 0) < 0) {
+            return -1;
+        }
+
+        char cmdline[256];
+        int cmd_len = snprintf(cmdline, sizeof(cmdline),
+                               "Z:\\home\\steam\\enshrouded%d\\EnshroudedServer.exe", s + 1);
+        cmd_len++;
+        if (s == 0) {
+            cmd_len += snprintf(cmdline + cmd_len, sizeof(cmdline) - (size_t)cmd_len,
+                                "-queryport=%u", query_port) + 1;
+        }
+        if (write_process(root, server, launcher, "EnshroudedServe", cmdline, (size_t)cmd_len,
+                          9412236, sockets, 2) < 0) {
+            return -1;
+        }
+
+        for (int k = 0; k < 2; k++) {
+            udp_len += snprintf(udp + udp_len, sizeof(udp) - (size_t)udp_len,
+                                "%5d: 00000000:%04X 00000000:0000 07 00000000:00000000 "
+                                "00:00000000 00000000  1000        0 %lu 2 0000000000000000 0\n",
+                                2 * s + k, query_port - 1 + k, sockets[k]);
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/net", root);
+    static const char udp6_header[] =
+        "  sl  local_address                         remote_address                        "
+        "st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode ref pointer drops\n";
+    if (write_file(path, "udp", udp, (size_t)udp_len) < 0 ||
+        write_file(path, "udp6", udp6_header, sizeof(udp6_header) - 1) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int remove_entry(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+int procfs_remove(const char *root) {
+    return nftw(root, remove_entry, 64, FTW_DEPTH | FTW_PHYS);
+}
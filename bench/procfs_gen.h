@@ -0,0 +1,22 @@
+#ifndef PROCFS_GEN_H
+#define PROCFS_GEN_H
+
+// Synthetic procfs trees for benchmarking process discovery at scale.
+// Each PID gets comm, cmdline, stat, status and an fd/ directory; a share
+// of them look like Wine helpers (wineserver, services.exe, winedevice.exe)
+// so name matching sees realistic cmdlines.
+
+// Server instances are numbered from this PID upwards, launcher then server
+#define PROCFS_GEN_SERVER_PID 900000
+#define PROCFS_GEN_QUERY_PORT 15637
+
+// Write count background processes plus servers Enshrouded instances
+// (each a wine launcher and its EnshroudedServer.exe child) under root.
+// The first server passes -queryport; the others are only found through
+// their sockets in net/udp. Returns 0 on success, -1 on error.
+int procfs_generate(const char *root, int count, int servers);
+
+// Remove a tree written by procfs_generate()
+int procfs_remove(const char *root);
+
+#endif // PROCFS_GEN_H
@@ -0,0 +1,279 @@
+/*
+ * cgroup v2 memory and CPU accounting
+ * Inside a container /proc/meminfo describes the host, so limits and usage
+ * are taken from the server's cgroup instead.
+ */
+
+#define _GNU_SOURCE
+#include "cgroup_monitor.h"
+#include "selfstats.h"
+#include "proc_kv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+enum {
+    CG_FILE_MEMORY_CURRENT,
+    CG_FILE_MEMORY_EVENTS,
+    CG_FILE_CPU_STAT,
+    CG_FILE_COUNT
+};
+
+static const char *cg_file_names[CG_FILE_COUNT] = {
+    "memory.current", "memory.events", "cpu.stat"
+};
+
+enum {
+    EVENTS_HIGH,
+    EVENTS_MAX,
+    EVENTS_OOM,
+    EVENTS_OOM_KILL,
+    EVENTS_COUNT
+};
+
+static const proc_kv_key_t events_keys[] = {
+    { "high", EVENTS_HIGH },
+    { "max", EVENTS_MAX },
+    { "oom", EVENTS_OOM },
+    { "oom_kill", EVENTS_OOM_KILL },
+};
+
+enum {
+    CPUSTAT_USAGE,
+    CPUSTAT_USER,
+    CPUSTAT_SYSTEM,
+    CPUSTAT_NR_PERIODS,
+    CPUSTAT_NR_THROTTLED,
+    CPUSTAT_THROTTLED,
+    CPUSTAT_COUNT
+};
+
+static const proc_kv_key_t cpustat_keys[] = {
+    { "usage_usec", CPUSTAT_USAGE },
+    { "user_usec", CPUSTAT_USER },
+    { "system_usec", CPUSTAT_SYSTEM },
+    { "nr_periods", CPUSTAT_NR_PERIODS },
+    { "nr_throttled", CPUSTAT_NR_THROTTLED },
+    { "throttled_usec", CPUSTAT_THROTTLED },
+};
+
+static proc_kv_table_t events_table;
+static proc_kv_table_t cpustat_table;
+static int tables_ready = 0;
+
+static int cg_fds[CG_FILE_COUNT] = { -1, -1, -1 };
+static char cg_dir[MAX_CGROUP_PATH];
+static uint64_t limit_memory_max = 0;
+static uint64_t limit_memory_high = 0;
+static double limit_cpu_cores = 0.0;
+
+// Previous cpu.stat sample for rates
+static uint64_t prev_usage_usec = 0;
+static uint64_t prev_nr_periods = 0;
+static uint64_t prev_nr_throttled = 0;
+static struct timespec prev_sample_time = {0};
+
+uint64_t cgroup_parse_limit(const char *value) {
+    if (strncmp(value, "max", 3) == 0) {
+        return 0;
+    }
+    return strtoull(value, NULL, 10);
+}
+
+double cgroup_parse_cpu_max(const char *value) {
+    if (strncmp(value, "max", 3) == 0) {
+        return 0.0;
+    }
+
+    unsigned long long quota = 0, period = 0;
+    if (sscanf(value, "%llu %llu", &quota, &period) != 2 || period == 0) {
+        return 0.0;
+    }
+    return (double)quota / (double)period;
+}
+
+// Read a small cgroup file into buffer (open/read/close, for the limit files)
+static int read_small_file(const char *dir, const char *name, char *buffer, size_t size) {
+    char path[MAX_CGROUP_PATH + 32];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    selfstats_count_open();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    ssize_t len = read(fd, buffer, size - 1);
+    close(fd);
+    if (len <= 0) {
+        return -1;
+    }
+    buffer[len] = '\0';
+    return 0;
+}
+
+// Limits may be set on any ancestor (e.g. a systemd slice); take the tightest
+static void load_effective_limits(const char *dir) {
+    char path[MAX_CGROUP_PATH];
+    char value[64];
+
+    limit_memory_max = 0;
+    limit_memory_high = 0;
+    limit_cpu_cores = 0.0;
+
+    snprintf(path, sizeof(path), "%s", dir);
+    do {
+        if (read_small_file(path, "memory.max", value, sizeof(value)) == 0) {
+            uint64_t limit = cgroup_parse_limit(value);
+            if (limit && (limit_memory_max == 0 || limit < limit_memory_max)) {
+                limit_memory_max = limit;
+            }
+        }
+        if (read_small_file(path, "memory.high", value, sizeof(value)) == 0) {
+            uint64_t limit = cgroup_parse_limit(value);
+            if (limit && (limit_memory_high == 0 || limit < limit_memory_high)) {
+                limit_memory_high = limit;
+            }
+        }
+        if (read_small_file(path, "cpu.max", value, sizeof(value)) == 0) {
+            double cores = cgroup_parse_cpu_max(value);
+            if (cores > 0.0 && (limit_cpu_cores == 0.0 || cores < limit_cpu_cores)) {
+                limit_cpu_cores = cores;
+            }
+        }
+
+        char *slash = strrchr(path, '/');
+        if (!slash) {
+            break;
+        }
+        *slash = '\0';
+    } while (strncmp(path, "/sys/fs/cgroup/", strlen("/sys/fs/cgroup/")) == 0);
+}
+
+int cgroup_monitor_set_dir(const char *dir) {
+    for (int i = 0; i < CG_FILE_COUNT; i++) {
+        if (cg_fds[i] >= 0) {
+            close(cg_fds[i]);
+            cg_fds[i] = -1;
+        }
+    }
+    cg_dir[0] = '\0';
+    prev_sample_time.tv_sec = 0;
+    prev_sample_time.tv_nsec = 0;
+
+    if (!dir) {
+        return 0;
+    }
+
+    if (!tables_ready) {
+        if (proc_kv_table_init(&events_table, events_keys,
+                               sizeof(events_keys) / sizeof(events_keys[0])) < 0 ||
+            proc_kv_table_init(&cpustat_table, cpustat_keys,
+                               sizeof(cpustat_keys) / sizeof(cpustat_keys[0])) < 0) {
+            return -1;
+        }
+        tables_ready = 1;
+    }
+
+    snprintf(cg_dir, sizeof(cg_dir), "%s", dir);
+
+    for (int i = 0; i < CG_FILE_COUNT; i++) {
+        char path[MAX_CGROUP_PATH + 32];
+        snprintf(path, sizeof(path), "%s/%s", dir, cg_file_names[i]);
+        selfstats_count_open();
+        cg_fds[i] = open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+    load_effective_limits(dir);
+
+    // The root cgroup has no memory.current; host figures apply there
+    return cg_fds[CG_FILE_MEMORY_CURRENT] >= 0 ? 0 : -1;
+}
+
+static int read_fd(int fd, char *buffer, size_t size) {
+    if (fd < 0) {
+        return -1;
+    }
+
+    ssize_t len = pread(fd, buffer, size - 1, 0);
+    if (len <= 0) {
+        return -1;
+    }
+    buffer[len] = '\0';
+    return (int)len;
+}
+
+int cgroup_monitor_get_stats(cgroup_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    char buffer[1024];
+    if (read_fd(cg_fds[CG_FILE_MEMORY_CURRENT], buffer, sizeof(buffer)) < 0) {
+        return -1;
+    }
+
+    // Limits change at runtime (systemctl set-property, docker update)
+    load_effective_limits(cg_dir);
+
+    stats->available = 1;
+    snprintf(stats->dir, sizeof(stats->dir), "%s", cg_dir);
+    stats->memory_current = strtoull(buffer, NULL, 10);
+    stats->memory_max = limit_memory_max;
+    stats->memory_high = limit_memory_high;
+    stats->cpu_quota_cores = limit_cpu_cores;
+
+    int len = read_fd(cg_fds[CG_FILE_MEMORY_EVENTS], buffer, sizeof(buffer));
+    if (len > 0) {
+        uint64_t values[EVENTS_COUNT] = {0};
+        proc_kv_parse(&events_table, buffer, (size_t)len, values);
+        stats->events_high = values[EVENTS_HIGH];
+        stats->events_max = values[EVENTS_MAX];
+        stats->events_oom = values[EVENTS_OOM];
+        stats->events_oom_kill = values[EVENTS_OOM_KILL];
+    }
+
+    len = read_fd(cg_fds[CG_FILE_CPU_STAT], buffer, sizeof(buffer));
+    if (len > 0) {
+        uint64_t values[CPUSTAT_COUNT] = {0};
+        proc_kv_parse(&cpustat_table, buffer, (size_t)len, values);
+        stats->usage_usec = values[CPUSTAT_USAGE];
+        stats->user_usec = values[CPUSTAT_USER];
+        stats->system_usec = values[CPUSTAT_SYSTEM];
+        stats->nr_periods = values[CPUSTAT_NR_PERIODS];
+        stats->nr_throttled = values[CPUSTAT_NR_THROTTLED];
+        stats->throttled_usec = values[CPUSTAT_THROTTLED];
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double elapsed_usec = (now.tv_sec - prev_sample_time.tv_sec) * 1e6 +
+                              (now.tv_nsec - prev_sample_time.tv_nsec) / 1e3;
+
+        if (prev_sample_time.tv_sec != 0 && elapsed_usec > 0.0) {
+            double cores = limit_cpu_cores > 0.0 ? limit_cpu_cores
+                                                 : (double)sysconf(_SC_NPROCESSORS_ONLN);
+            if (cores > 0.0) {
+                stats->cpu_percent = 100.0 * (stats->usage_usec - prev_usage_usec) /
+                                     (elapsed_usec * cores);
+            }
+
+            uint64_t periods = stats->nr_periods - prev_nr_periods;
+            if (periods > 0) {
+                stats->throttled_percent = 100.0 * (stats->nr_throttled - prev_nr_throttled) /
+                                           periods;
+            }
+        }
+
+        prev_usage_usec = stats->usage_usec;
+        prev_nr_periods = stats->nr_periods;
+        prev_nr_throttled = stats->nr_throttled;
+        prev_sample_time = now;
+    }
+
+    return 0;
+}
+
+void cgroup_monitor_cleanup(void) {
+    cgroup_monitor_set_dir(NULL);
+}
@@ -0,0 +1,48 @@
+#ifndef CGROUP_MONITOR_H
+#define CGROUP_MONITOR_H
+
+#include <stdint.h>
+
+#define MAX_CGROUP_PATH 512
+
+typedef struct {
+    int available;                 // memory.current readable
+    char dir[MAX_CGROUP_PATH];
+
+    // Memory (bytes); limits are the tightest along the path to the root
+    uint64_t memory_current;
+    uint64_t memory_max;           // 0 = unlimited
+    uint64_t memory_high;          // 0 = unlimited
+    uint64_t events_high;          // memory.events counters
+    uint64_t events_max;
+    uint64_t events_oom;
+    uint64_t events_oom_kill;
+
+    // CPU
+    double cpu_quota_cores;        // cpu.max quota/period, 0 = unlimited
+    uint64_t usage_usec;           // cpu.stat counters
+    uint64_t user_usec;
+    uint64_t system_usec;
+    uint64_t nr_periods;
+    uint64_t nr_throttled;
+    uint64_t throttled_usec;
+    double cpu_percent;            // Usage relative to the quota since the last sample
+    double throttled_percent;      // Share of periods throttled since the last sample
+} cgroup_stats_t;
+
+// Follow a cgroup v2 directory (NULL to stop)
+int cgroup_monitor_set_dir(const char *dir);
+
+// Read current cgroup accounting
+int cgroup_monitor_get_stats(cgroup_stats_t *stats);
+
+// Parse a memory.max / memory.high value ("max" = 0 = unlimited)
+uint64_t cgroup_parse_limit(const char *value);
+
+// Parse cpu.max ("<quota|max> <period>"), returns cores (0 = unlimited)
+double cgroup_parse_cpu_max(const char *value);
+
+// Cleanup cgroup monitoring resources
+void cgroup_monitor_cleanup(void);
+
+#endif // CGROUP_MONITOR_H
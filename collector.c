@@ -0,0 +1,824 @@
+/*
+ * Snapshot pipeline
+ * The system, process, A2S and fleet collectors each run in a worker thread on
+ * their own schedule and publish into a seqlock-protected snapshot. The log
+ * worker has no schedule: it sleeps until inotify reports the log grew. The
+ * renderer copies the latest consistent snapshots and never waits for a
+ * slow /proc walk or an A2S timeout.
+ *
+ * Workers sleep on an absolute CLOCK_MONOTONIC timerfd, so a schedule
+ * advances by exact periods: time spent collecting or handling a reload
+ * does not push later samples back.
+ */
+
+#define _GNU_SOURCE
+#include "collector.h"
+#include "seqlock.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+typedef struct {
+    seqlock_t lock;
+    system_snapshot_t data;
+} system_slot_t;
+
+typedef struct {
+    seqlock_t lock;
+    process_snapshot_t data;
+} process_slot_t;
+
+typedef struct {
+    seqlock_t lock;
+    a2s_snapshot_t data;
+} a2s_slot_t;
+
+typedef struct {
+    seqlock_t lock;
+    fleet_snapshot_t data;
+} fleet_slot_t;
+
+typedef struct {
+    seqlock_t lock;
+    log_snapshot_t data;
+} log_slot_t;
+
+static system_slot_t system_slot;
+static process_slot_t process_slot;
+static a2s_slot_t a2s_slot;
+static fleet_slot_t fleet_slot;
+static log_slot_t log_slot;
+
+static collector_config_t config;
+static int a2s_available = 0;
+static int wake_fd = -1;        // Workers -> renderer
+static int stop_fd = -1;        // collector_stop() -> workers
+static int log_watch_fd = -1;   // log_tail_open()
+
+static const struct {
+    const char *name;
+    uint32_t interval_ms;
+} tasks[COLLECT_TASK_COUNT] = {
+    [COLLECT_CPU]     = { "cpu",     250 },
+    [COLLECT_MEMORY]  = { "memory",  1000 },
+    [COLLECT_PSI]     = { "psi",     1000 },
+    [COLLECT_CGROUP]  = { "cgroup",  1000 },
+    [COLLECT_DISK]    = { "disk",    1000 },
+    [COLLECT_SENSORS] = { "sensors", 2000 },
+    [COLLECT_PROCESS] = { "process", 2000 },
+    [COLLECT_A2S]     = { "a2s",     5000 },
+    [COLLECT_FLEET]   = { "fleet",   10000 },
+};
+
+// Host tasks run by the system worker, in this order
+#define SYSTEM_TASK_COUNT (COLLECT_SENSORS + 1)
+
+static atomic_uint interval_ms[COLLECT_TASK_COUNT];
+static atomic_int top_enabled;
+
+// One reload descriptor per worker so each sleeping worker sees the change,
+// and one deadline timer per worker
+enum { WORKER_SYSTEM, WORKER_PROCESS, WORKER_A2S, WORKER_FLEET, WORKER_COUNT };
+static int reload_fds[WORKER_COUNT] = { -1, -1, -1, -1 };
+static int timer_fds[WORKER_COUNT] = { -1, -1, -1, -1 };
+
+// Leading descriptors of every worker's poll set; PSI triggers follow
+#define SLEEP_FDS 3
+
+enum { SLEEP_DEADLINE, SLEEP_EVENT, SLEEP_RELOAD };
+
+static pthread_t system_thread;
+static pthread_t process_thread;
+static pthread_t a2s_thread;
+static pthread_t fleet_thread;
+static pthread_t log_thread;
+static int threads_started = 0;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void notify_renderer(void) {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+        // Counter saturated: the renderer is already due to wake
+    }
+}
+
+static uint64_t interval_ns(collect_task_t task) {
+    return atomic_load_explicit(&interval_ms[task], memory_order_relaxed) * 1000000ULL;
+}
+
+// Sleep until the absolute deadline. Returns -1 once a stop was requested,
+// SLEEP_RELOAD when the intervals changed and SLEEP_EVENT when one of the
+// extra descriptors (PSI triggers, from fds[SLEEP_FDS]) fired.
+static int sleep_until(uint64_t deadline_ns, int worker, struct pollfd *fds, int extra) {
+    fds[0].fd = stop_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = reload_fds[worker];
+    fds[1].events = POLLIN;
+    fds[2].fd = timer_fds[worker];
+    fds[2].events = POLLIN;
+
+    // Nanosecond deadline on the kernel's clock, not a rounded poll timeout
+    struct itimerspec when = {
+        .it_value = { .tv_sec = (time_t)(deadline_ns / 1000000000ULL),
+                      .tv_nsec = (long)(deadline_ns % 1000000000ULL) },
+    };
+    if (deadline_ns <= monotonic_ns() ||
+        timerfd_settime(timer_fds[worker], TFD_TIMER_ABSTIME, &when, NULL) < 0) {
+        return SLEEP_DEADLINE;
+    }
+
+    for (;;) {
+        int ready = poll(fds, SLEEP_FDS + extra, -1);
+        if (ready < 0 && errno != EINTR) {
+            return -1;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        if (fds[0].revents) {
+            return -1;
+        }
+        if (fds[1].revents) {
+            uint64_t count;
+            if (read(reload_fds[worker], &count, sizeof(count)) < 0) {
+                // Another read already drained it
+            }
+            return SLEEP_RELOAD;
+        }
+        if (fds[2].revents) {
+            uint64_t expirations;
+            if (read(timer_fds[worker], &expirations, sizeof(expirations)) < 0) {
+                // Re-armed before we read it
+            }
+            return SLEEP_DEADLINE;
+        }
+        return SLEEP_EVENT;
+    }
+}
+
+// Advance a fixed-rate schedule; after a stall (suspend, debugger) restart it
+static uint64_t next_deadline(uint64_t deadline_ns, uint64_t interval_ns) {
+    uint64_t now = monotonic_ns();
+    deadline_ns += interval_ns;
+    if (deadline_ns < now) {
+        deadline_ns = now + interval_ns;
+    }
+    return deadline_ns;
+}
+
+// Move a pending deadline to a new interval, counted from the last run
+static uint64_t reschedule(uint64_t deadline_ns, uint64_t old_interval_ns, uint64_t new_interval_ns) {
+    uint64_t now = monotonic_ns();
+    deadline_ns = deadline_ns - old_interval_ns + new_interval_ns;
+    return deadline_ns < now ? now : deadline_ns;
+}
+
+static void publish_system(const system_snapshot_t *snapshot) {
+    seqlock_write_begin(&system_slot.lock);
+    memcpy(&system_slot.data, snapshot, sizeof(*snapshot));
+    seqlock_write_end(&system_slot.lock);
+    notify_renderer();
+}
+
+static void publish_process(const process_snapshot_t *snapshot) {
+    seqlock_write_begin(&process_slot.lock);
+    memcpy(&process_slot.data, snapshot, sizeof(*snapshot));
+    seqlock_write_end(&process_slot.lock);
+    notify_renderer();
+}
+
+static void publish_a2s(const a2s_snapshot_t *snapshot) {
+    seqlock_write_begin(&a2s_slot.lock);
+    memcpy(&a2s_slot.data, snapshot, sizeof(*snapshot));
+    seqlock_write_end(&a2s_slot.lock);
+    notify_renderer();
+}
+
+static void publish_fleet(const fleet_snapshot_t *snapshot) {
+    seqlock_write_begin(&fleet_slot.lock);
+    memcpy(&fleet_slot.data, snapshot, sizeof(*snapshot));
+    seqlock_write_end(&fleet_slot.lock);
+    notify_renderer();
+}
+
+// Plain line counts ride along with the next frame; a matched event
+// (a save, a join) wakes the renderer
+static void publish_log(const log_snapshot_t *snapshot, int notify) {
+    seqlock_write_begin(&log_slot.lock);
+    memcpy(&log_slot.data, snapshot, sizeof(*snapshot));
+    seqlock_write_end(&log_slot.lock);
+    if (notify) {
+        notify_renderer();
+    }
+}
+
+void collector_read_system(system_snapshot_t *out) {
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&system_slot.lock);
+        memcpy(out, &system_slot.data, sizeof(*out));
+    } while (seqlock_read_retry(&system_slot.lock, seq));
+}
+
+void collector_read_process(process_snapshot_t *out) {
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&process_slot.lock);
+        memcpy(out, &process_slot.data, sizeof(*out));
+    } while (seqlock_read_retry(&process_slot.lock, seq));
+}
+
+void collector_read_a2s(a2s_snapshot_t *out) {
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&a2s_slot.lock);
+        memcpy(out, &a2s_slot.data, sizeof(*out));
+    } while (seqlock_read_retry(&a2s_slot.lock, seq));
+}
+
+void collector_read_log(log_snapshot_t *out) {
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&log_slot.lock);
+        memcpy(out, &log_slot.data, sizeof(*out));
+    } while (seqlock_read_retry(&log_slot.lock, seq));
+}
+
+void collector_read(emon_snapshot_t *out) {
+    collector_read_system(&out->system);
+    collector_read_process(&out->process);
+    collector_read_a2s(&out->a2s);
+    collector_read_log(&out->log);
+}
+
+void collector_read_fleet(fleet_snapshot_t *out) {
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&fleet_slot.lock);
+        memcpy(out, &fleet_slot.data, sizeof(*out));
+    } while (seqlock_read_retry(&fleet_slot.lock, seq));
+}
+
+uint64_t collector_fleet_sequence(void) {
+    unsigned int seq;
+    uint64_t sequence;
+    do {
+        seq = seqlock_read_begin(&fleet_slot.lock);
+        sequence = fleet_slot.data.sequence;
+    } while (seqlock_read_retry(&fleet_slot.lock, seq));
+    return sequence;
+}
+
+int collector_wake_fd(void) {
+    return wake_fd;
+}
+
+void collector_ack_wake(void) {
+    uint64_t count;
+    if (read(wake_fd, &count, sizeof(count)) < 0) {
+        // EAGAIN: nothing pending
+    }
+}
+
+static void run_system_task(collect_task_t task, system_snapshot_t *snapshot) {
+    switch (task) {
+    case COLLECT_CPU:
+        system_monitor_get_cpu(&snapshot->stats);
+        break;
+    case COLLECT_MEMORY:
+        snapshot->ok = (system_monitor_get_memory(&snapshot->stats) == 0);
+        // Older kernels lack some counters; not fatal
+        system_monitor_get_vmstat(&snapshot->stats);
+        break;
+    case COLLECT_PSI:
+        psi_monitor_get_stats(&snapshot->psi);
+        break;
+    case COLLECT_CGROUP:
+        cgroup_monitor_get_stats(&snapshot->cgroup);
+        break;
+    case COLLECT_DISK:
+        disk_monitor_get_stats(&snapshot->disk);
+        break;
+    case COLLECT_SENSORS:
+        hw_monitor_get_stats(&snapshot->hw);
+        break;
+    default:
+        break;
+    }
+}
+
+// Inside a container with its own cgroup namespace, emon's cgroup is the
+// namespace root, i.e. the cgroup2 mount itself
+static int is_namespace_root(const char *dir) {
+    return strcmp(dir, "/sys/fs/cgroup") == 0 || strcmp(dir, "/sys/fs/cgroup/unified") == 0;
+}
+
+// Owns system, PSI, cgroup, disk and hardware collectors, each on its own
+// interval; a pass runs whichever tasks are due and publishes once
+static void *system_worker(void *arg) {
+    (void)arg;
+    static system_snapshot_t snapshot;
+    static process_snapshot_t processes;
+    pid_t cgroup_target_pid = 0;
+    pid_t disk_target_pid = 0;
+
+    // Sleep on PSI triggers too so a stall is sampled immediately
+    struct pollfd fds[SLEEP_FDS + PSI_MAX_TRIGGERS];
+    int trigger_count = psi_monitor_trigger_fds(&fds[SLEEP_FDS], PSI_MAX_TRIGGERS);
+
+    uint64_t due[SYSTEM_TASK_COUNT];
+    uint64_t period[SYSTEM_TASK_COUNT];
+    uint64_t start = monotonic_ns();
+    for (int t = 0; t < SYSTEM_TASK_COUNT; t++) {
+        due[t] = start;
+        period[t] = interval_ns((collect_task_t)t);
+    }
+
+    int run_all = 0;
+    for (;;) {
+        // Follow the primary server's cgroup; without a local server fall
+        // back to our own, but only when it is the container's
+        collector_read_process(&processes);
+        int server_found = processes.primary >= 0;
+        pid_t server_pid = server_found ? processes.instances[processes.primary].pid : 0;
+
+        pid_t cgroup_pid = server_found ? server_pid : getpid();
+        if (cgroup_pid != cgroup_target_pid) {
+            char cgroup_dir[MAX_CGROUP_PATH];
+            int have_dir = (process_get_cgroup_dir(cgroup_pid, cgroup_dir, sizeof(cgroup_dir)) == 0);
+            if (have_dir && !server_found && !is_namespace_root(cgroup_dir)) {
+                have_dir = 0; // A host login or service scope, not the server's
+            }
+            cgroup_monitor_set_dir(have_dir ? cgroup_dir : NULL);
+            psi_monitor_set_cgroup(have_dir && server_found ? cgroup_dir : NULL);
+            cgroup_target_pid = cgroup_pid;
+        }
+
+        // Saves land under the server's working directory
+        if (server_pid != disk_target_pid) {
+            char cwd_path[64];
+            snprintf(cwd_path, sizeof(cwd_path), "/proc/%d/cwd", server_pid);
+            disk_monitor_set_path(server_pid ? cwd_path : NULL);
+            disk_target_pid = server_pid;
+        }
+
+        selfstats_span_t span;
+        selfstats_begin(&span);
+        start = monotonic_ns();
+        for (int t = 0; t < SYSTEM_TASK_COUNT; t++) {
+            if (due[t] <= start) {
+                run_system_task((collect_task_t)t, &snapshot);
+                due[t] = next_deadline(due[t], period[t]);
+            } else if (run_all) {
+                run_system_task((collect_task_t)t, &snapshot);
+            }
+        }
+        selfstats_end(SELFSTATS_SYSTEM, &span);
+        snapshot.collected_ns = monotonic_ns();
+        snapshot.duration_ns = snapshot.collected_ns - start;
+        snapshot.sequence++;
+        publish_system(&snapshot);
+
+        run_all = 0;
+        int woke;
+        for (;;) {
+            uint64_t deadline = due[0];
+            for (int t = 1; t < SYSTEM_TASK_COUNT; t++) {
+                deadline = (due[t] < deadline) ? due[t] : deadline;
+            }
+
+            woke = sleep_until(deadline, WORKER_SYSTEM, fds, trigger_count);
+            if (woke == SLEEP_RELOAD) {
+                for (int t = 0; t < SYSTEM_TASK_COUNT; t++) {
+                    uint64_t next = interval_ns((collect_task_t)t);
+                    due[t] = reschedule(due[t], period[t], next);
+                    period[t] = next;
+                }
+            } else if (woke != SLEEP_EVENT || psi_monitor_check_triggers(&fds[SLEEP_FDS], trigger_count)) {
+                break;
+            }
+        }
+        if (woke < 0) {
+            break;
+        }
+        // A PSI stall resamples everything now and keeps the schedule
+        run_all = (woke == SLEEP_EVENT);
+    }
+
+    return NULL;
+}
+
+// Scans /proc for local server instances
+static void *process_worker(void *arg) {
+    (void)arg;
+    static process_snapshot_t snapshot;
+    struct pollfd fds[SLEEP_FDS];
+
+    uint64_t period = interval_ns(COLLECT_PROCESS);
+    uint64_t deadline = monotonic_ns();
+    for (;;) {
+        selfstats_span_t span;
+        selfstats_begin(&span);
+        uint64_t start = monotonic_ns();
+        int count = process_find_all_by_name("EnshroudedServer", snapshot.instances,
+                                             MAX_SERVER_INSTANCES);
+        selfstats_end(SELFSTATS_PROCESS, &span);
+        snapshot.instance_count = (count < 0) ? 0 : count;
+
+        // Host process list, only while the view is open
+        if (atomic_load_explicit(&top_enabled, memory_order_relaxed)) {
+            selfstats_begin(&span);
+            if (top_monitor_update(&snapshot.top) < 0) {
+                snapshot.top.samples = 0;
+            }
+            selfstats_end(SELFSTATS_TOP, &span);
+        } else if (snapshot.top.samples) {
+            top_monitor_cleanup();
+            snapshot.top.samples = 0;
+        }
+
+        // The instance answering on the configured port is the primary one
+        snapshot.primary = (snapshot.instance_count > 0) ? 0 : -1;
+        for (int i = 0; i < snapshot.instance_count; i++) {
+            if (snapshot.instances[i].query_port == config.query_port) {
+                snapshot.primary = i;
+                break;
+            }
+        }
+
+        snapshot.collected_ns = monotonic_ns();
+        snapshot.duration_ns = snapshot.collected_ns - start;
+        snapshot.sequence++;
+        publish_process(&snapshot);
+
+        deadline = next_deadline(deadline, period);
+        int woke;
+        while ((woke = sleep_until(deadline, WORKER_PROCESS, fds, 0)) == SLEEP_RELOAD) {
+            uint64_t next = interval_ns(COLLECT_PROCESS);
+            deadline = reschedule(deadline, period, next);
+            period = next;
+        }
+        if (woke < 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+// Queries the configured target and every other local instance
+static void *a2s_worker(void *arg) {
+    (void)arg;
+    static a2s_snapshot_t snapshot;
+    static process_snapshot_t processes;
+    struct pollfd fds[SLEEP_FDS];
+
+    snapshot.available = 1;
+
+    uint64_t period = interval_ns(COLLECT_A2S);
+    uint64_t deadline = monotonic_ns();
+    for (;;) {
+        selfstats_span_t span;
+        selfstats_begin(&span);
+        uint64_t start = monotonic_ns();
+        snapshot.success = (a2s_query_info(&snapshot.info) == 0);
+        snapshot.rtt_ms = snapshot.success ? (monotonic_ns() - start) / 1e6 : 0.0;
+
+        collector_read_process(&processes);
+        snapshot.instance_count = 0;
+        for (int i = 0; i < processes.instance_count; i++) {
+            uint16_t port = processes.instances[i].query_port;
+            if (port == 0 || port == config.query_port) {
+                continue;
+            }
+            int slot = snapshot.instance_count++;
+            snapshot.instance_port[slot] = port;
+            snapshot.instance_ok[slot] = (a2s_query_info_port(port, &snapshot.instance_info[slot]) == 0);
+        }
+        selfstats_end(SELFSTATS_A2S, &span);
+
+        snapshot.collected_ns = monotonic_ns();
+        snapshot.duration_ns = snapshot.collected_ns - start;
+        snapshot.sequence++;
+        publish_a2s(&snapshot);
+
+        deadline = next_deadline(deadline, period);
+        int woke;
+        while ((woke = sleep_until(deadline, WORKER_A2S, fds, 0)) == SLEEP_RELOAD) {
+            uint64_t next = interval_ns(COLLECT_A2S);
+            deadline = reschedule(deadline, period, next);
+            period = next;
+        }
+        if (woke < 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+// Queries every fleet target in one round; stop cuts a round short
+static void *fleet_worker(void *arg) {
+    (void)arg;
+    static fleet_snapshot_t snapshot;
+    struct pollfd fds[SLEEP_FDS];
+
+    snapshot.count = fleet_target_count();
+
+    uint64_t period = interval_ns(COLLECT_FLEET);
+    uint64_t deadline = monotonic_ns();
+    for (;;) {
+        selfstats_span_t span;
+        selfstats_begin(&span);
+        uint64_t start = monotonic_ns();
+        int answered = fleet_query_round(snapshot.results, stop_fd, FLEET_TIMEOUT_MS);
+        selfstats_end(SELFSTATS_FLEET, &span);
+        if (answered < 0) {
+            break;
+        }
+
+        snapshot.answered = answered;
+        snapshot.collected_ns = monotonic_ns();
+        snapshot.duration_ns = snapshot.collected_ns - start;
+        snapshot.sequence++;
+        publish_fleet(&snapshot);
+
+        deadline = next_deadline(deadline, period);
+        int woke;
+        while ((woke = sleep_until(deadline, WORKER_FLEET, fds, 0)) == SLEEP_RELOAD) {
+            uint64_t next = interval_ns(COLLECT_FLEET);
+            deadline = reschedule(deadline, period, next);
+            period = next;
+        }
+        if (woke < 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void copy_line(char *dest, size_t size, const char *line, size_t len) {
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(dest, line, len);
+    dest[len] = '\0';
+}
+
+// Every server log line goes through the event automaton once
+static void on_log_line(const char *line, size_t len, void *ctx) {
+    log_snapshot_t *snapshot = ctx;
+    copy_line(snapshot->last_line, sizeof(snapshot->last_line), line, len);
+
+    uint32_t found = log_events_match(line, len);
+    if (!found) {
+        return;
+    }
+
+    uint64_t now = monotonic_ns();
+    for (int e = 0; e < LOG_EVENT_COUNT; e++) {
+        if (found & LOG_EVENT_BIT(e)) {
+            snapshot->events[e]++;
+            snapshot->event_ns[e] = now;
+        }
+    }
+    if (found & (LOG_EVENT_BIT(LOG_EVENT_JOIN) | LOG_EVENT_BIT(LOG_EVENT_LEAVE))) {
+        log_events_player(line, len, snapshot->last_player, sizeof(snapshot->last_player));
+        snapshot->last_player_event = (found & LOG_EVENT_BIT(LOG_EVENT_JOIN)) ? LOG_EVENT_JOIN
+                                                                             : LOG_EVENT_LEAVE;
+    }
+    if (found & LOG_EVENT_BIT(LOG_EVENT_ERROR)) {
+        copy_line(snapshot->last_error, sizeof(snapshot->last_error), line, len);
+    }
+    if (found & LOG_EVENT_BIT(LOG_EVENT_DISCONNECT)) {
+        copy_line(snapshot->last_disconnect, sizeof(snapshot->last_disconnect), line, len);
+    }
+}
+
+static uint64_t log_event_total(const log_snapshot_t *snapshot) {
+    uint64_t total = 0;
+    for (int e = 0; e < LOG_EVENT_COUNT; e++) {
+        total += snapshot->events[e];
+    }
+    return total;
+}
+
+// Reads the server log whenever it grows, moves or is truncated
+static void *log_worker(void *arg) {
+    (void)arg;
+    static log_snapshot_t snapshot;
+    struct pollfd fds[2] = {
+        { .fd = stop_fd, .events = POLLIN },
+        { .fd = log_watch_fd, .events = POLLIN },
+    };
+
+    snapshot.available = 1;
+    log_tail_stats(&snapshot.tail);
+    snapshot.sequence++;
+    publish_log(&snapshot, 0);
+
+    for (;;) {
+        int ready = poll(fds, 2, -1);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        if (fds[0].revents || (fds[1].revents & POLLNVAL)) {
+            break;
+        }
+
+        selfstats_span_t span;
+        selfstats_begin(&span);
+        uint64_t start = monotonic_ns();
+        uint64_t events_before = log_event_total(&snapshot);
+        if (log_tail_read(on_log_line, &snapshot) < 0) {
+            break;
+        }
+        log_tail_stats(&snapshot.tail);
+        selfstats_end(SELFSTATS_LOG, &span);
+
+        snapshot.collected_ns = monotonic_ns();
+        snapshot.duration_ns = snapshot.collected_ns - start;
+        snapshot.sequence++;
+        publish_log(&snapshot, log_event_total(&snapshot) != events_before);
+    }
+
+    return NULL;
+}
+
+const char *collector_task_name(collect_task_t task) {
+    return (task >= 0 && task < COLLECT_TASK_COUNT) ? tasks[task].name : "unknown";
+}
+
+uint32_t collector_default_interval(collect_task_t task) {
+    return (task >= 0 && task < COLLECT_TASK_COUNT) ? tasks[task].interval_ms : 0;
+}
+
+void collector_set_intervals(const uint32_t *ms) {
+    for (int t = 0; t < COLLECT_TASK_COUNT; t++) {
+        uint32_t value = (ms && ms[t]) ? ms[t] : tasks[t].interval_ms;
+        if (value < COLLECT_MIN_INTERVAL_MS) {
+            value = COLLECT_MIN_INTERVAL_MS;
+        } else if (value > COLLECT_MAX_INTERVAL_MS) {
+            value = COLLECT_MAX_INTERVAL_MS;
+        }
+        atomic_store_explicit(&interval_ms[t], value, memory_order_relaxed);
+    }
+
+    for (int w = 0; w < WORKER_COUNT; w++) {
+        if (reload_fds[w] >= 0) {
+            uint64_t one = 1;
+            if (write(reload_fds[w], &one, sizeof(one)) < 0) {
+                // Already pending
+            }
+        }
+    }
+}
+
+void collector_set_top(int enabled) {
+    atomic_store_explicit(&top_enabled, enabled, memory_order_relaxed);
+}
+
+int collector_is_local_host(const char *host) {
+    return strcmp(host, "localhost") == 0 ||
+           strcmp(host, "127.0.0.1") == 0 ||
+           strcmp(host, "::1") == 0;
+}
+
+int collector_start(const collector_config_t *cfg) {
+    config = *cfg;
+    collector_set_intervals(config.interval_ms);
+
+    if (system_monitor_init() < 0) {
+        return -1;
+    }
+
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int reload_ok = 1;
+    for (int w = 0; w < WORKER_COUNT; w++) {
+        reload_fds[w] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timer_fds[w] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        reload_ok = reload_ok && reload_fds[w] >= 0 && timer_fds[w] >= 0;
+    }
+    if (wake_fd < 0 || stop_fd < 0 || !reload_ok) {
+        collector_stop();
+        return -1;
+    }
+
+    a2s_available = (a2s_query_init(config.query_host, config.query_port) == 0);
+
+    // PSI and hardware sensors are optional (kernel/VM may lack them)
+    psi_monitor_init();
+    hw_monitor_init(NULL);
+
+    // Collectors without a worker publish a final empty snapshot up front
+    process_slot.data.primary = -1;
+    if (config.is_remote) {
+        process_slot.data.sequence = 1;
+    }
+    a2s_slot.data.available = a2s_available;
+    if (!a2s_available) {
+        a2s_slot.data.sequence = 1;
+    }
+
+    threads_started = 0;
+    if (pthread_create(&system_thread, NULL, system_worker, NULL) != 0) {
+        collector_stop();
+        return -1;
+    }
+    threads_started |= 1;
+
+    if (!config.is_remote && pthread_create(&process_thread, NULL, process_worker, NULL) == 0) {
+        threads_started |= 2;
+    }
+    if (a2s_available && pthread_create(&a2s_thread, NULL, a2s_worker, NULL) == 0) {
+        threads_started |= 4;
+    }
+    if (config.fleet && fleet_query_open() == 0 &&
+        pthread_create(&fleet_thread, NULL, fleet_worker, NULL) == 0) {
+        threads_started |= 8;
+    }
+    if (config.log_path && config.log_path[0] && log_events_init() == 0) {
+        log_watch_fd = log_tail_open(config.log_path);
+        if (log_watch_fd >= 0 && pthread_create(&log_thread, NULL, log_worker, NULL) == 0) {
+            threads_started |= 16;
+        }
+    }
+
+    return 0;
+}
+
+void collector_stop(void) {
+    if (stop_fd >= 0) {
+        uint64_t one = 1;
+        if (write(stop_fd, &one, sizeof(one)) < 0) {
+            // Already signalled
+        }
+    }
+
+    // An A2S worker may sit in recvfrom() until its receive timeout
+    if (threads_started & 1) {
+        pthread_join(system_thread, NULL);
+    }
+    if (threads_started & 2) {
+        pthread_join(process_thread, NULL);
+    }
+    if (threads_started & 4) {
+        pthread_join(a2s_thread, NULL);
+    }
+    if (threads_started & 8) {
+        pthread_join(fleet_thread, NULL);
+    }
+    if (threads_started & 16) {
+        pthread_join(log_thread, NULL);
+    }
+    threads_started = 0;
+
+    system_monitor_cleanup();
+    psi_monitor_cleanup();
+    cgroup_monitor_cleanup();
+    disk_monitor_cleanup();
+    hw_monitor_cleanup();
+    a2s_query_cleanup();
+    fleet_query_close();
+    process_monitor_cleanup();
+    top_monitor_cleanup();
+    log_tail_close();
+    log_watch_fd = -1;
+
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+    if (stop_fd >= 0) {
+        close(stop_fd);
+        stop_fd = -1;
+    }
+    for (int w = 0; w < WORKER_COUNT; w++) {
+        if (reload_fds[w] >= 0) {
+            close(reload_fds[w]);
+            reload_fds[w] = -1;
+        }
+        if (timer_fds[w] >= 0) {
+            close(timer_fds[w]);
+            timer_fds[w] = -1;
+        }
+    }
+}
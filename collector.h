@@ -0,0 +1,159 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <stdint.h>
+#include "system_monitor.h"
+#include "psi_monitor.h"
+#include "cgroup_monitor.h"
+#include "disk_monitor.h"
+#include "hw_monitor.h"
+#include "process_monitor.h"
+#include "top_monitor.h"
+#include "a2s_query.h"
+#include "fleet.h"
+#include "log_tail.h"
+#include "log_events.h"
+
+// Sampling tasks, each on its own interval. The system worker runs the
+// host tasks (CPU through sensors); process, A2S and the fleet have a
+// thread each. The server log is read as it grows, not on an interval.
+typedef enum {
+    COLLECT_CPU,
+    COLLECT_MEMORY,                // meminfo and vmstat
+    COLLECT_PSI,
+    COLLECT_CGROUP,
+    COLLECT_DISK,
+    COLLECT_SENSORS,
+    COLLECT_PROCESS,
+    COLLECT_A2S,
+    COLLECT_FLEET,                 // Every target of --targets
+    COLLECT_TASK_COUNT
+} collect_task_t;
+
+#define COLLECT_MIN_INTERVAL_MS 50
+#define COLLECT_MAX_INTERVAL_MS (3600 * 1000)
+
+typedef struct {
+    const char *query_host;
+    uint16_t query_port;
+    int is_remote;                 // Skip local process discovery
+    int fleet;                     // Query the loaded fleet targets
+    const char *log_path;          // Server log to tail, NULL or "" = none
+    uint32_t interval_ms[COLLECT_TASK_COUNT];   // 0 = default
+} collector_config_t;
+
+// Host, cgroup, disk, pressure and sensor readings from one pass
+typedef struct {
+    uint64_t sequence;             // Samples published so far (0 = none yet)
+    uint64_t collected_ns;         // CLOCK_MONOTONIC at the end of the pass
+    uint64_t duration_ns;          // Time the pass took
+    int ok;                        // system_monitor_get_stats() succeeded
+    system_stats_t stats;
+    psi_stats_t psi;
+    cgroup_stats_t cgroup;
+    disk_stats_t disk;
+    hw_stats_t hw;
+} system_snapshot_t;
+
+// Local server instances from one /proc scan
+typedef struct {
+    uint64_t sequence;
+    uint64_t collected_ns;
+    uint64_t duration_ns;
+    int instance_count;
+    int primary;                   // Index answering on query_port, -1 if none
+    process_info_t instances[MAX_SERVER_INSTANCES];
+    top_stats_t top;               // Host process list; samples = 0 while it is off
+} process_snapshot_t;
+
+// A2S answers from one query round
+typedef struct {
+    uint64_t sequence;
+    uint64_t collected_ns;
+    uint64_t duration_ns;
+    int available;                 // a2s_query_init() succeeded
+    int success;                   // Primary target answered
+    double rtt_ms;                 // Round trip of the primary query
+    a2s_info_t info;
+    int instance_count;            // Other local instances queried on their own port
+    uint16_t instance_port[MAX_SERVER_INSTANCES];
+    int instance_ok[MAX_SERVER_INSTANCES];
+    a2s_info_t instance_info[MAX_SERVER_INSTANCES];
+} a2s_snapshot_t;
+
+#define LOG_LAST_LINE 160
+
+// Server log reader state after the latest batch of appended lines
+typedef struct {
+    uint64_t sequence;
+    uint64_t collected_ns;
+    uint64_t duration_ns;
+    int available;                 // log_path is set and its directory can be watched
+    log_tail_stats_t tail;
+    char last_line[LOG_LAST_LINE];
+    uint64_t events[LOG_EVENT_COUNT];          // Lines matching each event since start
+    uint64_t event_ns[LOG_EVENT_COUNT];        // CLOCK_MONOTONIC of the latest, 0 = none
+    char last_player[64];                      // From the latest join or leave
+    log_event_t last_player_event;
+    char last_error[LOG_LAST_LINE];
+    char last_disconnect[LOG_LAST_LINE];
+} log_snapshot_t;
+
+// Every fleet target after one query round. Large, so it is not part of
+// emon_snapshot_t: readers copy it only when the sequence moved.
+typedef struct {
+    uint64_t sequence;
+    uint64_t collected_ns;
+    uint64_t duration_ns;
+    int count;
+    int answered;
+    fleet_result_t results[FLEET_MAX_TARGETS];
+} fleet_snapshot_t;
+
+// Everything the renderer needs for one frame
+typedef struct {
+    system_snapshot_t system;
+    process_snapshot_t process;
+    a2s_snapshot_t a2s;
+    log_snapshot_t log;
+} emon_snapshot_t;
+
+// Config key suffix of a task ("cpu" for INTERVAL_CPU) and its default period
+const char *collector_task_name(collect_task_t task);
+uint32_t collector_default_interval(collect_task_t task);
+
+// Change sampling intervals while running (0 = default); sleeping workers
+// pick the new period up immediately
+void collector_set_intervals(const uint32_t *interval_ms);
+
+// Keep the host process list (top_monitor) up to date on the process
+// worker's interval; off releases its table and descriptors
+void collector_set_top(int enabled);
+
+// Whether host names this machine (local process discovery applies)
+int collector_is_local_host(const char *host);
+
+// Initialize the collectors and start one worker thread per collector
+int collector_start(const collector_config_t *config);
+
+// Stop and join the worker threads, then release collector resources
+void collector_stop(void);
+
+// Copy the latest consistent snapshot of each collector (never blocks writers)
+void collector_read_system(system_snapshot_t *out);
+void collector_read_process(process_snapshot_t *out);
+void collector_read_a2s(a2s_snapshot_t *out);
+void collector_read_log(log_snapshot_t *out);
+void collector_read(emon_snapshot_t *out);
+void collector_read_fleet(fleet_snapshot_t *out);
+
+// Sequence of the latest fleet snapshot, without copying it
+uint64_t collector_fleet_sequence(void);
+
+// Readable (eventfd) whenever any collector has published a new snapshot
+int collector_wake_fd(void);
+
+// Drain the wake descriptor after poll() reported it readable
+void collector_ack_wake(void);
+
+#endif // COLLECTOR_H
@@ -0,0 +1,230 @@
+/*
+ * Config file
+ * KEY=value lines from ~/.config/emon/config or /etc/emon/config. The file
+ * is watched through inotify on its directory so sampling intervals and
+ * alert rules can be changed without restarting (and losing history).
+ */
+
+#define _GNU_SOURCE
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#define MAX_LINE 512
+
+static int watch_fd = -1;
+static char watch_name[256];
+
+const char *config_default_path(void) {
+    static char path[CONFIG_MAX_PATH];
+    const char *home = getenv("HOME");
+    if (home) {
+        snprintf(path, sizeof(path), "%s/.config/emon/config", home);
+        if (access(path, R_OK) == 0) {
+            return path;
+        }
+    }
+    return access("/etc/emon/config", R_OK) == 0 ? "/etc/emon/config" : NULL;
+}
+
+void config_defaults(emon_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->refresh_ms = CONFIG_DEFAULT_REFRESH_MS;
+}
+
+int config_parse_interval(const char *text, uint32_t *ms) {
+    char *end;
+    errno = 0;
+    double v = strtod(text, &end);
+    if (end == text || errno != 0 || !(v > 0)) {
+        return -1;
+    }
+
+    double scale;
+    if (*end == '\0' || strcmp(end, "ms") == 0) {
+        scale = 1;
+    } else if (strcmp(end, "s") == 0) {
+        scale = 1000;
+    } else if (strcmp(end, "m") == 0) {
+        scale = 60 * 1000;
+    } else {
+        return -1;
+    }
+
+    v *= scale;
+    if (v < COLLECT_MIN_INTERVAL_MS || v > COLLECT_MAX_INTERVAL_MS) {
+        return -1;
+    }
+    *ms = (uint32_t)v;
+    return 0;
+}
+
+// INTERVAL_<TASK> (case-insensitive task name), -1 if no such task
+static int interval_task(const char *key) {
+    if (strncmp(key, "INTERVAL_", 9) != 0) {
+        return -1;
+    }
+    for (int t = 0; t < COLLECT_TASK_COUNT; t++) {
+        if (strcasecmp(key + 9, collector_task_name((collect_task_t)t)) == 0) {
+            return t;
+        }
+    }
+    return -1;
+}
+
+// Apply one KEY=value pair, returns -1 with a message on a bad value
+static int apply_setting(emon_config_t *cfg, const char *key, const char *value,
+                         char *error, size_t error_size) {
+    int task;
+
+    if (strcmp(key, "QUERY_HOST") == 0) {
+        snprintf(cfg->query_host, sizeof(cfg->query_host), "%s", value);
+    } else if (strcmp(key, "QUERY_PORT") == 0) {
+        char *end;
+        long port = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || port <= 0 || port > 65535) {
+            snprintf(error, error_size, "invalid QUERY_PORT '%.32s'", value);
+            return -1;
+        }
+        cfg->query_port = (uint16_t)port;
+    } else if (strcmp(key, "LOG_PATH") == 0) {
+        snprintf(cfg->log_path, sizeof(cfg->log_path), "%s", value);
+    } else if (strcmp(key, "REFRESH_INTERVAL") == 0) {
+        if (config_parse_interval(value, &cfg->refresh_ms) < 0) {
+            snprintf(error, error_size, "invalid REFRESH_INTERVAL '%.32s'", value);
+            return -1;
+        }
+    } else if ((task = interval_task(key)) >= 0) {
+        if (config_parse_interval(value, &cfg->interval_ms[task]) < 0) {
+            snprintf(error, error_size, "invalid %.32s '%.32s' (use e.g. 250ms, 5s, 1m; %d ms to 1 h)",
+                     key, value, COLLECT_MIN_INTERVAL_MS);
+            return -1;
+        }
+    } else if (strcmp(key, "ALERT") != 0 && strcmp(key, "RAM_DANGER_THRESHOLD") != 0) {
+        snprintf(error, error_size, "unknown key %.64s", key);
+        return -1;
+    }
+    return 0;
+}
+
+int config_load(const char *path, emon_config_t *cfg, char *error, size_t error_size) {
+    config_defaults(cfg);
+    if (error_size > 0) {
+        error[0] = '\0';
+    }
+    if (!path) {
+        return 0;
+    }
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        snprintf(error, error_size, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    char line[MAX_LINE];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+
+        char *p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '#' || *p == '\0') {
+            continue;
+        }
+
+        char *eq = strchr(p, '=');
+        if (!eq) {
+            if (error_size > 0 && error[0] == '\0') {
+                snprintf(error, error_size, "%s:%d: expected KEY=value", path, line_no);
+            }
+            continue;
+        }
+
+        // Trim the key and the value
+        char *key_end = eq;
+        while (key_end > p && isspace((unsigned char)key_end[-1])) {
+            key_end--;
+        }
+        *key_end = '\0';
+        char *value = eq + 1;
+        while (isspace((unsigned char)*value)) {
+            value++;
+        }
+        size_t len = strlen(value);
+        while (len > 0 && isspace((unsigned char)value[len - 1])) {
+            value[--len] = '\0';
+        }
+
+        char message[160];
+        if (apply_setting(cfg, p, value, message, sizeof(message)) < 0 &&
+            error_size > 0 && error[0] == '\0') {
+            snprintf(error, error_size, "%s:%d: %s", path, line_no, message);
+        }
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+int config_watch(const char *path) {
+    config_unwatch();
+
+    char dir[CONFIG_MAX_PATH];
+    const char *slash = strrchr(path, '/');
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+        if (dir[0] == '\0') {
+            snprintf(dir, sizeof(dir), "/");
+        }
+    } else {
+        snprintf(dir, sizeof(dir), ".");
+    }
+    snprintf(watch_name, sizeof(watch_name), "%s", slash ? slash + 1 : path);
+
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch_fd < 0) {
+        return -1;
+    }
+    if (inotify_add_watch(watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        config_unwatch();
+        return -1;
+    }
+    return watch_fd;
+}
+
+int config_changed(void) {
+    if (watch_fd < 0) {
+        return 0;
+    }
+
+    // One reload per batch: an editor's write + rename arrives together
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int changed = 0;
+    ssize_t len;
+    while ((len = read(watch_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0 && strcmp(event->name, watch_name) == 0) {
+                changed = 1;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+void config_unwatch(void) {
+    if (watch_fd >= 0) {
+        close(watch_fd);
+        watch_fd = -1;
+    }
+}
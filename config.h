@@ -0,0 +1,46 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "collector.h"
+
+#define CONFIG_MAX_HOST 256
+#define CONFIG_MAX_PATH 512
+#define CONFIG_DEFAULT_REFRESH_MS 1000
+
+// Settings from KEY=value lines. ALERT= and RAM_DANGER_THRESHOLD= belong to
+// alerts_load(), which reads the same file.
+typedef struct {
+    char query_host[CONFIG_MAX_HOST];          // "" = not set
+    uint16_t query_port;                       // 0 = not set
+    char log_path[CONFIG_MAX_PATH];            // "" = not set
+    uint32_t refresh_ms;                       // Longest gap between UI redraws
+    uint32_t interval_ms[COLLECT_TASK_COUNT];  // INTERVAL_<TASK>=, 0 = default
+} emon_config_t;
+
+// First of ~/.config/emon/config and /etc/emon/config that exists, or NULL
+const char *config_default_path(void);
+
+// Reset to built-in defaults
+void config_defaults(emon_config_t *cfg);
+
+// Defaults, then the file at path (NULL = defaults only). Bad lines are
+// skipped; the first one is described in error. Returns -1 if the file
+// cannot be read.
+int config_load(const char *path, emon_config_t *cfg, char *error, size_t error_size);
+
+// Parse "250ms", "5s", "2m" or a bare number of milliseconds
+int config_parse_interval(const char *text, uint32_t *ms);
+
+// Watch path for edits (inotify on its directory, so editors that save by
+// renaming are seen too). Returns a descriptor for poll(), or -1.
+int config_watch(const char *path);
+
+// Drain the watch descriptor; returns 1 if the config file changed
+int config_changed(void);
+
+// Stop watching
+void config_unwatch(void);
+
+#endif // CONFIG_H
@@ -0,0 +1,296 @@
+/*
+ * Block device throughput and latency for the server's save volume
+ * Resolves the device behind a path via /proc/self/mountinfo, then samples
+ * its /proc/diskstats line each tick.
+ */
+
+#define _GNU_SOURCE
+#include "disk_monitor.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#define DISKSTATS_BUFFER_SIZE 32768
+#define SECTOR_SIZE 512
+
+static int diskstats_fd = -1;
+static char diskstats_buffer[DISKSTATS_BUFFER_SIZE];
+
+static int device_valid = 0;
+static char device_name[MAX_DEVICE_NAME];
+static char device_mount[MAX_MOUNT_PATH];
+static unsigned int device_major = 0;
+static unsigned int device_minor = 0;
+static int match_by_name = 0;
+
+static disk_counters_t prev_counters;
+static struct timespec prev_sample_time = {0};
+
+// mountinfo writes space, tab, newline and backslash in paths as \ooo
+static void unescape_octal(char *s) {
+    char *out = s;
+    for (char *p = s; *p; p++) {
+        if (p[0] == '\\' && p[1] >= '0' && p[1] <= '3' && p[2] >= '0' && p[2] <= '7' &&
+            p[3] >= '0' && p[3] <= '7') {
+            *out++ = (char)((p[1] - '0') << 6 | (p[2] - '0') << 3 | (p[3] - '0'));
+            p += 3;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+}
+
+int disk_parse_mountinfo(const char *buf, unsigned int major, unsigned int minor,
+                         char *source, size_t source_size,
+                         char *mount_point, size_t mount_size) {
+    const char *line = buf;
+
+    while (line && *line) {
+        // id parent major:minor root mount_point options ... - fstype source superopts
+        unsigned int maj, min;
+        char mnt[MAX_MOUNT_PATH];
+        if (sscanf(line, "%*u %*u %u:%u %*s %255s", &maj, &min, mnt) == 3 &&
+            maj == major && min == minor) {
+            const char *sep = strstr(line, " - ");
+            char src[256] = "";
+            if (sep) {
+                sscanf(sep + 3, "%*s %255s", src);
+            }
+            unescape_octal(src);
+            unescape_octal(mnt);
+            snprintf(source, source_size, "%s", src);
+            snprintf(mount_point, mount_size, "%s", mnt);
+            return 0;
+        }
+
+        line = strchr(line, '\n');
+        if (line) {
+            line++;
+        }
+    }
+
+    return -1;
+}
+
+// Parse an unsigned decimal, skipping leading blanks
+static const char *parse_u64(const char *p, const char *end, uint64_t *value) {
+    while (p < end && *p == ' ') {
+        p++;
+    }
+
+    uint64_t v = 0;
+    const char *start = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+
+    *value = v;
+    return (p == start) ? NULL : p;
+}
+
+int disk_parse_diskstats(const char *buf, size_t len, const char *name,
+                         unsigned int major, unsigned int minor,
+                         disk_counters_t *counters) {
+    const char *p = buf;
+    const char *end = buf + len;
+    size_t name_len = name ? strlen(name) : 0;
+
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) {
+            line_end = end;
+        }
+
+        uint64_t maj, min;
+        const char *q = parse_u64(p, line_end, &maj);
+        q = q ? parse_u64(q, line_end, &min) : NULL;
+        if (!q) {
+            p = line_end + 1;
+            continue;
+        }
+
+        while (q < line_end && *q == ' ') {
+            q++;
+        }
+        const char *dev = q;
+        while (q < line_end && *q != ' ') {
+            q++;
+        }
+
+        int match = name ? ((size_t)(q - dev) == name_len && memcmp(dev, name, name_len) == 0)
+                         : (maj == major && min == minor);
+        if (!match) {
+            p = line_end + 1;
+            continue;
+        }
+
+        // reads merged sectors ms writes merged sectors ms in_flight io_ms weighted_ms
+        uint64_t fields[11];
+        for (int i = 0; i < 11; i++) {
+            q = parse_u64(q, line_end, &fields[i]);
+            if (!q) {
+                return -1;
+            }
+        }
+
+        counters->reads = fields[0];
+        counters->sectors_read = fields[2];
+        counters->read_ms = fields[3];
+        counters->writes = fields[4];
+        counters->sectors_written = fields[6];
+        counters->write_ms = fields[7];
+        counters->in_flight = fields[8];
+        counters->io_ms = fields[9];
+        counters->weighted_io_ms = fields[10];
+        return 0;
+    }
+
+    return -1;
+}
+
+static int read_diskstats(disk_counters_t *counters) {
+    if (diskstats_fd < 0) {
+        selfstats_count_open();
+        diskstats_fd = open("/proc/diskstats", O_RDONLY | O_CLOEXEC);
+        if (diskstats_fd < 0) {
+            return -1;
+        }
+    }
+
+    ssize_t len = pread(diskstats_fd, diskstats_buffer, sizeof(diskstats_buffer), 0);
+    if (len <= 0) {
+        return -1;
+    }
+
+    return disk_parse_diskstats(diskstats_buffer, (size_t)len,
+                                match_by_name ? device_name : NULL,
+                                device_major, device_minor, counters);
+}
+
+int disk_monitor_set_path(const char *path) {
+    device_valid = 0;
+    device_name[0] = '\0';
+    device_mount[0] = '\0';
+    prev_sample_time.tv_sec = 0;
+    prev_sample_time.tv_nsec = 0;
+
+    if (!path) {
+        return 0;
+    }
+
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        return -1;
+    }
+    device_major = major(st.st_dev);
+    device_minor = minor(st.st_dev);
+    match_by_name = 0;
+
+    // Filesystems like btrfs report an anonymous st_dev; the mount's source
+    // names the real block device
+    selfstats_count_open();
+    FILE *fp = fopen("/proc/self/mountinfo", "r");
+    if (fp) {
+        // Line by line: container hosts have mount tables far beyond any
+        // fixed buffer
+        char *line = NULL;
+        size_t line_size = 0;
+        char source[256];
+        int found = 0;
+        while (!found && getline(&line, &line_size, fp) > 0) {
+            found = disk_parse_mountinfo(line, device_major, device_minor,
+                                         source, sizeof(source),
+                                         device_mount, sizeof(device_mount)) == 0;
+        }
+        free(line);
+        fclose(fp);
+
+        if (found && strncmp(source, "/dev/", 5) == 0) {
+            // Resolve /dev/mapper/x and /dev/disk/by-* symlinks to dm-N / sdXN
+            char resolved[PATH_MAX];
+            const char *dev = realpath(source, resolved) ? resolved : source;
+            const char *base = strrchr(dev, '/');
+            snprintf(device_name, sizeof(device_name), "%.*s", MAX_DEVICE_NAME - 1,
+                     base ? base + 1 : dev);
+            match_by_name = 1;
+        }
+    }
+
+    disk_counters_t counters;
+    if (read_diskstats(&counters) < 0) {
+        return -1; // Not a block device (tmpfs, overlay without source, NFS)
+    }
+
+    if (!match_by_name) {
+        snprintf(device_name, sizeof(device_name), "%u:%u", device_major, device_minor);
+    }
+
+    device_valid = 1;
+    return 0;
+}
+
+int disk_monitor_get_stats(disk_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    if (!device_valid) {
+        return -1;
+    }
+
+    disk_counters_t curr;
+    if (read_diskstats(&curr) < 0) {
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - prev_sample_time.tv_sec) +
+                     (now.tv_nsec - prev_sample_time.tv_nsec) / 1e9;
+
+    stats->available = 1;
+    snprintf(stats->device, sizeof(stats->device), "%s", device_name);
+    snprintf(stats->mount_point, sizeof(stats->mount_point), "%s", device_mount);
+    stats->in_flight = curr.in_flight;
+
+    if (prev_sample_time.tv_sec != 0 && elapsed > 0.0) {
+        uint64_t reads = curr.reads - prev_counters.reads;
+        uint64_t writes = curr.writes - prev_counters.writes;
+        uint64_t wait_ms = (curr.read_ms - prev_counters.read_ms) +
+                           (curr.write_ms - prev_counters.write_ms);
+
+        stats->read_iops = reads / elapsed;
+        stats->write_iops = writes / elapsed;
+        stats->read_bytes_per_sec =
+            (double)(curr.sectors_read - prev_counters.sectors_read) * SECTOR_SIZE / elapsed;
+        stats->write_bytes_per_sec =
+            (double)(curr.sectors_written - prev_counters.sectors_written) * SECTOR_SIZE / elapsed;
+        stats->await_ms = (reads + writes) ? (double)wait_ms / (reads + writes) : 0.0;
+        stats->util_percent = 100.0 * (curr.io_ms - prev_counters.io_ms) / (elapsed * 1000.0);
+        if (stats->util_percent > 100.0) {
+            stats->util_percent = 100.0;
+        }
+        stats->queue_depth = (curr.weighted_io_ms - prev_counters.weighted_io_ms) /
+                             (elapsed * 1000.0);
+    }
+
+    prev_counters = curr;
+    prev_sample_time = now;
+    return 0;
+}
+
+void disk_monitor_cleanup(void) {
+    disk_monitor_set_path(NULL);
+
+    if (diskstats_fd >= 0) {
+        close(diskstats_fd);
+        diskstats_fd = -1;
+    }
+}
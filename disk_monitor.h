@@ -0,0 +1,58 @@
+#ifndef DISK_MONITOR_H
+#define DISK_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MAX_DEVICE_NAME 32
+#define MAX_MOUNT_PATH 256
+
+// Raw counters from one /proc/diskstats line
+typedef struct {
+    uint64_t reads;
+    uint64_t sectors_read;
+    uint64_t read_ms;
+    uint64_t writes;
+    uint64_t sectors_written;
+    uint64_t write_ms;
+    uint64_t in_flight;
+    uint64_t io_ms;            // Time the device had I/O in progress
+    uint64_t weighted_io_ms;   // Queue-time integral
+} disk_counters_t;
+
+typedef struct {
+    int available;
+    char device[MAX_DEVICE_NAME];
+    char mount_point[MAX_MOUNT_PATH];
+    double read_iops;
+    double write_iops;
+    double read_bytes_per_sec;
+    double write_bytes_per_sec;
+    double await_ms;           // Average time per completed request
+    double util_percent;       // Share of time the device was busy
+    double queue_depth;        // Average requests in flight (aqu-sz)
+    uint64_t in_flight;        // Requests in flight right now
+} disk_stats_t;
+
+// Follow the block device backing path (e.g. "/proc/<pid>/cwd"), NULL to stop
+int disk_monitor_set_path(const char *path);
+
+// Sample /proc/diskstats for the followed device
+int disk_monitor_get_stats(disk_stats_t *stats);
+
+// Find the mount for major:minor in /proc/self/mountinfo contents (one or
+// more lines); \040-style escapes in source and mount_point are decoded
+int disk_parse_mountinfo(const char *buf, unsigned int major, unsigned int minor,
+                         char *source, size_t source_size,
+                         char *mount_point, size_t mount_size);
+
+// Find a device's counters in /proc/diskstats contents, by name or by
+// major:minor when name is NULL
+int disk_parse_diskstats(const char *buf, size_t len, const char *name,
+                         unsigned int major, unsigned int minor,
+                         disk_counters_t *counters);
+
+// Cleanup disk monitoring resources
+void disk_monitor_cleanup(void);
+
+#endif // DISK_MONITOR_H
@@ -0,0 +1,413 @@
+/*
+ * Prometheus exporter
+ * A tiny HTTP/1.1 responder for headless mode. The complete /metrics
+ * response (status line, headers and body) is rendered once per collection
+ * cycle into one of two buffers; a scrape is a single send() of those bytes,
+ * however many scrapers there are. Clients are served from the caller's
+ * poll() loop, never blocking it.
+ */
+
+#define _GNU_SOURCE
+#include "exporter.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define REQUEST_MAX 2048
+#define HEADER_RESERVE 256      // Room in front of the body for the HTTP header
+#define REQUEST_TIMEOUT_MS 5000 // Longest wait for a complete request header
+
+typedef struct {
+    int fd;                     // -1 when the slot is free
+    char request[REQUEST_MAX];
+    size_t request_len;
+    int64_t accepted_ms;        // CLOCK_MONOTONIC, for the request timeout
+    const char *out;            // Response being sent, NULL while reading
+    size_t out_len;
+    size_t out_sent;
+    int buffer;                 // Response buffer in use, -1 for static replies
+} client_t;
+
+static int listen_fd = -1;
+static client_t clients[EXPORTER_MAX_CLIENTS];
+
+// Double-buffered so a slow client can finish the previous cycle's response
+static char responses[2][EXPORTER_BUFFER_SIZE];
+static const char *response_start[2];
+static size_t response_len[2];
+static int current = -1;
+
+static const char not_found[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 10\r\nConnection: close\r\n\r\nNot Found\n";
+
+static const char not_ready[] =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 21\r\nConnection: close\r\n\r\nNo sample yet, retry\n";
+
+static const char bad_request[] =
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 12\r\nConnection: close\r\n\r\nBad Request\n";
+
+static const char index_page[] =
+    "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+    "Content-Length: 28\r\nConnection: close\r\n\r\nemon exporter: see /metrics\n";
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} writer_t;
+
+static void put(writer_t *w, const char *format, ...) {
+    if (w->len >= w->size) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(w->buf + w->len, w->size - w->len, format, args);
+    va_end(args);
+    if (n > 0) {
+        w->len += (size_t)n;
+        if (w->len > w->size) {
+            w->len = w->size; // Truncated; the scrape fails visibly rather than lying
+        }
+    }
+}
+
+// Label values escape backslash, double quote and newline
+static void put_label(writer_t *w, const char *value) {
+    for (const char *p = value; *p && w->len + 2 < w->size; p++) {
+        if (*p == '\\' || *p == '"') {
+            w->buf[w->len++] = '\\';
+            w->buf[w->len++] = *p;
+        } else if (*p == '\n') {
+            w->buf[w->len++] = '\\';
+            w->buf[w->len++] = 'n';
+        } else {
+            w->buf[w->len++] = *p;
+        }
+    }
+}
+
+// One family at a time: Prometheus wants a family's samples contiguous
+static void put_collectors(writer_t *w, const emon_snapshot_t *snap, int runs) {
+    const char *names[] = { "system", "process", "a2s" };
+    uint64_t sequence[] = { snap->system.sequence, snap->process.sequence, snap->a2s.sequence };
+    uint64_t duration[] = { snap->system.duration_ns, snap->process.duration_ns, snap->a2s.duration_ns };
+
+    for (int i = 0; i < 3; i++) {
+        if (!sequence[i]) {
+            continue;
+        }
+        if (runs) {
+            put(w, "emon_collector_runs_total{collector=\"%s\"} %lu\n", names[i],
+                (unsigned long)sequence[i]);
+        } else {
+            put(w, "emon_collector_duration_seconds{collector=\"%s\"} %.9f\n", names[i],
+                duration[i] / 1e9);
+        }
+    }
+}
+
+size_t exporter_format(const emon_snapshot_t *snap, const double *values, char *buf, size_t size) {
+    writer_t w = { buf, size, 0 };
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        if (isnan(values[id])) {
+            continue;
+        }
+        const metric_desc_t *desc = metrics_desc((metric_id_t)id);
+        put(&w, "# HELP emon_%s %s\n# TYPE emon_%s gauge\nemon_%s %.17g\n",
+            desc->name, desc->help, desc->name, desc->name, values[id]);
+    }
+
+    if (snap->a2s.success) {
+        put(&w, "# HELP emon_server_info Primary server identity from A2S_INFO\n"
+                "# TYPE emon_server_info gauge\nemon_server_info{name=\"");
+        put_label(&w, snap->a2s.info.name);
+        put(&w, "\",version=\"");
+        put_label(&w, snap->a2s.info.version);
+        put(&w, "\",status=\"%s\"} 1\n", a2s_status_string(snap->a2s.info.status));
+    }
+
+    put(&w, "# HELP emon_collector_duration_seconds Time the last pass of a collector took\n"
+            "# TYPE emon_collector_duration_seconds gauge\n");
+    put_collectors(&w, snap, 0);
+    put(&w, "# HELP emon_collector_runs_total Passes completed by a collector\n"
+            "# TYPE emon_collector_runs_total counter\n");
+    put_collectors(&w, snap, 1);
+
+    return (w.len < size) ? w.len : size;
+}
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void close_client(client_t *c) {
+    if (c->fd >= 0) {
+        close(c->fd);
+    }
+    c->fd = -1;
+    c->out = NULL;
+    c->buffer = -1;
+}
+
+void exporter_render(const emon_snapshot_t *snap, const double *values) {
+    int target = (current == 0) ? 1 : 0;
+
+    // Anyone still sending the buffer about to be reused is too slow to keep
+    for (int i = 0; i < EXPORTER_MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0 && clients[i].buffer == target) {
+            close_client(&clients[i]);
+        }
+    }
+
+    char *body = responses[target] + HEADER_RESERVE;
+    size_t body_len = exporter_format(snap, values, body, EXPORTER_BUFFER_SIZE - HEADER_RESERVE);
+
+    char header[HEADER_RESERVE];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 200 OK\r\n"
+                              "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                              "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_len);
+    if (header_len < 0 || header_len >= HEADER_RESERVE) {
+        return;
+    }
+
+    // Header goes directly in front of the body so one send() covers both
+    char *start = body - header_len;
+    memcpy(start, header, (size_t)header_len);
+    response_start[target] = start;
+    response_len[target] = (size_t)header_len + body_len;
+    current = target;
+}
+
+int exporter_parse_listen(const char *spec, char *addr, size_t addr_size, uint16_t *port) {
+    const char *colon = strrchr(spec, ':');
+    const char *port_str = colon ? colon + 1 : spec;
+
+    if (colon) {
+        size_t len = (size_t)(colon - spec);
+        if (len == 0 || len >= addr_size) {
+            return -1;
+        }
+        memcpy(addr, spec, len);
+        addr[len] = '\0';
+    } else {
+        snprintf(addr, addr_size, "%s", EXPORTER_DEFAULT_ADDR);
+    }
+
+    char *end;
+    long value = strtol(port_str, &end, 10);
+    if (*port_str == '\0' || *end != '\0' || value <= 0 || value > 65535) {
+        return -1;
+    }
+    *port = (uint16_t)value;
+    return 0;
+}
+
+int exporter_open(const char *addr, uint16_t port) {
+    for (int i = 0; i < EXPORTER_MAX_CLIENTS; i++) {
+        clients[i].fd = -1;
+        clients[i].buffer = -1;
+    }
+    current = -1;
+
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    if (inet_pton(AF_INET, addr, &sa.sin_addr) != 1) {
+        return -1;
+    }
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(listen_fd, (struct sockaddr *)&sa, sizeof(sa)) < 0 ||
+        listen(listen_fd, EXPORTER_MAX_CLIENTS) < 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+int exporter_poll_fds(struct pollfd *fds, int max_fds) {
+    int count = 0;
+    if (listen_fd < 0 || max_fds <= 0) {
+        return 0;
+    }
+
+    fds[count].fd = listen_fd;
+    fds[count].events = POLLIN;
+    fds[count].revents = 0;
+    count++;
+
+    int64_t now_ms = monotonic_ms();
+    for (int i = 0; i < EXPORTER_MAX_CLIENTS && count < max_fds; i++) {
+        if (clients[i].fd < 0) {
+            continue;
+        }
+        // Idle or trickling connections would otherwise hold their slot forever
+        if (!clients[i].out && now_ms - clients[i].accepted_ms > REQUEST_TIMEOUT_MS) {
+            close_client(&clients[i]);
+            continue;
+        }
+        fds[count].fd = clients[i].fd;
+        fds[count].events = clients[i].out ? POLLOUT : POLLIN;
+        fds[count].revents = 0;
+        count++;
+    }
+
+    return count;
+}
+
+static void accept_clients(void) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN or a transient error; poll() will tell us again
+        }
+
+        client_t *slot = NULL;
+        for (int i = 0; i < EXPORTER_MAX_CLIENTS; i++) {
+            if (clients[i].fd < 0) {
+                slot = &clients[i];
+                break;
+            }
+        }
+        if (!slot) {
+            close(fd);
+            continue;
+        }
+
+        slot->fd = fd;
+        slot->request_len = 0;
+        slot->accepted_ms = monotonic_ms();
+        slot->out = NULL;
+        slot->buffer = -1;
+    }
+}
+
+// Send as much of the response as the socket takes, close when done
+static void flush_client(client_t *c) {
+    while (c->out_sent < c->out_len) {
+        ssize_t n = send(c->fd, c->out + c->out_sent, c->out_len - c->out_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        c->out_sent += (size_t)n;
+    }
+    close_client(c);
+}
+
+static void respond(client_t *c, const char *data, size_t len, int buffer) {
+    c->out = data;
+    c->out_len = len;
+    c->out_sent = 0;
+    c->buffer = buffer;
+    flush_client(c);
+}
+
+static void read_request(client_t *c) {
+    ssize_t n = recv(c->fd, c->request + c->request_len,
+                     sizeof(c->request) - 1 - c->request_len, 0);
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return;
+        }
+        close_client(c);
+        return;
+    }
+
+    c->request_len += (size_t)n;
+    c->request[c->request_len] = '\0';
+
+    if (!strstr(c->request, "\r\n\r\n") && !strstr(c->request, "\n\n")) {
+        if (c->request_len >= sizeof(c->request) - 1) {
+            respond(c, bad_request, sizeof(bad_request) - 1, -1);
+        }
+        return;
+    }
+
+    if (strncmp(c->request, "GET /metrics", 12) == 0 &&
+        (c->request[12] == ' ' || c->request[12] == '?')) {
+        if (current < 0) {
+            respond(c, not_ready, sizeof(not_ready) - 1, -1);
+        } else {
+            respond(c, response_start[current], response_len[current], current);
+        }
+    } else if (strncmp(c->request, "GET / ", 6) == 0) {
+        respond(c, index_page, sizeof(index_page) - 1, -1);
+    } else {
+        respond(c, not_found, sizeof(not_found) - 1, -1);
+    }
+}
+
+void exporter_handle(const struct pollfd *fds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!fds[i].revents) {
+            continue;
+        }
+
+        if (fds[i].fd == listen_fd) {
+            accept_clients();
+            continue;
+        }
+
+        for (int c = 0; c < EXPORTER_MAX_CLIENTS; c++) {
+            client_t *client = &clients[c];
+            if (client->fd != fds[i].fd) {
+                continue;
+            }
+            if (fds[i].revents & (POLLERR | POLLNVAL)) {
+                close_client(client);
+            } else if (client->out) {
+                flush_client(client);
+            } else {
+                read_request(client);
+            }
+            break;
+        }
+    }
+}
+
+void exporter_close(void) {
+    for (int i = 0; i < EXPORTER_MAX_CLIENTS; i++) {
+        if (clients[i].fd >= 0) {
+            close_client(&clients[i]);
+        }
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    current = -1;
+}
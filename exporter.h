@@ -0,0 +1,37 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <poll.h>
+#include "collector.h"
+
+#define EXPORTER_DEFAULT_ADDR "127.0.0.1"
+#define EXPORTER_DEFAULT_PORT 9637
+#define EXPORTER_MAX_CLIENTS 16
+#define EXPORTER_BUFFER_SIZE (64 * 1024)
+
+// Listen for HTTP scrapes on addr:port (IPv4 literal)
+int exporter_open(const char *addr, uint16_t port);
+
+// Parse "[addr:]port" into addr (addr_size bytes) and port
+int exporter_parse_listen(const char *spec, char *addr, size_t addr_size, uint16_t *port);
+
+// Render the /metrics response once; every scrape until the next call
+// sends these bytes as they are
+void exporter_render(const emon_snapshot_t *snap, const double *values);
+
+// Render the Prometheus text body alone into buf, returns its length
+size_t exporter_format(const emon_snapshot_t *snap, const double *values, char *buf, size_t size);
+
+// Fill pollfds with the listening socket and active clients, returns how many.
+// Clients that have not sent a full request within a few seconds are closed.
+int exporter_poll_fds(struct pollfd *fds, int max_fds);
+
+// Accept, read and answer whatever poll() reported ready
+void exporter_handle(const struct pollfd *fds, int count);
+
+// Close the listener and all clients
+void exporter_close(void);
+
+#endif // EXPORTER_H
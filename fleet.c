@@ -0,0 +1,509 @@
+/*
+ * Fleet of A2S targets
+ * A targets file lists many servers. One collector thread queries them all
+ * each round over a single non-blocking socket: requests go out in paced
+ * batches and answers are matched back to their target through an address
+ * hash, so a round costs one sendto/recvfrom pair per server however many
+ * there are. The UI keeps a sorted index over the results and re-sorts only
+ * the rows whose sort key changed; it formats just the rows on screen.
+ */
+
+#define _GNU_SOURCE
+#include "fleet.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define MAX_LINE 256
+#define HASH_SLOTS (FLEET_MAX_TARGETS * 2)     // Power of two, at most half full
+#define SEND_BATCH 256
+#define BATCH_GAP_MS 2
+#define RECV_BUFFER_BYTES (1 << 20)
+
+static fleet_target_t targets[FLEET_MAX_TARGETS];
+static int target_count = 0;
+static int hash_slots[HASH_SLOTS];             // Target index + 1, 0 = empty
+
+// Query round state (collector thread)
+static int sockfd = -1;
+static uint64_t sent_ns[FLEET_MAX_TARGETS];    // Latest request, 0 = not sent this round
+static uint8_t answered[FLEET_MAX_TARGETS];
+
+// Sorted table (UI thread)
+static fleet_result_t rows[FLEET_MAX_TARGETS];
+static int order[FLEET_MAX_TARGETS];           // Row position -> target index
+static int moved[FLEET_MAX_TARGETS];
+static uint8_t is_moved[FLEET_MAX_TARGETS];
+static fleet_column_t sort_column = FLEET_COL_TARGET;
+static int sort_descending = 0;
+static int up_count = 0;
+static int down_count = 0;
+
+static const char *column_names[FLEET_COL_COUNT] = {
+    "Target", "Name", "Status", "Players", "Version", "RTT", "Seen"
+};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t addr_hash(const struct sockaddr_in *addr) {
+    uint32_t h = (uint32_t)addr->sin_addr.s_addr ^ ((uint32_t)addr->sin_port * 0x9E3779B1u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h & (HASH_SLOTS - 1);
+}
+
+int fleet_find(const struct sockaddr_in *addr) {
+    for (uint32_t slot = addr_hash(addr);; slot = (slot + 1) & (HASH_SLOTS - 1)) {
+        int index = hash_slots[slot] - 1;
+        if (index < 0) {
+            return -1;
+        }
+        if (targets[index].addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
+            targets[index].addr.sin_port == addr->sin_port) {
+            return index;
+        }
+    }
+}
+
+static void hash_insert(int index) {
+    uint32_t slot = addr_hash(&targets[index].addr);
+    while (hash_slots[slot] != 0) {
+        slot = (slot + 1) & (HASH_SLOTS - 1);
+    }
+    hash_slots[slot] = index + 1;
+}
+
+int fleet_parse_target(const char *text, uint16_t default_port, fleet_target_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->port = default_port;
+
+    const char *colon = strrchr(text, ':');
+    size_t host_len = colon ? (size_t)(colon - text) : strlen(text);
+    if (host_len == 0 || host_len >= sizeof(out->host)) {
+        return -1;
+    }
+    memcpy(out->host, text, host_len);
+
+    if (colon) {
+        char *end;
+        long port = strtol(colon + 1, &end, 10);
+        if (end == colon + 1 || *end != '\0' || port <= 0 || port > 65535) {
+            return -1;
+        }
+        out->port = (uint16_t)port;
+    }
+    if (out->port == 0) {
+        return -1;
+    }
+
+    out->addr.sin_family = AF_INET;
+    out->addr.sin_port = htons(out->port);
+    if (inet_pton(AF_INET, out->host, &out->addr.sin_addr) == 1) {
+        return 0;
+    }
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_DGRAM };
+    struct addrinfo *found = NULL;
+    if (getaddrinfo(out->host, NULL, &hints, &found) != 0 || !found) {
+        return -1;
+    }
+    out->addr.sin_addr = ((const struct sockaddr_in *)found->ai_addr)->sin_addr;
+    freeaddrinfo(found);
+    return 0;
+}
+
+int fleet_load(const char *path, uint16_t default_port, char *error, size_t error_size) {
+    if (error_size > 0) {
+        error[0] = '\0';
+    }
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        snprintf(error, error_size, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    target_count = 0;
+    memset(hash_slots, 0, sizeof(hash_slots));
+
+    char line[MAX_LINE];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+
+        char *p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        size_t len = strlen(p);
+        while (len > 0 && isspace((unsigned char)p[len - 1])) {
+            p[--len] = '\0';
+        }
+        if (*p == '#' || *p == '\0') {
+            continue;
+        }
+
+        const char *problem = NULL;
+        fleet_target_t *target = &targets[target_count];
+        if (target_count == FLEET_MAX_TARGETS) {
+            problem = "too many targets";
+        } else if (fleet_parse_target(p, default_port, target) < 0) {
+            problem = "expected host[:port]";
+        } else if (fleet_find(&target->addr) >= 0) {
+            problem = "duplicate target";
+        }
+        if (problem) {
+            if (error_size > 0 && error[0] == '\0') {
+                snprintf(error, error_size, "%s:%d: %s '%.64s'", path, line_no, problem, p);
+            }
+            continue;
+        }
+        hash_insert(target_count++);
+    }
+    fclose(fp);
+
+    // Fresh table: every target waiting for its first answer
+    memset(rows, 0, sizeof(rows));
+    up_count = 0;
+    down_count = 0;
+    fleet_table_sort(sort_column, sort_descending);
+    return target_count;
+}
+
+int fleet_target_count(void) {
+    return target_count;
+}
+
+const fleet_target_t *fleet_target(int index) {
+    return (index >= 0 && index < target_count) ? &targets[index] : NULL;
+}
+
+int fleet_query_open(void) {
+    if (sockfd >= 0) {
+        return 0;
+    }
+    sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockfd < 0) {
+        return -1;
+    }
+
+    // A whole round of answers can arrive between two drains
+    int size = RECV_BUFFER_BYTES;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+        // Keep the default buffer; a burst may lose a few answers
+    }
+    return 0;
+}
+
+void fleet_query_close(void) {
+    if (sockfd >= 0) {
+        close(sockfd);
+        sockfd = -1;
+    }
+}
+
+static int send_request(int index, const uint8_t *challenge) {
+    uint8_t request[64];
+    size_t len = a2s_build_info_request(challenge, request, sizeof(request));
+
+    selfstats_count_syscalls(1);
+    if (sendto(sockfd, request, len, 0, (const struct sockaddr *)&targets[index].addr,
+               sizeof(targets[index].addr)) < 0) {
+        return -1;
+    }
+    sent_ns[index] = monotonic_ns();
+    return 0;
+}
+
+// Handle every datagram waiting on the socket, returns how many were answers
+static int drain_answers(fleet_result_t *results) {
+    uint8_t buffer[4096];
+    a2s_info_t info;
+    int count = 0;
+
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        selfstats_count_syscalls(1);
+        ssize_t received = recvfrom(sockfd, buffer, sizeof(buffer), 0,
+                                    (struct sockaddr *)&from, &from_len);
+        if (received < 0) {
+            return count;
+        }
+
+        // Strangers, late answers to the previous round and repeats
+        int index = fleet_find(&from);
+        if (index < 0 || sent_ns[index] == 0 || answered[index] || received < 5) {
+            continue;
+        }
+
+        if (buffer[4] == A2S_CHALLENGE_RESPONSE) {
+            if (received >= 9) {
+                send_request(index, &buffer[5]);
+            }
+            continue;
+        }
+        if (a2s_parse_info(buffer, (size_t)received, &info) < 0) {
+            continue;
+        }
+
+        uint64_t now = monotonic_ns();
+        fleet_result_t *r = &results[index];
+        r->status = FLEET_UP;
+        r->players = info.players;
+        r->max_players = info.max_players;
+        r->rtt_ms = (float)((now - sent_ns[index]) / 1e6);
+        r->seen_ns = now;
+        snprintf(r->version, sizeof(r->version), "%s", info.version);
+        snprintf(r->name, sizeof(r->name), "%.*s", (int)sizeof(r->name) - 1, info.name);
+        answered[index] = 1;
+        count++;
+    }
+}
+
+int fleet_query_round(fleet_result_t *results, int cancel_fd, uint32_t timeout_ms) {
+    if (sockfd < 0) {
+        return 0;
+    }
+
+    memset(sent_ns, 0, sizeof(sent_ns[0]) * (size_t)target_count);
+    memset(answered, 0, sizeof(answered[0]) * (size_t)target_count);
+    drain_answers(results);
+
+    struct pollfd fds[2] = {
+        { .fd = sockfd, .events = POLLIN },
+        { .fd = cancel_fd, .events = POLLIN },
+    };
+    int total = 0;
+    int next = 0;
+    uint64_t deadline = 0;
+
+    while (total < target_count) {
+        // Next batch; a full send buffer leaves the rest for the next pass
+        int end = (next + SEND_BATCH < target_count) ? next + SEND_BATCH : target_count;
+        while (next < end) {
+            if (send_request(next, NULL) < 0 && (errno == EAGAIN || errno == ENOBUFS)) {
+                break;
+            }
+            next++;
+        }
+        if (next == target_count && deadline == 0) {
+            deadline = monotonic_ns() + timeout_ms * 1000000ULL;
+        }
+
+        int wait_ms = BATCH_GAP_MS;
+        if (deadline) {
+            uint64_t now = monotonic_ns();
+            if (now >= deadline) {
+                break;
+            }
+            wait_ms = (int)((deadline - now + 999999) / 1000000);
+        }
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        int ready = poll(fds, cancel_fd >= 0 ? 2 : 1, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready > 0 && fds[1].revents) {
+            return -1;
+        }
+        if (ready > 0 && fds[0].revents) {
+            total += drain_answers(results);
+        }
+    }
+
+    for (int i = 0; i < target_count; i++) {
+        if (!answered[i]) {
+            results[i].status = FLEET_DOWN;
+        }
+    }
+    return total;
+}
+
+// Up first, then down, then never queried
+static int status_rank(uint8_t status) {
+    return status == FLEET_UP ? 0 : status == FLEET_DOWN ? 1 : 2;
+}
+
+static int compare_key(int a, int b) {
+    const fleet_result_t *ra = &rows[a];
+    const fleet_result_t *rb = &rows[b];
+    int c = 0;
+
+    switch (sort_column) {
+    case FLEET_COL_TARGET:
+        c = strverscmp(targets[a].host, targets[b].host);
+        if (c == 0) {
+            c = (targets[a].port > targets[b].port) - (targets[a].port < targets[b].port);
+        }
+        break;
+    case FLEET_COL_NAME:
+        c = strcasecmp(ra->name, rb->name);
+        break;
+    case FLEET_COL_STATUS:
+        c = status_rank(ra->status) - status_rank(rb->status);
+        break;
+    case FLEET_COL_PLAYERS:
+        c = (int)ra->players - (int)rb->players;
+        if (c == 0) {
+            c = (int)ra->max_players - (int)rb->max_players;
+        }
+        break;
+    case FLEET_COL_VERSION:
+        c = strverscmp(ra->version, rb->version);
+        break;
+    case FLEET_COL_RTT:
+        c = (ra->rtt_ms > rb->rtt_ms) - (ra->rtt_ms < rb->rtt_ms);
+        break;
+    case FLEET_COL_SEEN:
+        c = (ra->seen_ns > rb->seen_ns) - (ra->seen_ns < rb->seen_ns);
+        break;
+    default:
+        break;
+    }
+    return sort_descending ? -c : c;
+}
+
+// Total order: equal keys keep file order in either direction
+static int compare_rows(int a, int b) {
+    int c = compare_key(a, b);
+    return c ? c : a - b;
+}
+
+static int qsort_rows(const void *a, const void *b) {
+    return compare_rows(*(const int *)a, *(const int *)b);
+}
+
+// Whether the value the table is sorted by differs between two results
+static int key_changed(const fleet_result_t *old, const fleet_result_t *now) {
+    switch (sort_column) {
+    case FLEET_COL_NAME:
+        return strcasecmp(old->name, now->name) != 0;
+    case FLEET_COL_STATUS:
+        return status_rank(old->status) != status_rank(now->status);
+    case FLEET_COL_PLAYERS:
+        return old->players != now->players || old->max_players != now->max_players;
+    case FLEET_COL_VERSION:
+        return strcmp(old->version, now->version) != 0;
+    case FLEET_COL_RTT:
+        return old->rtt_ms != now->rtt_ms;
+    case FLEET_COL_SEEN:
+        return old->seen_ns != now->seen_ns;
+    default:
+        return 0;
+    }
+}
+
+int fleet_table_update(const fleet_result_t *results, int count) {
+    if (count > target_count) {
+        count = target_count;
+    }
+
+    int k = 0;
+    up_count = 0;
+    down_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (key_changed(&rows[i], &results[i])) {
+            moved[k++] = i;
+            is_moved[i] = 1;
+        }
+        rows[i] = results[i];
+        up_count += (rows[i].status == FLEET_UP);
+        down_count += (rows[i].status == FLEET_DOWN);
+    }
+    if (k == 0) {
+        return 0;
+    }
+
+    // Rows that kept their key are still in order among themselves
+    int kept = 0;
+    for (int pos = 0; pos < target_count; pos++) {
+        if (!is_moved[order[pos]]) {
+            order[kept++] = order[pos];
+        }
+    }
+
+    qsort(moved, (size_t)k, sizeof(moved[0]), qsort_rows);
+
+    // Merge from the back so order[] is its own output
+    int i = kept - 1;
+    int j = k - 1;
+    for (int out = target_count - 1; j >= 0; out--) {
+        if (i >= 0 && compare_rows(order[i], moved[j]) > 0) {
+            order[out] = order[i--];
+        } else {
+            order[out] = moved[j--];
+        }
+    }
+
+    for (j = 0; j < k; j++) {
+        is_moved[moved[j]] = 0;
+    }
+    return k;
+}
+
+void fleet_table_sort(fleet_column_t column, int descending) {
+    sort_column = (column >= 0 && column < FLEET_COL_COUNT) ? column : FLEET_COL_TARGET;
+    sort_descending = descending;
+    for (int i = 0; i < target_count; i++) {
+        order[i] = i;
+    }
+    qsort(order, (size_t)target_count, sizeof(order[0]), qsort_rows);
+}
+
+fleet_column_t fleet_table_column(void) {
+    return sort_column;
+}
+
+int fleet_table_descending(void) {
+    return sort_descending;
+}
+
+int fleet_table_rows(void) {
+    return target_count;
+}
+
+int fleet_table_row(int position) {
+    return (position >= 0 && position < target_count) ? order[position] : -1;
+}
+
+const fleet_result_t *fleet_table_result(int index) {
+    return (index >= 0 && index < target_count) ? &rows[index] : NULL;
+}
+
+void fleet_table_counts(int *up, int *down) {
+    *up = up_count;
+    *down = down_count;
+}
+
+const char *fleet_column_name(fleet_column_t column) {
+    return (column >= 0 && column < FLEET_COL_COUNT) ? column_names[column] : "unknown";
+}
+
+const char *fleet_status_name(fleet_status_t status) {
+    switch (status) {
+    case FLEET_UP:
+        return "UP";
+    case FLEET_DOWN:
+        return "DOWN";
+    default:
+        return "...";
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include "a2s_query.h"
+
+#define FLEET_MAX_TARGETS 8192
+#define FLEET_MAX_HOST 64
+#define FLEET_MAX_NAME 64
+#define FLEET_TIMEOUT_MS 2000
+
+// One server from the targets file
+typedef struct {
+    char host[FLEET_MAX_HOST];     // As written, for display
+    uint16_t port;
+    struct sockaddr_in addr;
+} fleet_target_t;
+
+typedef enum {
+    FLEET_WAITING,                 // Not queried yet
+    FLEET_UP,
+    FLEET_DOWN                     // No answer in the last round
+} fleet_status_t;
+
+// Latest answer of one target; a target that stops answering keeps its
+// last values with status FLEET_DOWN
+typedef struct {
+    uint8_t status;                // fleet_status_t
+    uint8_t players;
+    uint8_t max_players;
+    float rtt_ms;
+    uint64_t seen_ns;              // CLOCK_MONOTONIC of the last answer, 0 = never
+    char version[MAX_VERSION_STRING];
+    char name[FLEET_MAX_NAME];
+} fleet_result_t;
+
+typedef enum {
+    FLEET_COL_TARGET,
+    FLEET_COL_NAME,
+    FLEET_COL_STATUS,
+    FLEET_COL_PLAYERS,
+    FLEET_COL_VERSION,
+    FLEET_COL_RTT,
+    FLEET_COL_SEEN,
+    FLEET_COL_COUNT
+} fleet_column_t;
+
+// Targets
+
+// Parse "host[:port]" (IPv4 address or resolvable name) into out
+int fleet_parse_target(const char *text, uint16_t default_port, fleet_target_t *out);
+
+// Load one target per line ('#' comments, blank lines skipped) and clear the
+// table. Bad or duplicate lines are skipped; the first one is described in
+// error. Returns the number of targets, -1 if the file cannot be read.
+int fleet_load(const char *path, uint16_t default_port, char *error, size_t error_size);
+
+int fleet_target_count(void);
+const fleet_target_t *fleet_target(int index);
+
+// Index of the target at addr, -1 if none
+int fleet_find(const struct sockaddr_in *addr);
+
+// Query rounds (collector thread)
+
+// Open the non-blocking socket every round shares
+int fleet_query_open(void);
+
+// Send A2S_INFO to every target in paced batches and collect answers until
+// all have replied or timeout_ms has passed since the last send. results
+// holds the previous round and is updated in place. Returns the number of
+// targets that answered, -1 if cancel_fd became readable.
+int fleet_query_round(fleet_result_t *results, int cancel_fd, uint32_t timeout_ms);
+
+void fleet_query_close(void);
+
+// Sorted table (UI thread)
+
+// Take a new round of results. Only rows whose sort key changed move: they
+// are pulled out, sorted among themselves and merged back, so a round costs
+// O(n + k log k) for k moved rows. Returns k.
+int fleet_table_update(const fleet_result_t *results, int count);
+
+// Sort by column (full sort; ties fall back to file order)
+void fleet_table_sort(fleet_column_t column, int descending);
+
+fleet_column_t fleet_table_column(void);
+int fleet_table_descending(void);
+
+// Rows in the table and the target index shown at a row position
+int fleet_table_rows(void);
+int fleet_table_row(int position);
+
+// Latest result of a target
+const fleet_result_t *fleet_table_result(int index);
+
+// Targets currently up and down
+void fleet_table_counts(int *up, int *down);
+
+const char *fleet_column_name(fleet_column_t column);
+const char *fleet_status_name(fleet_status_t status);
+
+#endif // FLEET_H
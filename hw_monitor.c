@@ -0,0 +1,344 @@
+/*
+ * CPU frequency, thermal sensor and throttle collector
+ * All sysfs files are discovered once and kept open; each sample is a
+ * pread() per file, done at most every HW_SAMPLE_INTERVAL_MS.
+ */
+
+#define _GNU_SOURCE
+#include "hw_monitor.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+
+#define MAX_THROTTLE_FILES (MAX_CPU_CORES + 8)
+
+static char sysfs_root[256] = "/sys";
+
+static int freq_fds[MAX_CPU_CORES];
+static int freq_count = 0;
+static uint32_t freq_limit_mhz = 0;
+
+static int sensor_fds[MAX_THERMAL_SENSORS];
+static char sensor_labels[MAX_THERMAL_SENSORS][MAX_SENSOR_LABEL];
+static int sensor_count = 0;
+
+static int throttle_fds[MAX_THROTTLE_FILES];
+static int throttle_count_files = 0;
+static uint64_t prev_throttle_total = 0;
+static int have_prev_throttle = 0;
+
+static hw_stats_t cached_stats;
+static struct timespec last_sample = {0};
+static int initialized = 0;
+
+// Read an unsigned integer from a cached sysfs descriptor
+static int read_u64_fd(int fd, uint64_t *value) {
+    char buffer[32];
+    ssize_t len = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (len <= 0) {
+        return -1;
+    }
+    buffer[len] = '\0';
+    *value = strtoull(buffer, NULL, 10);
+    return 0;
+}
+
+// Read a one-line text file (labels, names), stripping the newline
+static int read_text_file(const char *path, char *dest, size_t size) {
+    selfstats_count_open();
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return -1;
+    }
+
+    if (!fgets(dest, size, fp)) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    dest[strcspn(dest, "\n")] = '\0';
+    return 0;
+}
+
+static void add_sensor(const char *temp_path, const char *label) {
+    if (sensor_count >= MAX_THERMAL_SENSORS) {
+        return;
+    }
+
+    selfstats_count_open();
+    int fd = open(temp_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    sensor_fds[sensor_count] = fd;
+    snprintf(sensor_labels[sensor_count], MAX_SENSOR_LABEL, "%s", label);
+    sensor_count++;
+}
+
+// Whether cpu is the first of its hyperthread siblings; the core counter
+// is shared by all of them and must only be counted once
+static int first_thread_of_core(int cpu) {
+    char path[640];
+    char siblings[128];
+    snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+             sysfs_root, cpu);
+    if (read_text_file(path, siblings, sizeof(siblings)) < 0) {
+        return 1;
+    }
+    // "0,8" or "0-1": lists are sorted, so the first number is the lowest
+    return atoi(siblings) == cpu;
+}
+
+static void discover_cpufreq(void) {
+    char path[640];
+
+    for (int cpu = 0; cpu < MAX_CPU_CORES; cpu++) {
+        snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
+                 sysfs_root, cpu);
+        selfstats_count_open();
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            // CPUs are numbered densely unless offline; keep the slot
+            snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d", sysfs_root, cpu);
+            if (access(path, F_OK) != 0) {
+                break;
+            }
+        }
+        freq_fds[cpu] = fd;
+        freq_count = cpu + 1;
+
+        // Intel thermal throttle counters, one per physical core
+        if (!first_thread_of_core(cpu)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/thermal_throttle/core_throttle_count",
+                 sysfs_root, cpu);
+        selfstats_count_open();
+        int tfd = open(path, O_RDONLY | O_CLOEXEC);
+        if (tfd >= 0 && throttle_count_files < MAX_THROTTLE_FILES) {
+            throttle_fds[throttle_count_files++] = tfd;
+        } else if (tfd >= 0) {
+            close(tfd);
+        }
+    }
+
+    // Package counter is shared by all CPUs of a package; cpu0 covers the common case
+    snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu0/thermal_throttle/package_throttle_count",
+             sysfs_root);
+    selfstats_count_open();
+    int pfd = open(path, O_RDONLY | O_CLOEXEC);
+    if (pfd >= 0 && throttle_count_files < MAX_THROTTLE_FILES) {
+        throttle_fds[throttle_count_files++] = pfd;
+    } else if (pfd >= 0) {
+        close(pfd);
+    }
+
+    // No cpufreq driver at all (common on VMs): nothing to sample
+    int any = 0;
+    for (int cpu = 0; cpu < freq_count; cpu++) {
+        any |= (freq_fds[cpu] >= 0);
+    }
+    if (!any) {
+        freq_count = 0;
+    }
+
+    snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", sysfs_root);
+    char value[32];
+    if (read_text_file(path, value, sizeof(value)) == 0) {
+        freq_limit_mhz = (uint32_t)(strtoul(value, NULL, 10) / 1000);
+    }
+}
+
+static void discover_thermal_zones(void) {
+    char path[640];
+    snprintf(path, sizeof(path), "%s/class/thermal", sysfs_root);
+
+    selfstats_count_open();
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0) {
+            continue;
+        }
+
+        char type[MAX_SENSOR_LABEL] = "";
+        snprintf(path, sizeof(path), "%s/class/thermal/%s/type", sysfs_root, entry->d_name);
+        if (read_text_file(path, type, sizeof(type)) < 0) {
+            snprintf(type, sizeof(type), "%.*s", MAX_SENSOR_LABEL - 1, entry->d_name);
+        }
+
+        snprintf(path, sizeof(path), "%s/class/thermal/%s/temp", sysfs_root, entry->d_name);
+        add_sensor(path, type);
+    }
+
+    closedir(dir);
+}
+
+static void discover_hwmon(void) {
+    char path[640];
+    snprintf(path, sizeof(path), "%s/class/hwmon", sysfs_root);
+
+    selfstats_count_open();
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "hwmon", 5) != 0) {
+            continue;
+        }
+
+        char chip[MAX_SENSOR_LABEL] = "";
+        snprintf(path, sizeof(path), "%s/class/hwmon/%s/name", sysfs_root, entry->d_name);
+        read_text_file(path, chip, sizeof(chip));
+
+        // temp1_input .. temp8_input; labels like "Package id 0" or "Tctl"
+        for (int i = 1; i <= 8; i++) {
+            char label[MAX_SENSOR_LABEL];
+            snprintf(path, sizeof(path), "%s/class/hwmon/%s/temp%d_label",
+                     sysfs_root, entry->d_name, i);
+            if (read_text_file(path, label, sizeof(label)) < 0) {
+                snprintf(label, sizeof(label), "%.24s", chip[0] ? chip : entry->d_name);
+            }
+
+            snprintf(path, sizeof(path), "%s/class/hwmon/%s/temp%d_input",
+                     sysfs_root, entry->d_name, i);
+            add_sensor(path, label);
+        }
+    }
+
+    closedir(dir);
+}
+
+int hw_monitor_init(const char *root) {
+    if (initialized) {
+        return 0;
+    }
+
+    snprintf(sysfs_root, sizeof(sysfs_root), "%s", root ? root : "/sys");
+    freq_count = 0;
+    sensor_count = 0;
+    throttle_count_files = 0;
+    freq_limit_mhz = 0;
+    prev_throttle_total = 0;
+    have_prev_throttle = 0;
+    last_sample.tv_sec = 0;
+    last_sample.tv_nsec = 0;
+
+    discover_cpufreq();
+    discover_thermal_zones();
+    discover_hwmon();
+
+    initialized = 1;
+    return (freq_count > 0 || sensor_count > 0 || throttle_count_files > 0) ? 0 : -1;
+}
+
+static void sample(hw_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->hottest = -1;
+    stats->freq_limit_mhz = freq_limit_mhz;
+
+    uint64_t sum = 0;
+    int known = 0;
+    for (int i = 0; i < freq_count; i++) {
+        uint64_t khz;
+        if (freq_fds[i] < 0 || read_u64_fd(freq_fds[i], &khz) < 0) {
+            continue;
+        }
+        uint32_t mhz = (uint32_t)(khz / 1000);
+        stats->freq_mhz[i] = mhz;
+        if (known == 0 || mhz < stats->freq_min_mhz) {
+            stats->freq_min_mhz = mhz;
+        }
+        if (mhz > stats->freq_max_mhz) {
+            stats->freq_max_mhz = mhz;
+        }
+        sum += mhz;
+        known++;
+    }
+    stats->cpu_count = freq_count;
+    stats->freq_avg_mhz = known ? (uint32_t)(sum / known) : 0;
+
+    for (int i = 0; i < sensor_count; i++) {
+        uint64_t millideg;
+        thermal_sensor_t *sensor = &stats->sensors[stats->sensor_count];
+        if (read_u64_fd(sensor_fds[i], &millideg) < 0) {
+            continue;
+        }
+        sensor->celsius = millideg / 1000.0f;
+        snprintf(sensor->label, sizeof(sensor->label), "%s", sensor_labels[i]);
+        if (stats->hottest < 0 || sensor->celsius > stats->sensors[stats->hottest].celsius) {
+            stats->hottest = stats->sensor_count;
+        }
+        stats->sensor_count++;
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < throttle_count_files; i++) {
+        uint64_t count;
+        if (read_u64_fd(throttle_fds[i], &count) == 0) {
+            total += count;
+        }
+    }
+    stats->throttle_count = total;
+    stats->throttle_new = (have_prev_throttle && total > prev_throttle_total) ?
+                          total - prev_throttle_total : 0;
+    prev_throttle_total = total;
+    have_prev_throttle = 1;
+}
+
+int hw_monitor_get_stats(hw_stats_t *stats) {
+    if (!initialized) {
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long elapsed_ms = (now.tv_sec - last_sample.tv_sec) * 1000 +
+                      (now.tv_nsec - last_sample.tv_nsec) / 1000000;
+
+    if (last_sample.tv_sec == 0 || elapsed_ms >= HW_SAMPLE_INTERVAL_MS) {
+        sample(&cached_stats);
+        last_sample = now;
+    }
+
+    *stats = cached_stats;
+    return 0;
+}
+
+void hw_monitor_invalidate(void) {
+    last_sample.tv_sec = 0;
+    last_sample.tv_nsec = 0;
+}
+
+void hw_monitor_cleanup(void) {
+    for (int i = 0; i < freq_count; i++) {
+        if (freq_fds[i] >= 0) {
+            close(freq_fds[i]);
+        }
+    }
+    for (int i = 0; i < sensor_count; i++) {
+        close(sensor_fds[i]);
+    }
+    for (int i = 0; i < throttle_count_files; i++) {
+        close(throttle_fds[i]);
+    }
+
+    freq_count = 0;
+    sensor_count = 0;
+    throttle_count_files = 0;
+    initialized = 0;
+}
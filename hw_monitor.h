@@ -0,0 +1,46 @@
+#ifndef HW_MONITOR_H
+#define HW_MONITOR_H
+
+#include <stdint.h>
+#include "system_monitor.h"
+
+// Frequencies and temperatures change slowly; sample them less often than CPU%
+#define HW_SAMPLE_INTERVAL_MS 5000
+
+#define MAX_THERMAL_SENSORS 16
+#define MAX_SENSOR_LABEL 32
+
+typedef struct {
+    char label[MAX_SENSOR_LABEL];
+    float celsius;
+} thermal_sensor_t;
+
+typedef struct {
+    int cpu_count;                        // CPUs with a cpufreq entry
+    uint32_t freq_mhz[MAX_CPU_CORES];     // Current frequency per CPU (0 = unknown)
+    uint32_t freq_min_mhz;                // Lowest / average / highest current frequency
+    uint32_t freq_avg_mhz;
+    uint32_t freq_max_mhz;
+    uint32_t freq_limit_mhz;              // cpuinfo_max_freq of cpu0
+
+    int sensor_count;
+    thermal_sensor_t sensors[MAX_THERMAL_SENSORS];
+    int hottest;                          // Index of the hottest sensor, -1 if none
+
+    uint64_t throttle_count;              // Core + package thermal throttle events
+    uint64_t throttle_new;                // Events since the previous sample
+} hw_stats_t;
+
+// Discover cpufreq, thermal and hwmon files under sysfs_root (NULL = "/sys")
+int hw_monitor_init(const char *sysfs_root);
+
+// Get hardware stats; rereads sysfs at most every HW_SAMPLE_INTERVAL_MS
+int hw_monitor_get_stats(hw_stats_t *stats);
+
+// Force a reread on the next hw_monitor_get_stats() call
+void hw_monitor_invalidate(void);
+
+// Cleanup hardware monitoring resources
+void hw_monitor_cleanup(void);
+
+#endif // HW_MONITOR_H
@@ -0,0 +1,440 @@
+/*
+ * Crash-safe metric journal
+ * Records are fixed 256-byte blocks, each with its own CRC32, written into
+ * preallocated segment files through a shared mapping. Appending is a
+ * memcpy into the page cache: no write() or fsync per sample, and a crash
+ * loses at most the records the kernel had not yet written back. Readers
+ * stop at the first free or torn block.
+ */
+
+#define _GNU_SOURCE
+#include "journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(journal_header_t) == JOURNAL_RECORD_SIZE, "header must fill one block");
+_Static_assert(sizeof(journal_record_t) == JOURNAL_RECORD_SIZE, "record must fill one block");
+
+#define SEGMENT_NAME_FORMAT "emon-%08u.jnl"
+#define MAX_JOURNAL_PATH 512
+
+static const char *event_names[JOURNAL_EVENT_COUNT] = {
+    "started", "server_up", "server_down", "instances_changed", "psi_stall", "oom_kill"
+};
+
+static journal_config_t config;
+static char dir_path[MAX_JOURNAL_PATH];
+static int segment_fd = -1;
+static uint8_t *segment_map = NULL;
+static uint32_t segment_index = 0;
+static size_t slot_count = 0;     // Record blocks per segment, header excluded
+static size_t next_slot = 0;
+static uint64_t next_sequence = 0;
+
+static uint32_t crc_table[256];
+static int crc_ready = 0;
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+    crc_ready = 1;
+}
+
+uint32_t journal_crc32(const void *data, size_t len) {
+    if (!crc_ready) {
+        crc_init();
+    }
+
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+const char *journal_event_name(journal_event_t event) {
+    if ((int)event < 0 || event >= JOURNAL_EVENT_COUNT) {
+        return "unknown";
+    }
+    return event_names[event];
+}
+
+static uint32_t header_crc(const journal_header_t *header) {
+    return journal_crc32(header, offsetof(journal_header_t, crc));
+}
+
+static uint32_t record_crc(const journal_record_t *record) {
+    return journal_crc32((const uint8_t *)record + sizeof(record->crc),
+                         JOURNAL_RECORD_SIZE - sizeof(record->crc));
+}
+
+static int header_valid(const journal_header_t *header) {
+    return memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == JOURNAL_VERSION &&
+           header->record_size == JOURNAL_RECORD_SIZE &&
+           header->crc == header_crc(header);
+}
+
+static int record_valid(const journal_record_t *record) {
+    return record->type != JOURNAL_RECORD_FREE && record->crc == record_crc(record);
+}
+
+static void segment_path(uint32_t index, char *path, size_t size) {
+    snprintf(path, size, "%s/" SEGMENT_NAME_FORMAT, dir_path, index);
+}
+
+static void unmap_segment(void) {
+    if (segment_map) {
+        // Start writeback now so the next segment's pages don't pile up behind it
+        msync(segment_map, config.segment_bytes, MS_ASYNC);
+        munmap(segment_map, config.segment_bytes);
+        segment_map = NULL;
+    }
+    if (segment_fd >= 0) {
+        close(segment_fd);
+        segment_fd = -1;
+    }
+}
+
+// Map a segment read-write; create and preallocate it when create is set
+static int map_segment(uint32_t index, int create) {
+    char path[MAX_JOURNAL_PATH + 32];
+    segment_path(index, path, sizeof(path));
+
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0);
+    int fd = open(path, flags, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (create) {
+        // Reserve the blocks up front: a full disk fails here, not as SIGBUS
+        // on a later store into the mapping
+        if (posix_fallocate(fd, 0, (off_t)config.segment_bytes) != 0) {
+            close(fd);
+            unlink(path);
+            return -1;
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) < 0 || (size_t)st.st_size != config.segment_bytes) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    void *map = mmap(NULL, config.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    segment_fd = fd;
+    segment_map = map;
+    segment_index = index;
+    next_slot = 0;
+    return 0;
+}
+
+static int create_segment(uint32_t index, uint32_t value_count) {
+    if (map_segment(index, 1) < 0) {
+        return -1;
+    }
+
+    journal_header_t *header = (journal_header_t *)segment_map;
+    memcpy(header->magic, JOURNAL_MAGIC, sizeof(header->magic));
+    header->version = JOURNAL_VERSION;
+    header->record_size = JOURNAL_RECORD_SIZE;
+    header->value_count = value_count;
+    header->segment = index;
+    header->created = (int64_t)time(NULL);
+    header->crc = header_crc(header);
+    return 0;
+}
+
+int journal_parse_segment_name(const char *name, uint32_t *index) {
+    unsigned int value;
+    int consumed = 0;
+    if (sscanf(name, "emon-%8u.jnl%n", &value, &consumed) != 1 ||
+        consumed == 0 || name[consumed] != '\0') {
+        return -1;
+    }
+    *index = value;
+    return 0;
+}
+
+// Delete segments beyond the count limit or idle past the age limit,
+// never the one being written. Returns the newest index found (0 if none).
+static uint32_t apply_retention(void) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        return 0;
+    }
+
+    uint32_t newest = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        uint32_t index;
+        if (journal_parse_segment_name(entry->d_name, &index) == 0 && index > newest) {
+            newest = index;
+        }
+    }
+
+    uint32_t keep_from = (newest >= (uint32_t)config.max_segments) ?
+                         newest - (uint32_t)config.max_segments + 1 : 0;
+    time_t now = time(NULL);
+
+    rewinddir(dir);
+    while ((entry = readdir(dir)) != NULL) {
+        uint32_t index;
+        if (journal_parse_segment_name(entry->d_name, &index) < 0 || index == newest ||
+            (segment_map && index == segment_index)) {
+            continue;
+        }
+
+        char path[MAX_JOURNAL_PATH + 32];
+        segment_path(index, path, sizeof(path));
+
+        struct stat st;
+        int expired = (stat(path, &st) == 0 && now - st.st_mtime > config.max_age_seconds);
+        if (index < keep_from || expired) {
+            unlink(path);
+        }
+    }
+
+    closedir(dir);
+    return newest;
+}
+
+// Find the first free or torn block of the mapped segment
+static void resume_segment(void) {
+    const journal_record_t *records = (const journal_record_t *)(segment_map + JOURNAL_RECORD_SIZE);
+    next_slot = 0;
+    while (next_slot < slot_count && record_valid(&records[next_slot])) {
+        next_sequence = records[next_slot].sequence + 1;
+        next_slot++;
+    }
+}
+
+int journal_open(const journal_config_t *cfg) {
+    journal_close();
+
+    config = *cfg;
+    if (config.segment_bytes == 0) {
+        config.segment_bytes = JOURNAL_DEFAULT_SEGMENT_BYTES;
+    }
+    if (config.max_segments <= 0) {
+        config.max_segments = JOURNAL_DEFAULT_MAX_SEGMENTS;
+    }
+    if (config.max_age_seconds <= 0) {
+        config.max_age_seconds = JOURNAL_DEFAULT_MAX_AGE_SECONDS;
+    }
+    config.segment_bytes -= config.segment_bytes % JOURNAL_RECORD_SIZE;
+    if (config.segment_bytes < 2 * JOURNAL_RECORD_SIZE) {
+        return -1;
+    }
+    slot_count = config.segment_bytes / JOURNAL_RECORD_SIZE - 1;
+
+    snprintf(dir_path, sizeof(dir_path), "%s", config.dir);
+    if (mkdir(dir_path, 0755) < 0) {
+        struct stat st;
+        if (stat(dir_path, &st) < 0 || !S_ISDIR(st.st_mode)) {
+            return -1;
+        }
+    }
+    config.dir = dir_path;
+
+    // Continue the newest segment if it is intact and has room
+    next_sequence = 0;
+    uint32_t newest = apply_retention();
+    if (newest > 0 && map_segment(newest, 0) == 0) {
+        if (header_valid((const journal_header_t *)segment_map)) {
+            resume_segment();
+            if (next_slot < slot_count) {
+                return 0;
+            }
+        }
+        unmap_segment();
+    }
+
+    return create_segment(newest + 1, 0);
+}
+
+// Reserve the next block, rotating to a fresh segment when full
+static journal_record_t *next_record(void) {
+    if (!segment_map) {
+        return NULL;
+    }
+
+    if (next_slot >= slot_count) {
+        uint32_t index = segment_index + 1;
+        uint32_t value_count = ((const journal_header_t *)segment_map)->value_count;
+        unmap_segment();
+        if (create_segment(index, value_count) < 0) {
+            return NULL;
+        }
+        apply_retention();
+    }
+
+    journal_record_t *records = (journal_record_t *)(segment_map + JOURNAL_RECORD_SIZE);
+    return &records[next_slot];
+}
+
+// Stamp, checksum and copy a finished record into its block
+static void commit_record(journal_record_t *slot, journal_record_t *record) {
+    record->sequence = next_sequence++;
+    record->crc = record_crc(record);
+    memcpy(slot, record, sizeof(*record));
+    next_slot++;
+}
+
+int journal_append_sample(int64_t time_ms, uint16_t sources, const double *values, int count) {
+    journal_record_t *slot = next_record();
+    if (!slot || count < 0 || count > JOURNAL_MAX_VALUES) {
+        return -1;
+    }
+
+    journal_header_t *header = (journal_header_t *)segment_map;
+    if (header->value_count < (uint32_t)count) {
+        header->value_count = (uint32_t)count;
+        header->crc = header_crc(header);
+    }
+
+    journal_record_t record;
+    record.type = JOURNAL_RECORD_SAMPLE;
+    record.detail = sources;
+    record.time_ms = time_ms;
+    for (int i = 0; i < JOURNAL_MAX_VALUES; i++) {
+        record.values[i] = (i < count) ? (float)values[i] : NAN;
+    }
+
+    commit_record(slot, &record);
+    return 0;
+}
+
+int journal_append_event(int64_t time_ms, journal_event_t event, const char *text) {
+    journal_record_t *slot = next_record();
+    if (!slot) {
+        return -1;
+    }
+
+    journal_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.type = JOURNAL_RECORD_EVENT;
+    record.detail = (uint16_t)event;
+    record.time_ms = time_ms;
+    snprintf(record.text, sizeof(record.text), "%s", text ? text : "");
+
+    commit_record(slot, &record);
+    return 0;
+}
+
+void journal_close(void) {
+    if (segment_map) {
+        // Leaving cleanly: make the tail durable once, off the sampling path
+        msync(segment_map, config.segment_bytes, MS_SYNC);
+    }
+    unmap_segment();
+}
+
+int journal_reader_open(journal_reader_t *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < 2 * JOURNAL_RECORD_SIZE) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    reader->fd = fd;
+    reader->map = map;
+    reader->size = (size_t)st.st_size;
+    reader->header = (const journal_header_t *)reader->map;
+    reader->offset = JOURNAL_RECORD_SIZE;
+
+    if (!header_valid(reader->header)) {
+        journal_reader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+const journal_record_t *journal_reader_next(journal_reader_t *reader) {
+    if (!reader->map || reader->offset + JOURNAL_RECORD_SIZE > reader->size) {
+        return NULL;
+    }
+
+    const journal_record_t *record = (const journal_record_t *)(reader->map + reader->offset);
+    if (!record_valid(record)) {
+        return NULL;
+    }
+
+    reader->offset += JOURNAL_RECORD_SIZE;
+    return record;
+}
+
+static size_t reader_slots(const journal_reader_t *reader) {
+    return reader->map ? reader->size / JOURNAL_RECORD_SIZE - 1 : 0;
+}
+
+static const journal_record_t *reader_slot(const journal_reader_t *reader, size_t index) {
+    return (const journal_record_t *)(reader->map + (index + 1) * JOURNAL_RECORD_SIZE);
+}
+
+size_t journal_reader_count(const journal_reader_t *reader) {
+    // Linear, like resume_segment(): blocks are written in order, but after
+    // a crash mmap writeback may have reached the disk in any order, so
+    // written and free blocks can interleave
+    size_t slots = reader_slots(reader);
+    size_t count = 0;
+    while (count < slots && record_valid(reader_slot(reader, count))) {
+        count++;
+    }
+    return count;
+}
+
+const journal_record_t *journal_reader_at(const journal_reader_t *reader, size_t index) {
+    if (index >= reader_slots(reader)) {
+        return NULL;
+    }
+    const journal_record_t *record = reader_slot(reader, index);
+    return record_valid(record) ? record : NULL;
+}
+
+void journal_reader_close(journal_reader_t *reader) {
+    if (reader->map) {
+        munmap((void *)reader->map, reader->size);
+        reader->map = NULL;
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+}
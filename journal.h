@@ -0,0 +1,114 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Fixed-size records in preallocated, memory-mapped segment files
+#define JOURNAL_RECORD_SIZE 256
+#define JOURNAL_MAX_VALUES 58
+#define JOURNAL_MAX_TEXT (JOURNAL_MAX_VALUES * 4)
+
+// 65535 records per segment: about 18 hours at the one sample per second
+// main.c journals, so the ten kept segments cover the seven-day age limit
+#define JOURNAL_DEFAULT_SEGMENT_BYTES (16u * 1024 * 1024)
+#define JOURNAL_DEFAULT_MAX_SEGMENTS 10
+#define JOURNAL_DEFAULT_MAX_AGE_SECONDS (7 * 24 * 3600)
+
+#define JOURNAL_MAGIC "EMONJRNL"
+#define JOURNAL_VERSION 1
+
+typedef enum {
+    JOURNAL_RECORD_FREE,           // Preallocated, never written: end of data
+    JOURNAL_RECORD_SAMPLE,
+    JOURNAL_RECORD_EVENT
+} journal_record_type_t;
+
+typedef enum {
+    JOURNAL_EVENT_STARTED,
+    JOURNAL_EVENT_SERVER_UP,
+    JOURNAL_EVENT_SERVER_DOWN,
+    JOURNAL_EVENT_INSTANCES_CHANGED,
+    JOURNAL_EVENT_PSI_STALL,
+    JOURNAL_EVENT_OOM_KILL,
+    JOURNAL_EVENT_COUNT
+} journal_event_t;
+
+// First record-sized block of every segment
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t value_count;          // Metrics per sample when the segment was created
+    uint32_t segment;              // Index in the file name
+    int64_t created;               // Unix time
+    uint32_t crc;                  // CRC32 of the fields above
+    uint8_t reserved[JOURNAL_RECORD_SIZE - 36];
+} journal_header_t;
+
+typedef struct {
+    uint32_t crc;                  // CRC32 of everything after this field
+    uint16_t type;                 // journal_record_type_t
+    uint16_t detail;               // Sample: bitmask of refreshed sources; event: journal_event_t
+    uint64_t sequence;             // Journal-wide record number
+    int64_t time_ms;               // Unix time in milliseconds
+    union {
+        float values[JOURNAL_MAX_VALUES];   // Indexed by metric_id_t, NaN if unavailable
+        char text[JOURNAL_MAX_TEXT];        // NUL-terminated event description
+    };
+} journal_record_t;
+
+typedef struct {
+    const char *dir;               // Directory holding emon-NNNNNNNN.jnl segments
+    size_t segment_bytes;          // 0 = JOURNAL_DEFAULT_SEGMENT_BYTES
+    int max_segments;              // Oldest segments beyond this are deleted (0 = default)
+    int64_t max_age_seconds;       // Segments idle longer than this are deleted (0 = default)
+} journal_config_t;
+
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t size;
+    size_t offset;                 // Next record to decode
+    const journal_header_t *header;
+} journal_reader_t;
+
+// Open the journal, resuming after the last intact record of the newest segment
+int journal_open(const journal_config_t *config);
+
+// Append a sample of count values (count <= JOURNAL_MAX_VALUES)
+int journal_append_sample(int64_t time_ms, uint16_t sources, const double *values, int count);
+
+// Append an event with a short description
+int journal_append_event(int64_t time_ms, journal_event_t event, const char *text);
+
+// Flush the current segment and close the journal
+void journal_close(void);
+
+// Map one segment read-only for sequential decoding
+int journal_reader_open(journal_reader_t *reader, const char *path);
+
+// Next intact record (pointer into the mapping), NULL at the end of the data
+const journal_record_t *journal_reader_next(journal_reader_t *reader);
+
+// Number of records before the first free or invalid one, which is where the
+// writer resumes. After a crash, blocks past a lost page are not counted even
+// if they reached the disk.
+size_t journal_reader_count(const journal_reader_t *reader);
+
+// Random access to record index (0-based), NULL past the data or if torn
+const journal_record_t *journal_reader_at(const journal_reader_t *reader, size_t index);
+
+// Unmap the segment
+void journal_reader_close(journal_reader_t *reader);
+
+// Parse a segment file name ("emon-NNNNNNNN.jnl"), returns -1 for other names
+int journal_parse_segment_name(const char *name, uint32_t *index);
+
+// CRC32 (IEEE 802.3) of a buffer
+uint32_t journal_crc32(const void *data, size_t len);
+
+// Name of an event code
+const char *journal_event_name(journal_event_t event);
+
+#endif // JOURNAL_H
@@ -0,0 +1,173 @@
+/*
+ * Server log events
+ * Every pattern of interest is compiled once into an Aho-Corasick automaton,
+ * flattened into a full transition table: failure links are resolved at
+ * build time, so matching a line is one table lookup per byte with no
+ * backtracking, however many patterns there are. Bytes are first mapped to
+ * a small alphabet (the letters the patterns use, folded to lower case;
+ * everything else is one class), which keeps the table a few KB and in L1.
+ * Table entries hold the next row's offset, flagged when that state ends a
+ * pattern, so the per-byte loop is a load, a mask and a rarely taken branch.
+ */
+
+#include "log_events.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_STATES 512
+#define MAX_CLASSES 64
+#define ACCEPTS 0x8000             // Entry flag: the target state ends a pattern
+
+static const struct {
+    const char *pattern;           // Lower case; matched case-insensitively
+    log_event_t event;
+} patterns[] = {
+    { "logged in with permissions", LOG_EVENT_JOIN },
+    { "' joined",                   LOG_EVENT_JOIN },
+    { "remove player '",            LOG_EVENT_LEAVE },
+    { "' logged out",               LOG_EVENT_LEAVE },
+    { "' left the",                 LOG_EVENT_LEAVE },
+    { "world saved",                LOG_EVENT_SAVE },
+    { "saved world",                LOG_EVENT_SAVE },
+    { "savegame saved",             LOG_EVENT_SAVE },
+    { "[error]",                    LOG_EVENT_ERROR },
+    { "error:",                     LOG_EVENT_ERROR },
+    { "exception",                  LOG_EVENT_ERROR },
+    { "fatal",                      LOG_EVENT_ERROR },
+    { "disconnected",               LOG_EVENT_DISCONNECT },
+    { "disconnect reason",          LOG_EVENT_DISCONNECT },
+    { "connection lost",            LOG_EVENT_DISCONNECT },
+    { "timed out",                  LOG_EVENT_DISCONNECT },
+    { "kicked",                     LOG_EVENT_DISCONNECT },
+};
+
+#define PATTERN_COUNT (int)(sizeof(patterns) / sizeof(patterns[0]))
+
+static const char *names[LOG_EVENT_COUNT] = { "join", "leave", "save", "error", "disconnect" };
+
+static int compiled = 0;
+static uint8_t byte_class[256];    // 0 = no pattern uses this byte
+static int class_count;
+static int state_count;
+static uint16_t next_state[MAX_STATES * MAX_CLASSES];   // state * class_count + class
+static uint32_t output[MAX_STATES];                     // Events ending at each state
+static uint16_t table[MAX_STATES * MAX_CLASSES];        // Row offsets, ACCEPTS-flagged
+
+static int fold(int c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+int log_events_init(void) {
+    if (compiled) {
+        return 0;
+    }
+
+    // Alphabet: one class per distinct pattern byte, both cases of a letter share it
+    memset(byte_class, 0, sizeof(byte_class));
+    class_count = 1;
+    for (int p = 0; p < PATTERN_COUNT; p++) {
+        for (const char *c = patterns[p].pattern; *c; c++) {
+            uint8_t b = (uint8_t)fold((unsigned char)*c);
+            if (byte_class[b] == 0) {
+                if (class_count == MAX_CLASSES) {
+                    return -1;
+                }
+                byte_class[b] = (uint8_t)class_count++;
+            }
+        }
+    }
+    for (int c = 'A'; c <= 'Z'; c++) {
+        byte_class[c] = byte_class[c - 'A' + 'a'];
+    }
+
+    // Trie, with 0 standing for "no edge" (the root is never a child)
+    memset(next_state, 0, sizeof(next_state));
+    memset(output, 0, sizeof(output));
+    state_count = 1;
+    for (int p = 0; p < PATTERN_COUNT; p++) {
+        int s = 0;
+        for (const char *c = patterns[p].pattern; *c; c++) {
+            uint16_t *edge = &next_state[s * class_count + byte_class[(unsigned char)*c]];
+            if (*edge == 0) {
+                if (state_count == MAX_STATES) {
+                    return -1;
+                }
+                *edge = (uint16_t)state_count++;
+            }
+            s = *edge;
+        }
+        output[s] |= LOG_EVENT_BIT(patterns[p].event);
+    }
+
+    // Breadth-first: each state inherits the failure state's outputs, and
+    // every missing edge is replaced by the failure state's edge
+    static uint16_t fail[MAX_STATES];
+    static uint16_t queue[MAX_STATES];
+    int head = 0, tail = 0;
+    for (int c = 0; c < class_count; c++) {
+        uint16_t child = next_state[c];
+        if (child) {
+            fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+    while (head < tail) {
+        int s = queue[head++];
+        output[s] |= output[fail[s]];
+        for (int c = 0; c < class_count; c++) {
+            uint16_t *edge = &next_state[s * class_count + c];
+            uint16_t via_fail = next_state[fail[s] * class_count + c];
+            if (*edge) {
+                fail[*edge] = via_fail;
+                queue[tail++] = *edge;
+            } else {
+                *edge = via_fail;
+            }
+        }
+    }
+
+    // Row offsets instead of state numbers take the multiply out of the loop
+    if (state_count * class_count > ACCEPTS) {
+        return -1;
+    }
+    for (int i = 0; i < state_count * class_count; i++) {
+        uint16_t target = next_state[i];
+        table[i] = (uint16_t)(target * class_count) | (output[target] ? ACCEPTS : 0);
+    }
+
+    compiled = 1;
+    return 0;
+}
+
+uint32_t log_events_match(const char *line, size_t len) {
+    const uint8_t *p = (const uint8_t *)line;
+    uint32_t found = 0;
+    unsigned row = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned entry = table[row + byte_class[p[i]]];
+        row = entry & ~ACCEPTS;
+        if (entry & ACCEPTS) {
+            found |= output[row / class_count];
+        }
+    }
+    return found;
+}
+
+int log_events_player(const char *line, size_t len, char *name, size_t size) {
+    const char *open = memchr(line, '\'', len);
+    if (!open) {
+        return -1;
+    }
+    const char *start = open + 1;
+    const char *close = memchr(start, '\'', len - (size_t)(start - line));
+    if (!close || close == start || size == 0) {
+        return -1;
+    }
+    snprintf(name, size, "%.*s", (int)(close - start), start);
+    return 0;
+}
+
+const char *log_event_name(log_event_t event) {
+    return (event >= 0 && event < LOG_EVENT_COUNT) ? names[event] : "unknown";
+}
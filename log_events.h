@@ -0,0 +1,33 @@
+#ifndef LOG_EVENTS_H
+#define LOG_EVENTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum {
+    LOG_EVENT_JOIN,
+    LOG_EVENT_LEAVE,
+    LOG_EVENT_SAVE,                // "World Saved" and friends
+    LOG_EVENT_ERROR,
+    LOG_EVENT_DISCONNECT,          // Disconnect reasons: timeouts, kicks, lost connections
+    LOG_EVENT_COUNT
+} log_event_t;
+
+#define LOG_EVENT_BIT(event) (1u << (event))
+
+// Compile every pattern into one Aho-Corasick automaton. Cheap to call
+// again; returns -1 if the pattern table outgrew the automaton.
+int log_events_init(void);
+
+// LOG_EVENT_BIT() of every event with a pattern somewhere in the line, in
+// one pass over its bytes whatever the number of patterns. Case-insensitive
+// (ASCII).
+uint32_t log_events_match(const char *line, size_t len);
+
+// Player name from a join or leave line: the text inside the first pair of
+// single quotes. Returns -1 if there is none.
+int log_events_player(const char *line, size_t len, char *name, size_t size);
+
+const char *log_event_name(log_event_t event);
+
+#endif // LOG_EVENTS_H
@@ -0,0 +1,314 @@
+/*
+ * Server log tailer
+ * Follows LOG_PATH like tail -F without polling: inotify wakes the reader
+ * on IN_MODIFY and IN_MOVE_SELF only, and each wake preads just the bytes
+ * past the last offset into one reusable buffer. A file that shrank was
+ * truncated in place and is read again from its start; a file moved away
+ * is drained, then the new file at the path is followed from byte 0.
+ * Complete lines are handed to a callback; a partial last line waits in
+ * the buffer for the rest of it. Newlines are located a 64-byte block at a
+ * time as a bitmask (four SSE2 compares), so short log lines do not each
+ * pay for a separate memchr() call.
+ */
+
+#define _GNU_SOURCE
+#include "log_tail.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define MAX_LOG_PATH 512
+
+static int notify_fd = -1;
+static int file_wd = -1;
+static int dir_wd = -1;
+static int log_fd = -1;
+static char log_path[MAX_LOG_PATH];
+static char log_name[256];
+static int reopen_pending = 0;     // Moved away or recreated: switch files after draining
+static int skip_partial = 0;       // Started mid-line: drop bytes up to the first newline
+
+static char buffer[LOG_TAIL_BUFFER + 1];
+static size_t pending = 0;         // Partial line at the start of buffer
+
+static log_tail_stats_t stats;
+
+static void emit(char *line, size_t len, log_line_fn fn, void *ctx) {
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    line[len] = '\0';
+    stats.lines++;
+    fn(line, len, ctx);
+}
+
+#ifdef __SSE2__
+// Bit i set where block[i] is a newline
+static inline uint64_t newline_mask(const char *block) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    uint64_t m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)block), nl));
+    uint64_t m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(block + 16)), nl));
+    uint64_t m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(block + 32)), nl));
+    uint64_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(block + 48)), nl));
+    return m0 | m1 << 16 | m2 << 32 | m3 << 48;
+}
+#endif
+
+int log_tail_split(char *data, size_t len, log_line_fn fn, void *ctx, size_t *consumed) {
+    int count = 0;
+    size_t start = 0;
+    size_t pos = 0;
+
+#ifdef __SSE2__
+    // The mask is taken before emit() writes its NUL, so lines ending
+    // inside the block are all found
+    for (; pos + 64 <= len; pos += 64) {
+        uint64_t mask = newline_mask(data + pos);
+        while (mask) {
+            size_t end = pos + (size_t)__builtin_ctzll(mask);
+            emit(data + start, end - start, fn, ctx);
+            count++;
+            start = end + 1;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // Tail shorter than a block (or no SSE2)
+    char *nl;
+    pos = (pos > start) ? pos : start;
+    while (pos < len && (nl = memchr(data + pos, '\n', len - pos)) != NULL) {
+        size_t end = (size_t)(nl - data);
+        emit(data + start, end - start, fn, ctx);
+        count++;
+        start = end + 1;
+        pos = start;
+    }
+
+    *consumed = start;
+    return count;
+}
+
+// Hand over the complete lines in buffer[0, end) and keep the remainder
+static int split_lines(size_t end, log_line_fn fn, void *ctx) {
+    size_t start = 0;
+
+    if (skip_partial) {
+        char *nl = memchr(buffer, '\n', end);
+        if (!nl) {
+            pending = 0;
+            return 0;
+        }
+        start = (size_t)(nl - buffer) + 1;
+        skip_partial = 0;
+    }
+
+    size_t consumed;
+    int count = log_tail_split(buffer + start, end - start, fn, ctx, &consumed);
+    start += consumed;
+
+    pending = end - start;
+    if (pending == LOG_TAIL_BUFFER) {
+        // No newline in a full buffer: pass it on in pieces
+        emit(buffer, pending, fn, ctx);
+        stats.long_lines++;
+        pending = 0;
+        count++;
+    } else if (pending > 0 && start > 0) {
+        memmove(buffer, buffer + start, pending);
+    }
+    return count;
+}
+
+// The file is finished with (rotated or truncated): its last line is complete
+static int flush_partial(log_line_fn fn, void *ctx) {
+    if (pending == 0 || skip_partial) {
+        pending = 0;
+        skip_partial = 0;
+        return 0;
+    }
+    emit(buffer, pending, fn, ctx);
+    pending = 0;
+    return 1;
+}
+
+// Read from the current offset to the end of the file
+static int read_appended(log_line_fn fn, void *ctx) {
+    struct stat st;
+    if (fstat(log_fd, &st) < 0) {
+        return 0;
+    }
+
+    int count = 0;
+    if ((uint64_t)st.st_size < stats.offset) {
+        count += flush_partial(fn, ctx);
+        stats.offset = 0;
+        stats.truncations++;
+    }
+
+    while (stats.offset < (uint64_t)st.st_size) {
+        ssize_t n = pread(log_fd, buffer + pending, LOG_TAIL_BUFFER - pending, (off_t)stats.offset);
+        if (n <= 0) {
+            break;
+        }
+        stats.offset += (uint64_t)n;
+        stats.bytes += (uint64_t)n;
+        count += split_lines(pending + (size_t)n, fn, ctx);
+    }
+    return count;
+}
+
+// Open the file at the path and watch it; from_end skips what is already there
+static int attach(int from_end) {
+    int fd = open(log_path, O_RDONLY | O_CLOEXEC);
+    selfstats_count_open();
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return -1;
+    }
+
+    int wd = inotify_add_watch(notify_fd, log_path, IN_MODIFY | IN_MOVE_SELF);
+    if (wd < 0) {
+        close(fd);
+        return -1;
+    }
+    if (file_wd >= 0 && file_wd != wd) {
+        inotify_rm_watch(notify_fd, file_wd);
+    }
+    file_wd = wd;
+
+    if (log_fd >= 0) {
+        close(log_fd);
+    }
+    log_fd = fd;
+    stats.open = 1;
+    stats.offset = 0;
+    pending = 0;
+    skip_partial = 0;
+
+    if (from_end && st.st_size > 0) {
+        char last;
+        stats.offset = (uint64_t)st.st_size;
+        skip_partial = pread(fd, &last, 1, st.st_size - 1) == 1 && last != '\n';
+    }
+    return 0;
+}
+
+// Whether the file at the path is no longer the one being read; -1 while
+// nothing is there
+static int path_replaced(void) {
+    struct stat now, current;
+    if (stat(log_path, &now) < 0) {
+        return -1;
+    }
+    return log_fd < 0 || fstat(log_fd, &current) < 0 ||
+           now.st_ino != current.st_ino || now.st_dev != current.st_dev;
+}
+
+int log_tail_open(const char *path) {
+    log_tail_close();
+    memset(&stats, 0, sizeof(stats));
+
+    snprintf(log_path, sizeof(log_path), "%s", path);
+    char dir[MAX_LOG_PATH];
+    const char *slash = strrchr(path, '/');
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+        if (dir[0] == '\0') {
+            snprintf(dir, sizeof(dir), "/");
+        }
+    } else {
+        snprintf(dir, sizeof(dir), ".");
+    }
+    snprintf(log_name, sizeof(log_name), "%s", slash ? slash + 1 : path);
+
+    notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify_fd < 0) {
+        return -1;
+    }
+    // Only a new file appearing at the path matters here, not writes to
+    // other files in the directory
+    dir_wd = inotify_add_watch(notify_fd, dir, IN_CREATE | IN_MOVED_TO);
+    if (dir_wd < 0) {
+        log_tail_close();
+        return -1;
+    }
+
+    // A missing file is not an error: it is picked up when created
+    attach(1);
+    return notify_fd;
+}
+
+int log_tail_read(log_line_fn fn, void *ctx) {
+    if (notify_fd < 0) {
+        return -1;
+    }
+
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(notify_fd, events, sizeof(events))) > 0) {
+        for (char *p = events; p < events + len;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->wd == file_wd && (event->mask & IN_MOVE_SELF)) {
+                reopen_pending = 1;
+            } else if (event->wd == dir_wd && event->len > 0 && strcmp(event->name, log_name) == 0) {
+                reopen_pending = 1;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    int count = 0;
+    if (log_fd >= 0) {
+        count += read_appended(fn, ctx);
+    }
+
+    // Old file drained: move over to whatever now sits at the path. If
+    // nothing does yet, keep the old descriptor until the create event.
+    int replaced = reopen_pending ? path_replaced() : 0;
+    if (replaced == 0) {
+        reopen_pending = 0;
+    } else if (replaced > 0) {
+        int had_file = log_fd >= 0;
+        count += flush_partial(fn, ctx);
+        if (attach(0) == 0) {
+            reopen_pending = 0;
+            stats.rotations += had_file;
+            count += read_appended(fn, ctx);
+        }
+    }
+    return count;
+}
+
+void log_tail_stats(log_tail_stats_t *out) {
+    *out = stats;
+}
+
+void log_tail_close(void) {
+    if (log_fd >= 0) {
+        close(log_fd);
+        log_fd = -1;
+    }
+    if (notify_fd >= 0) {
+        close(notify_fd);
+        notify_fd = -1;
+    }
+    file_wd = -1;
+    dir_wd = -1;
+    stats.open = 0;
+    pending = 0;
+    skip_partial = 0;
+    reopen_pending = 0;
+}
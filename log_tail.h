@@ -0,0 +1,44 @@
+#ifndef LOG_TAIL_H
+#define LOG_TAIL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LOG_TAIL_BUFFER 65536      // Longest line handed over whole; longer ones are split
+
+// Called once per complete line: no newline (or trailing CR), NUL-terminated,
+// valid only for the duration of the call
+typedef void (*log_line_fn)(const char *line, size_t len, void *ctx);
+
+typedef struct {
+    int open;                      // The file exists and is being followed
+    uint64_t offset;               // Bytes consumed from the current file
+    uint64_t bytes;                // Appended bytes read since log_tail_open()
+    uint64_t lines;
+    uint64_t truncations;          // File shrank under us (copytruncate)
+    uint64_t rotations;            // A new file took over the path
+    uint64_t long_lines;           // Lines split at LOG_TAIL_BUFFER
+} log_tail_stats_t;
+
+// Follow path from its current end (a file that appears later is read from
+// the start). Watches the file for IN_MODIFY | IN_MOVE_SELF and its
+// directory for the path being created again. Returns an inotify
+// descriptor for poll(), or -1.
+int log_tail_open(const char *path);
+
+// Drain the inotify descriptor, then read the bytes appended since the last
+// call and hand every complete line to fn. Returns the number of lines, or
+// -1 if nothing is being tailed.
+int log_tail_read(log_line_fn fn, void *ctx);
+
+// Hand every complete line in data[0, len) to fn, newlines found 64 bytes
+// per step with SSE2 where available. Sets consumed to the bytes up to and
+// including the last newline; returns the number of lines.
+int log_tail_split(char *data, size_t len, log_line_fn fn, void *ctx, size_t *consumed);
+
+void log_tail_stats(log_tail_stats_t *out);
+
+// Stop following and close every descriptor
+void log_tail_close(void);
+
+#endif // LOG_TAIL_H
@@ -1,301 +1,649 @@
-#include <ncurses.h>
+#define _GNU_SOURCE
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
-#include <math.h>
-#include "system_monitor.h"
-#include "process_monitor.h"
-#include "a2s_query.h"
-#include "formatting.h"
-
-#define REFRESH_INTERVAL_MS 1000
-#define RAM_DANGER_THRESHOLD_GB 12
-#define RAM_DANGER_THRESHOLD_KB (RAM_DANGER_THRESHOLD_GB * 1024 * 1024ULL)
+#include <poll.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/timerfd.h>
+#include <ncurses.h>
+#include "alerts.h"
+#include "collector.h"
+#include "config.h"
+#include "exporter.h"
+#include "fleet.h"
+#include "journal.h"
+#include "metrics.h"
+#include "output.h"
+#include "replay.h"
+#include "selfstats.h"
+#include "tsdb.h"
+#include "ui.h"
+
 #define DEFAULT_A2S_PORT 15637
+#define REPLAY_FRAME_MS 50
+#define JOURNAL_SAMPLE_MS 1000     // One journalled sample per second, whatever the tick rates
+#define DAEMON_MAX_FDS (EXPORTER_MAX_CLIENTS + 3)
 
 static volatile int running = 1;
 
+// Loaded settings; hot-reloaded when the config file changes
+static emon_config_t settings;
+static const char *settings_path = NULL;
+
 void signal_handler(int signum) {
     (void)signum;
     running = 0;
 }
 
-// Draw a progress bar
-void draw_bar(int y, int x, const char *label, double percent, int width, int is_danger) {
-    mvprintw(y, x, "%s", label);
+// Transitions worth a journal event, remembered between frames
+typedef struct {
+    int server_up;
+    int instance_count;
+    uint64_t oom_kills;
+    int have_oom_kills;            // oom_kills holds a real sample, even if 0
+    int pending_sources;           // Refreshed since the last journalled sample
+    int64_t sample_slot;           // now_ms / JOURNAL_SAMPLE_MS of that sample
+    time_t psi_trigger[PSI_RESOURCE_COUNT];
+} event_state_t;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-    int bar_start = x + strlen(label);
-    int filled = (int)(width * percent / 100.0);
+static int64_t wall_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-    if (is_danger) {
-        attron(COLOR_PAIR(2)); // Red for danger
-    } else {
-        attron(COLOR_PAIR(1)); // Green for normal
+// Journal the current values plus any state changes since the last frame
+static void record_journal(const emon_snapshot_t *snap, int fresh, const double *values,
+                           event_state_t *state, int64_t now_ms) {
+    char text[JOURNAL_MAX_TEXT];
+
+    // Sources refreshing several times a second are merged into the first
+    // frame of the next second; events below are still written at once
+    state->pending_sources |= fresh;
+    int64_t slot = now_ms / JOURNAL_SAMPLE_MS;
+    if (slot != state->sample_slot) {
+        journal_append_sample(now_ms, (uint16_t)state->pending_sources, values, METRIC_COUNT);
+        state->pending_sources = 0;
+        state->sample_slot = slot;
     }
 
-    for (int i = 0; i < width; i++) {
-        if (i < filled) {
-            mvaddch(y, bar_start + i, '|');
+    if ((fresh & (1 << METRIC_SOURCE_A2S)) && snap->a2s.available &&
+        snap->a2s.success != state->server_up) {
+        state->server_up = snap->a2s.success;
+        if (state->server_up) {
+            snprintf(text, sizeof(text), "%.160s (%.31s)", snap->a2s.info.name, snap->a2s.info.version);
+            journal_append_event(now_ms, JOURNAL_EVENT_SERVER_UP, text);
         } else {
-            mvaddch(y, bar_start + i, '-');
+            journal_append_event(now_ms, JOURNAL_EVENT_SERVER_DOWN, "no A2S response");
         }
     }
 
-    if (is_danger) {
-        attroff(COLOR_PAIR(2));
-    } else {
-        attroff(COLOR_PAIR(1));
+    if ((fresh & (1 << METRIC_SOURCE_PROCESS)) &&
+        snap->process.instance_count != state->instance_count) {
+        snprintf(text, sizeof(text), "%d -> %d local instances",
+                 state->instance_count, snap->process.instance_count);
+        state->instance_count = snap->process.instance_count;
+        journal_append_event(now_ms, JOURNAL_EVENT_INSTANCES_CHANGED, text);
+    }
+
+    if (fresh & (1 << METRIC_SOURCE_SYSTEM)) {
+        const system_snapshot_t *sys = &snap->system;
+        if (state->have_oom_kills && sys->stats.oom_kills > state->oom_kills) {
+            snprintf(text, sizeof(text), "%lu new OOM kills",
+                     (unsigned long)(sys->stats.oom_kills - state->oom_kills));
+            journal_append_event(now_ms, JOURNAL_EVENT_OOM_KILL, text);
+        }
+        state->oom_kills = sys->stats.oom_kills;
+        state->have_oom_kills = 1;
+
+        for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+            if (sys->psi.last_trigger[i] != state->psi_trigger[i]) {
+                state->psi_trigger[i] = sys->psi.last_trigger[i];
+                snprintf(text, sizeof(text), "%s some avg10 %.2f%%", psi_resource_name(i),
+                         sys->psi.host[i].some.avg10);
+                journal_append_event(now_ms, JOURNAL_EVENT_PSI_STALL, text);
+            }
+        }
     }
+}
 
-    mvprintw(y, bar_start + width + 1, "%.1f%%", percent);
+// Wall-clock time a sample was taken, from its CLOCK_MONOTONIC stamp
+static int64_t sample_wall_ms(uint64_t collected_ns, int64_t now_ms) {
+    int64_t age_ms = monotonic_ms() - (int64_t)(collected_ns / 1000000);
+    return (collected_ns == 0 || age_ms < 0) ? now_ms : now_ms - age_ms;
+}
+
+// Pull the latest snapshots into the tsdb and the journal, returns fresh sources
+static int collect_frame(emon_snapshot_t *snap, metrics_cursor_t *cursor,
+                         event_state_t *events, double *values, int journaling) {
+    collector_read(snap);
+    int64_t now_ms = wall_clock_ms();
+    int fresh = metrics_record(snap, cursor, now_ms / 1000, values);
+
+    // Rates divide by when each collector actually sampled, not by when
+    // this frame happened to run
+    const uint64_t collected_ns[METRIC_SOURCE_COUNT] = {
+        [METRIC_SOURCE_SYSTEM] = snap->system.collected_ns,
+        [METRIC_SOURCE_PROCESS] = snap->process.collected_ns,
+        [METRIC_SOURCE_A2S] = snap->a2s.collected_ns,
+    };
+    if (fresh & (1 << METRIC_SOURCE_SYSTEM)) {
+        const cgroup_stats_t *cg = &snap->system.cgroup;
+        alerts_set_memory_limit(cg->available ? cg->memory_max : 0);
+    }
+    for (int source = 0; source < METRIC_SOURCE_COUNT; source++) {
+        if (fresh & (1 << source)) {
+            alerts_evaluate(values, 1 << source, sample_wall_ms(collected_ns[source], now_ms));
+        }
+    }
+    if (fresh && journaling) {
+        record_journal(snap, fresh, values, events, now_ms);
+    }
+    return fresh;
+}
+
+// Pick up an edited config file: alert rules and sampling intervals apply
+// at once; host, port and log path keep their startup values
+static void reload_config(void) {
+    emon_config_t next;
+    char error[256];
+    if (!config_changed() || config_load(settings_path, &next, error, sizeof(error)) < 0) {
+        return; // Unchanged, or removed mid-save: keep what we have
+    }
+
+    alerts_load(settings_path);
+    collector_set_intervals(next.interval_ms);
+    memcpy(settings.interval_ms, next.interval_ms, sizeof(settings.interval_ms));
+    settings.refresh_ms = next.refresh_ms;
+}
+
+// Fixed-rate redraw clock: ticks every refresh_ms on CLOCK_MONOTONIC no
+// matter how often keys or samples wake the loop in between
+static int arm_refresh_timer(int fd, uint32_t refresh_ms) {
+    struct itimerspec period = {
+        .it_interval = { .tv_sec = refresh_ms / 1000, .tv_nsec = (long)(refresh_ms % 1000) * 1000000 },
+        .it_value = { .tv_sec = refresh_ms / 1000, .tv_nsec = (long)(refresh_ms % 1000) * 1000000 },
+    };
+    return timerfd_settime(fd, 0, &period, NULL);
+}
+
+// Headless mode: serve /metrics and/or stream records until a signal or
+// until the output pipe closes, doing the work once per collection
+static void run_headless(int journaling, int exporting, int streaming, int watch_fd) {
+    static emon_snapshot_t snapshot;
+    metrics_cursor_t cursor = { { 0 } };
+    event_state_t events = { 0 };
+    double values[METRIC_COUNT];
+    struct pollfd fds[DAEMON_MAX_FDS];
+
+    while (running) {
+        fds[0].fd = collector_wake_fd();
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = watch_fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        int count = 2 + exporter_poll_fds(fds + 2, DAEMON_MAX_FDS - 2);
+
+        // Sleep until a collector publishes or a scraper needs attention
+        if (poll(fds, (nfds_t)count, -1) <= 0) {
+            continue;
+        }
+        if (fds[1].revents) {
+            reload_config();
+        }
+        if (fds[0].revents) {
+            collector_ack_wake();
+            int fresh = collect_frame(&snapshot, &cursor, &events, values, journaling);
+            if (fresh && exporting) {
+                exporter_render(&snapshot, values);
+            }
+            if (fresh && streaming &&
+                (output_record(wall_clock_ms(), fresh, &snapshot, values) < 0 ||
+                 output_flush() < 0)) {
+                break;
+            }
+        }
+        exporter_handle(fds + 2, count - 2);
+    }
+}
+
+// Interactive playback of a journal until 'q' or a signal
+static int run_replay(const char *path, uint16_t query_port) {
+    static const int speeds[] = { 1, 10, 100, 1000 };
+    const int speed_count = (int)(sizeof(speeds) / sizeof(speeds[0]));
+
+    if (replay_open(path) < 0) {
+        fprintf(stderr, "Error: No readable journal records in '%s'\n", path);
+        return 1;
+    }
+
+    static emon_snapshot_t snapshot;
+    snapshot.process.primary = -1;
+
+    const char *host = replay_host()[0] ? replay_host() : path;
+    collector_config_t config = {
+        .query_host = host,
+        .query_port = query_port,
+        .is_remote = !collector_is_local_host(host),
+    };
+
+    int64_t start = replay_start_ms();
+    int64_t end = replay_end_ms();
+    int64_t clock = start;
+    int speed = 0;
+    int paused = 0;
+    char footer[256];
+    double values[METRIC_COUNT];
+
+    // Rule states follow the recording, but hooks must not fire again
+    alerts_set_actions(0);
+
+    ui_init();
+    ui_set_footer(footer);
+    replay_seek(clock, &snapshot);
+
+    struct pollfd stdin_fd = { .fd = STDIN_FILENO, .events = POLLIN };
+    int64_t last = monotonic_ms();
+
+    while (running) {
+        int ch;
+        int quit = 0;
+        int64_t seek_to = -1;
+        while ((ch = ui_getch()) != ERR) {
+            switch (ch) {
+            case 'q':
+                quit = 1;
+                break;
+            case ' ':
+                paused = !paused;
+                break;
+            case '+':
+            case '=':
+                speed = (speed + 1 < speed_count) ? speed + 1 : speed;
+                break;
+            case '-':
+                speed = (speed > 0) ? speed - 1 : 0;
+                break;
+            case KEY_RIGHT:
+                seek_to = clock + 60 * 1000;
+                break;
+            case KEY_LEFT:
+                seek_to = clock - 60 * 1000;
+                break;
+            case KEY_NPAGE:
+            case ']':
+                seek_to = clock + 3600 * 1000;
+                break;
+            case KEY_PPAGE:
+            case '[':
+                seek_to = clock - 3600 * 1000;
+                break;
+            case KEY_HOME:
+            case 'g':
+                seek_to = start;
+                break;
+            case KEY_END:
+            case 'G':
+                seek_to = end;
+                break;
+            default:
+                break;
+            }
+        }
+        if (quit) {
+            break;
+        }
+
+        int64_t now = monotonic_ms();
+        if (!paused) {
+            clock += (now - last) * speeds[speed];
+        }
+        last = now;
+
+        if (seek_to >= 0) {
+            clock = (seek_to < start) ? start : (seek_to > end) ? end : seek_to;
+            replay_seek(clock, &snapshot);
+        }
+        if (clock >= end) {
+            clock = end;
+            paused = 1;
+        }
+        if (replay_advance(clock, &snapshot) > 0) {
+            metrics_extract(&snapshot, values);
+            alerts_evaluate(values, (1 << METRIC_SOURCE_COUNT) - 1, clock);
+        }
+
+        struct tm tm;
+        time_t seconds = (time_t)(clock / 1000);
+        char when[32];
+        localtime_r(&seconds, &tm);
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+        snprintf(footer, sizeof(footer),
+                 "REPLAY %s %dx%s | %s | spc pause +/- speed <-/-> 1m [/] 1h g/G ends",
+                 when, speeds[speed], paused ? " PAUSED" : "", replay_last_event());
+        ui_draw(&config, &snapshot);
+
+        poll(&stdin_fd, 1, paused ? 1000 : REPLAY_FRAME_MS);
+    }
+
+    ui_set_footer(NULL);
+    ui_cleanup();
+    replay_close();
+    return 0;
 }
 
 void print_usage(const char *program_name) {
-    fprintf(stderr, "Usage: %s <host> [port]\n", program_name);
+    fprintf(stderr, "Usage: %s [options] <host> [port]\n", program_name);
     fprintf(stderr, "\nArguments:\n");
-    fprintf(stderr, "  host     Server hostname or IP address (required)\n");
-    fprintf(stderr, "  port     Query port (default: %d)\n", DEFAULT_A2S_PORT);
+    fprintf(stderr, "  host     Server hostname or IP address (default: QUERY_HOST from the config)\n");
+    fprintf(stderr, "  port     Query port (default: QUERY_PORT from the config, else %d)\n",
+            DEFAULT_A2S_PORT);
+    fprintf(stderr, "\nOptions:\n");
+    fprintf(stderr, "  --config PATH   Config file, reloaded on change (default: ~/.config/emon/config,\n");
+    fprintf(stderr, "                  then /etc/emon/config)\n");
+    fprintf(stderr, "  --output FMT    Stream one record per sample to stdout as jsonl or csv\n");
+    fprintf(stderr, "  --journal DIR   Record samples and events to a crash-safe journal in DIR\n");
+    fprintf(stderr, "  --replay PATH   Play back a journal segment or directory instead of live data\n");
+    fprintf(stderr, "  --daemon        Run headless and serve Prometheus metrics over HTTP\n");
+    fprintf(stderr, "  --listen [ADDR:]PORT\n");
+    fprintf(stderr, "                  Exporter address (default: %s:%d)\n",
+            EXPORTER_DEFAULT_ADDR, EXPORTER_DEFAULT_PORT);
+    fprintf(stderr, "  --targets FILE  Query every host[:port] listed in FILE; 'f' shows them as a table\n");
+    fprintf(stderr, "  --self-stats    Print emon's own timings and syscall counts at exit\n");
     fprintf(stderr, "\nExamples:\n");
     fprintf(stderr, "  %s 10.0.2.33\n", program_name);
     fprintf(stderr, "  %s 10.0.2.33 15637\n", program_name);
-    fprintf(stderr, "  %s 192.168.1.100 25637\n", program_name);
+    fprintf(stderr, "  %s --journal /var/lib/emon 127.0.0.1\n", program_name);
+    fprintf(stderr, "  %s --replay /var/lib/emon\n", program_name);
+    fprintf(stderr, "  %s --targets servers.txt\n", program_name);
+    fprintf(stderr, "  %s --output jsonl 127.0.0.1 | jq .players\n", program_name);
+    fprintf(stderr, "  %s --daemon --listen 0.0.0.0:9637 127.0.0.1\n", program_name);
 }
 
 int main(int argc, char *argv[]) {
-    // Require host as positional argument
-    if (argc < 2) {
+    static const struct option long_options[] = {
+        { "journal", required_argument, NULL, 'j' },
+        { "replay", required_argument, NULL, 'r' },
+        { "daemon", no_argument, NULL, 'd' },
+        { "listen", required_argument, NULL, 'l' },
+        { "output", required_argument, NULL, 'o' },
+        { "config", required_argument, NULL, 'c' },
+        { "self-stats", no_argument, NULL, 's' },
+        { "targets", required_argument, NULL, 't' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    const char *journal_dir = NULL;
+    const char *replay_path = NULL;
+    int daemon_mode = 0;
+    char listen_addr[64] = EXPORTER_DEFAULT_ADDR;
+    uint16_t listen_port = EXPORTER_DEFAULT_PORT;
+    output_format_t output_format = OUTPUT_NONE;
+    const char *config_path = NULL;
+    const char *targets_path = NULL;
+    int self_stats = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'j':
+            journal_dir = optarg;
+            break;
+        case 'r':
+            replay_path = optarg;
+            break;
+        case 'd':
+            daemon_mode = 1;
+            break;
+        case 'l':
+            if (exporter_parse_listen(optarg, listen_addr, sizeof(listen_addr), &listen_port) < 0) {
+                fprintf(stderr, "Error: Invalid listen address '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            if (output_parse_format(optarg, &output_format) < 0) {
+                fprintf(stderr, "Error: Unknown output format '%s' (use jsonl or csv)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            config_path = optarg;
+            break;
+        case 's':
+            self_stats = 1;
+            break;
+        case 't':
+            targets_path = optarg;
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            return 0;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config_path && access(config_path, R_OK) < 0) {
+        fprintf(stderr, "Error: Cannot read config '%s'\n", config_path);
+        return 1;
+    }
+    settings_path = config_path ? config_path : config_default_path();
+
+    char config_error[256];
+    config_load(settings_path, &settings, config_error, sizeof(config_error));
+    if (config_error[0]) {
+        fprintf(stderr, "%s\n", config_error);
+    }
+    alerts_load(settings_path);
+
+    // Replay needs no live target: the journal records the host
+    if (replay_path) {
+        uint16_t port = (argc - optind >= 2) ? (uint16_t)atoi(argv[optind + 1]) : settings.query_port;
+        signal(SIGINT, signal_handler);
+        signal(SIGTERM, signal_handler);
+        return run_replay(replay_path, port ? port : DEFAULT_A2S_PORT);
+    }
+
+    // The fleet table only exists in the interactive view
+    int headless = daemon_mode || output_format != OUTPUT_NONE;
+    int fleet_count = 0;
+    if (targets_path && !headless) {
+        char fleet_error[256];
+        uint16_t default_port = settings.query_port ? settings.query_port : DEFAULT_A2S_PORT;
+        fleet_count = fleet_load(targets_path, default_port, fleet_error, sizeof(fleet_error));
+        if (fleet_error[0]) {
+            fprintf(stderr, "%s\n", fleet_error);
+        }
+        if (fleet_count <= 0) {
+            fprintf(stderr, "Error: No usable targets in '%s'\n", targets_path);
+            return 1;
+        }
+    }
+
+    // Host comes from the command line, else from the config, else the
+    // first fleet target
+    int positional = argc - optind;
+    if (positional < 1 && !settings.query_host[0] && fleet_count == 0) {
         fprintf(stderr, "Error: Server host is required\n\n");
         print_usage(argv[0]);
         return 1;
     }
 
-    const char *query_host = argv[1];
-    uint16_t query_port = DEFAULT_A2S_PORT;
+    const char *query_host = (positional >= 1) ? argv[optind] : settings.query_host;
+    uint16_t query_port = settings.query_port ? settings.query_port : DEFAULT_A2S_PORT;
+    if (positional < 1 && !settings.query_host[0]) {
+        query_host = fleet_target(0)->host;
+        query_port = fleet_target(0)->port;
+    }
 
     // Optional port as second argument
-    if (argc >= 3) {
-        query_port = (uint16_t)atoi(argv[2]);
+    if (positional >= 2) {
+        query_port = (uint16_t)atoi(argv[optind + 1]);
         if (query_port == 0) {
-            fprintf(stderr, "Error: Invalid port number '%s'\n", argv[2]);
+            fprintf(stderr, "Error: Invalid port number '%s'\n", argv[optind + 1]);
             return 1;
         }
     }
 
-    if (argc > 3) {
+    if (positional > 2) {
         fprintf(stderr, "Error: Too many arguments\n\n");
         print_usage(argv[0]);
         return 1;
     }
 
-    // Set up signal handler
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+    // Determine if we're monitoring a remote server or localhost
+    int is_remote = !collector_is_local_host(query_host);
 
-    // Initialize system monitoring
-    if (system_monitor_init() < 0) {
-        fprintf(stderr, "Failed to initialize system monitoring\n");
+    if (daemon_mode && exporter_open(listen_addr, listen_port) < 0) {
+        fprintf(stderr, "Error: Cannot listen on %s:%u\n", listen_addr, listen_port);
         return 1;
     }
 
-    // Initialize ncurses
-    initscr();
-    cbreak();
-    noecho();
-    curs_set(0);
-    timeout(REFRESH_INTERVAL_MS);
-
-    // Enable colors
-    if (has_colors()) {
-        start_color();
-        init_pair(1, COLOR_GREEN, COLOR_BLACK);
-        init_pair(2, COLOR_RED, COLOR_BLACK);
-        init_pair(3, COLOR_YELLOW, COLOR_BLACK);
-        init_pair(4, COLOR_CYAN, COLOR_BLACK);
-    }
-
-    // Initialize A2S query with configured host/port
-    int a2s_available = (a2s_query_init(query_host, query_port) == 0);
-
-    // Determine if we're monitoring a remote server or localhost
-    int is_remote = (strcmp(query_host, "localhost") != 0 &&
-                     strcmp(query_host, "127.0.0.1") != 0 &&
-                     strcmp(query_host, "::1") != 0);
-
-    int ch;
-    system_stats_t stats;
-    process_info_t server_process;
-    a2s_info_t server_info;
-    int server_found = 0;
-    int a2s_query_success = 0;
-    int query_counter = 0;
-
-    while (running && (ch = getch()) != 'q') {
-        query_counter++;
-        clear();
-
-        // Get system stats
-        if (system_monitor_get_stats(&stats) < 0) {
-            mvprintw(0, 0, "Error reading system stats");
-            refresh();
-            continue;
+    if (journal_dir) {
+        journal_config_t journal_config = { .dir = journal_dir };
+        if (journal_open(&journal_config) < 0) {
+            fprintf(stderr, "Error: Cannot open journal in '%s'\n", journal_dir);
+            exporter_close();
+            return 1;
         }
+        journal_append_event(wall_clock_ms(), JOURNAL_EVENT_STARTED, query_host);
+    }
 
-        // Draw header
-        attron(A_BOLD | COLOR_PAIR(4));
-        mvprintw(0, 0, "=== Enshrouded Monitor (EMon) ===");
-        attroff(A_BOLD | COLOR_PAIR(4));
-        mvprintw(0, 60, "Press 'q' to quit");
-
-        // Show query target
-        attron(COLOR_PAIR(4));
-        mvprintw(1, 0, "Query Target: %s:%d", query_host, query_port);
-        attroff(COLOR_PAIR(4));
-
-        // Draw CPU bar
-        draw_bar(2, 0, "CPU:  ", stats.cpu_percent, 40, 0);
-
-        // Draw RAM bar
-        double ram_percent = 100.0 * stats.used_mem_kb / stats.total_mem_kb;
-        int ram_danger = (stats.used_mem_kb > RAM_DANGER_THRESHOLD_KB);
-        draw_bar(3, 0, "RAM:  ", ram_percent, 40, ram_danger);
-
-        // RAM details
-        char used_str[32], total_str[32];
-        format_bytes(stats.used_mem_kb, used_str, sizeof(used_str));
-        format_bytes(stats.total_mem_kb, total_str, sizeof(total_str));
-        mvprintw(4, 6, "%s / %s", used_str, total_str);
-
-        if (ram_danger) {
-            attron(COLOR_PAIR(2) | A_BOLD);
-            mvprintw(4, 30, "[DANGER: >%dGB]", RAM_DANGER_THRESHOLD_GB);
-            attroff(COLOR_PAIR(2) | A_BOLD);
-        }
+    // Set up signal handler
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
 
-        // Separator
-        mvprintw(6, 0, "================================");
+    // Start the collector threads
+    collector_config_t config = {
+        .query_host = query_host,
+        .query_port = query_port,
+        .is_remote = is_remote,
+        .fleet = fleet_count > 0,
+        .log_path = settings.log_path,
+    };
+    memcpy(config.interval_ms, settings.interval_ms, sizeof(config.interval_ms));
+    if (collector_start(&config) < 0) {
+        fprintf(stderr, "Failed to initialize system monitoring\n");
+        journal_close();
+        exporter_close();
+        return 1;
+    }
 
-        // Search for Enshrouded server process (only if local)
-        if (!is_remote) {
-            server_found = (process_find_by_name("EnshroudedServer", &server_process) == 0);
-        } else {
-            server_found = 0; // Skip local process search for remote servers
+    tsdb_init();
+    int watch_fd = settings_path ? config_watch(settings_path) : -1;
+
+    if (headless) {
+        // A closed pipe ends the loop through write() errors instead of killing us
+        signal(SIGPIPE, SIG_IGN);
+        output_open(output_format, STDOUT_FILENO);
+        run_headless(journal_dir != NULL, daemon_mode, output_format != OUTPUT_NONE, watch_fd);
+        config_unwatch();
+        output_close();
+        collector_stop();
+        journal_close();
+        exporter_close();
+        if (self_stats) {
+            selfstats_dump(stderr);
         }
+        return 0;
+    }
 
-        // Query A2S_INFO (every refresh if available)
-        if (a2s_available) {
-            int query_result = a2s_query_info(&server_info);
-            if (query_result == 0) {
-                a2s_query_success = 1;
-            } else if (query_result == -2) {
-                // Timeout - server not responding to queries
-                a2s_query_success = 0;
-            } else {
-                a2s_query_success = 0;
-            }
+    ui_init();
+
+    // Sleep until a collector publishes, a key is pressed or the refresh
+    // timer ticks
+    int refresh_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    uint32_t refresh_ms = settings.refresh_ms;
+    arm_refresh_timer(refresh_fd, refresh_ms);
+
+    struct pollfd wait_fds[4];
+    wait_fds[0].fd = STDIN_FILENO;
+    wait_fds[0].events = POLLIN;
+    wait_fds[1].fd = collector_wake_fd();
+    wait_fds[1].events = POLLIN;
+    wait_fds[2].fd = watch_fd;
+    wait_fds[2].events = POLLIN;
+    wait_fds[3].fd = refresh_fd;
+    wait_fds[3].events = POLLIN;
+
+    static emon_snapshot_t snapshot;
+    static fleet_snapshot_t fleet;
+    metrics_cursor_t cursor = { { 0 } };
+    event_state_t events = { 0 };
+    double values[METRIC_COUNT];
+
+    while (running) {
+        collect_frame(&snapshot, &cursor, &events, values, journal_dir != NULL);
+
+        // A fleet round is large: copy it only when a new one was published
+        if (config.fleet && collector_fleet_sequence() != fleet.sequence) {
+            collector_read_fleet(&fleet);
+            fleet_table_update(fleet.results, fleet.count);
         }
 
-        // Display server status and info
-        if (a2s_query_success) {
-            // Status indicator based on A2S query
-            int color = COLOR_PAIR(1); // Green
-            if (server_info.status == SERVER_STATUS_LOADING) {
-                color = COLOR_PAIR(3); // Yellow
-            } else if (server_info.status == SERVER_STATUS_LOBBY) {
-                color = COLOR_PAIR(4); // Cyan
-            }
-
-            attron(A_BOLD | color);
-            mvprintw(8, 0, "Server Status: %s", a2s_status_string(server_info.status));
-            attroff(A_BOLD | color);
+        selfstats_span_t span;
+        selfstats_begin(&span);
+        ui_draw(&config, &snapshot);
+        selfstats_end(SELFSTATS_RENDER, &span);
 
-            if (is_remote) {
-                attron(COLOR_PAIR(4));
-                mvprintw(9, 0, "Mode: Remote Monitoring");
-                attroff(COLOR_PAIR(4));
+        if (poll(wait_fds, 4, -1) > 0) {
+            if (wait_fds[1].revents) {
+                collector_ack_wake();
             }
-
-            // Local process info (only if found)
-            int line = 10;
-            if (server_found) {
-                mvprintw(line++, 0, "Process: %s", server_process.name);
-                mvprintw(line++, 0, "PID:     %d", server_process.pid);
-
-                char uptime_str[64];
-                format_uptime(server_process.uptime_seconds, uptime_str, sizeof(uptime_str));
-                mvprintw(line++, 0, "Uptime:  %s", uptime_str);
-
-                char mem_str[32];
-                format_bytes(server_process.rss_kb, mem_str, sizeof(mem_str));
-                mvprintw(line++, 0, "Memory:  %s", mem_str);
-                line++;
+            if (wait_fds[2].revents) {
+                reload_config();
+                if (settings.refresh_ms != refresh_ms) {
+                    refresh_ms = settings.refresh_ms;
+                    arm_refresh_timer(refresh_fd, refresh_ms);
+                }
             }
-
-            // Separator
-            mvprintw(line++, 0, "--- Server Details (A2S Query) ---");
-
-            // Server details from A2S query
-            mvprintw(line++, 0, "Server Name: %s", server_info.name);
-            mvprintw(line++, 0, "Version:     %s", server_info.version);
-            mvprintw(line++, 0, "Players:     %d/%d", server_info.players, server_info.max_players);
-            mvprintw(line++, 0, "Map:         %s", server_info.map);
-            mvprintw(line++, 0, "Game:        %s", server_info.game);
-
-        } else if (!is_remote && server_found) {
-            // Local server found but A2S query failed
-            attron(A_BOLD | COLOR_PAIR(3));
-            mvprintw(8, 0, "Server Status: RUNNING (Query Unavailable)");
-            attroff(A_BOLD | COLOR_PAIR(3));
-
-            // Process info
-            mvprintw(10, 0, "Process: %s", server_process.name);
-            mvprintw(11, 0, "PID:     %d", server_process.pid);
-
-            char uptime_str[64];
-            format_uptime(server_process.uptime_seconds, uptime_str, sizeof(uptime_str));
-            mvprintw(12, 0, "Uptime:  %s", uptime_str);
-
-            char mem_str[32];
-            format_bytes(server_process.rss_kb, mem_str, sizeof(mem_str));
-            mvprintw(13, 0, "Memory:  %s", mem_str);
-
-            // Separator
-            mvprintw(15, 0, "--- Server Details (A2S Query) ---");
-            attron(COLOR_PAIR(3));
-            mvprintw(16, 0, "A2S Query: No response from %s:%d", query_host, query_port);
-            mvprintw(17, 0, "Server may not have query port enabled or firewall blocking.");
-            attroff(COLOR_PAIR(3));
-
-        } else {
-            // No A2S response and no local process
-            attron(A_BOLD | COLOR_PAIR(2));
-            mvprintw(8, 0, "Server Status: NOT FOUND");
-            attroff(A_BOLD | COLOR_PAIR(2));
-
-            if (is_remote) {
-                attron(COLOR_PAIR(4));
-                mvprintw(9, 0, "Mode: Remote Monitoring");
-                attroff(COLOR_PAIR(4));
-                mvprintw(11, 0, "No A2S response from %s:%d", query_host, query_port);
-                mvprintw(12, 0, "Server may be offline or query port blocked.");
-            } else {
-                mvprintw(10, 0, "Searching for 'EnshroudedServer.exe' process...");
-                mvprintw(11, 0, "Make sure the server is running via Wine/Proton.");
+            if (wait_fds[3].revents) {
+                uint64_t ticks;
+                if (read(refresh_fd, &ticks, sizeof(ticks)) < 0) {
+                    // Drained by an earlier pass
+                }
             }
         }
 
-        // Footer
-        mvprintw(LINES - 2, 0, "================================");
-        mvprintw(LINES - 1, 0, "Phase 2: A2S Query Integration | Query: %s",
-                 a2s_available ? "Enabled" : "Unavailable");
-
-        refresh();
+        int ch = ui_getch();
+        if (ch == 'q') {
+            break;
+        }
+        if (ch == 'o') {
+            ui_toggle_overhead();
+        } else if (ch == 'f' && config.fleet) {
+            ui_toggle_fleet();
+        } else if (ch == 'p' && !config.is_remote) {
+            ui_toggle_top();
+        } else if (!ui_fleet_key(ch)) {
+            ui_top_key(ch);
+        }
+        collector_set_top(ui_top_shown());
     }
 
-    // Cleanup
-    endwin();
-    system_monitor_cleanup();
-    a2s_query_cleanup();
+    // Restore the terminal first: joining may wait out an A2S timeout
+    ui_cleanup();
+    if (refresh_fd >= 0) {
+        close(refresh_fd);
+    }
+    config_unwatch();
+    collector_stop();
+    journal_close();
+    if (self_stats) {
+        selfstats_dump(stderr);
+    }
 
     return 0;
 }
@@ -0,0 +1,232 @@
+/*
+ * Metric registry
+ * Flattens collector snapshots into one array of named scalars so the
+ * time-series store and exporters never need to know snapshot layouts.
+ */
+
+#include "metrics.h"
+#include "tsdb.h"
+#include <stdio.h>
+#include <math.h>
+
+_Static_assert(METRIC_COUNT <= TSDB_MAX_SERIES, "every metric needs a tsdb series");
+
+static const metric_desc_t descs[METRIC_COUNT] = {
+    [METRIC_CPU_PERCENT]              = { "cpu_percent", "Host CPU utilization", METRIC_SOURCE_SYSTEM },
+    [METRIC_STEAL_PERCENT]            = { "cpu_steal_percent", "CPU time stolen by the hypervisor", METRIC_SOURCE_SYSTEM },
+    [METRIC_MEM_USED_KB]              = { "memory_used_kb", "Host memory in use", METRIC_SOURCE_SYSTEM },
+    [METRIC_MEM_TOTAL_KB]             = { "memory_total_kb", "Host memory installed", METRIC_SOURCE_SYSTEM },
+    [METRIC_SWAP_USED_KB]             = { "swap_used_kb", "Swap in use", METRIC_SOURCE_SYSTEM },
+    [METRIC_SWAP_IN_RATE]             = { "swap_in_pages_per_sec", "Pages swapped in per second", METRIC_SOURCE_SYSTEM },
+    [METRIC_SWAP_OUT_RATE]            = { "swap_out_pages_per_sec", "Pages swapped out per second", METRIC_SOURCE_SYSTEM },
+    [METRIC_OOM_KILLS]                = { "oom_kills", "Host OOM kills since boot", METRIC_SOURCE_SYSTEM },
+    [METRIC_CGROUP_MEMORY_BYTES]      = { "cgroup_memory_bytes", "Server cgroup memory.current", METRIC_SOURCE_SYSTEM },
+    [METRIC_CGROUP_CPU_PERCENT]       = { "cgroup_cpu_percent", "Server cgroup CPU use against its quota", METRIC_SOURCE_SYSTEM },
+    [METRIC_CGROUP_THROTTLED_PERCENT] = { "cgroup_throttled_percent", "Share of cgroup periods throttled", METRIC_SOURCE_SYSTEM },
+    [METRIC_PSI_CPU_SOME]             = { "psi_cpu_some_avg10", "CPU pressure, some, 10s average", METRIC_SOURCE_SYSTEM },
+    [METRIC_PSI_MEMORY_SOME]          = { "psi_memory_some_avg10", "Memory pressure, some, 10s average", METRIC_SOURCE_SYSTEM },
+    [METRIC_PSI_IO_SOME]              = { "psi_io_some_avg10", "IO pressure, some, 10s average", METRIC_SOURCE_SYSTEM },
+    [METRIC_DISK_READ_IOPS]           = { "disk_read_iops", "Save volume reads per second", METRIC_SOURCE_SYSTEM },
+    [METRIC_DISK_WRITE_IOPS]          = { "disk_write_iops", "Save volume writes per second", METRIC_SOURCE_SYSTEM },
+    [METRIC_DISK_READ_BYTES_PER_SEC]  = { "disk_read_bytes_per_sec", "Save volume read throughput", METRIC_SOURCE_SYSTEM },
+    [METRIC_DISK_WRITE_BYTES_PER_SEC] = { "disk_write_bytes_per_sec", "Save volume write throughput", METRIC_SOURCE_SYSTEM },
+    [METRIC_DISK_AWAIT_MS]            = { "disk_await_ms", "Save volume average request latency", METRIC_SOURCE_SYSTEM },
+    [METRIC_DISK_UTIL_PERCENT]        = { "disk_util_percent", "Save volume busy time", METRIC_SOURCE_SYSTEM },
+    [METRIC_CPU_FREQ_MHZ]             = { "cpu_freq_mhz", "Average current CPU clock", METRIC_SOURCE_SYSTEM },
+    [METRIC_CPU_TEMP_CELSIUS]         = { "cpu_temp_celsius", "Hottest thermal sensor", METRIC_SOURCE_SYSTEM },
+    [METRIC_SERVER_INSTANCES]         = { "server_instances", "Local server processes found", METRIC_SOURCE_PROCESS },
+    [METRIC_SERVER_RSS_KB]            = { "server_rss_kb", "Primary server resident memory", METRIC_SOURCE_PROCESS },
+    [METRIC_SERVER_UP]                = { "server_up", "Primary server answered A2S_INFO", METRIC_SOURCE_A2S },
+    [METRIC_PLAYERS]                  = { "players", "Players online", METRIC_SOURCE_A2S },
+    [METRIC_MAX_PLAYERS]              = { "max_players", "Player slots", METRIC_SOURCE_A2S },
+    [METRIC_A2S_RTT_MS]               = { "a2s_rtt_ms", "A2S_INFO round trip", METRIC_SOURCE_A2S },
+};
+
+const metric_desc_t *metrics_desc(metric_id_t id) {
+    if ((int)id < 0 || id >= METRIC_COUNT) {
+        return NULL;
+    }
+    return &descs[id];
+}
+
+static void extract_system(const system_snapshot_t *sys, double *v) {
+    const system_stats_t *s = &sys->stats;
+    int ok = sys->sequence && sys->ok;
+
+    v[METRIC_CPU_PERCENT] = ok ? s->cpu_percent : NAN;
+    v[METRIC_STEAL_PERCENT] = ok ? s->steal_percent : NAN;
+    v[METRIC_MEM_USED_KB] = ok ? (double)s->used_mem_kb : NAN;
+    v[METRIC_MEM_TOTAL_KB] = ok ? (double)s->total_mem_kb : NAN;
+    v[METRIC_SWAP_USED_KB] = ok ? (double)s->used_swap_kb : NAN;
+    v[METRIC_SWAP_IN_RATE] = ok ? s->swap_in_rate : NAN;
+    v[METRIC_SWAP_OUT_RATE] = ok ? s->swap_out_rate : NAN;
+    v[METRIC_OOM_KILLS] = ok ? (double)s->oom_kills : NAN;
+
+    const cgroup_stats_t *cg = &sys->cgroup;
+    int cg_ok = sys->sequence && cg->available;
+    v[METRIC_CGROUP_MEMORY_BYTES] = cg_ok ? (double)cg->memory_current : NAN;
+    v[METRIC_CGROUP_CPU_PERCENT] = cg_ok ? cg->cpu_percent : NAN;
+    v[METRIC_CGROUP_THROTTLED_PERCENT] = cg_ok ? cg->throttled_percent : NAN;
+
+    int psi_ok = sys->sequence && sys->psi.host_available;
+    v[METRIC_PSI_CPU_SOME] = psi_ok ? sys->psi.host[PSI_CPU].some.avg10 : NAN;
+    v[METRIC_PSI_MEMORY_SOME] = psi_ok ? sys->psi.host[PSI_MEMORY].some.avg10 : NAN;
+    v[METRIC_PSI_IO_SOME] = psi_ok ? sys->psi.host[PSI_IO].some.avg10 : NAN;
+
+    const disk_stats_t *d = &sys->disk;
+    int disk_ok = sys->sequence && d->available;
+    v[METRIC_DISK_READ_IOPS] = disk_ok ? d->read_iops : NAN;
+    v[METRIC_DISK_WRITE_IOPS] = disk_ok ? d->write_iops : NAN;
+    v[METRIC_DISK_READ_BYTES_PER_SEC] = disk_ok ? d->read_bytes_per_sec : NAN;
+    v[METRIC_DISK_WRITE_BYTES_PER_SEC] = disk_ok ? d->write_bytes_per_sec : NAN;
+    v[METRIC_DISK_AWAIT_MS] = disk_ok ? d->await_ms : NAN;
+    v[METRIC_DISK_UTIL_PERCENT] = disk_ok ? d->util_percent : NAN;
+
+    const hw_stats_t *hw = &sys->hw;
+    v[METRIC_CPU_FREQ_MHZ] = (sys->sequence && hw->freq_avg_mhz) ? hw->freq_avg_mhz : NAN;
+    v[METRIC_CPU_TEMP_CELSIUS] = (sys->sequence && hw->hottest >= 0) ?
+                                 hw->sensors[hw->hottest].celsius : NAN;
+}
+
+static void extract_process(const process_snapshot_t *proc, double *v) {
+    int ok = proc->sequence != 0;
+    v[METRIC_SERVER_INSTANCES] = ok ? proc->instance_count : NAN;
+    v[METRIC_SERVER_RSS_KB] = (ok && proc->primary >= 0) ?
+                              (double)proc->instances[proc->primary].rss_kb : NAN;
+}
+
+static void extract_a2s(const a2s_snapshot_t *a2s, double *v) {
+    int ok = a2s->sequence && a2s->available;
+    v[METRIC_SERVER_UP] = ok ? a2s->success : NAN;
+    v[METRIC_PLAYERS] = (ok && a2s->success) ? a2s->info.players : NAN;
+    v[METRIC_MAX_PLAYERS] = (ok && a2s->success) ? a2s->info.max_players : NAN;
+    v[METRIC_A2S_RTT_MS] = (ok && a2s->success) ? a2s->rtt_ms : NAN;
+}
+
+void metrics_extract(const emon_snapshot_t *snap, double *values) {
+    extract_system(&snap->system, values);
+    extract_process(&snap->process, values);
+    extract_a2s(&snap->a2s, values);
+}
+
+// Recorded value of a metric, NaN if the recording predates it
+static double recorded(const float *values, int count, metric_id_t id) {
+    return ((int)id < count) ? values[id] : NAN;
+}
+
+#define HAVE(id) (!isnan(recorded(values, count, (id))))
+#define GET(id) recorded(values, count, (id))
+
+void metrics_apply(const float *values, int count, emon_snapshot_t *snap) {
+    system_snapshot_t *sys = &snap->system;
+    system_stats_t *s = &sys->stats;
+
+    sys->sequence++;
+    sys->ok = HAVE(METRIC_CPU_PERCENT) && HAVE(METRIC_MEM_TOTAL_KB);
+    if (sys->ok) {
+        s->cpu_percent = GET(METRIC_CPU_PERCENT);
+        s->steal_percent = HAVE(METRIC_STEAL_PERCENT) ? GET(METRIC_STEAL_PERCENT) : 0.0;
+        s->used_mem_kb = (uint64_t)GET(METRIC_MEM_USED_KB);
+        s->total_mem_kb = (uint64_t)GET(METRIC_MEM_TOTAL_KB);
+        s->used_swap_kb = HAVE(METRIC_SWAP_USED_KB) ? (uint64_t)GET(METRIC_SWAP_USED_KB) : 0;
+        s->swap_in_rate = HAVE(METRIC_SWAP_IN_RATE) ? GET(METRIC_SWAP_IN_RATE) : 0.0;
+        s->swap_out_rate = HAVE(METRIC_SWAP_OUT_RATE) ? GET(METRIC_SWAP_OUT_RATE) : 0.0;
+        s->oom_kills = HAVE(METRIC_OOM_KILLS) ? (uint64_t)GET(METRIC_OOM_KILLS) : 0;
+    }
+
+    cgroup_stats_t *cg = &sys->cgroup;
+    cg->available = HAVE(METRIC_CGROUP_MEMORY_BYTES);
+    if (cg->available) {
+        cg->memory_current = (uint64_t)GET(METRIC_CGROUP_MEMORY_BYTES);
+        cg->cpu_percent = HAVE(METRIC_CGROUP_CPU_PERCENT) ? GET(METRIC_CGROUP_CPU_PERCENT) : 0.0;
+        cg->throttled_percent = HAVE(METRIC_CGROUP_THROTTLED_PERCENT) ?
+                                GET(METRIC_CGROUP_THROTTLED_PERCENT) : 0.0;
+    }
+
+    psi_stats_t *psi = &sys->psi;
+    psi->host_available = HAVE(METRIC_PSI_CPU_SOME);
+    if (psi->host_available) {
+        psi->host[PSI_CPU].some.avg10 = (float)GET(METRIC_PSI_CPU_SOME);
+        psi->host[PSI_MEMORY].some.avg10 = (float)GET(METRIC_PSI_MEMORY_SOME);
+        psi->host[PSI_IO].some.avg10 = (float)GET(METRIC_PSI_IO_SOME);
+    }
+
+    disk_stats_t *d = &sys->disk;
+    d->available = HAVE(METRIC_DISK_UTIL_PERCENT);
+    if (d->available) {
+        d->read_iops = GET(METRIC_DISK_READ_IOPS);
+        d->write_iops = GET(METRIC_DISK_WRITE_IOPS);
+        d->read_bytes_per_sec = GET(METRIC_DISK_READ_BYTES_PER_SEC);
+        d->write_bytes_per_sec = GET(METRIC_DISK_WRITE_BYTES_PER_SEC);
+        d->await_ms = GET(METRIC_DISK_AWAIT_MS);
+        d->util_percent = GET(METRIC_DISK_UTIL_PERCENT);
+        if (!d->device[0]) {
+            snprintf(d->device, sizeof(d->device), "-");
+        }
+    }
+
+    hw_stats_t *hw = &sys->hw;
+    uint32_t freq = HAVE(METRIC_CPU_FREQ_MHZ) ? (uint32_t)GET(METRIC_CPU_FREQ_MHZ) : 0;
+    hw->freq_min_mhz = hw->freq_avg_mhz = hw->freq_max_mhz = freq;
+    hw->hottest = -1;
+    if (HAVE(METRIC_CPU_TEMP_CELSIUS)) {
+        hw->sensor_count = 1;
+        hw->hottest = 0;
+        hw->sensors[0].celsius = (float)GET(METRIC_CPU_TEMP_CELSIUS);
+        if (!hw->sensors[0].label[0]) {
+            snprintf(hw->sensors[0].label, sizeof(hw->sensors[0].label), "hottest");
+        }
+    }
+
+    // Only the primary instance's figures are recorded
+    process_snapshot_t *proc = &snap->process;
+    proc->sequence++;
+    proc->instance_count = (HAVE(METRIC_SERVER_INSTANCES) && GET(METRIC_SERVER_INSTANCES) > 0) ? 1 : 0;
+    proc->primary = HAVE(METRIC_SERVER_RSS_KB) ? 0 : -1;
+    if (proc->primary == 0) {
+        proc->instances[0].rss_kb = (uint64_t)GET(METRIC_SERVER_RSS_KB);
+        if (!proc->instances[0].name[0]) {
+            snprintf(proc->instances[0].name, sizeof(proc->instances[0].name), "EnshroudedServer.exe");
+        }
+    }
+
+    a2s_snapshot_t *a2s = &snap->a2s;
+    a2s->sequence++;
+    a2s->available = HAVE(METRIC_SERVER_UP);
+    a2s->success = a2s->available && GET(METRIC_SERVER_UP) > 0.5;
+    if (a2s->success) {
+        a2s->info.players = (uint8_t)GET(METRIC_PLAYERS);
+        a2s->info.max_players = (uint8_t)GET(METRIC_MAX_PLAYERS);
+        a2s->rtt_ms = HAVE(METRIC_A2S_RTT_MS) ? GET(METRIC_A2S_RTT_MS) : 0.0;
+    }
+}
+
+#undef HAVE
+#undef GET
+
+int metrics_record(const emon_snapshot_t *snap, metrics_cursor_t *cursor, int64_t now,
+                   double *values) {
+    const uint64_t sequence[METRIC_SOURCE_COUNT] = {
+        snap->system.sequence, snap->process.sequence, snap->a2s.sequence
+    };
+
+    int fresh = 0;
+    for (int src = 0; src < METRIC_SOURCE_COUNT; src++) {
+        if (sequence[src] != cursor->sequence[src]) {
+            fresh |= 1 << src;
+            cursor->sequence[src] = sequence[src];
+        }
+    }
+    if (!fresh) {
+        return 0;
+    }
+
+    metrics_extract(snap, values);
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        if (fresh & (1 << descs[id].source)) {
+            tsdb_append(id, now, values[id]);
+        }
+    }
+
+    return fresh;
+}
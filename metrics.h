@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include "collector.h"
+
+// Every scalar emon samples, in a stable order shared by the time-series
+// store and exporters. Append new metrics at the end.
+typedef enum {
+    METRIC_CPU_PERCENT,
+    METRIC_STEAL_PERCENT,
+    METRIC_MEM_USED_KB,
+    METRIC_MEM_TOTAL_KB,
+    METRIC_SWAP_USED_KB,
+    METRIC_SWAP_IN_RATE,
+    METRIC_SWAP_OUT_RATE,
+    METRIC_OOM_KILLS,
+    METRIC_CGROUP_MEMORY_BYTES,
+    METRIC_CGROUP_CPU_PERCENT,
+    METRIC_CGROUP_THROTTLED_PERCENT,
+    METRIC_PSI_CPU_SOME,
+    METRIC_PSI_MEMORY_SOME,
+    METRIC_PSI_IO_SOME,
+    METRIC_DISK_READ_IOPS,
+    METRIC_DISK_WRITE_IOPS,
+    METRIC_DISK_READ_BYTES_PER_SEC,
+    METRIC_DISK_WRITE_BYTES_PER_SEC,
+    METRIC_DISK_AWAIT_MS,
+    METRIC_DISK_UTIL_PERCENT,
+    METRIC_CPU_FREQ_MHZ,
+    METRIC_CPU_TEMP_CELSIUS,
+    METRIC_SERVER_INSTANCES,
+    METRIC_SERVER_RSS_KB,
+    METRIC_SERVER_UP,
+    METRIC_PLAYERS,
+    METRIC_MAX_PLAYERS,
+    METRIC_A2S_RTT_MS,
+    METRIC_COUNT
+} metric_id_t;
+
+// Which collector produces a metric
+typedef enum {
+    METRIC_SOURCE_SYSTEM,
+    METRIC_SOURCE_PROCESS,
+    METRIC_SOURCE_A2S,
+    METRIC_SOURCE_COUNT
+} metric_source_t;
+
+typedef struct {
+    const char *name;          // snake_case, stable across releases
+    const char *help;
+    metric_source_t source;
+} metric_desc_t;
+
+// Last snapshot sequence recorded per collector
+typedef struct {
+    uint64_t sequence[METRIC_SOURCE_COUNT];
+} metrics_cursor_t;
+
+const metric_desc_t *metrics_desc(metric_id_t id);
+
+// Fill values[METRIC_COUNT] from a snapshot; unavailable metrics are NaN
+void metrics_extract(const emon_snapshot_t *snap, double *values);
+
+// Rebuild the parts of a snapshot that metrics cover from recorded values
+// (count entries of values, the rest treated as NaN). Per-core figures,
+// names and other non-scalar fields are left untouched.
+void metrics_apply(const float *values, int count, emon_snapshot_t *snap);
+
+// Append the metrics of every collector that published since the cursor
+// to the time-series store at time now, leaving all current values in
+// values[METRIC_COUNT]. Returns a bitmask of sources stored.
+int metrics_record(const emon_snapshot_t *snap, metrics_cursor_t *cursor, int64_t now,
+                   double *values);
+
+#endif // METRICS_H
@@ -0,0 +1,257 @@
+/*
+ * Streaming output
+ * Writes one JSON Lines object or CSV row per sample for log pipelines.
+ * Records are serialized by hand into a static buffer that is written out
+ * once per frame, so a sample costs no allocation and, at most, one
+ * write(); numbers never go through printf, which keeps them independent
+ * of the locale and cheap enough for 100 Hz.
+ */
+
+#include "output.h"
+#include "metrics.h"
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+
+static output_format_t format = OUTPUT_NONE;
+static int out_fd = -1;
+static char buffer[OUTPUT_BUFFER_SIZE];
+static size_t used = 0;
+
+static const char *source_names[METRIC_SOURCE_COUNT] = { "system", "process", "a2s" };
+
+static void put_char(char c) {
+    if (used < sizeof(buffer)) {
+        buffer[used++] = c;
+    }
+}
+
+static void put_str(const char *s) {
+    while (*s) {
+        put_char(*s++);
+    }
+}
+
+static void put_u64(uint64_t v) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) {
+        put_char(digits[--n]);
+    }
+}
+
+static void put_i64(int64_t v) {
+    if (v < 0) {
+        put_char('-');
+        put_u64((uint64_t)0 - (uint64_t)v);
+    } else {
+        put_u64((uint64_t)v);
+    }
+}
+
+// Fixed point with up to three decimals, trailing zeros trimmed; returns
+// -1 (nothing written) for NaN or values too large to scale
+static int put_number(double v) {
+    if (isnan(v) || fabs(v) >= 9e15) {
+        return -1;
+    }
+    if (v < 0) {
+        put_char('-');
+        v = -v;
+    }
+
+    uint64_t scaled = (uint64_t)(v * 1000.0 + 0.5);
+    unsigned frac = (unsigned)(scaled % 1000);
+    put_u64(scaled / 1000);
+    if (frac) {
+        char decimals[3] = { (char)('0' + frac / 100), (char)('0' + frac / 10 % 10),
+                             (char)('0' + frac % 10) };
+        int n = 3;
+        while (decimals[n - 1] == '0') {
+            n--;
+        }
+        put_char('.');
+        for (int i = 0; i < n; i++) {
+            put_char(decimals[i]);
+        }
+    }
+    return 0;
+}
+
+static void put_json_string(const char *s) {
+    static const char hex[] = "0123456789abcdef";
+    put_char('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            put_char('\\');
+            put_char((char)c);
+        } else if (c < 0x20) {
+            put_str("\\u00");
+            put_char(hex[c >> 4]);
+            put_char(hex[c & 0xf]);
+        } else {
+            put_char((char)c);
+        }
+    }
+    put_char('"');
+}
+
+// RFC 4180: quote every text field, double embedded quotes
+static void put_csv_string(const char *s) {
+    put_char('"');
+    for (; *s; s++) {
+        if (*s == '"') {
+            put_char('"');
+        }
+        put_char(*s);
+    }
+    put_char('"');
+}
+
+static void put_sources(int sources) {
+    int first = 1;
+    for (int i = 0; i < METRIC_SOURCE_COUNT; i++) {
+        if (sources & (1 << i)) {
+            if (!first) {
+                put_char('+');
+            }
+            put_str(source_names[i]);
+            first = 0;
+        }
+    }
+}
+
+static void write_csv_header(void) {
+    put_str("time_ms,sources");
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        put_char(',');
+        put_str(metrics_desc((metric_id_t)id)->name);
+    }
+    put_str(",server_name,server_version,server_status\n");
+}
+
+static void write_jsonl(int64_t time_ms, int sources, const emon_snapshot_t *snap,
+                        const double *values) {
+    put_str("{\"time_ms\":");
+    put_i64(time_ms);
+    put_str(",\"sources\":\"");
+    put_sources(sources);
+    put_char('"');
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        put_str(",\"");
+        put_str(metrics_desc((metric_id_t)id)->name);
+        put_str("\":");
+        if (put_number(values[id]) < 0) {
+            put_str("null");
+        }
+    }
+
+    if (snap->a2s.success) {
+        put_str(",\"server_name\":");
+        put_json_string(snap->a2s.info.name);
+        put_str(",\"server_version\":");
+        put_json_string(snap->a2s.info.version);
+        put_str(",\"server_status\":");
+        put_json_string(a2s_status_string(snap->a2s.info.status));
+    } else {
+        put_str(",\"server_name\":null,\"server_version\":null,\"server_status\":null");
+    }
+    put_str("}\n");
+}
+
+static void write_csv(int64_t time_ms, int sources, const emon_snapshot_t *snap,
+                      const double *values) {
+    put_i64(time_ms);
+    put_char(',');
+    put_sources(sources);
+
+    for (int id = 0; id < METRIC_COUNT; id++) {
+        put_char(',');
+        put_number(values[id]);
+    }
+
+    if (snap->a2s.success) {
+        put_char(',');
+        put_csv_string(snap->a2s.info.name);
+        put_char(',');
+        put_csv_string(snap->a2s.info.version);
+        put_char(',');
+        put_str(a2s_status_string(snap->a2s.info.status));
+        put_char('\n');
+    } else {
+        put_str(",,,\n");
+    }
+}
+
+int output_parse_format(const char *name, output_format_t *out) {
+    if (strcmp(name, "jsonl") == 0) {
+        *out = OUTPUT_JSONL;
+    } else if (strcmp(name, "csv") == 0) {
+        *out = OUTPUT_CSV;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int output_open(output_format_t fmt, int fd) {
+    if (fmt == OUTPUT_NONE || fd < 0) {
+        return -1;
+    }
+    format = fmt;
+    out_fd = fd;
+    used = 0;
+    if (format == OUTPUT_CSV) {
+        write_csv_header();
+    }
+    return 0;
+}
+
+int output_record(int64_t time_ms, int sources, const emon_snapshot_t *snap,
+                  const double *values) {
+    if (format == OUTPUT_NONE) {
+        return -1;
+    }
+    if (used > sizeof(buffer) - OUTPUT_MAX_RECORD && output_flush() < 0) {
+        return -1;
+    }
+
+    if (format == OUTPUT_JSONL) {
+        write_jsonl(time_ms, sources, snap, values);
+    } else {
+        write_csv(time_ms, sources, snap, values);
+    }
+    return 0;
+}
+
+int output_flush(void) {
+    size_t done = 0;
+    while (done < used) {
+        ssize_t n = write(out_fd, buffer + done, used - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            used = 0;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    used = 0;
+    return 0;
+}
+
+void output_close(void) {
+    if (format != OUTPUT_NONE) {
+        output_flush();
+    }
+    format = OUTPUT_NONE;
+    out_fd = -1;
+}
@@ -0,0 +1,34 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "collector.h"
+
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+#define OUTPUT_MAX_RECORD 4096     // Upper bound of one serialized record
+
+typedef enum {
+    OUTPUT_NONE,
+    OUTPUT_JSONL,                  // One JSON object per line
+    OUTPUT_CSV                     // Header line, then one row per sample
+} output_format_t;
+
+// Parse "jsonl" or "csv", returns -1 for anything else
+int output_parse_format(const char *name, output_format_t *format);
+
+// Start streaming records to fd (CSV writes its header line here)
+int output_open(output_format_t format, int fd);
+
+// Serialize one sample: the current values plus server identity. sources
+// is the metrics_record() bitmask of collectors that refreshed.
+int output_record(int64_t time_ms, int sources, const emon_snapshot_t *snap,
+                  const double *values);
+
+// Write out everything buffered, returns -1 once the reader has gone away
+int output_flush(void);
+
+// Flush and stop (the descriptor is left open)
+void output_close(void);
+
+#endif // OUTPUT_H
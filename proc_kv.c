@@ -0,0 +1,91 @@
+/*
+ * Keyword-table parser for key/value procfs files
+ */
+
+#include "proc_kv.h"
+#include <string.h>
+
+int proc_kv_table_init(proc_kv_table_t *table, const proc_kv_key_t *keys, int count) {
+    if (count <= 0 || count > PROC_KV_MAX_KEYS) {
+        return -1;
+    }
+
+    memset(table, 0, sizeof(*table));
+    table->keys = keys;
+    table->count = count;
+
+    // Counting sort of key indices by first character
+    int bucket[256] = {0};
+    for (int i = 0; i < count; i++) {
+        size_t len = strlen(keys[i].name);
+        if (len == 0 || len > 255) {
+            return -1;
+        }
+        table->key_len[i] = (uint8_t)len;
+        bucket[(unsigned char)keys[i].name[0]]++;
+    }
+
+    int pos = 0;
+    for (int c = 0; c < 256; c++) {
+        table->first[c] = (uint8_t)pos;
+        pos += bucket[c];
+        table->last[c] = (uint8_t)pos;
+        bucket[c] = table->first[c];
+    }
+
+    for (int i = 0; i < count; i++) {
+        unsigned char c = (unsigned char)keys[i].name[0];
+        table->order[bucket[c]++] = (uint8_t)i;
+    }
+
+    return 0;
+}
+
+int proc_kv_parse(const proc_kv_table_t *table, const char *buf, size_t len, uint64_t *values) {
+    const char *p = buf;
+    const char *end = buf + len;
+    int found = 0;
+
+    while (p < end && found < table->count) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) {
+            line_end = end;
+        }
+
+        // Key runs up to ':' (meminfo) or ' ' (vmstat, cgroup files)
+        const char *key = p;
+        while (p < line_end && *p != ':' && *p != ' ') {
+            p++;
+        }
+        size_t key_len = p - key;
+
+        unsigned char c = key_len ? (unsigned char)key[0] : 0;
+        for (int i = table->first[c]; key_len && i < table->last[c]; i++) {
+            const proc_kv_key_t *k = &table->keys[table->order[i]];
+            if (table->key_len[table->order[i]] != key_len ||
+                memcmp(k->name, key, key_len) != 0) {
+                continue;
+            }
+
+            // Skip separator and padding, then read the decimal value
+            while (p < line_end && (*p == ':' || *p == ' ' || *p == '\t')) {
+                p++;
+            }
+            uint64_t v = 0;
+            const char *digits = p;
+            while (p < line_end && *p >= '0' && *p <= '9') {
+                v = v * 10 + (uint64_t)(*p - '0');
+                p++;
+            }
+            if (p != digits) {
+                values[k->slot] = v;
+                found++;
+            }
+            break;
+        }
+
+        p = line_end + 1;
+    }
+
+    return found;
+}
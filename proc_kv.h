@@ -0,0 +1,35 @@
+#ifndef PROC_KV_H
+#define PROC_KV_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Single-pass parser for "Key: value" / "key value" procfs files such as
+// /proc/meminfo, /proc/vmstat and cgroup memory.events / cpu.stat.
+// Keys are dispatched through a first-character index built once, so each
+// line costs one table lookup and at most a couple of memcmp()s.
+
+#define PROC_KV_MAX_KEYS 64
+
+typedef struct {
+    const char *name;
+    int slot;                    // Index into the caller's value array
+} proc_kv_key_t;
+
+typedef struct {
+    const proc_kv_key_t *keys;
+    int count;
+    uint8_t order[PROC_KV_MAX_KEYS];   // Key indices grouped by first character
+    uint8_t key_len[PROC_KV_MAX_KEYS];
+    uint8_t first[256];                // Range of order[] for each first character
+    uint8_t last[256];
+} proc_kv_table_t;
+
+// Build the dispatch index for a key table
+int proc_kv_table_init(proc_kv_table_t *table, const proc_kv_key_t *keys, int count);
+
+// Parse buf, storing each matched key's value in values[slot].
+// Stops as soon as every key has been seen. Returns the number of keys found.
+int proc_kv_parse(const proc_kv_table_t *table, const char *buf, size_t len, uint64_t *values);
+
+#endif // PROC_KV_H
@@ -1,5 +1,6 @@
 #define _GNU_SOURCE
 #include "process_monitor.h"
+#include "selfstats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,16 +8,176 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <strings.h>
 
+#define MAX_PROC_PATH 384
+
+static char proc_root[256] = "/proc";
 static long boot_time = 0;
 
+// PIDs whose comm and cmdline did not match, so the cached scan can skip
+// their cmdline read. Rebuilt from the PIDs present on every scan (exited
+// processes drop out) into a second table that is then swapped in.
+// Every PID's stat is still read each scan: an entry only applies while
+// its starttime (a reused PID is a new process) and comm (changed by exec)
+// are the same. It is trusted after two consecutive misses, and expires
+// after MISS_TTL_SCANS as a backstop for an exec that keeps its comm.
+#define MISS_TTL_SCANS 30
+#define MISS_MIN_CAPACITY 1024
+
+typedef struct {
+    uint32_t pid;              // 0 = empty slot
+    uint32_t comm_hash;        // comm when last checked
+    uint64_t starttime;        // Tells a reused PID from the process it replaced
+    uint16_t misses;           // Consecutive non-matching checks
+    uint16_t age;              // Scans since the entry was last checked
+} miss_entry_t;
+
+typedef struct {
+    miss_entry_t *slots;
+    uint32_t capacity;         // Power of two
+    uint32_t count;
+} miss_table_t;
+
+static process_scan_mode_t scan_mode = PROCESS_SCAN_CACHED;
+static miss_table_t miss_tables[2];
+static int miss_current = 0;
+static char miss_target[MAX_PROCESS_NAME];
+
+// Every match of one scan, launchers included, before they are collapsed
+static process_info_t *matches = NULL;
+static int match_capacity = 0;
+
+static void miss_reset(void) {
+    for (int i = 0; i < 2; i++) {
+        free(miss_tables[i].slots);
+        miss_tables[i].slots = NULL;
+        miss_tables[i].capacity = 0;
+        miss_tables[i].count = 0;
+    }
+    miss_target[0] = '\0';
+}
+
+static uint32_t miss_hash(uint32_t pid, uint32_t capacity) {
+    return (pid * 2654435761u) & (capacity - 1);
+}
+
+static const miss_entry_t *miss_lookup(const miss_table_t *table, uint32_t pid) {
+    if (!table->slots) {
+        return NULL;
+    }
+    for (uint32_t i = miss_hash(pid, table->capacity);; i = (i + 1) & (table->capacity - 1)) {
+        if (table->slots[i].pid == pid) {
+            return &table->slots[i];
+        }
+        if (table->slots[i].pid == 0) {
+            return NULL;
+        }
+    }
+}
+
+static void miss_place(miss_table_t *table, const miss_entry_t *entry) {
+    uint32_t i = miss_hash(entry->pid, table->capacity);
+    while (table->slots[i].pid != 0) {
+        i = (i + 1) & (table->capacity - 1);
+    }
+    table->slots[i] = *entry;
+    table->count++;
+}
+
+// Double a table that passed 3/4 load; on allocation failure it just stops
+// caching and the remaining PIDs are checked every scan
+static int miss_grow(miss_table_t *table) {
+    uint32_t capacity = table->capacity * 2;
+    miss_entry_t *slots = calloc(capacity, sizeof(miss_entry_t));
+    if (!slots) {
+        return -1;
+    }
+
+    miss_table_t grown = { slots, capacity, 0 };
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        if (table->slots[i].pid != 0) {
+            miss_place(&grown, &table->slots[i]);
+        }
+    }
+    free(table->slots);
+    *table = grown;
+    return 0;
+}
+
+static void miss_insert(miss_table_t *table, const miss_entry_t *entry) {
+    if (!table->slots) {
+        return;
+    }
+    if (table->count >= table->capacity / 4 * 3 && miss_grow(table) < 0) {
+        return;
+    }
+    miss_place(table, entry);
+}
+
+// FNV-1a; a collision only costs a skipped exec check until the entry expires
+static uint32_t comm_hash(const char *comm) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)comm; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+// Empty the next table, sized for twice the PIDs the current one holds
+static void miss_prepare_next(void) {
+    miss_table_t *next = &miss_tables[!miss_current];
+    uint32_t want = MISS_MIN_CAPACITY;
+    while (want < miss_tables[miss_current].count * 2 + MISS_MIN_CAPACITY) {
+        want *= 2;
+    }
+
+    if (next->capacity != want) {
+        miss_entry_t *slots = realloc(next->slots, want * sizeof(miss_entry_t));
+        if (!slots) {
+            // Nothing is cached this scan
+            free(next->slots);
+            next->slots = NULL;
+            next->capacity = 0;
+            next->count = 0;
+            return;
+        }
+        next->slots = slots;
+        next->capacity = want;
+    }
+    memset(next->slots, 0, next->capacity * sizeof(miss_entry_t));
+    next->count = 0;
+}
+
+void process_monitor_set_proc_root(const char *root) {
+    snprintf(proc_root, sizeof(proc_root), "%s", root ? root : "/proc");
+    boot_time = 0;
+    miss_reset();
+}
+
+void process_monitor_set_scan_mode(process_scan_mode_t mode) {
+    scan_mode = mode;
+    miss_reset();
+}
+
+void process_monitor_cleanup(void) {
+    miss_reset();
+    free(matches);
+    matches = NULL;
+    match_capacity = 0;
+}
+
 // Get system boot time from /proc/stat
 static long get_boot_time(void) {
     if (boot_time != 0) {
         return boot_time;
     }
 
-    FILE *fp = fopen("/proc/stat", "r");
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/stat", proc_root);
+
+    selfstats_count_open();
+    FILE *fp = fopen(path, "r");
     if (!fp) {
         return -1;
     }
@@ -45,9 +206,10 @@ static int is_pid(const char *str) {
 
 // Read process name from /proc/[pid]/comm
 static int read_process_name(pid_t pid, char *name, size_t max_len) {
-    char path[64];
-    snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/%d/comm", proc_root, pid);
 
+    selfstats_count_open();
     FILE *fp = fopen(path, "r");
     if (!fp) {
         return -1;
@@ -71,9 +233,10 @@ static int read_process_name(pid_t pid, char *name, size_t max_len) {
 
 // Read process cmdline from /proc/[pid]/cmdline (for Wine processes)
 static int read_process_cmdline(pid_t pid, char *cmdline, size_t max_len) {
-    char path[64];
-    snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/%d/cmdline", proc_root, pid);
 
+    selfstats_count_open();
     FILE *fp = fopen(path, "r");
     if (!fp) {
         return -1;
@@ -99,9 +262,10 @@ static int read_process_cmdline(pid_t pid, char *cmdline, size_t max_len) {
 }
 
 int process_get_memory(pid_t pid, uint64_t *rss_kb) {
-    char path[64];
-    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/%d/status", proc_root, pid);
 
+    selfstats_count_open();
     FILE *fp = fopen(path, "r");
     if (!fp) {
         return -1;
@@ -121,43 +285,58 @@ int process_get_memory(pid_t pid, uint64_t *rss_kb) {
     return found ? 0 : -1;
 }
 
-uint64_t process_get_uptime(pid_t pid) {
-    char path[64];
-    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+// Read ppid (field 4) and starttime (field 22) from /proc/[pid]/stat
+static int read_process_stat(pid_t pid, pid_t *ppid, unsigned long long *starttime,
+                             char *comm, size_t comm_size) {
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_root, pid);
 
+    selfstats_count_open();
     FILE *fp = fopen(path, "r");
     if (!fp) {
-        return 0;
+        return -1;
     }
 
     char buffer[1024];
     if (!fgets(buffer, sizeof(buffer), fp)) {
         fclose(fp);
-        return 0;
+        return -1;
     }
     fclose(fp);
 
-    // Parse the 22nd field (starttime) from /proc/[pid]/stat
     // Format: pid (comm) state ppid ... starttime ...
-    char *p = strchr(buffer, ')');
-    if (!p) {
-        return 0;
+    // comm may contain spaces or ')' so search from the end
+    char *open = strchr(buffer, '(');
+    char *p = strrchr(buffer, ')');
+    if (!open || !p || p < open || p[1] == '\0') {
+        return -1;
+    }
+    if (comm) {
+        snprintf(comm, comm_size, "%.*s", (int)(p - open - 1), open + 1);
     }
     p += 2; // Skip ") "
 
-    unsigned long long starttime = 0;
     int field = 3; // We're now at field 3 (state)
-
     while (field < 22 && *p) {
+        if (field == 4 && ppid) {
+            *ppid = (pid_t)strtol(p, NULL, 10);
+        }
         while (*p && *p != ' ') p++;
         while (*p && *p == ' ') p++;
         field++;
     }
 
-    if (field == 22) {
-        sscanf(p, "%llu", &starttime);
+    if (field != 22) {
+        return -1;
     }
 
+    if (starttime) {
+        *starttime = strtoull(p, NULL, 10);
+    }
+    return 0;
+}
+
+static uint64_t starttime_to_uptime(unsigned long long starttime) {
     long btime = get_boot_time();
     if (btime <= 0) {
         return 0;
@@ -175,59 +354,360 @@ uint64_t process_get_uptime(pid_t pid) {
     return (now > process_start) ? (now - process_start) : 0;
 }
 
-int process_find_by_name(const char *target_name, process_info_t *info) {
-    DIR *proc_dir = opendir("/proc");
+uint64_t process_get_uptime(pid_t pid) {
+    unsigned long long starttime = 0;
+    if (read_process_stat(pid, NULL, &starttime, NULL, 0) < 0) {
+        return 0;
+    }
+    return starttime_to_uptime(starttime);
+}
+
+uint16_t process_parse_query_port_arg(const char *cmdline) {
+    static const char key[] = "queryport";
+    const size_t key_len = sizeof(key) - 1;
+
+    for (const char *p = cmdline; *p; p++) {
+        if (strncasecmp(p, key, key_len) != 0) {
+            continue;
+        }
+        // Must start an argument: "-queryport", "--queryPort", "queryport"
+        if (p != cmdline && p[-1] != '-' && p[-1] != ' ') {
+            continue;
+        }
+
+        const char *v = p + key_len;
+        if (*v != '=' && *v != ' ' && *v != ':') {
+            continue;
+        }
+        v++;
+
+        char *end;
+        long port = strtol(v, &end, 10);
+        if (end != v && port > 0 && port <= 65535) {
+            return (uint16_t)port;
+        }
+    }
+
+    return 0;
+}
+
+uint16_t process_pick_query_port(const uint16_t *ports, int count) {
+    uint16_t best = 0;
+    uint16_t highest = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (ports[i] > highest) {
+            highest = ports[i];
+        }
+        for (int j = 0; j < count; j++) {
+            if (ports[j] + 1 == ports[i] && ports[i] > best) {
+                best = ports[i];
+            }
+        }
+    }
+
+    return best ? best : highest;
+}
+
+// Bound UDP sockets from /proc/net/udp{,6}, loaded once per scan
+#define MAX_UDP_SOCKETS 4096
+
+typedef struct {
+    unsigned long inode;
+    uint16_t port;
+} udp_socket_t;
+
+static udp_socket_t udp_sockets[MAX_UDP_SOCKETS];
+static int udp_socket_count = 0;
+
+static void load_udp_table(const char *path) {
+    selfstats_count_open();
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return;
+    }
+
+    char buffer[512];
+    // Skip header line
+    if (!fgets(buffer, sizeof(buffer), fp)) {
+        fclose(fp);
+        return;
+    }
+
+    while (udp_socket_count < MAX_UDP_SOCKETS && fgets(buffer, sizeof(buffer), fp)) {
+        // sl local_address rem_address st tx:rx tr:when retrnsmt uid timeout inode
+        unsigned int port, state;
+        unsigned long inode;
+        if (sscanf(buffer, " %*d: %*[0-9A-Fa-f]:%x %*[0-9A-Fa-f]:%*x %x %*s %*s %*s %*u %*d %lu",
+                   &port, &state, &inode) != 3) {
+            continue;
+        }
+        // UDP sockets that are bound but unconnected report TCP_CLOSE (07)
+        if (state != 0x07 || port == 0 || inode == 0) {
+            continue;
+        }
+        udp_sockets[udp_socket_count].inode = inode;
+        udp_sockets[udp_socket_count].port = (uint16_t)port;
+        udp_socket_count++;
+    }
+
+    fclose(fp);
+}
+
+// Resolve the query port of a process from the UDP sockets it holds open
+static uint16_t find_socket_query_port(pid_t pid) {
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/%d/fd", proc_root, pid);
+
+    selfstats_count_open();
+    DIR *fd_dir = opendir(path);
+    if (!fd_dir) {
+        return 0;
+    }
+
+    uint16_t ports[32];
+    int port_count = 0;
+    struct dirent *entry;
+
+    while ((entry = readdir(fd_dir)) != NULL && port_count < 32) {
+        if (!is_pid(entry->d_name)) {
+            continue;
+        }
+
+        char link_path[MAX_PROC_PATH + 256];
+        char target[64];
+        snprintf(link_path, sizeof(link_path), "%s/%d/fd/%s", proc_root, pid, entry->d_name);
+        ssize_t len = readlink(link_path, target, sizeof(target) - 1);
+        if (len <= 0) {
+            continue;
+        }
+        target[len] = '\0';
+
+        unsigned long inode;
+        if (sscanf(target, "socket:[%lu]", &inode) != 1) {
+            continue;
+        }
+
+        for (int i = 0; i < udp_socket_count; i++) {
+            if (udp_sockets[i].inode == inode) {
+                ports[port_count++] = udp_sockets[i].port;
+                break;
+            }
+        }
+    }
+
+    closedir(fd_dir);
+    return process_pick_query_port(ports, port_count);
+}
+
+// Room for one more match in the scratch array; 0 if it cannot grow
+static int reserve_match(int count) {
+    if (count < match_capacity) {
+        return 1;
+    }
+    int capacity = match_capacity ? match_capacity * 2 : MAX_SERVER_INSTANCES * 2;
+    process_info_t *grown = realloc(matches, (size_t)capacity * sizeof(*grown));
+    if (!grown) {
+        return 0;
+    }
+    matches = grown;
+    match_capacity = capacity;
+    return 1;
+}
+
+int process_find_all_by_name(const char *target_name, process_info_t *list, int max_count) {
+    if (max_count <= 0) {
+        return 0;
+    }
+
+    selfstats_count_open();
+    DIR *proc_dir = opendir(proc_root);
     if (!proc_dir) {
         return -1;
     }
 
     struct dirent *entry;
-    int found = 0;
+    pid_t self = getpid();
+    int count = 0;
+    int need_sockets = 0;
+
+    int cached = (scan_mode == PROCESS_SCAN_CACHED);
+    if (cached) {
+        if (strcmp(miss_target, target_name) != 0) {
+            miss_reset();
+            snprintf(miss_target, sizeof(miss_target), "%s", target_name);
+        }
+        miss_prepare_next();
+    }
+    const miss_table_t *known = &miss_tables[miss_current];
+    miss_table_t *next = &miss_tables[!miss_current];
 
+    // Walk every PID: launchers only collapse once all matches are in, and
+    // the next miss table must cover the whole directory
     while ((entry = readdir(proc_dir)) != NULL) {
         if (!is_pid(entry->d_name)) {
             continue;
         }
 
         pid_t pid = atoi(entry->d_name);
+        if (pid == self) {
+            continue;
+        }
+
+        // One read gives comm, ppid and starttime; a PID that is gone
+        // by now has exited
         char name[MAX_PROCESS_NAME];
+        pid_t ppid = 0;
+        unsigned long long starttime = 0;
+        if (read_process_stat(pid, &ppid, &starttime, name, sizeof(name)) < 0) {
+            continue;
+        }
+
+        miss_entry_t seen = { (uint32_t)pid, comm_hash(name), starttime, 0, 0 };
+        if (cached) {
+            const miss_entry_t *miss = miss_lookup(known, (uint32_t)pid);
+            if (miss && (miss->starttime != starttime || miss->comm_hash != seen.comm_hash)) {
+                miss = NULL; // Reused PID or exec: a different program now
+            }
+            if (miss && miss->misses >= 2 && miss->age < MISS_TTL_SCANS) {
+                seen.misses = miss->misses;
+                seen.age = miss->age + 1;
+                miss_insert(next, &seen);
+                continue;
+            }
+            seen.misses = miss ? miss->misses : 0;
+        }
+
+        if (!reserve_match(count)) {
+            continue;
+        }
+        process_info_t *info = &matches[count];
         char cmdline[512];
+        int matched = 0;
 
         // Try comm first
-        if (read_process_name(pid, name, sizeof(name)) == 0) {
-            if (strcasestr(name, target_name) != NULL) {
-                found = 1;
-                info->pid = pid;
-                strncpy(info->name, name, MAX_PROCESS_NAME - 1);
-                info->name[MAX_PROCESS_NAME - 1] = '\0';
-                break;
-            }
+        if (strcasestr(name, target_name) != NULL) {
+            matched = 1;
+            snprintf(info->name, sizeof(info->name), "%s", name);
         }
 
-        // For Wine processes, check cmdline
+        // For Wine processes, check cmdline. Read it even on a comm match so
+        // the query port argument can be picked up.
         if (read_process_cmdline(pid, cmdline, sizeof(cmdline)) == 0) {
-            if (strcasestr(cmdline, target_name) != NULL) {
-                found = 1;
-                info->pid = pid;
+            if (!matched && strcasestr(cmdline, target_name) != NULL) {
+                matched = 1;
                 strncpy(info->name, target_name, MAX_PROCESS_NAME - 1);
-                info->name[MAX_PROCESS_NAME - 1] = '\0';
-                break;
             }
+        } else {
+            cmdline[0] = '\0';
         }
+
+        if (!matched) {
+            if (cached) {
+                seen.misses = seen.misses < 2 ? seen.misses + 1 : 2;
+                miss_insert(next, &seen);
+            }
+            continue;
+        }
+
+        info->name[MAX_PROCESS_NAME - 1] = '\0';
+        info->pid = pid;
+        info->ppid = ppid;
+        info->uptime_seconds = starttime_to_uptime(starttime);
+        info->query_port = process_parse_query_port_arg(cmdline);
+        if (info->query_port == 0) {
+            need_sockets = 1;
+        }
+        count++;
     }
 
     closedir(proc_dir);
+    if (cached) {
+        miss_current = !miss_current;
+    }
+
+    // Collapse launchers: drop any match that is the parent of another
+    // match, then keep as many instances as the caller has room for
+    int kept = 0;
+    for (int i = 0; i < count && kept < max_count; i++) {
+        int is_parent = 0;
+        for (int j = 0; j < count; j++) {
+            if (j != i && matches[j].ppid == matches[i].pid) {
+                is_parent = 1;
+                break;
+            }
+        }
+        if (!is_parent) {
+            list[kept++] = matches[i];
+        }
+    }
+    count = kept;
+
+    // Socket table is read once per scan, not once per instance
+    if (need_sockets && count > 0) {
+        udp_socket_count = 0;
+        char path[MAX_PROC_PATH];
+        snprintf(path, sizeof(path), "%s/net/udp", proc_root);
+        load_udp_table(path);
+        snprintf(path, sizeof(path), "%s/net/udp6", proc_root);
+        load_udp_table(path);
+    }
+
+    for (int i = 0; i < count; i++) {
+        process_info_t *info = &list[i];
+        if (info->query_port == 0) {
+            info->query_port = find_socket_query_port(info->pid);
+        }
+        if (process_get_memory(info->pid, &info->rss_kb) < 0) {
+            info->rss_kb = 0;
+        }
+        info->cpu_percent = 0.0; // TODO: Implement CPU percentage for specific process
+    }
 
-    if (!found) {
+    return count;
+}
+
+int process_find_by_name(const char *target_name, process_info_t *info) {
+    return (process_find_all_by_name(target_name, info, 1) > 0) ? 0 : -1;
+}
+
+int process_get_cgroup_dir(pid_t pid, char *dir, size_t dir_size) {
+    char path[MAX_PROC_PATH];
+    snprintf(path, sizeof(path), "%s/%d/cgroup", proc_root, pid);
+
+    selfstats_count_open();
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
         return -1;
     }
 
-    // Get additional process info
-    process_get_memory(info->pid, &info->rss_kb);
-    info->uptime_seconds = process_get_uptime(info->pid);
-    info->cpu_percent = 0.0; // TODO: Implement CPU percentage for specific process
+    // The unified hierarchy is the "0::<path>" entry
+    char buffer[512];
+    char cgroup_path[448] = "";
+    while (fgets(buffer, sizeof(buffer), fp)) {
+        if (strncmp(buffer, "0::", 3) == 0) {
+            size_t len = strcspn(buffer + 3, "\n");
+            if (len >= sizeof(cgroup_path)) {
+                len = sizeof(cgroup_path) - 1;
+            }
+            memcpy(cgroup_path, buffer + 3, len);
+            cgroup_path[len] = '\0';
+            break;
+        }
+    }
+    fclose(fp);
 
-    return 0;
+    if (cgroup_path[0] != '/') {
+        return -1;
+    }
+
+    const char *mount = "/sys/fs/cgroup";
+    if (access("/sys/fs/cgroup/cgroup.controllers", F_OK) != 0) {
+        mount = "/sys/fs/cgroup/unified";
+    }
+
+    snprintf(dir, dir_size, "%s%s", mount, strcmp(cgroup_path, "/") == 0 ? "" : cgroup_path);
+    return access(dir, F_OK) == 0 ? 0 : -1;
 }
 
 int process_get_info(pid_t pid, process_info_t *info) {
@@ -241,7 +721,13 @@ int process_get_info(pid_t pid, process_info_t *info) {
         info->rss_kb = 0;
     }
 
-    info->uptime_seconds = process_get_uptime(pid);
+    unsigned long long starttime = 0;
+    info->ppid = 0;
+    info->uptime_seconds = 0;
+    if (read_process_stat(pid, &info->ppid, &starttime, NULL, 0) == 0) {
+        info->uptime_seconds = starttime_to_uptime(starttime);
+    }
+    info->query_port = 0;
     info->cpu_percent = 0.0;
 
     return 0;
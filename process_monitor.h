@@ -6,6 +6,7 @@
 #include <time.h>
 
 #define MAX_PROCESS_NAME 256
+#define MAX_SERVER_INSTANCES 16
 
 typedef struct {
     pid_t pid;
@@ -14,17 +15,52 @@ typedef struct {
     double cpu_percent;
     time_t start_time;        // Process start time
     uint64_t uptime_seconds;  // Process uptime
+    pid_t ppid;               // Parent PID
+    uint16_t query_port;      // A2S query port (0 if unknown)
 } process_info_t;
 
+typedef enum {
+    PROCESS_SCAN_FULL,        // Read stat and cmdline of every PID on every scan
+    PROCESS_SCAN_CACHED       // Skip the cmdline of PIDs that recently failed to match
+                              // and have not exec'd or been reused since (default)
+} process_scan_mode_t;
+
+// Read /proc from another directory (fixtures, benchmarks); NULL restores /proc
+void process_monitor_set_proc_root(const char *root);
+
+// Choose how process_find_all_by_name() walks /proc; drops the miss cache
+void process_monitor_set_scan_mode(process_scan_mode_t mode);
+
+// Release the miss cache
+void process_monitor_cleanup(void);
+
 // Find process by name (e.g., "EnshroudedServer.exe")
 int process_find_by_name(const char *name, process_info_t *info);
 
+// Find every process matching name in a single /proc walk.
+// Wrapper processes (wine launchers, shell scripts) whose child also matches
+// are collapsed into the child. Returns the number of instances stored in
+// list (at most max_count), or -1 on error.
+int process_find_all_by_name(const char *name, process_info_t *list, int max_count);
+
+// Parse "-queryport=N" / "--queryPort N" style arguments from a cmdline
+// (NUL bytes already replaced by spaces). Returns 0 if not present.
+uint16_t process_parse_query_port_arg(const char *cmdline);
+
+// Pick the A2S query port from a set of bound UDP ports. Enshrouded binds the
+// query port directly above the game port, so prefer the upper port of a pair.
+uint16_t process_pick_query_port(const uint16_t *ports, int count);
+
 // Get detailed process information by PID
 int process_get_info(pid_t pid, process_info_t *info);
 
 // Calculate process uptime
 uint64_t process_get_uptime(pid_t pid);
 
+// Resolve the cgroup v2 directory of a process under /sys/fs/cgroup
+// (or /sys/fs/cgroup/unified on hybrid hosts)
+int process_get_cgroup_dir(pid_t pid, char *dir, size_t dir_size);
+
 // Get process memory usage
 int process_get_memory(pid_t pid, uint64_t *rss_kb);
 
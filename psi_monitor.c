@@ -0,0 +1,233 @@
+/*
+ * Pressure Stall Information collector
+ * Reads /proc/pressure/{cpu,memory,io} and, when set, the server's cgroup
+ * *.pressure files. Host triggers wake the main loop through poll().
+ */
+
+#define _GNU_SOURCE
+#include "psi_monitor.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+static const char *resource_names[PSI_RESOURCE_COUNT] = { "cpu", "memory", "io" };
+
+static const uint32_t trigger_stall_us[PSI_RESOURCE_COUNT] = {
+    PSI_CPU_STALL_US, PSI_MEMORY_STALL_US, PSI_IO_STALL_US
+};
+
+static int host_fds[PSI_RESOURCE_COUNT] = { -1, -1, -1 };
+static int cgroup_fds[PSI_RESOURCE_COUNT] = { -1, -1, -1 };
+
+typedef struct {
+    int fd;
+    psi_resource_id_t resource;
+} psi_trigger_t;
+
+static psi_trigger_t triggers[PSI_MAX_TRIGGERS];
+static int trigger_count = 0;
+static time_t last_trigger[PSI_RESOURCE_COUNT];
+static int initialized = 0;
+static char proc_root[256] = "/proc";
+
+int psi_parse(const char *buffer, psi_resource_t *resource) {
+    memset(resource, 0, sizeof(*resource));
+
+    const char *line = buffer;
+    int found = 0;
+
+    while (line && *line) {
+        psi_line_t parsed;
+        unsigned long long total = 0;
+
+        if (sscanf(line, "some avg10=%f avg60=%f avg300=%f total=%llu",
+                   &parsed.avg10, &parsed.avg60, &parsed.avg300, &total) == 4) {
+            parsed.total_us = total;
+            resource->some = parsed;
+            found = 1;
+        } else if (sscanf(line, "full avg10=%f avg60=%f avg300=%f total=%llu",
+                          &parsed.avg10, &parsed.avg60, &parsed.avg300, &total) == 4) {
+            parsed.total_us = total;
+            resource->full = parsed;
+            resource->has_full = 1;
+        }
+
+        line = strchr(line, '\n');
+        if (line) {
+            line++;
+        }
+    }
+
+    return found ? 0 : -1;
+}
+
+// Re-read a cached pressure file descriptor from offset 0
+static int read_pressure_fd(int fd, psi_resource_t *resource) {
+    char buffer[256];
+
+    ssize_t len = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (len <= 0) {
+        return -1;
+    }
+    buffer[len] = '\0';
+
+    return psi_parse(buffer, resource);
+}
+
+// Register a trigger: writing "<some|full> <stall us> <window us>" turns the
+// descriptor into an event source that raises POLLPRI when crossed
+static int register_trigger(psi_resource_id_t resource) {
+    if (trigger_count >= PSI_MAX_TRIGGERS) {
+        return -1;
+    }
+
+    char path[320];
+    snprintf(path, sizeof(path), "%s/pressure/%s", proc_root, resource_names[resource]);
+
+    selfstats_count_open();
+    int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    char spec[64];
+    int len = snprintf(spec, sizeof(spec), "some %u %u",
+                       trigger_stall_us[resource], PSI_TRIGGER_WINDOW_US);
+    if (write(fd, spec, len + 1) < 0) {
+        // EPERM/EINVAL on older kernels: fall back to polling only
+        close(fd);
+        return -1;
+    }
+
+    triggers[trigger_count].fd = fd;
+    triggers[trigger_count].resource = resource;
+    trigger_count++;
+    return 0;
+}
+
+int psi_monitor_init(void) {
+    if (initialized) {
+        return 0;
+    }
+
+    int opened = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/pressure/%s", proc_root, resource_names[i]);
+        selfstats_count_open();
+        host_fds[i] = open(path, O_RDONLY | O_CLOEXEC);
+        if (host_fds[i] >= 0) {
+            opened++;
+            // Writing a trigger spec to a fixture file would overwrite it
+            if (strcmp(proc_root, "/proc") == 0) {
+                register_trigger((psi_resource_id_t)i);
+            }
+        }
+    }
+
+    memset(last_trigger, 0, sizeof(last_trigger));
+    initialized = 1;
+
+    // Kernel without CONFIG_PSI (or psi=0)
+    return opened > 0 ? 0 : -1;
+}
+
+void psi_monitor_set_proc_root(const char *root) {
+    psi_monitor_cleanup();
+    snprintf(proc_root, sizeof(proc_root), "%s", root ? root : "/proc");
+}
+
+int psi_monitor_set_cgroup(const char *cgroup_dir) {
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (cgroup_fds[i] >= 0) {
+            close(cgroup_fds[i]);
+            cgroup_fds[i] = -1;
+        }
+    }
+
+    if (!cgroup_dir) {
+        return 0;
+    }
+
+    int opened = 0;
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.pressure", cgroup_dir, resource_names[i]);
+        selfstats_count_open();
+        cgroup_fds[i] = open(path, O_RDONLY | O_CLOEXEC);
+        if (cgroup_fds[i] >= 0) {
+            opened++;
+        }
+    }
+
+    return opened > 0 ? 0 : -1;
+}
+
+int psi_monitor_get_stats(psi_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (host_fds[i] >= 0 && read_pressure_fd(host_fds[i], &stats->host[i]) == 0) {
+            stats->host_available = 1;
+        }
+        if (cgroup_fds[i] >= 0 && read_pressure_fd(cgroup_fds[i], &stats->cgroup[i]) == 0) {
+            stats->cgroup_available = 1;
+        }
+        stats->last_trigger[i] = last_trigger[i];
+    }
+
+    return stats->host_available ? 0 : -1;
+}
+
+int psi_monitor_trigger_fds(struct pollfd *fds, int max_fds) {
+    int count = 0;
+    for (int i = 0; i < trigger_count && count < max_fds; i++) {
+        fds[count].fd = triggers[i].fd;
+        fds[count].events = POLLPRI;
+        fds[count].revents = 0;
+        count++;
+    }
+    return count;
+}
+
+int psi_monitor_check_triggers(const struct pollfd *fds, int count) {
+    int fired = 0;
+    time_t now = time(NULL);
+
+    for (int i = 0; i < count && i < trigger_count; i++) {
+        if (fds[i].revents & POLLPRI) {
+            last_trigger[triggers[i].resource] = now;
+            fired |= 1 << triggers[i].resource;
+        }
+    }
+
+    return fired;
+}
+
+const char* psi_resource_name(psi_resource_id_t resource) {
+    if ((int)resource < 0 || resource >= PSI_RESOURCE_COUNT) {
+        return "unknown";
+    }
+    return resource_names[resource];
+}
+
+void psi_monitor_cleanup(void) {
+    psi_monitor_set_cgroup(NULL);
+
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        if (host_fds[i] >= 0) {
+            close(host_fds[i]);
+            host_fds[i] = -1;
+        }
+    }
+
+    for (int i = 0; i < trigger_count; i++) {
+        close(triggers[i].fd);
+    }
+    trigger_count = 0;
+    initialized = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef PSI_MONITOR_H
+#define PSI_MONITOR_H
+
+#include <stdint.h>
+#include <poll.h>
+#include <time.h>
+
+// Trigger defaults: fire when tasks stall this long within a 2s window.
+// Unprivileged triggers require the window to be a multiple of 2s.
+#define PSI_TRIGGER_WINDOW_US 2000000
+#define PSI_CPU_STALL_US 500000
+#define PSI_MEMORY_STALL_US 100000
+#define PSI_IO_STALL_US 200000
+
+#define PSI_MAX_TRIGGERS 6
+
+typedef enum {
+    PSI_CPU,
+    PSI_MEMORY,
+    PSI_IO,
+    PSI_RESOURCE_COUNT
+} psi_resource_id_t;
+
+typedef struct {
+    float avg10;
+    float avg60;
+    float avg300;
+    uint64_t total_us;        // Cumulative stall time
+} psi_line_t;
+
+typedef struct {
+    psi_line_t some;          // Some tasks stalled
+    psi_line_t full;          // All non-idle tasks stalled
+    int has_full;
+} psi_resource_t;
+
+typedef struct {
+    int host_available;
+    psi_resource_t host[PSI_RESOURCE_COUNT];
+    int cgroup_available;
+    psi_resource_t cgroup[PSI_RESOURCE_COUNT];
+    time_t last_trigger[PSI_RESOURCE_COUNT];  // When a trigger last fired (0 = never)
+} psi_stats_t;
+
+// Initialize PSI monitoring and register host triggers
+int psi_monitor_init(void);
+
+// Read /proc/pressure from another proc root (fixtures, benchmarks); NULL
+// restores /proc. Closes open descriptors, so call psi_monitor_init() after it.
+void psi_monitor_set_proc_root(const char *root);
+
+// Also read the *.pressure files of a cgroup v2 directory (NULL to clear)
+int psi_monitor_set_cgroup(const char *cgroup_dir);
+
+// Read current pressure values
+int psi_monitor_get_stats(psi_stats_t *stats);
+
+// Parse the contents of a pressure file
+int psi_parse(const char *buffer, psi_resource_t *resource);
+
+// Fill pollfds with the trigger descriptors, returns how many were added
+int psi_monitor_trigger_fds(struct pollfd *fds, int max_fds);
+
+// Check polled trigger descriptors, returns bitmask of fired resources
+int psi_monitor_check_triggers(const struct pollfd *fds, int count);
+
+// Get resource name
+const char* psi_resource_name(psi_resource_id_t resource);
+
+// Cleanup PSI monitoring resources
+void psi_monitor_cleanup(void);
+
+#endif // PSI_MONITOR_H
@@ -0,0 +1,301 @@
+/*
+ * Journal replay
+ * Rebuilds emon snapshots from a recorded journal so the live screens can
+ * be driven without /proc or A2S. Segments are mapped read-only and decoded
+ * in place, so playback allocates nothing per record; fixed-size records
+ * make seeking a bisection.
+ */
+
+#define _GNU_SOURCE
+#include "replay.h"
+#include "journal.h"
+#include "metrics.h"
+#include "tsdb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define REPLAY_BACKTRACK_RECORDS 256
+#define MAX_REPLAY_PATH 512
+
+typedef struct {
+    journal_reader_t reader;
+    size_t count;              // Intact records
+    int value_count;           // Metrics per sample in this segment
+} segment_t;
+
+static segment_t segments[REPLAY_MAX_SEGMENTS];
+static int segment_count = 0;
+static size_t total_records = 0;
+
+// Next record to apply
+static int cur_segment = 0;
+static size_t cur_index = 0;
+
+static char host[MAX_SERVER_NAME];
+static char last_event[128];
+
+static const journal_record_t *record_at(int segment, size_t index) {
+    return journal_reader_at(&segments[segment].reader, index);
+}
+
+// Corrupt records sort first so bisection steps past them
+static int64_t record_time(int segment, size_t index) {
+    const journal_record_t *rec = record_at(segment, index);
+    return rec ? rec->time_ms : INT64_MIN;
+}
+
+static int add_segment(const char *path) {
+    if (segment_count >= REPLAY_MAX_SEGMENTS) {
+        return -1;
+    }
+
+    segment_t *seg = &segments[segment_count];
+    if (journal_reader_open(&seg->reader, path) < 0) {
+        return -1;
+    }
+
+    seg->count = journal_reader_count(&seg->reader);
+    if (seg->count == 0) {
+        journal_reader_close(&seg->reader);
+        return -1;
+    }
+
+    seg->value_count = (int)seg->reader.header->value_count;
+    if (seg->value_count > JOURNAL_MAX_VALUES) {
+        seg->value_count = JOURNAL_MAX_VALUES;
+    }
+
+    total_records += seg->count;
+    segment_count++;
+    return 0;
+}
+
+static int compare_index(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Open the newest REPLAY_MAX_SEGMENTS segments of a journal directory, oldest first
+static int add_directory(const char *dir_path) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        return -1;
+    }
+
+    uint32_t indices[1024];
+    int found = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && found < 1024) {
+        uint32_t index;
+        if (journal_parse_segment_name(entry->d_name, &index) == 0) {
+            indices[found++] = index;
+        }
+    }
+    closedir(dir);
+
+    qsort(indices, (size_t)found, sizeof(indices[0]), compare_index);
+
+    int first = (found > REPLAY_MAX_SEGMENTS) ? found - REPLAY_MAX_SEGMENTS : 0;
+    for (int i = first; i < found; i++) {
+        char path[MAX_REPLAY_PATH + 32];
+        snprintf(path, sizeof(path), "%s/emon-%08u.jnl", dir_path, indices[i]);
+        add_segment(path);
+    }
+    return 0;
+}
+
+static void apply_event(const journal_record_t *rec, emon_snapshot_t *snap) {
+    switch (rec->detail) {
+    case JOURNAL_EVENT_STARTED:
+        snprintf(host, sizeof(host), "%s", rec->text);
+        break;
+
+    case JOURNAL_EVENT_SERVER_UP: {
+        // Text is "<name> (<version>)"
+        a2s_info_t *info = &snap->a2s.info;
+        const char *open = strrchr(rec->text, '(');
+        size_t name_len = open ? (size_t)(open - rec->text) : strlen(rec->text);
+        if (name_len > 0 && rec->text[name_len - 1] == ' ') {
+            name_len--;
+        }
+        snprintf(info->name, sizeof(info->name), "%.*s", (int)name_len, rec->text);
+        if (open) {
+            snprintf(info->version, sizeof(info->version), "%.*s",
+                     (int)strcspn(open + 1, ")"), open + 1);
+        }
+        info->status = a2s_parse_server_status(info->name, info->map);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    struct tm tm;
+    time_t seconds = (time_t)(rec->time_ms / 1000);
+    char when[16];
+    localtime_r(&seconds, &tm);
+    strftime(when, sizeof(when), "%H:%M:%S", &tm);
+    snprintf(last_event, sizeof(last_event), "%s %s %.80s", when,
+             journal_event_name((journal_event_t)rec->detail), rec->text);
+}
+
+static void apply_record(int segment, const journal_record_t *rec, emon_snapshot_t *snap) {
+    if (rec->type == JOURNAL_RECORD_SAMPLE) {
+        int count = segments[segment].value_count;
+        metrics_apply(rec->values, count, snap);
+
+        // Graphs read the tsdb; feed it the sources this sample refreshed,
+        // keyed by record time as metrics_record() does live
+        int64_t seconds = rec->time_ms / 1000;
+        for (int id = 0; id < count && id < METRIC_COUNT; id++) {
+            if (rec->detail & (1 << metrics_desc((metric_id_t)id)->source)) {
+                tsdb_append(id, seconds, rec->values[id]);
+            }
+        }
+    } else if (rec->type == JOURNAL_RECORD_EVENT) {
+        apply_event(rec, snap);
+    }
+}
+
+int replay_open(const char *path) {
+    replay_close();
+
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        return -1;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        add_directory(path);
+    } else {
+        add_segment(path);
+    }
+    if (segment_count == 0) {
+        return -1;
+    }
+
+    // Take the host from the first "started" event near the beginning
+    host[0] = '\0';
+    last_event[0] = '\0';
+    for (size_t i = 0; i < segments[0].count && i < 16; i++) {
+        const journal_record_t *rec = record_at(0, i);
+        if (rec && rec->type == JOURNAL_RECORD_EVENT && rec->detail == JOURNAL_EVENT_STARTED) {
+            snprintf(host, sizeof(host), "%s", rec->text);
+            break;
+        }
+    }
+
+    cur_segment = 0;
+    cur_index = 0;
+    return 0;
+}
+
+size_t replay_record_count(void) {
+    return total_records;
+}
+
+int64_t replay_start_ms(void) {
+    return segment_count ? record_time(0, 0) : 0;
+}
+
+int64_t replay_end_ms(void) {
+    if (!segment_count) {
+        return 0;
+    }
+    const segment_t *last = &segments[segment_count - 1];
+    return record_time(segment_count - 1, last->count - 1);
+}
+
+const char *replay_host(void) {
+    return host;
+}
+
+const char *replay_last_event(void) {
+    return last_event;
+}
+
+void replay_seek(int64_t time_ms, emon_snapshot_t *snap) {
+    if (!segment_count) {
+        return;
+    }
+
+    // Last segment starting at or before the target
+    int seg = 0;
+    while (seg + 1 < segment_count && record_time(seg + 1, 0) <= time_ms) {
+        seg++;
+    }
+
+    // First record at or after the target within it
+    size_t lo = 0, hi = segments[seg].count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (record_time(seg, mid) < time_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    cur_segment = seg;
+    cur_index = lo;
+
+    // History after the old position would block appends from the new one
+    tsdb_init();
+
+    // Every sample carries all values, so the newest one before the target
+    // restores the full picture
+    int s = seg;
+    size_t i = lo;
+    for (int n = 0; n < REPLAY_BACKTRACK_RECORDS; n++) {
+        if (i == 0) {
+            if (s == 0) {
+                break;
+            }
+            s--;
+            i = segments[s].count;
+        }
+        i--;
+        const journal_record_t *rec = record_at(s, i);
+        if (rec && rec->type == JOURNAL_RECORD_SAMPLE) {
+            apply_record(s, rec, snap);
+            break;
+        }
+    }
+}
+
+int replay_advance(int64_t time_ms, emon_snapshot_t *snap) {
+    int applied = 0;
+    while (cur_segment < segment_count) {
+        if (cur_index >= segments[cur_segment].count) {
+            cur_segment++;
+            cur_index = 0;
+            continue;
+        }
+
+        const journal_record_t *rec = record_at(cur_segment, cur_index);
+        if (rec && rec->time_ms > time_ms) {
+            break;
+        }
+        if (rec) {
+            apply_record(cur_segment, rec, snap);
+            applied++;
+        }
+        cur_index++;
+    }
+    return applied;
+}
+
+void replay_close(void) {
+    for (int i = 0; i < segment_count; i++) {
+        journal_reader_close(&segments[i].reader);
+    }
+    segment_count = 0;
+    total_records = 0;
+    cur_segment = 0;
+    cur_index = 0;
+}
@@ -0,0 +1,35 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "collector.h"
+
+#define REPLAY_MAX_SEGMENTS 64
+
+// Open a journal segment, or every segment of a journal directory in order
+int replay_open(const char *path);
+
+// Total records and the time span covered (Unix ms)
+size_t replay_record_count(void);
+int64_t replay_start_ms(void);
+int64_t replay_end_ms(void);
+
+// Position on the first record at or after time_ms and rebuild the snapshot
+// from the latest sample before it; the tsdb restarts from there
+void replay_seek(int64_t time_ms, emon_snapshot_t *snap);
+
+// Apply every record up to and including time_ms, appending samples to the
+// tsdb. Returns how many were applied
+int replay_advance(int64_t time_ms, emon_snapshot_t *snap);
+
+// Host recorded by the journal's "started" event ("" if none)
+const char *replay_host(void);
+
+// Most recent event applied, formatted for display ("" if none)
+const char *replay_last_event(void);
+
+// Unmap all segments
+void replay_close(void);
+
+#endif // REPLAY_H
@@ -0,0 +1,188 @@
+/*
+ * Self-instrumentation
+ * Times each collector pass and the render pass on CLOCK_MONOTONIC into
+ * fixed log2 histograms, and counts what each pass asks of the kernel so
+ * emon can show it is not perturbing the server it watches. Read/write
+ * syscalls come from the thread's own /proc/thread-self/io; opens and
+ * socket calls are counted by the collectors themselves.
+ */
+
+#define _GNU_SOURCE
+#include "selfstats.h"
+#include "seqlock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+typedef struct {
+    seqlock_t lock;
+    selfstats_timer_t data;
+} timer_slot_t;
+
+static timer_slot_t slots[SELFSTATS_COUNT];
+
+static const char *names[SELFSTATS_COUNT] = { "system", "process", "a2s", "fleet", "top", "log", "render" };
+
+// Per-thread counters; the io descriptor is opened on first use and kept
+static _Thread_local uint64_t thread_opens;
+static _Thread_local uint64_t thread_syscalls;
+static _Thread_local int io_fd = -2;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// syscr + syscw of this thread, 0 without task I/O accounting
+static uint64_t io_syscalls(void) {
+    if (io_fd == -2) {
+        io_fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+    }
+    if (io_fd < 0) {
+        return 0;
+    }
+
+    char buf[256];
+    ssize_t n = pread(io_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+
+    uint64_t total = 0;
+    const char *p = strstr(buf, "syscr:");
+    if (p) {
+        total += strtoull(p + 6, NULL, 10);
+    }
+    p = strstr(buf, "syscw:");
+    if (p) {
+        total += strtoull(p + 6, NULL, 10);
+    }
+    return total;
+}
+
+void selfstats_count_open(void) {
+    thread_opens++;
+    thread_syscalls++;
+}
+
+void selfstats_count_syscalls(int count) {
+    thread_syscalls += (uint64_t)count;
+}
+
+uint64_t selfstats_syscalls(void) {
+    return io_syscalls() + thread_syscalls;
+}
+
+void selfstats_begin(selfstats_span_t *span) {
+    span->syscalls = selfstats_syscalls();
+    span->opens = thread_opens;
+    span->start_ns = monotonic_ns();
+}
+
+void selfstats_end(selfstats_id_t id, const selfstats_span_t *span) {
+    uint64_t duration = monotonic_ns() - span->start_ns;
+
+    // The pread() in selfstats_begin() shows up in syscr; ours is not yet counted
+    uint64_t syscalls = selfstats_syscalls() - span->syscalls;
+    if (io_fd >= 0 && syscalls > 0) {
+        syscalls--;
+    }
+    uint64_t opens = thread_opens - span->opens;
+
+    uint64_t us = duration / 1000;
+    int bucket = 0;
+    while (bucket < SELFSTATS_BUCKETS - 1 && us >= (1ULL << bucket)) {
+        bucket++;
+    }
+
+    timer_slot_t *slot = &slots[id];
+    seqlock_write_begin(&slot->lock);
+    selfstats_timer_t *t = &slot->data;
+    t->count++;
+    t->total_ns += duration;
+    t->last_ns = duration;
+    if (duration > t->max_ns) {
+        t->max_ns = duration;
+    }
+    t->total_syscalls += syscalls;
+    t->last_syscalls = syscalls;
+    t->total_opens += opens;
+    t->last_opens = opens;
+    t->buckets[bucket]++;
+    seqlock_write_end(&slot->lock);
+}
+
+void selfstats_read(selfstats_id_t id, selfstats_timer_t *out) {
+    timer_slot_t *slot = &slots[id];
+    unsigned int seq;
+    do {
+        seq = seqlock_read_begin(&slot->lock);
+        memcpy(out, &slot->data, sizeof(*out));
+    } while (seqlock_read_retry(&slot->lock, seq));
+}
+
+uint64_t selfstats_percentile_ns(const selfstats_timer_t *timer, double p) {
+    if (!timer->count) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(p * (double)timer->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < SELFSTATS_BUCKETS; i++) {
+        seen += timer->buckets[i];
+        if (seen >= rank) {
+            uint64_t upper = (1ULL << i) * 1000;
+            return upper < timer->max_ns ? upper : timer->max_ns;
+        }
+    }
+    return timer->max_ns;
+}
+
+const char *selfstats_name(selfstats_id_t id) {
+    return ((int)id >= 0 && id < SELFSTATS_COUNT) ? names[id] : "unknown";
+}
+
+void selfstats_dump(FILE *fp) {
+    fprintf(fp, "emon self-stats\n");
+    fprintf(fp, "%-8s %8s %10s %10s %10s %10s %10s %9s\n", "pass", "count", "mean_us",
+            "p50_us", "p99_us", "max_us", "sys/pass", "open/pass");
+
+    for (int id = 0; id < SELFSTATS_COUNT; id++) {
+        selfstats_timer_t t;
+        selfstats_read((selfstats_id_t)id, &t);
+        if (!t.count) {
+            fprintf(fp, "%-8s %8d\n", names[id], 0);
+            continue;
+        }
+        fprintf(fp, "%-8s %8lu %10.1f %10.1f %10.1f %10.1f %10.1f %9.1f\n", names[id],
+                (unsigned long)t.count, t.total_ns / 1e3 / t.count,
+                selfstats_percentile_ns(&t, 0.50) / 1e3, selfstats_percentile_ns(&t, 0.99) / 1e3,
+                t.max_ns / 1e3, (double)t.total_syscalls / t.count,
+                (double)t.total_opens / t.count);
+    }
+
+    // Raw histograms: "<2^i us" buckets with any samples
+    for (int id = 0; id < SELFSTATS_COUNT; id++) {
+        selfstats_timer_t t;
+        selfstats_read((selfstats_id_t)id, &t);
+        if (!t.count) {
+            continue;
+        }
+        fprintf(fp, "%s histogram:", names[id]);
+        for (int i = 0; i < SELFSTATS_BUCKETS; i++) {
+            if (t.buckets[i] && i == SELFSTATS_BUCKETS - 1) {
+                fprintf(fp, " >=%luus:%u", 1UL << (i - 1), t.buckets[i]);
+            } else if (t.buckets[i]) {
+                fprintf(fp, " <%luus:%u", 1UL << i, t.buckets[i]);
+            }
+        }
+        fprintf(fp, "\n");
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SELFSTATS_H
+#define SELFSTATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Bucket i counts passes shorter than 2^i microseconds (the last one is open)
+#define SELFSTATS_BUCKETS 24
+
+typedef enum {
+    SELFSTATS_SYSTEM,              // system_monitor_get_stats() and friends
+    SELFSTATS_PROCESS,             // process_find_all_by_name()
+    SELFSTATS_A2S,                 // a2s_query_info() round
+    SELFSTATS_FLEET,               // fleet_query_round()
+    SELFSTATS_TOP,                 // top_monitor_update()
+    SELFSTATS_LOG,                 // log_tail_read() and the line parsers
+    SELFSTATS_RENDER,              // ui_draw()
+    SELFSTATS_COUNT
+} selfstats_id_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t last_ns;
+    uint64_t max_ns;
+    uint64_t total_syscalls;       // Read/write family, opens and socket calls (closes not counted)
+    uint64_t last_syscalls;
+    uint64_t total_opens;          // open/fopen/opendir
+    uint64_t last_opens;
+    uint32_t buckets[SELFSTATS_BUCKETS];
+} selfstats_timer_t;
+
+// Taken at the start of a pass, on the thread doing the work
+typedef struct {
+    uint64_t start_ns;
+    uint64_t syscalls;
+    uint64_t opens;
+} selfstats_span_t;
+
+void selfstats_begin(selfstats_span_t *span);
+
+// Fold the pass into id's histogram (one writer thread per id)
+void selfstats_end(selfstats_id_t id, const selfstats_span_t *span);
+
+// Called by collectors on the calling thread: each open, and syscalls the
+// kernel's I/O accounting does not see (sockets)
+void selfstats_count_open(void);
+void selfstats_count_syscalls(int count);
+
+// Syscalls made so far on the calling thread (the read itself costs one
+// when I/O accounting is available)
+uint64_t selfstats_syscalls(void);
+
+// Consistent copy of one timer
+void selfstats_read(selfstats_id_t id, selfstats_timer_t *out);
+
+// Upper bound of the bucket holding the p-th percentile (0..1), capped at max
+uint64_t selfstats_percentile_ns(const selfstats_timer_t *timer, double p);
+
+const char *selfstats_name(selfstats_id_t id);
+
+// Human-readable summary of every timer
+void selfstats_dump(FILE *fp);
+
+#endif // SELFSTATS_H
@@ -0,0 +1,45 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+/*
+ * Single-writer sequence lock
+ * The writer bumps the sequence to odd, copies the payload, then bumps it
+ * back to even. Readers never block the writer: they copy optimistically and
+ * retry if the sequence was odd or changed underneath them.
+ */
+
+#include <stdatomic.h>
+#include <sched.h>
+
+typedef struct {
+    atomic_uint sequence;
+} seqlock_t;
+
+#define SEQLOCK_INIT { 0 }
+
+static inline void seqlock_write_begin(seqlock_t *lock) {
+    unsigned int seq = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void seqlock_write_end(seqlock_t *lock) {
+    unsigned int seq = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, seq + 1, memory_order_release);
+}
+
+static inline unsigned int seqlock_read_begin(seqlock_t *lock) {
+    unsigned int seq;
+    while ((seq = atomic_load_explicit(&lock->sequence, memory_order_acquire)) & 1) {
+        sched_yield(); // Writer is mid-copy
+    }
+    return seq;
+}
+
+// Returns nonzero if the copy made since seqlock_read_begin() is torn
+static inline int seqlock_read_retry(seqlock_t *lock, unsigned int start) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&lock->sequence, memory_order_relaxed) != start;
+}
+
+#endif // SEQLOCK_H
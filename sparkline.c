@@ -0,0 +1,213 @@
+/*
+ * History sparklines
+ * Reads the time-series store's 1 s tier straight into a fixed ring of
+ * samples and pre-rendered glyphs. An update fetches only the buckets since
+ * the previous one, re-renders only their cells and reports how far the
+ * graph scrolled, so the renderer can shift the row instead of repainting.
+ */
+
+#include "sparkline.h"
+#include "tsdb.h"
+#include <math.h>
+#include <string.h>
+
+// Dot bits of the left and right braille columns, bottom row first
+static const uint8_t braille_left[4] = { 0x40, 0x04, 0x02, 0x01 };
+static const uint8_t braille_right[4] = { 0x80, 0x20, 0x10, 0x08 };
+
+static const char ascii_levels[] = " .:-=+*#";
+
+static int seconds_per_cell(const sparkline_t *sp) {
+    return (sp->style == SPARK_BRAILLE) ? 2 : 1;
+}
+
+static int slot_of(const sparkline_t *sp, int64_t cell) {
+    return (int)(cell % sp->cells);
+}
+
+void sparkline_init(sparkline_t *sp, int series, spark_style_t style, int cells, double scale) {
+    memset(sp, 0, sizeof(*sp));
+    sp->series = series;
+    sp->style = style;
+    sp->cells = (cells < 1) ? 1 : (cells > SPARK_MAX_CELLS) ? SPARK_MAX_CELLS : cells;
+    sp->scale = scale;
+    sp->newest_cell = -1;
+    for (int i = 0; i < SPARK_MAX_CELLS; i++) {
+        sp->samples[i][0] = sp->samples[i][1] = NAN;
+        strcpy(sp->glyphs[i], " ");
+    }
+}
+
+void sparkline_set_scale(sparkline_t *sp, double scale) {
+    if (scale != sp->scale) {
+        sp->scale = scale;
+        sp->rescale = 1;
+    }
+}
+
+double sparkline_nice_ceiling(double value) {
+    if (!(value > 0.0)) {
+        return 1.0;
+    }
+    double power = pow(10.0, floor(log10(value)));
+    static const double steps[] = { 1.0, 2.0, 5.0, 10.0 };
+    for (int i = 0; i < 4; i++) {
+        if (steps[i] * power >= value * (1.0 - 1e-9)) {
+            return steps[i] * power;
+        }
+    }
+    return 10.0 * power;
+}
+
+// Height of a sample in steps, -1 for no data; anything above zero shows
+static int level(float value, double top, int steps) {
+    if (isnan(value)) {
+        return -1;
+    }
+    double ratio = value / top;
+    ratio = (ratio < 0.0) ? 0.0 : (ratio > 1.0) ? 1.0 : ratio;
+    int h = (int)(ratio * steps + 0.5);
+    return (h == 0 && value > 0.0f) ? 1 : h;
+}
+
+static void put_codepoint(char *out, unsigned int cp) {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    out[3] = '\0';
+}
+
+static void render_cell(sparkline_t *sp, int slot) {
+    const float *s = sp->samples[slot];
+    char *out = sp->glyphs[slot];
+
+    switch (sp->style) {
+    case SPARK_BRAILLE: {
+        int left = level(s[0], sp->top, 4);
+        int right = level(s[1], sp->top, 4);
+        unsigned int bits = 0;
+        for (int row = 0; row < 4; row++) {
+            bits |= (row < left) ? braille_left[row] : 0;
+            bits |= (row < right) ? braille_right[row] : 0;
+        }
+        if (bits) {
+            put_codepoint(out, 0x2800 + bits);
+        } else {
+            strcpy(out, " ");
+        }
+        break;
+    }
+    case SPARK_BLOCK: {
+        int h = level(s[0], sp->top, 8);
+        if (h > 0) {
+            put_codepoint(out, 0x2580 + (unsigned int)h);
+        } else {
+            strcpy(out, " ");
+        }
+        break;
+    }
+    default: {
+        int h = level(s[0], sp->top, 7);
+        out[0] = ascii_levels[h < 0 ? 0 : h];
+        out[1] = '\0';
+        break;
+    }
+    }
+}
+
+// Autoscale top: the largest sample on screen, rounded up
+static double visible_top(const sparkline_t *sp) {
+    if (sp->scale > 0.0) {
+        return sp->scale;
+    }
+    float peak = 0.0f;
+    for (int i = 0; i < sp->cells; i++) {
+        for (int k = 0; k < 2; k++) {
+            if (sp->samples[i][k] > peak) {
+                peak = sp->samples[i][k];
+            }
+        }
+    }
+    return sparkline_nice_ceiling(peak);
+}
+
+spark_delta_t sparkline_update(sparkline_t *sp) {
+    spark_delta_t delta = { 0, 0, 0 };
+    int64_t last_time;
+    double last_value;
+    if (tsdb_last(sp->series, &last_time, &last_value) < 0) {
+        return delta;
+    }
+
+    int per_cell = seconds_per_cell(sp);
+    int64_t cell = last_time / per_cell;
+    int64_t from_cell;
+
+    if (sp->newest_cell < 0 || cell < sp->newest_cell || cell - sp->newest_cell >= sp->cells) {
+        // First fill, clock stepped back or a gap wider than the graph
+        for (int i = 0; i < sp->cells; i++) {
+            sp->samples[i][0] = sp->samples[i][1] = NAN;
+        }
+        from_cell = cell - sp->cells + 1;
+        delta.full = 1;
+    } else {
+        // The newest cell may still be filling, so it is read again
+        from_cell = sp->newest_cell;
+        delta.shift = (int)(cell - sp->newest_cell);
+        for (int64_t c = sp->newest_cell + 1; c <= cell; c++) {
+            int slot = slot_of(sp, c);
+            sp->samples[slot][0] = sp->samples[slot][1] = NAN;
+        }
+    }
+    if (from_cell < 0) {
+        from_cell = 0;
+    }
+
+    tsdb_point_t points[2 * SPARK_MAX_CELLS];
+    int count = tsdb_query(sp->series, TSDB_TIER_1S, from_cell * per_cell, last_time,
+                           points, 2 * SPARK_MAX_CELLS);
+    for (int i = 0; i < count; i++) {
+        int64_t c = points[i].time / per_cell;
+        sp->samples[slot_of(sp, c)][points[i].time % per_cell] = points[i].avg;
+    }
+    sp->newest_cell = cell;
+
+    double top = visible_top(sp);
+    if (top != sp->top || sp->rescale) {
+        sp->top = top;
+        sp->rescale = 0;
+        delta.full = 1;
+    }
+
+    if (delta.full) {
+        for (int i = 0; i < sp->cells; i++) {
+            render_cell(sp, i);
+        }
+        delta.shift = 0;
+        delta.dirty = sp->cells;
+        return delta;
+    }
+
+    // Re-render the fetched cells; the oldest one is dirty only if it changed
+    for (int64_t c = from_cell; c <= cell; c++) {
+        int slot = slot_of(sp, c);
+        char before[SPARK_GLYPH_BYTES];
+        memcpy(before, sp->glyphs[slot], sizeof(before));
+        render_cell(sp, slot);
+        if (delta.dirty == 0 && c == from_cell && strcmp(before, sp->glyphs[slot]) == 0) {
+            continue;
+        }
+        if (delta.dirty == 0) {
+            delta.dirty = (int)(cell - c + 1);
+        }
+    }
+    return delta;
+}
+
+const char *sparkline_glyph(const sparkline_t *sp, int i) {
+    if (sp->newest_cell < 0) {
+        return " ";
+    }
+    int64_t cell = sp->newest_cell - sp->cells + 1 + i;
+    return (cell < 0) ? " " : sp->glyphs[slot_of(sp, cell)];
+}
@@ -0,0 +1,53 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <stdint.h>
+
+// Widest graph kept; one cell is one terminal column
+#define SPARK_MAX_CELLS 128
+#define SPARK_GLYPH_BYTES 4        // UTF-8 glyph plus NUL
+
+typedef enum {
+    SPARK_BLOCK,                   // ▁▂▃▄▅▆▇█, one second per cell
+    SPARK_BRAILLE,                 // Two seconds per cell, four dot rows each
+    SPARK_ASCII                    // " .:-=+*#" for terminals without UTF-8
+} spark_style_t;
+
+// History graph of one tsdb series (1 s tier), newest second on the right.
+// Glyphs are kept in a ring indexed like the samples, so a new second only
+// renders its own cell.
+typedef struct {
+    int series;
+    spark_style_t style;
+    int cells;
+    double scale;                  // Fixed top of the graph, <= 0 autoscales
+    double top;                    // Top the glyphs were rendered against
+    int rescale;                   // Scale changed since the last update
+    int64_t newest_cell;           // Cell number (bucket / seconds per cell), -1 = empty
+    float samples[SPARK_MAX_CELLS][2];
+    char glyphs[SPARK_MAX_CELLS][SPARK_GLYPH_BYTES];
+} sparkline_t;
+
+// What changed on screen after an update
+typedef struct {
+    int full;                      // Redraw every cell
+    int shift;                     // Cells scrolled off the left edge
+    int dirty;                     // Cells at the right edge to rewrite after the shift
+} spark_delta_t;
+
+// Empty graph of a series, cells wide (clamped to SPARK_MAX_CELLS)
+void sparkline_init(sparkline_t *sp, int series, spark_style_t style, int cells, double scale);
+
+// Change the fixed top (<= 0 autoscales); glyphs are re-rendered on the next update
+void sparkline_set_scale(sparkline_t *sp, double scale);
+
+// Pull buckets newer than the last update from the time-series store
+spark_delta_t sparkline_update(sparkline_t *sp);
+
+// Glyph of cell i, 0 = leftmost
+const char *sparkline_glyph(const sparkline_t *sp, int i);
+
+// Round up to 1, 2 or 5 times a power of ten (autoscale steps)
+double sparkline_nice_ceiling(double value);
+
+#endif // SPARKLINE_H
@@ -2,14 +2,26 @@
 #define SYSTEM_MONITOR_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+#define MAX_CPU_CORES 256
 
 typedef struct {
     double cpu_percent;
+    double steal_percent;                // Time stolen by the hypervisor
+    int cpu_count;                       // Number of cpuN slots (highest N + 1)
+    float core_percent[MAX_CPU_CORES];   // Per-core utilization
     uint64_t total_mem_kb;
     uint64_t used_mem_kb;
     uint64_t free_mem_kb;
     uint64_t total_swap_kb;
     uint64_t used_swap_kb;
+    uint64_t swap_in_pages;      // pswpin since boot
+    uint64_t swap_out_pages;     // pswpout since boot
+    uint64_t major_faults;       // pgmajfault since boot
+    uint64_t oom_kills;          // oom_kill since boot (kernel 4.13+)
+    double swap_in_rate;         // Pages per second since the previous sample
+    double swap_out_rate;
 } system_stats_t;
 
 typedef struct {
@@ -23,18 +35,53 @@ typedef struct {
     uint64_t steal;
 } cpu_times_t;
 
+// Per-core counters, stored as structure-of-arrays so the delta pass over
+// all cores is a straight vectorizable loop. Indexed by N of "cpuN";
+// offline CPUs read as zero.
+typedef struct {
+    int count;
+    uint64_t total[MAX_CPU_CORES];
+    uint64_t idle[MAX_CPU_CORES];        // idle + iowait
+} cpu_core_times_t;
+
+// Read /proc from another directory (fixtures, benchmarks); NULL restores
+// /proc. Closes cached descriptors, so call system_monitor_init() after it.
+void system_monitor_set_proc_root(const char *root);
+
 // Initialize system monitoring
 int system_monitor_init(void);
 
 // Get current system statistics
 int system_monitor_get_stats(system_stats_t *stats);
 
+// Sample aggregate, steal and per-core CPU usage since the previous call
+int system_monitor_get_cpu(system_stats_t *stats);
+
 // Calculate CPU usage percentage
 double system_monitor_calc_cpu_percent(void);
 
+// Parse the aggregate "cpu" line and every "cpuN" line of /proc/stat.
+// Returns 0 if the aggregate line was found, -1 otherwise.
+int system_monitor_parse_cpu_lines(const char *buf, size_t len,
+                                   cpu_times_t *aggregate, cpu_core_times_t *cores);
+
+// Compute per-core utilization from two samples in a single pass.
+// percent must hold MAX_CPU_CORES entries; count is rounded up to a
+// multiple of 8 internally.
+void system_monitor_calc_core_percent(const cpu_core_times_t *prev,
+                                      const cpu_core_times_t *curr,
+                                      float *percent, int count);
+
 // Get memory information
 int system_monitor_get_memory(system_stats_t *stats);
 
+// Get swap and OOM counters from /proc/vmstat
+int system_monitor_get_vmstat(system_stats_t *stats);
+
+// Parse /proc/meminfo and /proc/vmstat contents
+int system_monitor_parse_meminfo(const char *buf, size_t len, system_stats_t *stats);
+int system_monitor_parse_vmstat(const char *buf, size_t len, system_stats_t *stats);
+
 // Cleanup system monitoring resources
 void system_monitor_cleanup(void);
 
@@ -3,20 +3,10 @@
  */
 
 #include "unity.h"
+#include "../a2s_query.h"
 #include <stdint.h>
 #include <string.h>
 
-// Forward declarations
-typedef enum {
-    SERVER_STATUS_UNKNOWN,
-    SERVER_STATUS_LOBBY,
-    SERVER_STATUS_LOADING,
-    SERVER_STATUS_HOST_ONLINE
-} server_status_t;
-
-server_status_t a2s_parse_server_status(const char *server_name, const char *map_name);
-const char* a2s_status_string(server_status_t status);
-
 void test_status_lobby_name(void) {
     server_status_t status = a2s_parse_server_status("My Lobby Server", "");
     TEST_ASSERT_EQUAL_INT(SERVER_STATUS_LOBBY, status);
@@ -67,6 +57,39 @@ void test_status_string_unknown(void) {
     TEST_ASSERT_EQUAL_STRING("Unknown", str);
 }
 
+// Response header, protocol, name, map, folder, game, app id, players,
+// max players, bots, type, environment, visibility, VAC, version
+static const uint8_t info_response[] =
+    "\xFF\xFF\xFF\xFF\x49\x11"
+    "Enshrouded #1\0" "Embervale\0" "enshrouded\0" "Enshrouded\0"
+    "\x00\x00" "\x07\x10\x00" "dw" "\x00\x01" "0.8.1.1";
+
+void test_parse_info_response(void) {
+    a2s_info_t info;
+    TEST_ASSERT_EQUAL_INT(0, a2s_parse_info(info_response, sizeof(info_response), &info));
+    TEST_ASSERT_EQUAL_STRING("Enshrouded #1", info.name);
+    TEST_ASSERT_EQUAL_STRING("Embervale", info.map);
+    TEST_ASSERT_EQUAL_INT(7, info.players);
+    TEST_ASSERT_EQUAL_INT(16, info.max_players);
+    TEST_ASSERT_EQUAL_STRING("0.8.1.1", info.version);
+}
+
+void test_parse_info_rejects_bad_header(void) {
+    uint8_t packet[sizeof(info_response)];
+    memcpy(packet, info_response, sizeof(packet));
+    packet[4] = A2S_CHALLENGE_RESPONSE;
+
+    a2s_info_t info;
+    TEST_ASSERT_EQUAL_INT(-1, a2s_parse_info(packet, sizeof(packet), &info));
+    TEST_ASSERT_EQUAL_INT(-1, a2s_parse_info(info_response, 8, &info));
+}
+
+void test_parse_info_truncated_string(void) {
+    a2s_info_t info;
+    // Cut inside the server name: no terminator
+    TEST_ASSERT_EQUAL_INT(-1, a2s_parse_info(info_response, 14, &info));
+}
+
 int main(void) {
     UNITY_BEGIN();
 
@@ -82,5 +105,9 @@ int main(void) {
     RUN_TEST(test_status_string_online);
     RUN_TEST(test_status_string_unknown);
 
+    RUN_TEST(test_parse_info_response);
+    RUN_TEST(test_parse_info_rejects_bad_header);
+    RUN_TEST(test_parse_info_truncated_string);
+
     UNITY_END();
 }
@@ -0,0 +1,273 @@
+/*
+ * Unit tests for the alert rule engine
+ * Drives rules with synthetic samples; actions are checked through a FIFO.
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../alerts.h"
+#include "../metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define SYSTEM (1 << METRIC_SOURCE_SYSTEM)
+#define A2S (1 << METRIC_SOURCE_A2S)
+
+static double values[METRIC_COUNT];
+static char error[128];
+
+static void reset(void) {
+    alerts_reset();
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        values[i] = NAN;
+    }
+}
+
+static int compile(const char *rule) {
+    return alerts_compile(rule, error, sizeof(error));
+}
+
+void test_compile_rejects_bad_rules(void) {
+    reset();
+    TEST_ASSERT_EQUAL_INT(-1, compile("no colon here"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: not_a_metric > 1"));
+    TEST_ASSERT_NOT_NULL(strstr(error, "not_a_metric"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent => 1"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > lots"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > 90 for 3 days"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > 90 for nan"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > 90 for 1e999s"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > 90 clear 95"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: rate(cpu_percent > 1"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > 90 exec"));
+    TEST_ASSERT_EQUAL_INT(0, alerts_count());
+
+    TEST_ASSERT_EQUAL_INT(0, compile("x: cpu_percent > 90"));
+    TEST_ASSERT_EQUAL_INT(-1, compile("x: cpu_percent > 95"));
+    TEST_ASSERT_EQUAL_INT(1, alerts_count());
+}
+
+void test_threshold_fires_and_resolves(void) {
+    reset();
+    TEST_ASSERT_EQUAL_INT(0, compile("hot: cpu_percent >= 90"));
+    int rule = alerts_find("hot");
+
+    values[METRIC_CPU_PERCENT] = 50;
+    TEST_ASSERT_EQUAL_INT(0, alerts_evaluate(values, SYSTEM, 1000));
+    values[METRIC_CPU_PERCENT] = 90;
+    TEST_ASSERT_EQUAL_INT(1, alerts_evaluate(values, SYSTEM, 2000));
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(rule));
+    values[METRIC_CPU_PERCENT] = 89;
+    TEST_ASSERT_EQUAL_INT(1, alerts_evaluate(values, SYSTEM, 3000));
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(rule));
+}
+
+void test_duration_must_hold(void) {
+    reset();
+    compile("hot: cpu_percent > 90 for 30s");
+    int rule = alerts_find("hot");
+
+    values[METRIC_CPU_PERCENT] = 95;
+    alerts_evaluate(values, SYSTEM, 0);
+    TEST_ASSERT_EQUAL_INT(ALERT_PENDING, alerts_state(rule));
+    alerts_evaluate(values, SYSTEM, 29999);
+    TEST_ASSERT_EQUAL_INT(ALERT_PENDING, alerts_state(rule));
+
+    // A dip restarts the clock
+    values[METRIC_CPU_PERCENT] = 80;
+    alerts_evaluate(values, SYSTEM, 20000);
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(rule));
+    values[METRIC_CPU_PERCENT] = 95;
+    alerts_evaluate(values, SYSTEM, 21000);
+    alerts_evaluate(values, SYSTEM, 50000);
+    TEST_ASSERT_EQUAL_INT(ALERT_PENDING, alerts_state(rule));
+    alerts_evaluate(values, SYSTEM, 51000);
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(rule));
+}
+
+void test_plain_duration_is_milliseconds(void) {
+    reset();
+    compile("hot: cpu_percent > 90 for 500");
+    int rule = alerts_find("hot");
+
+    values[METRIC_CPU_PERCENT] = 95;
+    alerts_evaluate(values, SYSTEM, 0);
+    alerts_evaluate(values, SYSTEM, 499);
+    TEST_ASSERT_EQUAL_INT(ALERT_PENDING, alerts_state(rule));
+    alerts_evaluate(values, SYSTEM, 500);
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(rule));
+}
+
+void test_hysteresis(void) {
+    reset();
+    compile("ram: memory_used_kb > 1000 clear 900");
+    int rule = alerts_find("ram");
+
+    values[METRIC_MEM_USED_KB] = 1001;
+    alerts_evaluate(values, SYSTEM, 1);
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(rule));
+
+    // Between clear and threshold it stays firing
+    values[METRIC_MEM_USED_KB] = 950;
+    TEST_ASSERT_EQUAL_INT(0, alerts_evaluate(values, SYSTEM, 2));
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(rule));
+
+    values[METRIC_MEM_USED_KB] = 899;
+    TEST_ASSERT_EQUAL_INT(1, alerts_evaluate(values, SYSTEM, 3));
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(rule));
+}
+
+void test_rate_uses_sample_times(void) {
+    reset();
+    compile("leaving: rate(players) < -0.5");
+    int rule = alerts_find("leaving");
+
+    values[METRIC_PLAYERS] = 10;
+    alerts_evaluate(values, A2S, 10000);
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(rule));
+
+    // -4 players over 10 s is -0.4/s
+    values[METRIC_PLAYERS] = 6;
+    alerts_evaluate(values, A2S, 20000);
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(rule));
+
+    // -3 players over 2 s is -1.5/s
+    values[METRIC_PLAYERS] = 3;
+    alerts_evaluate(values, A2S, 22000);
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(rule));
+}
+
+void test_only_refreshed_sources_are_evaluated(void) {
+    reset();
+    compile("hot: cpu_percent > 90");
+    compile("empty: players < 1");
+
+    values[METRIC_CPU_PERCENT] = 99;
+    values[METRIC_PLAYERS] = 0;
+    TEST_ASSERT_EQUAL_INT(1, alerts_evaluate(values, A2S, 1));
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(alerts_find("hot")));
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(alerts_find("empty")));
+
+    // Unavailable metrics leave the state alone
+    values[METRIC_PLAYERS] = NAN;
+    TEST_ASSERT_EQUAL_INT(1, alerts_evaluate(values, SYSTEM | A2S, 2));
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(alerts_find("empty")));
+}
+
+void test_fifo_action(void) {
+    char fifo[] = "/tmp/emon_alerts_fifo_XXXXXX";
+    int tmp = mkstemp(fifo);
+    close(tmp);
+    unlink(fifo);
+    TEST_ASSERT_EQUAL_INT(0, mkfifo(fifo, 0600));
+    int reader = open(fifo, O_RDONLY | O_NONBLOCK);
+
+    reset();
+    char rule[128];
+    snprintf(rule, sizeof(rule), "hot: cpu_percent > 90 fifo %s", fifo);
+    TEST_ASSERT_EQUAL_INT(0, compile(rule));
+
+    values[METRIC_CPU_PERCENT] = 95;
+    alerts_evaluate(values, SYSTEM, 1234);
+    values[METRIC_CPU_PERCENT] = 10;
+    alerts_evaluate(values, SYSTEM, 5678);
+
+    char buf[256] = { 0 };
+    ssize_t n = read(reader, buf, sizeof(buf) - 1);
+    TEST_ASSERT_TRUE(n > 0);
+    TEST_ASSERT_EQUAL_STRING("1234 hot firing 95\n5678 hot resolved 10\n", buf);
+
+    close(reader);
+    unlink(fifo);
+}
+
+void test_load_builds_ram_rule(void) {
+    char path[] = "/tmp/emon_alerts_config_XXXXXX";
+    int fd = mkstemp(path);
+    const char *text = "QUERY_HOST=127.0.0.1\nRAM_DANGER_THRESHOLD=2\n"
+                       "ALERT=hot: cpu_percent > 90 for 1m\nALERT=broken: nope > 1\n";
+    TEST_ASSERT_EQUAL_INT((int)strlen(text), (int)write(fd, text, strlen(text)));
+    close(fd);
+
+    freopen("/dev/null", "w", stderr); // The broken rule is reported there
+    TEST_ASSERT_EQUAL_INT(2, alerts_load(path));
+    int ram = alerts_find(ALERTS_RAM_DANGER);
+    TEST_ASSERT_TRUE(ram >= 0);
+    TEST_ASSERT_EQUAL_INT(2 * 1024 * 1024, (int)alerts_threshold(ram));
+    TEST_ASSERT_TRUE(alerts_find("hot") >= 0);
+    unlink(path);
+
+    // Without a config only the default RAM rule exists
+    TEST_ASSERT_EQUAL_INT(1, alerts_load(NULL));
+    TEST_ASSERT_EQUAL_INT(12 * 1024 * 1024, (int)alerts_threshold(alerts_find(ALERTS_RAM_DANGER)));
+}
+
+static void load_text(const char *text) {
+    char path[] = "/tmp/emon_alerts_reload_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT_EQUAL_INT((int)strlen(text), (int)write(fd, text, strlen(text)));
+    close(fd);
+    alerts_load(path);
+    unlink(path);
+}
+
+void test_reload_keeps_unchanged_rules(void) {
+    reset();
+    load_text("ALERT=hot: cpu_percent > 90\nALERT=warm: cpu_percent > 50 for 1m\n");
+    values[METRIC_CPU_PERCENT] = 95;
+    alerts_evaluate(values, SYSTEM, 1000);
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(alerts_find("hot")));
+    TEST_ASSERT_EQUAL_INT(ALERT_PENDING, alerts_state(alerts_find("warm")));
+
+    // An unrelated edit: hot stays firing, the edited rule starts over
+    load_text("QUERY_PORT=15637\nALERT=hot: cpu_percent > 90\nALERT=warm: cpu_percent > 60 for 1m\n");
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(alerts_find("hot")));
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(alerts_find("warm")));
+    TEST_ASSERT_EQUAL_INT(0, alerts_evaluate(values, SYSTEM, 2000));
+
+    values[METRIC_CPU_PERCENT] = 10;
+    TEST_ASSERT_EQUAL_INT(1, alerts_evaluate(values, SYSTEM, 3000));
+    TEST_ASSERT_EQUAL_INT(ALERT_OK, alerts_state(alerts_find("hot")));
+}
+
+void test_cgroup_rule_follows_the_limit(void) {
+    reset();
+    alerts_load(NULL);
+    alerts_set_memory_limit(1000000);
+    int rule = alerts_find(ALERTS_CGROUP_RAM_DANGER);
+    TEST_ASSERT_TRUE(rule >= 0);
+    TEST_ASSERT_EQUAL_INT(900000, (int)alerts_threshold(rule));
+
+    values[METRIC_CGROUP_MEMORY_BYTES] = 950000;
+    alerts_evaluate(values, SYSTEM, 1000);
+    TEST_ASSERT_EQUAL_INT(ALERT_FIRING, alerts_state(alerts_find(ALERTS_CGROUP_RAM_DANGER)));
+
+    alerts_set_memory_limit(2000000);
+    TEST_ASSERT_EQUAL_INT(1800000, (int)alerts_threshold(alerts_find(ALERTS_CGROUP_RAM_DANGER)));
+    alerts_set_memory_limit(0);
+    TEST_ASSERT_EQUAL_INT(-1, alerts_find(ALERTS_CGROUP_RAM_DANGER));
+    TEST_ASSERT_TRUE(alerts_find(ALERTS_RAM_DANGER) >= 0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_compile_rejects_bad_rules);
+    RUN_TEST(test_threshold_fires_and_resolves);
+    RUN_TEST(test_duration_must_hold);
+    RUN_TEST(test_plain_duration_is_milliseconds);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_rate_uses_sample_times);
+    RUN_TEST(test_only_refreshed_sources_are_evaluated);
+    RUN_TEST(test_fifo_action);
+    RUN_TEST(test_load_builds_ram_rule);
+    RUN_TEST(test_reload_keeps_unchanged_rules);
+    RUN_TEST(test_cgroup_rule_follows_the_limit);
+
+    UNITY_END();
+}
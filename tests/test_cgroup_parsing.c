@@ -0,0 +1,119 @@
+/*
+ * Unit tests for cgroup v2 accounting
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../cgroup_monitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char fixture_dir[] = "/tmp/emon_cgroup_XXXXXX";
+
+static void write_file(const char *name, const char *content) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", fixture_dir, name);
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fputs(content, fp);
+        fclose(fp);
+    }
+}
+
+static void remove_file(const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", fixture_dir, name);
+    unlink(path);
+}
+
+void test_parse_limit_max(void) {
+    TEST_ASSERT_EQUAL_INT(0, (int)cgroup_parse_limit("max\n"));
+}
+
+void test_parse_limit_bytes(void) {
+    TEST_ASSERT_TRUE(cgroup_parse_limit("8589934592\n") == 8589934592ULL);
+}
+
+void test_parse_cpu_max_quota(void) {
+    double cores = cgroup_parse_cpu_max("200000 100000\n");
+    TEST_ASSERT_EQUAL_INT(200, (int)(cores * 100 + 0.5));
+}
+
+void test_parse_cpu_max_unlimited(void) {
+    TEST_ASSERT_TRUE(cgroup_parse_cpu_max("max 100000\n") == 0.0);
+}
+
+void test_cgroup_fixture_stats(void) {
+    write_file("memory.current", "4294967296\n");
+    write_file("memory.max", "8589934592\n");
+    write_file("memory.high", "max\n");
+    write_file("memory.events", "low 0\nhigh 3\nmax 5\noom 1\noom_kill 1\noom_group_kill 0\n");
+    write_file("cpu.max", "400000 100000\n");
+    write_file("cpu.stat",
+               "usage_usec 1000000\nuser_usec 800000\nsystem_usec 200000\n"
+               "nr_periods 50\nnr_throttled 10\nthrottled_usec 250000\n");
+
+    TEST_ASSERT_EQUAL_INT(0, cgroup_monitor_set_dir(fixture_dir));
+
+    cgroup_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, cgroup_monitor_get_stats(&stats));
+    TEST_ASSERT_TRUE(stats.available);
+    TEST_ASSERT_TRUE(stats.memory_current == 4294967296ULL);
+    TEST_ASSERT_TRUE(stats.memory_max == 8589934592ULL);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.memory_high);
+    TEST_ASSERT_EQUAL_INT(3, (int)stats.events_high);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.events_oom_kill);
+    TEST_ASSERT_EQUAL_INT(4, (int)stats.cpu_quota_cores);
+    TEST_ASSERT_EQUAL_INT(10, (int)stats.nr_throttled);
+    TEST_ASSERT_EQUAL_INT(250000, (int)stats.throttled_usec);
+
+    // Limits changed at runtime are picked up on the next sample
+    write_file("memory.max", "max\n");
+    write_file("cpu.max", "150000 100000\n");
+    TEST_ASSERT_EQUAL_INT(0, cgroup_monitor_get_stats(&stats));
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.memory_max);
+    TEST_ASSERT_EQUAL_INT(150, (int)(stats.cpu_quota_cores * 100 + 0.5));
+
+    cgroup_monitor_cleanup();
+}
+
+void test_cgroup_missing_current(void) {
+    // Root cgroup: no memory.current, host figures apply
+    remove_file("memory.current");
+    TEST_ASSERT_EQUAL_INT(-1, cgroup_monitor_set_dir(fixture_dir));
+
+    cgroup_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(-1, cgroup_monitor_get_stats(&stats));
+    TEST_ASSERT_FALSE(stats.available);
+
+    cgroup_monitor_cleanup();
+}
+
+int main(void) {
+    if (!mkdtemp(fixture_dir)) {
+        printf("Failed to create fixture directory\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_limit_max);
+    RUN_TEST(test_parse_limit_bytes);
+    RUN_TEST(test_parse_cpu_max_quota);
+    RUN_TEST(test_parse_cpu_max_unlimited);
+
+    RUN_TEST(test_cgroup_fixture_stats);
+    RUN_TEST(test_cgroup_missing_current);
+
+    const char *files[] = { "memory.current", "memory.max", "memory.high",
+                            "memory.events", "cpu.max", "cpu.stat" };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        remove_file(files[i]);
+    }
+    rmdir(fixture_dir);
+
+    UNITY_END();
+}
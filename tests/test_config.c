@@ -0,0 +1,188 @@
+/*
+ * Unit tests for config file loading and hot-reload detection
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+
+static char config_dir[] = "/tmp/emon-test-config-XXXXXX";
+
+static void write_file(const char *name, const char *text) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", config_dir, name);
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fputs(text, fp);
+        fclose(fp);
+    }
+}
+
+static void config_path(char *path, size_t size) {
+    snprintf(path, size, "%s/config", config_dir);
+}
+
+void test_parse_interval_units(void) {
+    uint32_t ms = 0;
+    TEST_ASSERT_EQUAL_INT(0, config_parse_interval("250ms", &ms));
+    TEST_ASSERT_EQUAL_INT(250, ms);
+    TEST_ASSERT_EQUAL_INT(0, config_parse_interval("5s", &ms));
+    TEST_ASSERT_EQUAL_INT(5000, ms);
+    TEST_ASSERT_EQUAL_INT(0, config_parse_interval("0.5s", &ms));
+    TEST_ASSERT_EQUAL_INT(500, ms);
+    TEST_ASSERT_EQUAL_INT(0, config_parse_interval("2m", &ms));
+    TEST_ASSERT_EQUAL_INT(120000, ms);
+    TEST_ASSERT_EQUAL_INT(0, config_parse_interval("1000", &ms));
+    TEST_ASSERT_EQUAL_INT(1000, ms);
+}
+
+void test_parse_interval_rejects_bad_values(void) {
+    uint32_t ms = 7;
+    TEST_ASSERT_EQUAL_INT(-1, config_parse_interval("fast", &ms));
+    TEST_ASSERT_EQUAL_INT(-1, config_parse_interval("5h", &ms));
+    TEST_ASSERT_EQUAL_INT(-1, config_parse_interval("10ms", &ms));   // Below the floor
+    TEST_ASSERT_EQUAL_INT(-1, config_parse_interval("2h", &ms));
+    TEST_ASSERT_EQUAL_INT(-1, config_parse_interval("-1s", &ms));
+    TEST_ASSERT_EQUAL_INT(7, ms);
+}
+
+void test_load_defaults_without_file(void) {
+    emon_config_t cfg;
+    char error[128];
+    TEST_ASSERT_EQUAL_INT(0, config_load(NULL, &cfg, error, sizeof(error)));
+    TEST_ASSERT_EQUAL_STRING("", cfg.query_host);
+    TEST_ASSERT_EQUAL_INT(0, cfg.query_port);
+    TEST_ASSERT_EQUAL_INT(CONFIG_DEFAULT_REFRESH_MS, cfg.refresh_ms);
+    TEST_ASSERT_EQUAL_INT(0, cfg.interval_ms[COLLECT_CPU]);
+    TEST_ASSERT_EQUAL_STRING("", error);
+}
+
+void test_load_example_keys(void) {
+    write_file("config",
+               "# Comment\n"
+               "QUERY_HOST = 10.0.2.33\n"
+               "QUERY_PORT=15637\n"
+               "LOG_PATH=./logs/enshrouded_server.log\n"
+               "REFRESH_INTERVAL=500\n"
+               "RAM_DANGER_THRESHOLD=12\n"
+               "ALERT=players_leaving: rate(players) < -0.2 for 1m\n"
+               "INTERVAL_CPU=250ms\n"
+               "INTERVAL_a2s=5s\n"
+               "INTERVAL_Memory=1s\n");
+
+    char path[128];
+    config_path(path, sizeof(path));
+    emon_config_t cfg;
+    char error[128];
+    TEST_ASSERT_EQUAL_INT(0, config_load(path, &cfg, error, sizeof(error)));
+    TEST_ASSERT_EQUAL_STRING("", error);
+    TEST_ASSERT_EQUAL_STRING("10.0.2.33", cfg.query_host);
+    TEST_ASSERT_EQUAL_INT(15637, cfg.query_port);
+    TEST_ASSERT_EQUAL_STRING("./logs/enshrouded_server.log", cfg.log_path);
+    TEST_ASSERT_EQUAL_INT(500, cfg.refresh_ms);
+    TEST_ASSERT_EQUAL_INT(250, cfg.interval_ms[COLLECT_CPU]);
+    TEST_ASSERT_EQUAL_INT(1000, cfg.interval_ms[COLLECT_MEMORY]);
+    TEST_ASSERT_EQUAL_INT(5000, cfg.interval_ms[COLLECT_A2S]);
+    TEST_ASSERT_EQUAL_INT(0, cfg.interval_ms[COLLECT_PROCESS]);
+}
+
+void test_load_reports_first_bad_line(void) {
+    write_file("config",
+               "INTERVAL_CPU=250ms\n"
+               "INTERVAL_SMAPS=30s\n"
+               "QUERY_PORT=99999\n"
+               "INTERVAL_DISK=2s\n");
+
+    char path[128];
+    config_path(path, sizeof(path));
+    emon_config_t cfg;
+    char error[256];
+    TEST_ASSERT_EQUAL_INT(0, config_load(path, &cfg, error, sizeof(error)));
+    TEST_ASSERT_NOT_NULL(strstr(error, ":2: unknown key INTERVAL_SMAPS"));
+
+    // Good lines around the bad ones still apply
+    TEST_ASSERT_EQUAL_INT(250, cfg.interval_ms[COLLECT_CPU]);
+    TEST_ASSERT_EQUAL_INT(2000, cfg.interval_ms[COLLECT_DISK]);
+    TEST_ASSERT_EQUAL_INT(0, cfg.query_port);
+}
+
+void test_load_missing_file(void) {
+    emon_config_t cfg;
+    char error[256];
+    TEST_ASSERT_EQUAL_INT(-1, config_load("/nonexistent/emon/config", &cfg, error, sizeof(error)));
+    TEST_ASSERT_TRUE(error[0] != '\0');
+}
+
+void test_task_names(void) {
+    TEST_ASSERT_EQUAL_STRING("cpu", collector_task_name(COLLECT_CPU));
+    TEST_ASSERT_EQUAL_STRING("a2s", collector_task_name(COLLECT_A2S));
+    TEST_ASSERT_EQUAL_INT(250, collector_default_interval(COLLECT_CPU));
+    TEST_ASSERT_EQUAL_INT(5000, collector_default_interval(COLLECT_A2S));
+}
+
+static int wait_readable(int fd) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    return poll(&pfd, 1, 1000);
+}
+
+void test_watch_sees_write_and_rename(void) {
+    char path[128];
+    config_path(path, sizeof(path));
+    write_file("config", "INTERVAL_CPU=1s\n");
+
+    int fd = config_watch(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL_INT(0, config_changed());
+
+    // Other files in the directory do not count
+    write_file("unrelated", "x\n");
+    TEST_ASSERT_EQUAL_INT(1, wait_readable(fd));
+    TEST_ASSERT_EQUAL_INT(0, config_changed());
+
+    write_file("config", "INTERVAL_CPU=100ms\n");
+    TEST_ASSERT_EQUAL_INT(1, wait_readable(fd));
+    TEST_ASSERT_EQUAL_INT(1, config_changed());
+
+    // Editors that save to a temporary file and rename it over the original
+    char tmp[128];
+    snprintf(tmp, sizeof(tmp), "%s/config.swp", config_dir);
+    write_file("config.swp", "INTERVAL_CPU=2s\n");
+    TEST_ASSERT_EQUAL_INT(0, rename(tmp, path));
+    TEST_ASSERT_EQUAL_INT(1, wait_readable(fd));
+    TEST_ASSERT_EQUAL_INT(1, config_changed());
+
+    config_unwatch();
+    TEST_ASSERT_EQUAL_INT(0, config_changed());
+}
+
+int main(void) {
+    if (!mkdtemp(config_dir)) {
+        printf("Failed to create config directory\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_interval_units);
+    RUN_TEST(test_parse_interval_rejects_bad_values);
+    RUN_TEST(test_load_defaults_without_file);
+    RUN_TEST(test_load_example_keys);
+    RUN_TEST(test_load_reports_first_bad_line);
+    RUN_TEST(test_load_missing_file);
+    RUN_TEST(test_task_names);
+    RUN_TEST(test_watch_sees_write_and_rename);
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/config", config_dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/unrelated", config_dir);
+    unlink(path);
+    rmdir(config_dir);
+
+    UNITY_END();
+}
@@ -0,0 +1,92 @@
+/*
+ * Unit tests for mountinfo / diskstats parsing
+ */
+
+#include "unity.h"
+#include "../disk_monitor.h"
+#include <string.h>
+
+static const char mountinfo_fixture[] =
+    "23 28 0:22 / /proc rw,relatime - proc proc rw\n"
+    "28 1 254:0 / / rw,relatime - ext4 /dev/vda rw,discard\n"
+    "45 28 0:45 /@saves /srv/enshrouded rw,relatime - btrfs /dev/sdb2 rw,space_cache\n"
+    "46 28 0:46 / /var/lib/docker/overlay rw - overlay overlay rw,lowerdir=/a\n"
+    "47 28 8:17 / /srv/my\\040saves rw,relatime - ext4 /dev/disk/by-label/game\\134data rw\n";
+
+static const char diskstats_fixture[] =
+    "   7       0 loop0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+    " 254       0 vda 6095 3859 1204562 14113 1748 1269 50032 4447 2 3024 18737 572 0 17848 175 35 1\n"
+    "   8      18 sdb2 100 0 800 50 200 0 1600 150 0 180 200\n";
+
+void test_mountinfo_root(void) {
+    char source[256], mount[256];
+    TEST_ASSERT_EQUAL_INT(0, disk_parse_mountinfo(mountinfo_fixture, 254, 0,
+                                                  source, sizeof(source), mount, sizeof(mount)));
+    TEST_ASSERT_EQUAL_STRING("/dev/vda", source);
+    TEST_ASSERT_EQUAL_STRING("/", mount);
+}
+
+void test_mountinfo_btrfs_anonymous_dev(void) {
+    char source[256], mount[256];
+    TEST_ASSERT_EQUAL_INT(0, disk_parse_mountinfo(mountinfo_fixture, 0, 45,
+                                                  source, sizeof(source), mount, sizeof(mount)));
+    TEST_ASSERT_EQUAL_STRING("/dev/sdb2", source);
+    TEST_ASSERT_EQUAL_STRING("/srv/enshrouded", mount);
+}
+
+void test_mountinfo_unescapes_paths(void) {
+    char source[256], mount[256];
+    TEST_ASSERT_EQUAL_INT(0, disk_parse_mountinfo(mountinfo_fixture, 8, 17,
+                                                  source, sizeof(source), mount, sizeof(mount)));
+    TEST_ASSERT_EQUAL_STRING("/dev/disk/by-label/game\\data", source);
+    TEST_ASSERT_EQUAL_STRING("/srv/my saves", mount);
+}
+
+void test_mountinfo_missing(void) {
+    char source[256], mount[256];
+    TEST_ASSERT_EQUAL_INT(-1, disk_parse_mountinfo(mountinfo_fixture, 9, 9,
+                                                   source, sizeof(source), mount, sizeof(mount)));
+}
+
+void test_diskstats_by_name(void) {
+    disk_counters_t c;
+    TEST_ASSERT_EQUAL_INT(0, disk_parse_diskstats(diskstats_fixture, strlen(diskstats_fixture),
+                                                  "vda", 0, 0, &c));
+    TEST_ASSERT_EQUAL_INT(6095, (int)c.reads);
+    TEST_ASSERT_EQUAL_INT(1204562, (int)c.sectors_read);
+    TEST_ASSERT_EQUAL_INT(1748, (int)c.writes);
+    TEST_ASSERT_EQUAL_INT(2, (int)c.in_flight);
+    TEST_ASSERT_EQUAL_INT(3024, (int)c.io_ms);
+    TEST_ASSERT_EQUAL_INT(18737, (int)c.weighted_io_ms);
+}
+
+void test_diskstats_by_dev_number(void) {
+    // Old kernels only report the first 11 counters
+    disk_counters_t c;
+    TEST_ASSERT_EQUAL_INT(0, disk_parse_diskstats(diskstats_fixture, strlen(diskstats_fixture),
+                                                  NULL, 8, 18, &c));
+    TEST_ASSERT_EQUAL_INT(200, (int)c.writes);
+    TEST_ASSERT_EQUAL_INT(150, (int)c.write_ms);
+}
+
+void test_diskstats_name_prefix(void) {
+    // "vd" must not match "vda"
+    disk_counters_t c;
+    TEST_ASSERT_EQUAL_INT(-1, disk_parse_diskstats(diskstats_fixture, strlen(diskstats_fixture),
+                                                   "vd", 0, 0, &c));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_mountinfo_root);
+    RUN_TEST(test_mountinfo_btrfs_anonymous_dev);
+    RUN_TEST(test_mountinfo_unescapes_paths);
+    RUN_TEST(test_mountinfo_missing);
+
+    RUN_TEST(test_diskstats_by_name);
+    RUN_TEST(test_diskstats_by_dev_number);
+    RUN_TEST(test_diskstats_name_prefix);
+
+    UNITY_END();
+}
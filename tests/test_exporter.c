@@ -0,0 +1,127 @@
+/*
+ * Unit tests for the Prometheus exporter
+ * Checks the exposition text and --listen parsing; no sockets involved.
+ */
+
+#include "unity.h"
+#include "../exporter.h"
+#include "../metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+static emon_snapshot_t snap;
+static double values[METRIC_COUNT];
+static char body[EXPORTER_BUFFER_SIZE];
+
+static void reset(void) {
+    memset(&snap, 0, sizeof(snap));
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        values[i] = NAN;
+    }
+}
+
+void test_format_emits_available_metrics(void) {
+    reset();
+    values[METRIC_CPU_PERCENT] = 12.5;
+    values[METRIC_PLAYERS] = 3;
+
+    size_t len = exporter_format(&snap, values, body, sizeof(body));
+    TEST_ASSERT_EQUAL_INT((int)strlen(body), (int)len);
+    TEST_ASSERT_NOT_NULL(strstr(body, "# TYPE emon_cpu_percent gauge\nemon_cpu_percent 12.5\n"));
+    TEST_ASSERT_NOT_NULL(strstr(body, "\nemon_players 3\n"));
+}
+
+void test_format_skips_unavailable_metrics(void) {
+    reset();
+    values[METRIC_CPU_PERCENT] = 1;
+
+    exporter_format(&snap, values, body, sizeof(body));
+    TEST_ASSERT_NULL(strstr(body, "emon_players"));
+    TEST_ASSERT_NULL(strstr(body, "emon_server_info"));
+    TEST_ASSERT_NULL(strstr(body, "NaN"));
+}
+
+void test_format_collector_durations(void) {
+    reset();
+    snap.system.sequence = 7;
+    snap.system.duration_ns = 1500000;
+    snap.a2s.sequence = 2;
+    snap.a2s.duration_ns = 250000000;
+
+    exporter_format(&snap, values, body, sizeof(body));
+    TEST_ASSERT_NOT_NULL(strstr(body, "emon_collector_duration_seconds{collector=\"system\"} 0.001500000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(body, "emon_collector_duration_seconds{collector=\"a2s\"} 0.250000000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(body, "emon_collector_runs_total{collector=\"system\"} 7\n"));
+
+    // Collectors that never ran are left out
+    TEST_ASSERT_NULL(strstr(body, "collector=\"process\""));
+
+    // Samples of one family stay contiguous
+    char *last_duration = strstr(body, "emon_collector_duration_seconds{collector=\"a2s\"}");
+    char *first_runs = strstr(body, "emon_collector_runs_total{");
+    TEST_ASSERT_TRUE(last_duration < first_runs);
+}
+
+void test_format_escapes_server_labels(void) {
+    reset();
+    snap.a2s.success = 1;
+    snprintf(snap.a2s.info.name, sizeof(snap.a2s.info.name), "Say \"hi\" \\o/");
+    snprintf(snap.a2s.info.version, sizeof(snap.a2s.info.version), "0.7.4.0");
+
+    exporter_format(&snap, values, body, sizeof(body));
+    TEST_ASSERT_NOT_NULL(strstr(body, "emon_server_info{name=\"Say \\\"hi\\\" \\\\o/\",version=\"0.7.4.0\""));
+}
+
+void test_format_truncates_to_buffer(void) {
+    reset();
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        values[i] = i;
+    }
+
+    char small[64];
+    size_t len = exporter_format(&snap, values, small, sizeof(small));
+    TEST_ASSERT_TRUE(len <= sizeof(small));
+}
+
+void test_parse_listen_port_only(void) {
+    char addr[64];
+    uint16_t port = 0;
+    TEST_ASSERT_EQUAL_INT(0, exporter_parse_listen("9100", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_STRING(EXPORTER_DEFAULT_ADDR, addr);
+    TEST_ASSERT_EQUAL_INT(9100, port);
+}
+
+void test_parse_listen_address_and_port(void) {
+    char addr[64];
+    uint16_t port = 0;
+    TEST_ASSERT_EQUAL_INT(0, exporter_parse_listen("0.0.0.0:9637", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_STRING("0.0.0.0", addr);
+    TEST_ASSERT_EQUAL_INT(9637, port);
+}
+
+void test_parse_listen_rejects_bad_input(void) {
+    char addr[64];
+    uint16_t port = 0;
+    TEST_ASSERT_EQUAL_INT(-1, exporter_parse_listen("", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_INT(-1, exporter_parse_listen("abc", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_INT(-1, exporter_parse_listen("127.0.0.1:", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_INT(-1, exporter_parse_listen(":9637", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_INT(-1, exporter_parse_listen("127.0.0.1:70000", addr, sizeof(addr), &port));
+    TEST_ASSERT_EQUAL_INT(-1, exporter_parse_listen("9637x", addr, sizeof(addr), &port));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_format_emits_available_metrics);
+    RUN_TEST(test_format_skips_unavailable_metrics);
+    RUN_TEST(test_format_collector_durations);
+    RUN_TEST(test_format_escapes_server_labels);
+    RUN_TEST(test_format_truncates_to_buffer);
+    RUN_TEST(test_parse_listen_port_only);
+    RUN_TEST(test_parse_listen_address_and_port);
+    RUN_TEST(test_parse_listen_rejects_bad_input);
+
+    UNITY_END();
+}
@@ -0,0 +1,303 @@
+/*
+ * Unit tests for fleet targets, query rounds and the incrementally sorted table
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../fleet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+static char fleet_dir[] = "/tmp/emon-test-fleet-XXXXXX";
+static fleet_result_t results[FLEET_MAX_TARGETS];
+
+static void write_targets(const char *text, char *path, size_t size) {
+    snprintf(path, size, "%s/targets", fleet_dir);
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fputs(text, fp);
+        fclose(fp);
+    }
+}
+
+// n targets 10.0.<i/250>.<i%250 + 1>, all waiting
+static int load_generated(int n) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/targets", fleet_dir);
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        fprintf(fp, "10.0.%d.%d:15637\n", i / 250, i % 250 + 1);
+    }
+    fclose(fp);
+
+    char error[128];
+    memset(results, 0, sizeof(results));
+    return fleet_load(path, 15637, error, sizeof(error));
+}
+
+// Table order must equal what a full sort by the same column produces
+static int matches_full_sort(void) {
+    static int incremental[FLEET_MAX_TARGETS];
+    int rows = fleet_table_rows();
+    for (int i = 0; i < rows; i++) {
+        incremental[i] = fleet_table_row(i);
+    }
+    fleet_table_sort(fleet_table_column(), fleet_table_descending());
+    for (int i = 0; i < rows; i++) {
+        if (fleet_table_row(i) != incremental[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void test_parse_target(void) {
+    fleet_target_t target;
+    TEST_ASSERT_EQUAL_INT(0, fleet_parse_target("10.0.2.33:27015", 15637, &target));
+    TEST_ASSERT_EQUAL_STRING("10.0.2.33", target.host);
+    TEST_ASSERT_EQUAL_INT(27015, target.port);
+    TEST_ASSERT_EQUAL_INT(27015, ntohs(target.addr.sin_port));
+
+    TEST_ASSERT_EQUAL_INT(0, fleet_parse_target("10.0.2.34", 15637, &target));
+    TEST_ASSERT_EQUAL_INT(15637, target.port);
+
+    TEST_ASSERT_EQUAL_INT(-1, fleet_parse_target("10.0.2.33:0", 15637, &target));
+    TEST_ASSERT_EQUAL_INT(-1, fleet_parse_target("10.0.2.33:70000", 15637, &target));
+    TEST_ASSERT_EQUAL_INT(-1, fleet_parse_target(":15637", 15637, &target));
+    TEST_ASSERT_EQUAL_INT(-1, fleet_parse_target("10.0.2.33:port", 15637, &target));
+}
+
+void test_load_skips_comments_bad_and_duplicate_lines(void) {
+    char path[128];
+    char error[256];
+    write_targets("# EU cluster\n"
+                  "10.0.0.1:15637\n"
+                  "\n"
+                  "  10.0.0.2  \n"
+                  "10.0.0.1:15637\n"
+                  "10.0.0.3:notaport\n"
+                  "10.0.0.1:15638\n", path, sizeof(path));
+
+    TEST_ASSERT_EQUAL_INT(3, fleet_load(path, 15637, error, sizeof(error)));
+    TEST_ASSERT_NOT_NULL(strstr(error, ":5: duplicate target"));
+    TEST_ASSERT_EQUAL_INT(3, fleet_target_count());
+    TEST_ASSERT_EQUAL_STRING("10.0.0.2", fleet_target(1)->host);
+    TEST_ASSERT_EQUAL_INT(15638, fleet_target(2)->port);
+    TEST_ASSERT_NULL(fleet_target(3));
+
+    struct sockaddr_in addr = fleet_target(2)->addr;
+    TEST_ASSERT_EQUAL_INT(2, fleet_find(&addr));
+    addr.sin_port = htons(1);
+    TEST_ASSERT_EQUAL_INT(-1, fleet_find(&addr));
+}
+
+void test_load_missing_file(void) {
+    char error[256];
+    TEST_ASSERT_EQUAL_INT(-1, fleet_load("/nonexistent/emon/targets", 15637, error, sizeof(error)));
+    TEST_ASSERT_NOT_NULL(strstr(error, "/nonexistent/emon/targets"));
+}
+
+void test_sort_target_in_natural_order(void) {
+    char path[128];
+    char error[128];
+    write_targets("10.0.0.10\n10.0.0.9\n10.0.0.100\n", path, sizeof(path));
+    TEST_ASSERT_EQUAL_INT(3, fleet_load(path, 15637, error, sizeof(error)));
+
+    fleet_table_sort(FLEET_COL_TARGET, 0);
+    TEST_ASSERT_EQUAL_INT(1, fleet_table_row(0));
+    TEST_ASSERT_EQUAL_INT(0, fleet_table_row(1));
+    TEST_ASSERT_EQUAL_INT(2, fleet_table_row(2));
+
+    fleet_table_sort(FLEET_COL_TARGET, 1);
+    TEST_ASSERT_EQUAL_INT(2, fleet_table_row(0));
+    TEST_ASSERT_EQUAL_INT(1, fleet_table_row(2));
+}
+
+void test_update_moves_changed_rows_only(void) {
+    TEST_ASSERT_EQUAL_INT(5, load_generated(5));
+    fleet_table_sort(FLEET_COL_PLAYERS, 1);
+
+    for (int i = 0; i < 5; i++) {
+        results[i].status = FLEET_UP;
+        results[i].players = (uint8_t)(i * 2);
+        results[i].max_players = 16;
+    }
+    TEST_ASSERT_EQUAL_INT(5, fleet_table_update(results, 5));
+    TEST_ASSERT_EQUAL_INT(4, fleet_table_row(0));
+    TEST_ASSERT_EQUAL_INT(0, fleet_table_row(4));
+
+    // Target 1 (2 players) becomes the busiest; an RTT change moves nothing
+    results[1].players = 12;
+    results[3].rtt_ms = 80.0f;
+    TEST_ASSERT_EQUAL_INT(1, fleet_table_update(results, 5));
+    TEST_ASSERT_EQUAL_INT(1, fleet_table_row(0));
+    TEST_ASSERT_EQUAL_INT(4, fleet_table_row(1));
+    TEST_ASSERT_EQUAL_INT(0, fleet_table_row(4));
+    TEST_ASSERT_EQUAL_INT(80, (int)fleet_table_result(3)->rtt_ms);
+
+    // Equal keys keep file order
+    results[4].players = 12;
+    fleet_table_update(results, 5);
+    TEST_ASSERT_EQUAL_INT(1, fleet_table_row(0));
+    TEST_ASSERT_EQUAL_INT(4, fleet_table_row(1));
+    TEST_ASSERT_EQUAL_INT(1, matches_full_sort());
+}
+
+void test_incremental_matches_full_sort(void) {
+    const int n = 5000;
+    TEST_ASSERT_EQUAL_INT(n, load_generated(n));
+
+    unsigned int seed = 42;
+    static const fleet_column_t columns[] = { FLEET_COL_PLAYERS, FLEET_COL_RTT, FLEET_COL_STATUS,
+                                              FLEET_COL_VERSION, FLEET_COL_SEEN };
+    for (int c = 0; c < (int)(sizeof(columns) / sizeof(columns[0])); c++) {
+        fleet_table_sort(columns[c], c % 2);
+
+        // Rounds from a handful of changes up to nearly every row
+        for (int round = 0; round < 6; round++) {
+            int changes = 1 << (round * 2);
+            for (int k = 0; k < changes; k++) {
+                seed = seed * 1103515245u + 12345u;
+                int i = (int)((seed >> 8) % (unsigned int)n);
+                results[i].status = (uint8_t)(1 + (seed >> 4) % 2);
+                results[i].players = (uint8_t)((seed >> 12) % 17);
+                results[i].max_players = 16;
+                results[i].rtt_ms = (float)((seed >> 16) % 200);
+                results[i].seen_ns = (seed >> 10) % 1000;
+                snprintf(results[i].version, sizeof(results[i].version), "0.8.%u", (seed >> 20) % 12);
+            }
+            fleet_table_update(results, n);
+            TEST_ASSERT_EQUAL_INT(1, matches_full_sort());
+        }
+    }
+}
+
+void test_counts(void) {
+    TEST_ASSERT_EQUAL_INT(4, load_generated(4));
+    results[0].status = FLEET_UP;
+    results[1].status = FLEET_UP;
+    results[2].status = FLEET_DOWN;
+    fleet_table_update(results, 4);
+
+    int up, down;
+    fleet_table_counts(&up, &down);
+    TEST_ASSERT_EQUAL_INT(2, up);
+    TEST_ASSERT_EQUAL_INT(1, down);
+}
+
+// Answers one A2S_INFO the way Enshrouded does: challenge first, then the info
+static int responder_fd = -1;
+
+static void *responder(void *arg) {
+    (void)arg;
+    static const uint8_t info[] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0x49, 0x11,
+        'F', 'l', 'e', 'e', 't', ' ', 'T', 'e', 's', 't', 0,
+        'E', 'm', 'b', 'e', 'r', 'v', 'a', 'l', 'e', 0,
+        'e', 'n', 's', 'h', 'r', 'o', 'u', 'd', 'e', 'd', 0,
+        'E', 'n', 's', 'h', 'r', 'o', 'u', 'd', 'e', 'd', 0,
+        0x00, 0x00, 5, 16, 0, 'd', 'w', 0, 0,
+        '0', '.', '8', '.', '1', '.', '1', 0
+    };
+    static const uint8_t challenge[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x41, 1, 2, 3, 4 };
+
+    for (int packets = 0; packets < 2; packets++) {
+        uint8_t buffer[256];
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(responder_fd, buffer, sizeof(buffer), 0,
+                               (struct sockaddr *)&from, &from_len);
+        if (len < 5) {
+            break;
+        }
+        int challenged = len >= 4 && memcmp(buffer + len - 4, challenge + 5, 4) == 0;
+        sendto(responder_fd, challenged ? info : challenge,
+               challenged ? sizeof(info) : sizeof(challenge), 0,
+               (struct sockaddr *)&from, from_len);
+        if (challenged) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+static uint16_t bound_port(int fd) {
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    socklen_t len = sizeof(addr);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr *)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+void test_query_round_handles_challenge_and_silence(void) {
+    responder_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct timeval timeout = { .tv_sec = 2 };
+    setsockopt(responder_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    uint16_t live_port = bound_port(responder_fd);
+
+    // A port nobody listens on any more
+    int silent_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    uint16_t silent_port = bound_port(silent_fd);
+    close(silent_fd);
+
+    char text[128];
+    char path[128];
+    char error[128];
+    snprintf(text, sizeof(text), "127.0.0.1:%u\n127.0.0.1:%u\n", silent_port, live_port);
+    write_targets(text, path, sizeof(path));
+    TEST_ASSERT_EQUAL_INT(2, fleet_load(path, 15637, error, sizeof(error)));
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, responder, NULL);
+
+    memset(results, 0, sizeof(results));
+    TEST_ASSERT_EQUAL_INT(0, fleet_query_open());
+    TEST_ASSERT_EQUAL_INT(1, fleet_query_round(results, -1, 300));
+    pthread_join(thread, NULL);
+    fleet_query_close();
+    close(responder_fd);
+
+    TEST_ASSERT_EQUAL_INT(FLEET_DOWN, results[0].status);
+    TEST_ASSERT_EQUAL_INT(0, (int)(results[0].seen_ns != 0));
+    TEST_ASSERT_EQUAL_INT(FLEET_UP, results[1].status);
+    TEST_ASSERT_EQUAL_STRING("Fleet Test", results[1].name);
+    TEST_ASSERT_EQUAL_STRING("0.8.1.1", results[1].version);
+    TEST_ASSERT_EQUAL_INT(5, results[1].players);
+    TEST_ASSERT_EQUAL_INT(16, results[1].max_players);
+    TEST_ASSERT_TRUE(results[1].seen_ns != 0);
+}
+
+int main(void) {
+    if (!mkdtemp(fleet_dir)) {
+        printf("Failed to create test directory\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_target);
+    RUN_TEST(test_load_skips_comments_bad_and_duplicate_lines);
+    RUN_TEST(test_load_missing_file);
+    RUN_TEST(test_sort_target_in_natural_order);
+    RUN_TEST(test_update_moves_changed_rows_only);
+    RUN_TEST(test_incremental_matches_full_sort);
+    RUN_TEST(test_counts);
+    RUN_TEST(test_query_round_handles_challenge_and_silence);
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/targets", fleet_dir);
+    unlink(path);
+    rmdir(fleet_dir);
+
+    UNITY_END();
+}
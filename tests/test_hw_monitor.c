@@ -0,0 +1,151 @@
+/*
+ * Unit tests for the cpufreq / thermal / hwmon collector
+ * Builds a small fake sysfs tree and points hw_monitor at it.
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../hw_monitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char sysfs_dir[] = "/tmp/emon_sysfs_XXXXXX";
+
+// Create parent directories as needed, then write content
+static void write_fixture(const char *rel_path, const char *content) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", sysfs_dir, rel_path);
+
+    for (char *p = path + strlen(sysfs_dir) + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fputs(content, fp);
+        fclose(fp);
+    }
+}
+
+static void build_fixture(void) {
+    write_fixture("devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "3500000\n");
+    write_fixture("devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", "4200000\n");
+    write_fixture("devices/system/cpu/cpu0/thermal_throttle/core_throttle_count", "3\n");
+    write_fixture("devices/system/cpu/cpu0/thermal_throttle/package_throttle_count", "2\n");
+    write_fixture("devices/system/cpu/cpu1/cpufreq/scaling_cur_freq", "1500000\n");
+    write_fixture("devices/system/cpu/cpu1/thermal_throttle/core_throttle_count", "1\n");
+    // cpu2 is cpu0's hyperthread: it reports the same core counter
+    write_fixture("devices/system/cpu/cpu2/cpufreq/scaling_cur_freq", "2500000\n");
+    write_fixture("devices/system/cpu/cpu2/thermal_throttle/core_throttle_count", "3\n");
+    write_fixture("devices/system/cpu/cpu0/topology/thread_siblings_list", "0,2\n");
+    write_fixture("devices/system/cpu/cpu1/topology/thread_siblings_list", "1\n");
+    write_fixture("devices/system/cpu/cpu2/topology/thread_siblings_list", "0,2\n");
+    write_fixture("class/thermal/thermal_zone0/type", "x86_pkg_temp\n");
+    write_fixture("class/thermal/thermal_zone0/temp", "61000\n");
+    write_fixture("class/hwmon/hwmon0/name", "coretemp\n");
+    write_fixture("class/hwmon/hwmon0/temp1_label", "Package id 0\n");
+    write_fixture("class/hwmon/hwmon0/temp1_input", "87500\n");
+}
+
+void test_hw_frequencies(void) {
+    hw_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(0, hw_monitor_get_stats(&stats));
+    TEST_ASSERT_EQUAL_INT(3, stats.cpu_count);
+    TEST_ASSERT_EQUAL_INT(3500, stats.freq_mhz[0]);
+    TEST_ASSERT_EQUAL_INT(1500, stats.freq_mhz[1]);
+    TEST_ASSERT_EQUAL_INT(1500, stats.freq_min_mhz);
+    TEST_ASSERT_EQUAL_INT(2500, stats.freq_avg_mhz);
+    TEST_ASSERT_EQUAL_INT(3500, stats.freq_max_mhz);
+    TEST_ASSERT_EQUAL_INT(4200, stats.freq_limit_mhz);
+}
+
+void test_hw_sensors(void) {
+    hw_stats_t stats;
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(2, stats.sensor_count);
+    TEST_ASSERT_TRUE(stats.hottest >= 0);
+    TEST_ASSERT_EQUAL_STRING("Package id 0", stats.sensors[stats.hottest].label);
+    TEST_ASSERT_EQUAL_INT(875, (int)(stats.sensors[stats.hottest].celsius * 10));
+}
+
+void test_hw_throttle_counts(void) {
+    hw_stats_t stats;
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(6, (int)stats.throttle_count);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.throttle_new);
+
+    write_fixture("devices/system/cpu/cpu1/thermal_throttle/core_throttle_count", "5\n");
+    hw_monitor_invalidate();
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(10, (int)stats.throttle_count);
+    TEST_ASSERT_EQUAL_INT(4, (int)stats.throttle_new);
+}
+
+void test_hw_cached_between_samples(void) {
+    hw_stats_t stats;
+    hw_monitor_invalidate();
+    hw_monitor_get_stats(&stats);
+
+    // Within HW_SAMPLE_INTERVAL_MS the previous reading is returned
+    write_fixture("devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "800000\n");
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(3500, stats.freq_mhz[0]);
+
+    hw_monitor_invalidate();
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(800, stats.freq_mhz[0]);
+}
+
+void test_hw_throttle_from_zero(void) {
+    hw_stats_t stats;
+    write_fixture("devices/system/cpu/cpu0/thermal_throttle/core_throttle_count", "0\n");
+    write_fixture("devices/system/cpu/cpu0/thermal_throttle/package_throttle_count", "0\n");
+    write_fixture("devices/system/cpu/cpu1/thermal_throttle/core_throttle_count", "0\n");
+    hw_monitor_invalidate();
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.throttle_count);
+
+    // A zero total is still a baseline: the first events are reported
+    write_fixture("devices/system/cpu/cpu1/thermal_throttle/core_throttle_count", "2\n");
+    hw_monitor_invalidate();
+    hw_monitor_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(2, (int)stats.throttle_new);
+}
+
+int main(void) {
+    if (!mkdtemp(sysfs_dir)) {
+        printf("Failed to create fixture directory\n");
+        return 1;
+    }
+    build_fixture();
+
+    if (hw_monitor_init(sysfs_dir) < 0) {
+        printf("hw_monitor_init failed on fixture\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_hw_frequencies);
+    RUN_TEST(test_hw_sensors);
+    RUN_TEST(test_hw_throttle_counts);
+    RUN_TEST(test_hw_cached_between_samples);
+    RUN_TEST(test_hw_throttle_from_zero);
+
+    hw_monitor_cleanup();
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", sysfs_dir);
+    if (system(cmd) != 0) {
+        printf("Failed to remove %s\n", sysfs_dir);
+    }
+
+    UNITY_END();
+}
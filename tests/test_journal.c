@@ -0,0 +1,210 @@
+/*
+ * Unit tests for the memory-mapped metric journal
+ * Uses tiny segments (8 records) in a temporary directory.
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#define SLOTS 8
+
+static char journal_dir[] = "/tmp/emon_journal_XXXXXX";
+
+static journal_config_t small_config(int max_segments) {
+    journal_config_t config = {
+        .dir = journal_dir,
+        .segment_bytes = (SLOTS + 1) * JOURNAL_RECORD_SIZE,
+        .max_segments = max_segments,
+    };
+    return config;
+}
+
+static void segment_path(unsigned int index, char *path, size_t size) {
+    snprintf(path, size, "%s/emon-%08u.jnl", journal_dir, index);
+}
+
+static void clear_dir(void) {
+    char path[256];
+    for (unsigned int i = 1; i < 32; i++) {
+        segment_path(i, path, sizeof(path));
+        unlink(path);
+    }
+}
+
+// Count intact records in a segment, -1 if it cannot be opened
+static int count_records(unsigned int index, const journal_record_t **last_out) {
+    char path[256];
+    journal_reader_t reader;
+    segment_path(index, path, sizeof(path));
+    if (journal_reader_open(&reader, path) < 0) {
+        return -1;
+    }
+
+    int count = 0;
+    const journal_record_t *record;
+    static journal_record_t last;
+    while ((record = journal_reader_next(&reader)) != NULL) {
+        last = *record;
+        count++;
+    }
+    journal_reader_close(&reader);
+    if (last_out) {
+        *last_out = &last;
+    }
+    return count;
+}
+
+void test_journal_crc32_known_value(void) {
+    TEST_ASSERT_EQUAL_INT((int)0xCBF43926u, (int)journal_crc32("123456789", 9));
+}
+
+void test_journal_roundtrip_samples_and_events(void) {
+    clear_dir();
+    journal_config_t config = small_config(4);
+    TEST_ASSERT_EQUAL_INT(0, journal_open(&config));
+
+    double values[3] = { 12.5, NAN, 4096.0 };
+    TEST_ASSERT_EQUAL_INT(0, journal_append_sample(1000, 0x5, values, 3));
+    TEST_ASSERT_EQUAL_INT(0, journal_append_event(2000, JOURNAL_EVENT_SERVER_DOWN, "no reply"));
+    journal_close();
+
+    char path[256];
+    journal_reader_t reader;
+    segment_path(1, path, sizeof(path));
+    TEST_ASSERT_EQUAL_INT(0, journal_reader_open(&reader, path));
+    TEST_ASSERT_EQUAL_INT(3, (int)reader.header->value_count);
+
+    const journal_record_t *rec = journal_reader_next(&reader);
+    TEST_ASSERT_NOT_NULL(rec);
+    TEST_ASSERT_EQUAL_INT(JOURNAL_RECORD_SAMPLE, rec->type);
+    TEST_ASSERT_EQUAL_INT(0x5, rec->detail);
+    TEST_ASSERT_EQUAL_INT(1000, (int)rec->time_ms);
+    TEST_ASSERT_EQUAL_INT(125, (int)(rec->values[0] * 10));
+    TEST_ASSERT_TRUE(isnan(rec->values[1]));
+    TEST_ASSERT_TRUE(isnan(rec->values[3]));
+
+    rec = journal_reader_next(&reader);
+    TEST_ASSERT_NOT_NULL(rec);
+    TEST_ASSERT_EQUAL_INT(JOURNAL_RECORD_EVENT, rec->type);
+    TEST_ASSERT_EQUAL_INT(JOURNAL_EVENT_SERVER_DOWN, rec->detail);
+    TEST_ASSERT_EQUAL_INT(1, (int)rec->sequence);
+    TEST_ASSERT_EQUAL_STRING("no reply", rec->text);
+
+    TEST_ASSERT_NULL(journal_reader_next(&reader));
+    journal_reader_close(&reader);
+}
+
+void test_journal_torn_record_ends_data_and_resume_overwrites_it(void) {
+    clear_dir();
+    journal_config_t config = small_config(4);
+    double value = 1.0;
+
+    TEST_ASSERT_EQUAL_INT(0, journal_open(&config));
+    for (int i = 0; i < 3; i++) {
+        journal_append_sample(i, 1, &value, 1);
+    }
+    journal_close();
+
+    // Simulate a crash mid-write of the third record
+    char path[256];
+    segment_path(1, path, sizeof(path));
+    int fd = open(path, O_WRONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    uint8_t garbage = 0xAB;
+    TEST_ASSERT_EQUAL_INT(1, (int)pwrite(fd, &garbage, 1, 3 * JOURNAL_RECORD_SIZE + 40));
+    close(fd);
+    TEST_ASSERT_EQUAL_INT(2, count_records(1, NULL));
+
+    // Reopening continues in place after the last intact record
+    const journal_record_t *last;
+    TEST_ASSERT_EQUAL_INT(0, journal_open(&config));
+    journal_append_sample(10, 1, &value, 1);
+    journal_close();
+    TEST_ASSERT_EQUAL_INT(3, count_records(1, &last));
+    TEST_ASSERT_EQUAL_INT(10, (int)last->time_ms);
+    TEST_ASSERT_EQUAL_INT(2, (int)last->sequence);
+    TEST_ASSERT_EQUAL_INT(-1, count_records(2, NULL));
+}
+
+void test_journal_count_stops_at_a_lost_block(void) {
+    clear_dir();
+    journal_config_t config = small_config(4);
+    double value = 1.0;
+
+    TEST_ASSERT_EQUAL_INT(0, journal_open(&config));
+    for (int i = 0; i < 5; i++) {
+        journal_append_sample(i, 1, &value, 1);
+    }
+    journal_close();
+
+    // Writeback reached the disk out of order: the second block never did
+    char path[256];
+    segment_path(1, path, sizeof(path));
+    int fd = open(path, O_WRONLY);
+    TEST_ASSERT_TRUE(fd >= 0);
+    static const uint8_t zero[JOURNAL_RECORD_SIZE];
+    TEST_ASSERT_EQUAL_INT(JOURNAL_RECORD_SIZE,
+                          (int)pwrite(fd, zero, sizeof(zero), 2 * JOURNAL_RECORD_SIZE));
+    close(fd);
+
+    journal_reader_t reader;
+    TEST_ASSERT_EQUAL_INT(0, journal_reader_open(&reader, path));
+    TEST_ASSERT_EQUAL_INT(1, (int)journal_reader_count(&reader));
+    journal_reader_close(&reader);
+}
+
+void test_journal_rotation_and_retention(void) {
+    clear_dir();
+    journal_config_t config = small_config(2);
+    double value = 2.0;
+
+    // 20 records: segments 1 and 2 fill, 3 holds the rest
+    TEST_ASSERT_EQUAL_INT(0, journal_open(&config));
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL_INT(0, journal_append_sample(i, 1, &value, 1));
+    }
+    journal_close();
+
+    const journal_record_t *last;
+    TEST_ASSERT_EQUAL_INT(-1, count_records(1, NULL));   // Beyond max_segments
+    TEST_ASSERT_EQUAL_INT(SLOTS, count_records(2, &last));
+    TEST_ASSERT_EQUAL_INT(15, (int)last->sequence);
+    TEST_ASSERT_EQUAL_INT(4, count_records(3, &last));
+    TEST_ASSERT_EQUAL_INT(19, (int)last->time_ms);
+}
+
+void test_journal_rejects_bad_files(void) {
+    journal_reader_t reader;
+    TEST_ASSERT_EQUAL_INT(-1, journal_reader_open(&reader, "/nonexistent/emon.jnl"));
+    TEST_ASSERT_EQUAL_INT(-1, journal_reader_open(&reader, "/proc/self/stat"));
+    TEST_ASSERT_EQUAL_STRING("psi_stall", journal_event_name(JOURNAL_EVENT_PSI_STALL));
+    TEST_ASSERT_EQUAL_STRING("unknown", journal_event_name(JOURNAL_EVENT_COUNT));
+}
+
+int main(void) {
+    if (!mkdtemp(journal_dir)) {
+        printf("Failed to create journal directory\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_journal_crc32_known_value);
+    RUN_TEST(test_journal_roundtrip_samples_and_events);
+    RUN_TEST(test_journal_torn_record_ends_data_and_resume_overwrites_it);
+    RUN_TEST(test_journal_count_stops_at_a_lost_block);
+    RUN_TEST(test_journal_rotation_and_retention);
+    RUN_TEST(test_journal_rejects_bad_files);
+
+    clear_dir();
+    rmdir(journal_dir);
+
+    UNITY_END();
+}
@@ -0,0 +1,133 @@
+/*
+ * Unit tests for the log event automaton and the block newline splitter
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../log_events.h"
+#include "../log_tail.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t match(const char *line) {
+    return log_events_match(line, strlen(line));
+}
+
+void test_init_compiles_the_patterns(void) {
+    TEST_ASSERT_EQUAL_INT(0, log_events_init());
+    TEST_ASSERT_EQUAL_INT(0, log_events_init());
+}
+
+void test_each_event_is_recognised(void) {
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_JOIN),
+                          match("[server] Player 'Alice' logged in with Permissions: Default"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_LEAVE), match("[server] Remove Player 'Alice'"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_SAVE), match("[savegame] World Saved in 120ms"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_ERROR), match("[error] could not bind port"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_DISCONNECT), match("[net] client 3 timed out"));
+}
+
+void test_matching_ignores_case(void) {
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_SAVE), match("WORLD SAVED"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_DISCONNECT), match("Peer KiCkEd by host"));
+}
+
+void test_plain_lines_match_nothing(void) {
+    TEST_ASSERT_EQUAL_INT(0, match(""));
+    TEST_ASSERT_EQUAL_INT(0, match("[Session] tick update ok"));
+    TEST_ASSERT_EQUAL_INT(0, match("world save"));
+    TEST_ASSERT_EQUAL_INT(0, match("errors"));
+}
+
+void test_one_line_can_carry_several_events(void) {
+    uint32_t found = match("[error] Player 'Bob' disconnected: connection lost");
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_ERROR) | LOG_EVENT_BIT(LOG_EVENT_DISCONNECT), found);
+}
+
+void test_failure_links_find_overlapping_patterns(void) {
+    // A false start must not hide a match that begins inside it
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_SAVE), match("world saveworld saved"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_SAVE), match("savegame saved world"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_ERROR), match("unhandled exceptionfatal"));
+    TEST_ASSERT_EQUAL_INT(LOG_EVENT_BIT(LOG_EVENT_DISCONNECT), match("disconnecdisconnected"));
+}
+
+void test_player_name_comes_from_the_quotes(void) {
+    char name[64];
+    const char *line = "[server] Player 'Sir Lancelot' logged in with Permissions: Admin";
+    TEST_ASSERT_EQUAL_INT(0, log_events_player(line, strlen(line), name, sizeof(name)));
+    TEST_ASSERT_EQUAL_STRING("Sir Lancelot", name);
+
+    TEST_ASSERT_EQUAL_INT(-1, log_events_player("no quotes", 9, name, sizeof(name)));
+    TEST_ASSERT_EQUAL_INT(-1, log_events_player("open 'only", 10, name, sizeof(name)));
+    TEST_ASSERT_EQUAL_INT(-1, log_events_player("empty ''", 8, name, sizeof(name)));
+}
+
+static char expected[256][160];
+static int seen_count;
+static int seen_ok;
+
+static void check_line(const char *line, size_t len, void *ctx) {
+    (void)ctx;
+    if (seen_count >= 256 || strlen(expected[seen_count]) != len ||
+        memcmp(expected[seen_count], line, len) != 0 || line[len] != '\0') {
+        seen_ok = 0;
+    }
+    seen_count++;
+}
+
+void test_split_finds_every_newline_across_blocks(void) {
+    // Lines of every length from 0 to 129 so newlines land at every offset
+    // of a 64-byte block, some ending in CR
+    static char data[20000];
+    size_t len = 0;
+    int lines = 0;
+    for (int n = 0; n < 130; n++, lines++) {
+        for (int i = 0; i < n; i++) {
+            expected[lines][i] = (char)('a' + (n + i) % 26);
+        }
+        expected[lines][n] = '\0';
+        memcpy(data + len, expected[lines], (size_t)n);
+        len += (size_t)n;
+        if (n % 7 == 3) {
+            data[len++] = '\r';
+        }
+        data[len++] = '\n';
+    }
+    memcpy(data + len, "partial", 7);
+    size_t total = len + 7;
+
+    size_t consumed = 0;
+    seen_count = 0;
+    seen_ok = 1;
+    TEST_ASSERT_EQUAL_INT(lines, log_tail_split(data, total, check_line, NULL, &consumed));
+    TEST_ASSERT_EQUAL_INT(lines, seen_count);
+    TEST_ASSERT_TRUE(seen_ok);
+    TEST_ASSERT_EQUAL_INT((int)len, (int)consumed);
+}
+
+void test_split_without_newline_consumes_nothing(void) {
+    char data[200];
+    memset(data, 'x', sizeof(data));
+    size_t consumed = 1;
+    seen_count = 0;
+    TEST_ASSERT_EQUAL_INT(0, log_tail_split(data, sizeof(data), check_line, NULL, &consumed));
+    TEST_ASSERT_EQUAL_INT(0, (int)consumed);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_init_compiles_the_patterns);
+    RUN_TEST(test_each_event_is_recognised);
+    RUN_TEST(test_matching_ignores_case);
+    RUN_TEST(test_plain_lines_match_nothing);
+    RUN_TEST(test_one_line_can_carry_several_events);
+    RUN_TEST(test_failure_links_find_overlapping_patterns);
+    RUN_TEST(test_player_name_comes_from_the_quotes);
+    RUN_TEST(test_split_finds_every_newline_across_blocks);
+    RUN_TEST(test_split_without_newline_consumes_nothing);
+
+    UNITY_END();
+}
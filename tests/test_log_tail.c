@@ -0,0 +1,188 @@
+/*
+ * Unit tests for the server log tailer (appends, partial lines, truncation,
+ * rotation)
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../log_tail.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+
+#define MAX_SEEN 16
+
+static char log_dir[] = "/tmp/emon-test-log-XXXXXX";
+static char log_path[256];
+static int watch_fd = -1;
+
+static char seen[MAX_SEEN][128];
+static int seen_count;
+
+static void collect_line(const char *line, size_t len, void *ctx) {
+    (void)ctx;
+    if (seen_count < MAX_SEEN) {
+        snprintf(seen[seen_count], sizeof(seen[0]), "%.*s", (int)len, line);
+    }
+    seen_count++;
+}
+
+static void append(const char *path, const char *text) {
+    FILE *fp = fopen(path, "a");
+    if (fp) {
+        fputs(text, fp);
+        fclose(fp);
+    }
+}
+
+// Whether inotify has something for us (the tailer never blocks)
+static int woke(void) {
+    struct pollfd pfd = { .fd = watch_fd, .events = POLLIN };
+    return poll(&pfd, 1, 1000) == 1;
+}
+
+static int read_lines(void) {
+    seen_count = 0;
+    return log_tail_read(collect_line, NULL);
+}
+
+void test_existing_content_is_skipped(void) {
+    append(log_path, "old line 1\nold line 2\nhalf a li");
+    watch_fd = log_tail_open(log_path);
+    TEST_ASSERT_TRUE(watch_fd >= 0);
+
+    log_tail_stats_t stats;
+    log_tail_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.open);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.bytes);
+
+    // The rest of the line we started in is dropped, not handed over
+    append(log_path, "ne\n[Session] 'Alice' logged in\n");
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(1, read_lines());
+    TEST_ASSERT_EQUAL_STRING("[Session] 'Alice' logged in", seen[0]);
+}
+
+void test_partial_line_waits_for_newline(void) {
+    append(log_path, "[Save] World Sa");
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(0, read_lines());
+
+    append(log_path, "ved\r\nnext\n");
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(2, read_lines());
+    TEST_ASSERT_EQUAL_STRING("[Save] World Saved", seen[0]);
+    TEST_ASSERT_EQUAL_STRING("next", seen[1]);
+}
+
+void test_nothing_new_reads_nothing(void) {
+    TEST_ASSERT_EQUAL_INT(0, read_lines());
+}
+
+void test_truncation_restarts_at_the_beginning(void) {
+    log_tail_stats_t before;
+    log_tail_stats(&before);
+
+    // copytruncate: the file is emptied in place and written again
+    FILE *fp = fopen(log_path, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fputs("after truncate\n", fp);
+    fclose(fp);
+
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(1, read_lines());
+    TEST_ASSERT_EQUAL_STRING("after truncate", seen[0]);
+
+    log_tail_stats_t after;
+    log_tail_stats(&after);
+    TEST_ASSERT_EQUAL_INT((int)before.truncations + 1, (int)after.truncations);
+    TEST_ASSERT_EQUAL_INT(15, (int)after.offset);
+}
+
+void test_rotation_drains_old_file_then_follows_new_one(void) {
+    char rotated[300];
+    snprintf(rotated, sizeof(rotated), "%s.1", log_path);
+
+    append(log_path, "last before rotate\n");
+    TEST_ASSERT_EQUAL_INT(0, rename(log_path, rotated));
+    append(rotated, "written late to the old file\n");
+    append(log_path, "first in new file\n");
+
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(3, read_lines());
+    TEST_ASSERT_EQUAL_STRING("last before rotate", seen[0]);
+    TEST_ASSERT_EQUAL_STRING("written late to the old file", seen[1]);
+    TEST_ASSERT_EQUAL_STRING("first in new file", seen[2]);
+
+    log_tail_stats_t stats;
+    log_tail_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.rotations);
+
+    // Writes to the old file are no longer followed
+    append(rotated, "ignored\n");
+    append(log_path, "second in new file\n");
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(1, read_lines());
+    TEST_ASSERT_EQUAL_STRING("second in new file", seen[0]);
+    unlink(rotated);
+}
+
+void test_missing_file_is_picked_up_when_created(void) {
+    log_tail_close();
+    unlink(log_path);
+
+    watch_fd = log_tail_open(log_path);
+    TEST_ASSERT_TRUE(watch_fd >= 0);
+    log_tail_stats_t stats;
+    log_tail_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(0, stats.open);
+
+    // A file that appears later is read from its first byte
+    append(log_path, "server starting\n");
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(1, read_lines());
+    TEST_ASSERT_EQUAL_STRING("server starting", seen[0]);
+    log_tail_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.open);
+    TEST_ASSERT_EQUAL_INT(0, (int)stats.rotations);
+}
+
+void test_overlong_line_is_split(void) {
+    static char big[LOG_TAIL_BUFFER + 64];
+    memset(big, 'x', LOG_TAIL_BUFFER + 10);
+    big[LOG_TAIL_BUFFER + 10] = '\n';
+    big[LOG_TAIL_BUFFER + 11] = '\0';
+    append(log_path, big);
+
+    TEST_ASSERT_TRUE(woke());
+    TEST_ASSERT_EQUAL_INT(2, read_lines());
+    log_tail_stats_t stats;
+    log_tail_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.long_lines);
+}
+
+int main(void) {
+    if (!mkdtemp(log_dir)) {
+        printf("Failed to create test directory\n");
+        return 1;
+    }
+    snprintf(log_path, sizeof(log_path), "%s/enshrouded_server.log", log_dir);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_existing_content_is_skipped);
+    RUN_TEST(test_partial_line_waits_for_newline);
+    RUN_TEST(test_nothing_new_reads_nothing);
+    RUN_TEST(test_truncation_restarts_at_the_beginning);
+    RUN_TEST(test_rotation_drains_old_file_then_follows_new_one);
+    RUN_TEST(test_missing_file_is_picked_up_when_created);
+    RUN_TEST(test_overlong_line_is_split);
+
+    log_tail_close();
+    unlink(log_path);
+    rmdir(log_dir);
+
+    UNITY_END();
+}
@@ -0,0 +1,147 @@
+/*
+ * Unit tests for streaming JSON Lines / CSV output
+ * Records are written to a pipe and read back.
+ */
+
+#include "unity.h"
+#include "../output.h"
+#include "../metrics.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+static emon_snapshot_t snap;
+static double values[METRIC_COUNT];
+static char text[OUTPUT_BUFFER_SIZE];
+static int pipe_fds[2];
+
+static void reset(void) {
+    memset(&snap, 0, sizeof(snap));
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        values[i] = NAN;
+    }
+}
+
+// Flush and return whatever reached the pipe ("" if the flush failed)
+static const char *drain(void) {
+    if (output_flush() < 0) {
+        return "";
+    }
+    ssize_t n = read(pipe_fds[0], text, sizeof(text) - 1);
+    text[n > 0 ? n : 0] = '\0';
+    return text;
+}
+
+void test_parse_format(void) {
+    output_format_t format;
+    TEST_ASSERT_EQUAL_INT(0, output_parse_format("jsonl", &format));
+    TEST_ASSERT_EQUAL_INT(OUTPUT_JSONL, format);
+    TEST_ASSERT_EQUAL_INT(0, output_parse_format("csv", &format));
+    TEST_ASSERT_EQUAL_INT(OUTPUT_CSV, format);
+    TEST_ASSERT_EQUAL_INT(-1, output_parse_format("xml", &format));
+}
+
+void test_jsonl_record(void) {
+    reset();
+    values[METRIC_CPU_PERCENT] = 12.5;
+    values[METRIC_MEM_USED_KB] = 1048576;
+    values[METRIC_A2S_RTT_MS] = 0.0004;
+    values[METRIC_SWAP_IN_RATE] = -1.25;
+
+    TEST_ASSERT_EQUAL_INT(0, output_open(OUTPUT_JSONL, pipe_fds[1]));
+    TEST_ASSERT_EQUAL_INT(0, output_record(1700000000123LL, 0x5, &snap, values));
+    const char *line = drain();
+
+    TEST_ASSERT_EQUAL_INT(0, strncmp(line, "{\"time_ms\":1700000000123,\"sources\":\"system+a2s\",", 48));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"cpu_percent\":12.5,"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"memory_used_kb\":1048576,"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"a2s_rtt_ms\":0,"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"swap_in_pages_per_sec\":-1.25,"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"players\":null,"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"server_name\":null"));
+    TEST_ASSERT_EQUAL_STRING("}\n", line + strlen(line) - 2);
+    output_close();
+}
+
+void test_jsonl_escapes_server_name(void) {
+    reset();
+    snap.a2s.success = 1;
+    snprintf(snap.a2s.info.name, sizeof(snap.a2s.info.name), "A \"B\"\\\t");
+    snprintf(snap.a2s.info.version, sizeof(snap.a2s.info.version), "0.7.4.0");
+
+    output_open(OUTPUT_JSONL, pipe_fds[1]);
+    output_record(0, 0x4, &snap, values);
+    const char *line = drain();
+
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"server_name\":\"A \\\"B\\\"\\\\\\u0009\""));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"server_version\":\"0.7.4.0\""));
+    output_close();
+}
+
+void test_csv_header_and_row(void) {
+    reset();
+    values[METRIC_CPU_PERCENT] = 99.999;
+    values[METRIC_PLAYERS] = 3;
+    snap.a2s.success = 1;
+    snprintf(snap.a2s.info.name, sizeof(snap.a2s.info.name), "Say \"hi\", all");
+
+    TEST_ASSERT_EQUAL_INT(0, output_open(OUTPUT_CSV, pipe_fds[1]));
+    output_record(42, 0x1, &snap, values);
+    const char *out = drain();
+
+    TEST_ASSERT_EQUAL_INT(0, strncmp(out, "time_ms,sources,cpu_percent,cpu_steal_percent,", 46));
+    const char *row = strchr(out, '\n') + 1;
+    TEST_ASSERT_EQUAL_INT(0, strncmp(row, "42,system,99.999,,", 18));
+    TEST_ASSERT_NOT_NULL(strstr(row, ",\"Say \"\"hi\"\", all\",\"\","));
+
+    // Every row has as many fields as the header
+    int header_commas = 0, row_commas = 0;
+    for (const char *p = out; *p != '\n'; p++) {
+        header_commas += (*p == ',');
+    }
+    for (const char *p = row; *p != '\n'; p++) {
+        row_commas += (*p == ',');
+    }
+    TEST_ASSERT_EQUAL_INT(header_commas, row_commas - 1); // One comma inside the quoted name
+    output_close();
+}
+
+void test_buffer_flushes_before_overflow(void) {
+    reset();
+    values[METRIC_CPU_PERCENT] = 1;
+
+    output_open(OUTPUT_JSONL, pipe_fds[1]);
+    size_t total = 0;
+    for (int i = 0; i < 200; i++) {
+        TEST_ASSERT_EQUAL_INT(0, output_record(i, 0x1, &snap, values));
+        // Keep the pipe from filling up
+        ssize_t n;
+        while ((n = read(pipe_fds[0], text, sizeof(text))) == (ssize_t)sizeof(text)) {
+            total += (size_t)n;
+        }
+        total += (n > 0) ? (size_t)n : 0;
+    }
+    total += strlen(drain());
+    TEST_ASSERT_TRUE(total > OUTPUT_BUFFER_SIZE);
+    output_close();
+}
+
+int main(void) {
+    if (pipe(pipe_fds) < 0) {
+        printf("Failed to create pipe\n");
+        return 1;
+    }
+    fcntl(pipe_fds[0], F_SETFL, O_NONBLOCK);
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_format);
+    RUN_TEST(test_jsonl_record);
+    RUN_TEST(test_jsonl_escapes_server_name);
+    RUN_TEST(test_csv_header_and_row);
+    RUN_TEST(test_buffer_flushes_before_overflow);
+
+    UNITY_END();
+}
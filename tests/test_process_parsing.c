@@ -0,0 +1,261 @@
+/*
+ * Unit tests for process discovery helpers
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../process_monitor.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+void test_query_port_arg_equals(void) {
+    uint16_t port = process_parse_query_port_arg("wine EnshroudedServer.exe -queryport=25637");
+    TEST_ASSERT_EQUAL_INT(25637, port);
+}
+
+void test_query_port_arg_space_mixed_case(void) {
+    uint16_t port = process_parse_query_port_arg("EnshroudedServer.exe --queryPort 15647 -log");
+    TEST_ASSERT_EQUAL_INT(15647, port);
+}
+
+void test_query_port_arg_missing(void) {
+    uint16_t port = process_parse_query_port_arg("wine EnshroudedServer.exe -log");
+    TEST_ASSERT_EQUAL_INT(0, port);
+}
+
+void test_query_port_arg_embedded_word(void) {
+    // "myqueryport" is not a queryport argument
+    uint16_t port = process_parse_query_port_arg("EnshroudedServer.exe -myqueryport=1");
+    TEST_ASSERT_EQUAL_INT(0, port);
+}
+
+void test_query_port_arg_out_of_range(void) {
+    uint16_t port = process_parse_query_port_arg("EnshroudedServer.exe -queryport=70000");
+    TEST_ASSERT_EQUAL_INT(0, port);
+}
+
+void test_pick_query_port_pair(void) {
+    uint16_t ports[] = {15637, 40000, 15636};
+    TEST_ASSERT_EQUAL_INT(15637, process_pick_query_port(ports, 3));
+}
+
+void test_pick_query_port_single(void) {
+    uint16_t ports[] = {27015};
+    TEST_ASSERT_EQUAL_INT(27015, process_pick_query_port(ports, 1));
+}
+
+void test_pick_query_port_none(void) {
+    TEST_ASSERT_EQUAL_INT(0, process_pick_query_port(NULL, 0));
+}
+
+static char temp_dir[] = "/tmp/emon-test-proc-XXXXXX";
+static char root[96];
+
+static void write_text(const char *name, const char *text) {
+    char path[192];
+    snprintf(path, sizeof(path), "%s/%s", root, name);
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fputs(text, fp);
+        fclose(fp);
+    }
+}
+
+static void write_full(int pid, int ppid, const char *comm, const char *cmdline, int starttime) {
+    char name[160], text[256];
+    snprintf(name, sizeof(name), "%s/%d", root, pid);
+    mkdir(name, 0755);
+
+    snprintf(name, sizeof(name), "%d/comm", pid);
+    snprintf(text, sizeof(text), "%s\n", comm);
+    write_text(name, text);
+    snprintf(name, sizeof(name), "%d/cmdline", pid);
+    write_text(name, cmdline);
+    snprintf(name, sizeof(name), "%d/status", pid);
+    write_text(name, "Name:\tx\nVmRSS:\t1024 kB\n");
+    snprintf(name, sizeof(name), "%d/stat", pid);
+    snprintf(text, sizeof(text), "%d (%s) S %d 0 0 0 -1 0 0 0 0 0 0 0 0 0 20 0 1 0 %d 0 0\n",
+             pid, comm, ppid, starttime);
+    write_text(name, text);
+}
+
+// A process with the given parent and comm; cmdline mirrors it
+static void write_child(int pid, int ppid, const char *comm) {
+    write_full(pid, ppid, comm, comm, 100);
+}
+
+static void write_process(int pid, const char *comm) {
+    write_child(pid, 1, comm);
+}
+
+// Fresh proc root per test; also drops the miss cache
+static void use_root(const char *name) {
+    snprintf(root, sizeof(root), "%s/%s", temp_dir, name);
+    mkdir(root, 0755);
+    write_text("stat", "btime 1760000000\n");
+    process_monitor_set_proc_root(root);
+}
+
+static int scan(void) {
+    process_info_t list[MAX_SERVER_INSTANCES];
+    return process_find_all_by_name("EnshroudedServer", list, MAX_SERVER_INSTANCES);
+}
+
+void test_scan_fixture_root(void) {
+    process_monitor_set_proc_root("../bench/fixtures/proc");
+    process_info_t list[MAX_SERVER_INSTANCES];
+    int count = process_find_all_by_name("EnshroudedServer", list, MAX_SERVER_INSTANCES);
+
+    // The wine launcher collapses into its child
+    TEST_ASSERT_EQUAL_INT(2, count);
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(list[i].pid == 4120 || list[i].pid == 5200);
+        TEST_ASSERT_EQUAL_INT(list[i].pid == 4120 ? 15637 : 16637, list[i].query_port);
+    }
+}
+
+void test_cached_scan_sees_exec_after_one_miss(void) {
+    use_root("exec");
+    write_process(100, "bash");
+    TEST_ASSERT_EQUAL_INT(0, scan());
+
+    // Launcher execs into the server before its second check
+    write_process(100, "EnshroudedServer.exe");
+    TEST_ASSERT_EQUAL_INT(1, scan());
+}
+
+void test_cached_scan_skips_known_misses(void) {
+    use_root("trusted");
+    write_process(100, "bash");
+    write_process(200, "EnshroudedServer.exe");
+    TEST_ASSERT_EQUAL_INT(1, scan());
+    TEST_ASSERT_EQUAL_INT(1, scan());
+
+    // Two misses make 100 trusted: a new cmdline under the same comm and
+    // starttime goes unseen until the entry expires
+    write_full(100, 1, "bash", "wine EnshroudedServer.exe", 100);
+    TEST_ASSERT_EQUAL_INT(1, scan());
+
+    int scans = 1;
+    while (scan() == 1 && scans < 100) {
+        scans++;
+    }
+    TEST_ASSERT_TRUE(scans < 100);
+}
+
+void test_cached_scan_sees_exec_of_trusted_pid(void) {
+    use_root("trusted-exec");
+    write_process(100, "bash");
+    TEST_ASSERT_EQUAL_INT(0, scan());
+    TEST_ASSERT_EQUAL_INT(0, scan());
+
+    // Exec changes comm, which invalidates the entry
+    write_process(100, "EnshroudedServer.exe");
+    TEST_ASSERT_EQUAL_INT(1, scan());
+}
+
+void test_cached_scan_sees_reused_pid(void) {
+    use_root("reused");
+    write_full(100, 1, "wine", "wine winecfg.exe", 100);
+    TEST_ASSERT_EQUAL_INT(0, scan());
+    TEST_ASSERT_EQUAL_INT(0, scan());
+
+    // Same PID and comm, but a later starttime: a new process
+    write_full(100, 1, "wine", "wine EnshroudedServer.exe", 5000);
+    TEST_ASSERT_EQUAL_INT(1, scan());
+}
+
+void test_full_scan_checks_every_pid(void) {
+    use_root("full");
+    process_monitor_set_scan_mode(PROCESS_SCAN_FULL);
+    write_process(100, "bash");
+    TEST_ASSERT_EQUAL_INT(0, scan());
+    TEST_ASSERT_EQUAL_INT(0, scan());
+
+    write_process(100, "EnshroudedServer.exe");
+    TEST_ASSERT_EQUAL_INT(1, scan());
+    process_monitor_set_scan_mode(PROCESS_SCAN_CACHED);
+}
+
+void test_single_lookups_keep_the_miss_history(void) {
+    use_root("history");
+    write_process(200, "EnshroudedServer.exe");
+    write_process(300, "bash");
+    process_info_t info;
+    TEST_ASSERT_EQUAL_INT(0, process_find_by_name("EnshroudedServer", &info));
+    TEST_ASSERT_EQUAL_INT(0, process_find_by_name("EnshroudedServer", &info));
+
+    // A lookup stopping at the first match would have lost 300's misses
+    write_full(300, 1, "bash", "bash EnshroudedServer.exe", 100);
+    TEST_ASSERT_EQUAL_INT(1, scan());
+}
+
+void test_every_wrapped_instance_is_listed(void) {
+    use_root("wrapped");
+    // Each instance is a wine launcher plus the server it starts
+    for (int i = 0; i < MAX_SERVER_INSTANCES; i++) {
+        write_child(1000 + i, 1, "EnshroudedServer.exe");
+        write_child(2000 + i, 1000 + i, "EnshroudedServer.exe");
+    }
+    TEST_ASSERT_EQUAL_INT(MAX_SERVER_INSTANCES, scan());
+
+    // More instances than room: the list is full of servers, no launchers
+    write_child(1999, 1, "EnshroudedServer.exe");
+    write_child(2999, 1999, "EnshroudedServer.exe");
+    process_info_t list[MAX_SERVER_INSTANCES];
+    TEST_ASSERT_EQUAL_INT(MAX_SERVER_INSTANCES,
+                          process_find_all_by_name("EnshroudedServer", list, MAX_SERVER_INSTANCES));
+    for (int i = 0; i < MAX_SERVER_INSTANCES; i++) {
+        TEST_ASSERT_TRUE(list[i].pid >= 2000);
+    }
+}
+
+void test_single_lookup_returns_the_server_not_its_launcher(void) {
+    use_root("single");
+    write_child(100, 1, "EnshroudedServer.exe");
+    write_child(300, 100, "EnshroudedServer.exe");
+    process_info_t info;
+    TEST_ASSERT_EQUAL_INT(0, process_find_by_name("EnshroudedServer", &info));
+    TEST_ASSERT_EQUAL_INT(300, info.pid);
+}
+
+int main(void) {
+    if (!mkdtemp(temp_dir)) {
+        printf("Failed to create proc directory\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_query_port_arg_equals);
+    RUN_TEST(test_query_port_arg_space_mixed_case);
+    RUN_TEST(test_query_port_arg_missing);
+    RUN_TEST(test_query_port_arg_embedded_word);
+    RUN_TEST(test_query_port_arg_out_of_range);
+
+    RUN_TEST(test_pick_query_port_pair);
+    RUN_TEST(test_pick_query_port_single);
+    RUN_TEST(test_pick_query_port_none);
+
+    RUN_TEST(test_scan_fixture_root);
+    RUN_TEST(test_cached_scan_sees_exec_after_one_miss);
+    RUN_TEST(test_cached_scan_skips_known_misses);
+    RUN_TEST(test_cached_scan_sees_exec_of_trusted_pid);
+    RUN_TEST(test_cached_scan_sees_reused_pid);
+    RUN_TEST(test_full_scan_checks_every_pid);
+    RUN_TEST(test_single_lookups_keep_the_miss_history);
+    RUN_TEST(test_every_wrapped_instance_is_listed);
+    RUN_TEST(test_single_lookup_returns_the_server_not_its_launcher);
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -rf %s", temp_dir);
+    if (system(command) != 0) {
+        printf("Failed to remove %s\n", temp_dir);
+    }
+    process_monitor_cleanup();
+
+    UNITY_END();
+}
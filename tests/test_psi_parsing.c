@@ -0,0 +1,55 @@
+/*
+ * Unit tests for Pressure Stall Information parsing
+ */
+
+#include "unity.h"
+#include "../psi_monitor.h"
+#include <string.h>
+
+void test_psi_parse_some_and_full(void) {
+    const char buf[] =
+        "some avg10=1.50 avg60=0.75 avg300=0.10 total=123456\n"
+        "full avg10=0.25 avg60=0.00 avg300=0.00 total=789\n";
+    psi_resource_t res;
+
+    TEST_ASSERT_EQUAL_INT(0, psi_parse(buf, &res));
+    TEST_ASSERT_EQUAL_INT(150, (int)(res.some.avg10 * 100 + 0.5f));
+    TEST_ASSERT_EQUAL_INT(123456, (int)res.some.total_us);
+    TEST_ASSERT_TRUE(res.has_full);
+    TEST_ASSERT_EQUAL_INT(25, (int)(res.full.avg10 * 100 + 0.5f));
+    TEST_ASSERT_EQUAL_INT(789, (int)res.full.total_us);
+}
+
+void test_psi_parse_some_only(void) {
+    // Host cpu pressure on kernels before 5.13 has no "full" line
+    const char buf[] = "some avg10=2.18 avg60=3.68 avg300=3.94 total=26978538\n";
+    psi_resource_t res;
+
+    TEST_ASSERT_EQUAL_INT(0, psi_parse(buf, &res));
+    TEST_ASSERT_FALSE(res.has_full);
+    TEST_ASSERT_EQUAL_INT(394, (int)(res.some.avg300 * 100 + 0.5f));
+}
+
+void test_psi_parse_garbage(void) {
+    psi_resource_t res;
+    TEST_ASSERT_EQUAL_INT(-1, psi_parse("not a pressure file\n", &res));
+    TEST_ASSERT_EQUAL_INT(-1, psi_parse("", &res));
+}
+
+void test_psi_resource_names(void) {
+    TEST_ASSERT_EQUAL_STRING("cpu", psi_resource_name(PSI_CPU));
+    TEST_ASSERT_EQUAL_STRING("memory", psi_resource_name(PSI_MEMORY));
+    TEST_ASSERT_EQUAL_STRING("io", psi_resource_name(PSI_IO));
+    TEST_ASSERT_EQUAL_STRING("unknown", psi_resource_name(PSI_RESOURCE_COUNT));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_psi_parse_some_and_full);
+    RUN_TEST(test_psi_parse_some_only);
+    RUN_TEST(test_psi_parse_garbage);
+    RUN_TEST(test_psi_resource_names);
+
+    UNITY_END();
+}
@@ -0,0 +1,157 @@
+/*
+ * Unit tests for journal replay
+ * Records a short session with journal.c, then decodes it with replay.c.
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../journal.h"
+#include "../metrics.h"
+#include "../replay.h"
+#include "../tsdb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define SLOTS 8
+#define T0 1700000000000LL
+
+static char journal_dir[] = "/tmp/emon_replay_XXXXXX";
+static emon_snapshot_t snap;
+
+// One sample per second with cpu = i and players = i / 2; 20 samples
+// across three segments plus a couple of events
+static void record_session(void) {
+    journal_config_t config = {
+        .dir = journal_dir,
+        .segment_bytes = (SLOTS + 1) * JOURNAL_RECORD_SIZE,
+    };
+    if (journal_open(&config) < 0) {
+        return;
+    }
+
+    journal_append_event(T0, JOURNAL_EVENT_STARTED, "127.0.0.1");
+    for (int i = 0; i < 20; i++) {
+        double values[METRIC_COUNT];
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            values[m] = NAN;
+        }
+        values[METRIC_CPU_PERCENT] = i;
+        values[METRIC_MEM_USED_KB] = 1024;
+        values[METRIC_MEM_TOTAL_KB] = 4096;
+        values[METRIC_SERVER_UP] = 1;
+        values[METRIC_PLAYERS] = i / 2;
+        values[METRIC_MAX_PLAYERS] = 16;
+        journal_append_sample(T0 + i * 1000, 0x7, values, METRIC_COUNT);
+
+        if (i == 5) {
+            journal_append_event(T0 + i * 1000 + 500, JOURNAL_EVENT_SERVER_UP,
+                                 "My Server (0.7.4.0)");
+        }
+    }
+    journal_close();
+}
+
+void test_replay_open_reports_span(void) {
+    TEST_ASSERT_EQUAL_INT(0, replay_open(journal_dir));
+    TEST_ASSERT_EQUAL_INT(22, (int)replay_record_count());
+    TEST_ASSERT_EQUAL_INT(0, (int)(replay_start_ms() - T0));
+    TEST_ASSERT_EQUAL_INT(19000, (int)(replay_end_ms() - T0));
+    TEST_ASSERT_EQUAL_STRING("127.0.0.1", replay_host());
+}
+
+void test_replay_advance_applies_in_order(void) {
+    memset(&snap, 0, sizeof(snap));
+    TEST_ASSERT_EQUAL_INT(0, replay_open(journal_dir));
+    replay_seek(T0, &snap);
+
+    // Started event plus samples 0..3
+    TEST_ASSERT_EQUAL_INT(5, replay_advance(T0 + 3000, &snap));
+    TEST_ASSERT_TRUE(snap.system.ok);
+    TEST_ASSERT_EQUAL_INT(3, (int)snap.system.stats.cpu_percent);
+    TEST_ASSERT_EQUAL_INT(4096, (int)snap.system.stats.total_mem_kb);
+    TEST_ASSERT_TRUE(snap.a2s.success);
+    TEST_ASSERT_EQUAL_INT(1, snap.a2s.info.players);
+    TEST_ASSERT_FALSE(snap.system.disk.available);
+
+    // Nothing new until the clock passes the next record
+    TEST_ASSERT_EQUAL_INT(0, replay_advance(T0 + 3999, &snap));
+
+    // Crosses the server_up event and a segment boundary
+    replay_advance(T0 + 12000, &snap);
+    TEST_ASSERT_EQUAL_INT(12, (int)snap.system.stats.cpu_percent);
+    TEST_ASSERT_EQUAL_STRING("My Server", snap.a2s.info.name);
+    TEST_ASSERT_EQUAL_STRING("0.7.4.0", snap.a2s.info.version);
+    TEST_ASSERT_NOT_NULL(strstr(replay_last_event(), "server_up"));
+}
+
+void test_replay_seek_restores_latest_sample(void) {
+    memset(&snap, 0, sizeof(snap));
+    TEST_ASSERT_EQUAL_INT(0, replay_open(journal_dir));
+
+    // Seeking lands between samples: state is the sample before the target
+    replay_seek(T0 + 15500, &snap);
+    TEST_ASSERT_EQUAL_INT(15, (int)snap.system.stats.cpu_percent);
+    TEST_ASSERT_EQUAL_INT(1, replay_advance(T0 + 16000, &snap));
+    TEST_ASSERT_EQUAL_INT(16, (int)snap.system.stats.cpu_percent);
+
+    // And backwards again
+    replay_seek(T0 + 2000, &snap);
+    TEST_ASSERT_EQUAL_INT(1, (int)snap.system.stats.cpu_percent);
+    TEST_ASSERT_EQUAL_INT(1, replay_advance(T0 + 2000, &snap));
+    TEST_ASSERT_EQUAL_INT(2, (int)snap.system.stats.cpu_percent);
+}
+
+void test_replay_feeds_the_graphs(void) {
+    memset(&snap, 0, sizeof(snap));
+    TEST_ASSERT_EQUAL_INT(0, replay_open(journal_dir));
+    replay_seek(T0 + 15500, &snap);
+    replay_advance(T0 + 17000, &snap);
+
+    int64_t t;
+    double value;
+    TEST_ASSERT_EQUAL_INT(0, tsdb_last(METRIC_CPU_PERCENT, &t, &value));
+    TEST_ASSERT_EQUAL_INT(17, (int)(t - T0 / 1000));
+    TEST_ASSERT_EQUAL_INT(17, (int)value);
+
+    // Seeking back starts the graphs over from the new position
+    replay_seek(T0 + 2000, &snap);
+    TEST_ASSERT_EQUAL_INT(0, tsdb_last(METRIC_CPU_PERCENT, &t, &value));
+    TEST_ASSERT_EQUAL_INT(1, (int)(t - T0 / 1000));
+    replay_advance(T0 + 3000, &snap);
+    TEST_ASSERT_EQUAL_INT(0, tsdb_last(METRIC_PLAYERS, &t, &value));
+    TEST_ASSERT_EQUAL_INT(3, (int)(t - T0 / 1000));
+    TEST_ASSERT_EQUAL_INT(1, (int)value);
+}
+
+void test_replay_missing_path(void) {
+    TEST_ASSERT_EQUAL_INT(-1, replay_open("/nonexistent/journal"));
+    TEST_ASSERT_EQUAL_INT(0, (int)replay_record_count());
+}
+
+int main(void) {
+    if (!mkdtemp(journal_dir)) {
+        printf("Failed to create journal directory\n");
+        return 1;
+    }
+    record_session();
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_replay_open_reports_span);
+    RUN_TEST(test_replay_advance_applies_in_order);
+    RUN_TEST(test_replay_seek_restores_latest_sample);
+    RUN_TEST(test_replay_feeds_the_graphs);
+    RUN_TEST(test_replay_missing_path);
+
+    replay_close();
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", journal_dir);
+    if (system(cmd) != 0) {
+        printf("Failed to remove %s\n", journal_dir);
+    }
+
+    UNITY_END();
+}
@@ -0,0 +1,118 @@
+/*
+ * Unit tests for self-instrumentation
+ * Timers, histogram buckets, percentiles and per-thread counters.
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../selfstats.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+void test_empty_timer(void) {
+    selfstats_timer_t t;
+    selfstats_read(SELFSTATS_RENDER, &t);
+    TEST_ASSERT_EQUAL_INT(0, (int)t.count);
+    TEST_ASSERT_EQUAL_INT(0, (int)selfstats_percentile_ns(&t, 0.5));
+}
+
+void test_span_records_duration(void) {
+    selfstats_span_t span;
+    selfstats_begin(&span);
+    sleep_us(2000);
+    selfstats_end(SELFSTATS_SYSTEM, &span);
+
+    selfstats_timer_t t;
+    selfstats_read(SELFSTATS_SYSTEM, &t);
+    TEST_ASSERT_EQUAL_INT(1, (int)t.count);
+    TEST_ASSERT_TRUE(t.last_ns >= 2000000);
+    TEST_ASSERT_EQUAL_INT((int)t.last_ns, (int)t.max_ns);
+
+    // 2 ms and change lands in the "< 4096 us" bucket (or later on a slow box)
+    uint32_t below = 0;
+    for (int i = 0; i < 11; i++) {
+        below += t.buckets[i];
+    }
+    TEST_ASSERT_EQUAL_INT(0, (int)below);
+}
+
+void test_counts_opens_and_syscalls(void) {
+    selfstats_span_t span;
+    selfstats_begin(&span);
+    selfstats_count_open();
+    selfstats_count_open();
+    selfstats_count_syscalls(3);
+    selfstats_end(SELFSTATS_PROCESS, &span);
+
+    selfstats_timer_t t;
+    selfstats_read(SELFSTATS_PROCESS, &t);
+    TEST_ASSERT_EQUAL_INT(2, (int)t.last_opens);
+    TEST_ASSERT_EQUAL_INT(5, (int)t.last_syscalls);
+}
+
+void test_io_syscalls_are_counted(void) {
+    int fd = open("/proc/self/stat", O_RDONLY);
+    char buf[512];
+
+    selfstats_span_t span;
+    selfstats_begin(&span);
+    for (int i = 0; i < 4; i++) {
+        if (pread(fd, buf, sizeof(buf), 0) < 0) {
+            break;
+        }
+    }
+    selfstats_end(SELFSTATS_A2S, &span);
+    close(fd);
+
+    selfstats_timer_t t;
+    selfstats_read(SELFSTATS_A2S, &t);
+    // Exactly 4 with task I/O accounting, 0 without it
+    TEST_ASSERT_TRUE(t.last_syscalls == 4 || t.last_syscalls == 0);
+}
+
+void test_percentiles_follow_buckets(void) {
+    selfstats_timer_t t;
+    memset(&t, 0, sizeof(t));
+    t.count = 100;
+    t.buckets[3] = 90;            // < 8 us
+    t.buckets[10] = 10;           // < 1024 us
+    t.max_ns = 700000;
+
+    TEST_ASSERT_EQUAL_INT(8000, (int)selfstats_percentile_ns(&t, 0.5));
+    TEST_ASSERT_EQUAL_INT(8000, (int)selfstats_percentile_ns(&t, 0.9));
+    // Capped by the observed maximum
+    TEST_ASSERT_EQUAL_INT(700000, (int)selfstats_percentile_ns(&t, 0.99));
+}
+
+void test_dump_lists_every_pass(void) {
+    char out[4096] = { 0 };
+    FILE *fp = fmemopen(out, sizeof(out) - 1, "w");
+    selfstats_dump(fp);
+    fclose(fp);
+
+    TEST_ASSERT_NOT_NULL(strstr(out, "system"));
+    TEST_ASSERT_NOT_NULL(strstr(out, "process"));
+    TEST_ASSERT_NOT_NULL(strstr(out, "render"));
+    TEST_ASSERT_NOT_NULL(strstr(out, "system histogram:"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_empty_timer);
+    RUN_TEST(test_span_records_duration);
+    RUN_TEST(test_counts_opens_and_syscalls);
+    RUN_TEST(test_io_syscalls_are_counted);
+    RUN_TEST(test_percentiles_follow_buckets);
+    RUN_TEST(test_dump_lists_every_pass);
+
+    UNITY_END();
+}
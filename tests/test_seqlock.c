@@ -0,0 +1,91 @@
+/*
+ * Unit tests for the snapshot seqlock
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../seqlock.h"
+#include <pthread.h>
+#include <string.h>
+
+#define PAYLOAD_WORDS 512
+#define WRITES 200000
+
+typedef struct {
+    seqlock_t lock;
+    unsigned int words[PAYLOAD_WORDS];
+} shared_t;
+
+static shared_t shared;
+static atomic_int writer_done;
+
+static void *writer(void *arg) {
+    (void)arg;
+    unsigned int local[PAYLOAD_WORDS];
+    for (unsigned int n = 1; n <= WRITES; n++) {
+        for (int i = 0; i < PAYLOAD_WORDS; i++) {
+            local[i] = n;
+        }
+        seqlock_write_begin(&shared.lock);
+        memcpy(shared.words, local, sizeof(local));
+        seqlock_write_end(&shared.lock);
+    }
+    atomic_store(&writer_done, 1);
+    return NULL;
+}
+
+void test_seqlock_sequence_even_after_write(void) {
+    seqlock_t lock = SEQLOCK_INIT;
+    unsigned int start = seqlock_read_begin(&lock);
+    TEST_ASSERT_EQUAL_INT(0, (int)start);
+
+    seqlock_write_begin(&lock);
+    seqlock_write_end(&lock);
+
+    TEST_ASSERT_TRUE(seqlock_read_retry(&lock, start));
+    TEST_ASSERT_EQUAL_INT(2, (int)seqlock_read_begin(&lock));
+}
+
+void test_seqlock_reader_never_sees_torn_copy(void) {
+    pthread_t thread;
+    memset(&shared, 0, sizeof(shared));
+    atomic_store(&writer_done, 0);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, writer, NULL));
+
+    unsigned int copy[PAYLOAD_WORDS];
+    unsigned int last = 0;
+    int torn = 0;
+    int backwards = 0;
+
+    while (!atomic_load(&writer_done)) {
+        unsigned int seq;
+        do {
+            seq = seqlock_read_begin(&shared.lock);
+            memcpy(copy, shared.words, sizeof(copy));
+        } while (seqlock_read_retry(&shared.lock, seq));
+
+        for (int i = 1; i < PAYLOAD_WORDS; i++) {
+            if (copy[i] != copy[0]) {
+                torn++;
+                break;
+            }
+        }
+        if (copy[0] < last) {
+            backwards++;
+        }
+        last = copy[0];
+    }
+
+    pthread_join(thread, NULL);
+    TEST_ASSERT_EQUAL_INT(0, torn);
+    TEST_ASSERT_EQUAL_INT(0, backwards);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_seqlock_sequence_even_after_write);
+    RUN_TEST(test_seqlock_reader_never_sees_torn_copy);
+
+    UNITY_END();
+}
@@ -0,0 +1,171 @@
+/*
+ * Unit tests for history sparklines over the time-series store
+ */
+
+#include "unity.h"
+#include "../sparkline.h"
+#include "../tsdb.h"
+
+#define T0 1700000000LL   // Even, so braille cells start on a pair
+
+static void fill(int series, int64_t from, int count, double step) {
+    for (int i = 0; i < count; i++) {
+        tsdb_append(series, from + i, step * i);
+    }
+}
+
+void test_nice_ceiling(void) {
+    TEST_ASSERT_EQUAL_INT(10, (int)(sparkline_nice_ceiling(0.0) * 10 + 0.5));
+    TEST_ASSERT_EQUAL_INT(5, (int)(sparkline_nice_ceiling(0.3) * 10 + 0.5));
+    TEST_ASSERT_EQUAL_INT(100, (int)(sparkline_nice_ceiling(7.0) * 10 + 0.5));
+    TEST_ASSERT_EQUAL_INT(200, (int)(sparkline_nice_ceiling(12.0) * 10 + 0.5));
+    TEST_ASSERT_EQUAL_INT(1000, (int)(sparkline_nice_ceiling(100.0) * 10 + 0.5));
+    TEST_ASSERT_EQUAL_INT(5000, (int)(sparkline_nice_ceiling(201.0) * 10 + 0.5));
+}
+
+void test_empty_series_draws_nothing(void) {
+    sparkline_t sp;
+    tsdb_init();
+    sparkline_init(&sp, 0, SPARK_BLOCK, 10, 100.0);
+
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(0, d.full);
+    TEST_ASSERT_EQUAL_INT(0, d.dirty);
+    TEST_ASSERT_EQUAL_STRING(" ", sparkline_glyph(&sp, 9));
+}
+
+void test_block_levels_and_first_fill(void) {
+    sparkline_t sp;
+    tsdb_init();
+    fill(0, T0, 10, 10.0);    // 0, 10 ... 90
+    sparkline_init(&sp, 0, SPARK_BLOCK, 10, 100.0);
+
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(1, d.full);
+    TEST_ASSERT_EQUAL_INT(10, d.dirty);
+    TEST_ASSERT_EQUAL_STRING(" ", sparkline_glyph(&sp, 0));              // 0
+    TEST_ASSERT_EQUAL_STRING("\xe2\x96\x81", sparkline_glyph(&sp, 1));   // 10 -> ▁
+    TEST_ASSERT_EQUAL_STRING("\xe2\x96\x84", sparkline_glyph(&sp, 5));   // 50 -> ▄
+    TEST_ASSERT_EQUAL_STRING("\xe2\x96\x87", sparkline_glyph(&sp, 9));   // 90 -> ▇
+}
+
+void test_new_second_shifts_one_cell(void) {
+    sparkline_t sp;
+    tsdb_init();
+    fill(0, T0, 10, 10.0);
+    sparkline_init(&sp, 0, SPARK_BLOCK, 10, 100.0);
+    sparkline_update(&sp);
+
+    // Nothing new: nothing to draw
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(0, d.full);
+    TEST_ASSERT_EQUAL_INT(0, d.shift);
+    TEST_ASSERT_EQUAL_INT(0, d.dirty);
+
+    tsdb_append(0, T0 + 10, 100.0);
+    d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(0, d.full);
+    TEST_ASSERT_EQUAL_INT(1, d.shift);
+    TEST_ASSERT_EQUAL_INT(1, d.dirty);
+    TEST_ASSERT_EQUAL_STRING("\xe2\x96\x81", sparkline_glyph(&sp, 0));   // Was cell 1
+    TEST_ASSERT_EQUAL_STRING("\xe2\x96\x88", sparkline_glyph(&sp, 9));   // 100 -> █
+
+    // Two seconds later with one missing: shift two, the gap stays blank
+    tsdb_append(0, T0 + 12, 50.0);
+    d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(2, d.shift);
+    TEST_ASSERT_EQUAL_INT(2, d.dirty);
+    TEST_ASSERT_EQUAL_STRING(" ", sparkline_glyph(&sp, 8));
+}
+
+void test_open_bucket_redraws_in_place(void) {
+    sparkline_t sp;
+    tsdb_init();
+    tsdb_append(0, T0, 10.0);
+    sparkline_init(&sp, 0, SPARK_BLOCK, 4, 100.0);
+    sparkline_update(&sp);
+
+    // Same second, same glyph: nothing to do
+    tsdb_append(0, T0, 12.0);
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(0, d.shift);
+    TEST_ASSERT_EQUAL_INT(0, d.dirty);
+
+    // Same second, the average moves up a level
+    tsdb_append(0, T0, 90.0);
+    d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(0, d.shift);
+    TEST_ASSERT_EQUAL_INT(1, d.dirty);
+}
+
+void test_braille_packs_two_seconds(void) {
+    sparkline_t sp;
+    tsdb_init();
+    tsdb_append(0, T0, 100.0);
+    tsdb_append(0, T0 + 1, 0.0);
+    sparkline_init(&sp, 0, SPARK_BRAILLE, 4, 100.0);
+
+    sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_STRING("\xe2\xa1\x87", sparkline_glyph(&sp, 3));   // U+2847: left column full
+
+    // The next second opens a new cell; the one after fills its right half
+    tsdb_append(0, T0 + 2, 50.0);
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(1, d.shift);
+    TEST_ASSERT_EQUAL_STRING("\xe2\xa1\x84", sparkline_glyph(&sp, 3));   // U+2844: two dots on the left
+
+    tsdb_append(0, T0 + 3, 100.0);
+    d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(0, d.shift);
+    TEST_ASSERT_EQUAL_INT(1, d.dirty);
+    TEST_ASSERT_EQUAL_STRING("\xe2\xa3\xbc", sparkline_glyph(&sp, 3));   // U+28FC
+}
+
+void test_autoscale_and_rescale_redraw_everything(void) {
+    sparkline_t sp;
+    tsdb_init();
+    fill(0, T0, 5, 9.0);      // Peak 36 -> top 50
+    sparkline_init(&sp, 0, SPARK_BLOCK, 8, 0.0);
+    sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(500, (int)(sp.top * 10 + 0.5));
+
+    tsdb_append(0, T0 + 5, 120.0);
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(1, d.full);
+    TEST_ASSERT_EQUAL_INT(2000, (int)(sp.top * 10 + 0.5));
+
+    sparkline_set_scale(&sp, 400.0);
+    d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(1, d.full);
+    TEST_ASSERT_EQUAL_INT(4000, (int)(sp.top * 10 + 0.5));
+}
+
+void test_gap_wider_than_graph_refills(void) {
+    sparkline_t sp;
+    tsdb_init();
+    fill(0, T0, 3, 10.0);
+    sparkline_init(&sp, 0, SPARK_ASCII, 5, 100.0);
+    sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_STRING(".", sparkline_glyph(&sp, 3));   // 10 of 100 over 7 levels
+
+    tsdb_append(0, T0 + 100, 100.0);
+    spark_delta_t d = sparkline_update(&sp);
+    TEST_ASSERT_EQUAL_INT(1, d.full);
+    TEST_ASSERT_EQUAL_STRING(" ", sparkline_glyph(&sp, 3));
+    TEST_ASSERT_EQUAL_STRING("#", sparkline_glyph(&sp, 4));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_nice_ceiling);
+    RUN_TEST(test_empty_series_draws_nothing);
+    RUN_TEST(test_block_levels_and_first_fill);
+    RUN_TEST(test_new_second_shifts_one_cell);
+    RUN_TEST(test_open_bucket_redraws_in_place);
+    RUN_TEST(test_braille_packs_two_seconds);
+    RUN_TEST(test_autoscale_and_rescale_redraw_everything);
+    RUN_TEST(test_gap_wider_than_graph_refills);
+
+    UNITY_END();
+}
@@ -0,0 +1,182 @@
+/*
+ * Unit tests for /proc parsing in system_monitor.c
+ */
+
+#include "unity.h"
+#include "../system_monitor.h"
+#include "../proc_kv.h"
+#include <stdint.h>
+#include <string.h>
+
+static const char stat_fixture[] =
+    "cpu  400 0 200 1200 100 0 0 100 0 0\n"
+    "cpu0 100 0 50 300 25 0 0 25 0 0\n"
+    "cpu1 100 0 50 300 25 0 0 25 0 0\n"
+    "cpu3 200 0 100 600 50 0 0 50 0 0\n"
+    "intr 34380 0 0 0\n"
+    "ctxt 12345\n"
+    "btime 1700000000\n";
+
+static cpu_core_times_t prev_cores;
+static cpu_core_times_t curr_cores;
+
+void test_parse_cpu_aggregate(void) {
+    cpu_times_t agg;
+    int rc = system_monitor_parse_cpu_lines(stat_fixture, strlen(stat_fixture), &agg, NULL);
+    TEST_ASSERT_EQUAL_INT(0, rc);
+    TEST_ASSERT_EQUAL_INT(400, agg.user);
+    TEST_ASSERT_EQUAL_INT(1200, agg.idle);
+    TEST_ASSERT_EQUAL_INT(100, agg.steal);
+}
+
+void test_parse_cpu_cores(void) {
+    cpu_times_t agg;
+    system_monitor_parse_cpu_lines(stat_fixture, strlen(stat_fixture), &agg, &curr_cores);
+    TEST_ASSERT_EQUAL_INT(4, curr_cores.count);
+    TEST_ASSERT_EQUAL_INT(500, curr_cores.total[0]);
+    TEST_ASSERT_EQUAL_INT(325, curr_cores.idle[1]);
+    TEST_ASSERT_EQUAL_INT(1000, curr_cores.total[3]);
+}
+
+void test_parse_cpu_offline_gap_zeroed(void) {
+    cpu_times_t agg;
+    curr_cores.total[2] = 999;
+    system_monitor_parse_cpu_lines(stat_fixture, strlen(stat_fixture), &agg, &curr_cores);
+    TEST_ASSERT_EQUAL_INT(0, curr_cores.total[2]);
+}
+
+void test_parse_cpu_missing_aggregate(void) {
+    const char buf[] = "intr 1 2 3\n";
+    cpu_times_t agg;
+    TEST_ASSERT_EQUAL_INT(-1, system_monitor_parse_cpu_lines(buf, strlen(buf), &agg, NULL));
+}
+
+void test_parse_cpu_truncated_line(void) {
+    // Last line lacks its newline and must not be parsed
+    const char buf[] = "cpu  1 2 3 4\ncpu0 1 2 3";
+    cpu_times_t agg;
+    system_monitor_parse_cpu_lines(buf, strlen(buf), &agg, &curr_cores);
+    TEST_ASSERT_EQUAL_INT(0, curr_cores.count);
+}
+
+void test_core_percent_delta(void) {
+    float percent[MAX_CPU_CORES];
+    memset(&prev_cores, 0, sizeof(prev_cores));
+    memset(&curr_cores, 0, sizeof(curr_cores));
+
+    curr_cores.total[0] = 100; curr_cores.idle[0] = 25;   // 75%
+    curr_cores.total[1] = 100; curr_cores.idle[1] = 100;  // idle
+    curr_cores.total[2] = 0;   curr_cores.idle[2] = 0;    // offline
+
+    system_monitor_calc_core_percent(&prev_cores, &curr_cores, percent, 3);
+    TEST_ASSERT_EQUAL_INT(75, (int)(percent[0] + 0.5f));
+    TEST_ASSERT_EQUAL_INT(0, (int)percent[1]);
+    TEST_ASSERT_EQUAL_INT(0, (int)percent[2]);
+}
+
+void test_core_percent_clamped(void) {
+    float percent[MAX_CPU_CORES];
+    memset(&prev_cores, 0, sizeof(prev_cores));
+    memset(&curr_cores, 0, sizeof(curr_cores));
+
+    // iowait stepping backwards makes idle negative
+    prev_cores.total[0] = 100; prev_cores.idle[0] = 50;
+    curr_cores.total[0] = 110; curr_cores.idle[0] = 40;
+
+    system_monitor_calc_core_percent(&prev_cores, &curr_cores, percent, 1);
+    TEST_ASSERT_EQUAL_INT(100, (int)percent[0]);
+}
+
+static const char meminfo_fixture[] =
+    "MemTotal:       16384000 kB\n"
+    "MemFree:         2048000 kB\n"
+    "MemAvailable:    8192000 kB\n"
+    "Buffers:          102400 kB\n"
+    "Cached:          4096000 kB\n"
+    "SwapCached:            0 kB\n"
+    "Active:          6000000 kB\n"
+    "SwapTotal:       2097152 kB\n"
+    "SwapFree:        1048576 kB\n"
+    "Dirty:               128 kB\n";
+
+static const char vmstat_fixture[] =
+    "nr_free_pages 512000\n"
+    "pgmajfault 4242\n"
+    "pswpin 17\n"
+    "pswpout 23\n"
+    "oom_kill 2\n";
+
+void test_parse_meminfo(void) {
+    system_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    TEST_ASSERT_EQUAL_INT(0, system_monitor_parse_meminfo(meminfo_fixture,
+                                                          strlen(meminfo_fixture), &stats));
+    TEST_ASSERT_EQUAL_INT(16384000, stats.total_mem_kb);
+    TEST_ASSERT_EQUAL_INT(2048000, stats.free_mem_kb);
+    TEST_ASSERT_EQUAL_INT(8192000, stats.used_mem_kb);
+    TEST_ASSERT_EQUAL_INT(2097152, stats.total_swap_kb);
+    TEST_ASSERT_EQUAL_INT(1048576, stats.used_swap_kb);
+}
+
+void test_parse_meminfo_prefix_keys(void) {
+    // "SwapCached" must not match "Cached", nor "MemTotalX" match "MemTotal"
+    const char buf[] =
+        "MemTotalX: 1 kB\nMemTotal: 100 kB\nMemFree: 10 kB\n"
+        "MemAvailable: 40 kB\nSwapCached: 7 kB\nSwapTotal: 0 kB\n";
+    system_stats_t stats;
+
+    TEST_ASSERT_EQUAL_INT(0, system_monitor_parse_meminfo(buf, strlen(buf), &stats));
+    TEST_ASSERT_EQUAL_INT(100, stats.total_mem_kb);
+    TEST_ASSERT_EQUAL_INT(60, stats.used_mem_kb);
+}
+
+void test_parse_meminfo_too_few_fields(void) {
+    const char buf[] = "MemTotal: 100 kB\nDirty: 1 kB\n";
+    system_stats_t stats;
+    TEST_ASSERT_EQUAL_INT(-1, system_monitor_parse_meminfo(buf, strlen(buf), &stats));
+}
+
+void test_parse_vmstat(void) {
+    system_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    TEST_ASSERT_EQUAL_INT(0, system_monitor_parse_vmstat(vmstat_fixture,
+                                                         strlen(vmstat_fixture), &stats));
+    TEST_ASSERT_EQUAL_INT(17, stats.swap_in_pages);
+    TEST_ASSERT_EQUAL_INT(23, stats.swap_out_pages);
+    TEST_ASSERT_EQUAL_INT(4242, stats.major_faults);
+    TEST_ASSERT_EQUAL_INT(2, stats.oom_kills);
+}
+
+void test_proc_kv_no_trailing_newline(void) {
+    static const proc_kv_key_t keys[] = { { "alpha", 0 }, { "beta", 1 } };
+    proc_kv_table_t table;
+    uint64_t values[2] = {0};
+    const char buf[] = "alpha 5\nbeta 9";
+
+    TEST_ASSERT_EQUAL_INT(0, proc_kv_table_init(&table, keys, 2));
+    TEST_ASSERT_EQUAL_INT(2, proc_kv_parse(&table, buf, strlen(buf), values));
+    TEST_ASSERT_EQUAL_INT(9, values[1]);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_cpu_aggregate);
+    RUN_TEST(test_parse_cpu_cores);
+    RUN_TEST(test_parse_cpu_offline_gap_zeroed);
+    RUN_TEST(test_parse_cpu_missing_aggregate);
+    RUN_TEST(test_parse_cpu_truncated_line);
+
+    RUN_TEST(test_core_percent_delta);
+    RUN_TEST(test_core_percent_clamped);
+
+    RUN_TEST(test_parse_meminfo);
+    RUN_TEST(test_parse_meminfo_prefix_keys);
+    RUN_TEST(test_parse_meminfo_too_few_fields);
+    RUN_TEST(test_parse_vmstat);
+    RUN_TEST(test_proc_kv_no_trailing_newline);
+
+    UNITY_END();
+}
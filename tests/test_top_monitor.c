@@ -0,0 +1,170 @@
+/*
+ * Unit tests for the host process list (stat parsing, PID table, top rows)
+ */
+
+#define _GNU_SOURCE
+#include "unity.h"
+#include "../top_monitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static char proc_dir[] = "/tmp/emon-test-top-XXXXXX";
+static top_stats_t stats;
+
+// A stat line with the fields the table reads; rss in pages
+static void write_stat(int pid, const char *comm, unsigned long utime, unsigned long starttime,
+                       long rss) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%d", proc_dir, pid);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_dir, pid);
+
+    FILE *fp = fopen(path, "w");
+    if (fp) {
+        fprintf(fp, "%d (%s) S 1 %d %d 0 -1 4194560 100 0 0 0 %lu 5 0 0 20 0 3 0 %lu "
+                "1000000 %ld 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 17 1 0 0 0 0 0\n",
+                pid, comm, pid, pid, utime, starttime, rss);
+        fclose(fp);
+    }
+}
+
+static void remove_pid(int pid) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%d/stat", proc_dir, pid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%d", proc_dir, pid);
+    rmdir(path);
+}
+
+static const top_process_t *find_row(top_sort_t sort, int pid) {
+    for (int i = 0; i < stats.count; i++) {
+        if (stats.rows[sort][i].pid == pid) {
+            return &stats.rows[sort][i];
+        }
+    }
+    return NULL;
+}
+
+void test_parse_stat_fields(void) {
+    top_stat_t stat;
+    const char *line = "4120 (Enshrouded) Serve) R 4100 4120 4100 0 -1 4194560 1223 0 12 0 "
+                       "48112 9120 0 0 20 0 32 0 910400 13221273600 2351224 18446744073709551615\n";
+    TEST_ASSERT_EQUAL_INT(0, top_parse_stat(line, &stat));
+    TEST_ASSERT_EQUAL_STRING("Enshrouded) Serv", stat.comm);
+    TEST_ASSERT_EQUAL_INT('R', stat.state);
+    TEST_ASSERT_EQUAL_INT(4100, stat.ppid);
+    TEST_ASSERT_EQUAL_INT(48112 + 9120, (int)stat.cpu_ticks);
+    TEST_ASSERT_EQUAL_INT(32, stat.threads);
+    TEST_ASSERT_EQUAL_INT(910400, (int)stat.starttime);
+    TEST_ASSERT_EQUAL_INT(2351224, (int)stat.rss_pages);
+}
+
+void test_parse_stat_rejects_truncated_lines(void) {
+    top_stat_t stat;
+    TEST_ASSERT_EQUAL_INT(-1, top_parse_stat("4120 (short) S 1 2 3", &stat));
+    TEST_ASSERT_EQUAL_INT(-1, top_parse_stat("4120 no parens S 1 2 3", &stat));
+    TEST_ASSERT_EQUAL_INT(-1, top_parse_stat("", &stat));
+}
+
+void test_known_pids_are_not_reopened(void) {
+    for (int pid = 100; pid < 110; pid++) {
+        write_stat(pid, "worker", 10, 5000 + pid, 100 + pid);
+    }
+    top_monitor_set_proc_root(proc_dir);
+
+    TEST_ASSERT_EQUAL_INT(0, top_monitor_update(&stats));
+    TEST_ASSERT_EQUAL_INT(10, stats.process_count);
+    TEST_ASSERT_EQUAL_INT(10, stats.opened);
+    TEST_ASSERT_EQUAL_INT(1, (int)stats.samples);
+
+    // Second tick re-reads through the cached descriptors
+    usleep(20000);
+    write_stat(103, "worker", 60, 5103, 103);
+    TEST_ASSERT_EQUAL_INT(0, top_monitor_update(&stats));
+    TEST_ASSERT_EQUAL_INT(0, stats.opened);
+    TEST_ASSERT_EQUAL_INT(0, stats.exited);
+    TEST_ASSERT_EQUAL_INT(103, stats.rows[TOP_SORT_CPU][0].pid);
+    TEST_ASSERT_TRUE(stats.rows[TOP_SORT_CPU][0].cpu_percent > 0.0f);
+    TEST_ASSERT_TRUE(find_row(TOP_SORT_CPU, 104)->cpu_percent == 0.0f);
+}
+
+void test_vanished_pids_are_dropped_and_new_ones_opened(void) {
+    remove_pid(105);
+    remove_pid(106);
+    write_stat(200, "newcomer", 1, 9000, 7);
+
+    TEST_ASSERT_EQUAL_INT(0, top_monitor_update(&stats));
+    TEST_ASSERT_EQUAL_INT(9, stats.process_count);
+    TEST_ASSERT_EQUAL_INT(2, stats.exited);
+    TEST_ASSERT_EQUAL_INT(1, stats.opened);
+    TEST_ASSERT_NULL(find_row(TOP_SORT_RSS, 105));
+    TEST_ASSERT_NOT_NULL(find_row(TOP_SORT_RSS, 200));
+
+    // A brand-new PID has no CPU baseline yet
+    TEST_ASSERT_TRUE(find_row(TOP_SORT_CPU, 200)->cpu_percent == 0.0f);
+}
+
+void test_reused_pid_starts_a_new_baseline(void) {
+    usleep(20000);
+    write_stat(107, "reborn", 5000, 99999, 1);
+    TEST_ASSERT_EQUAL_INT(0, top_monitor_update(&stats));
+    const top_process_t *row = find_row(TOP_SORT_CPU, 107);
+    TEST_ASSERT_NOT_NULL(row);
+    TEST_ASSERT_EQUAL_STRING("reborn", row->comm);
+    TEST_ASSERT_TRUE(row->cpu_percent == 0.0f);
+}
+
+void test_top_rows_by_rss_are_the_largest_in_order(void) {
+    top_monitor_cleanup();
+    for (int pid = 100; pid < 110; pid++) {
+        remove_pid(pid);
+    }
+    remove_pid(200);
+
+    // More processes than rows, RSS scattered across PIDs
+    const int n = TOP_MAX_ROWS * 3;
+    for (int i = 0; i < n; i++) {
+        write_stat(1000 + i, "job", 1, 100, (long)((i * 37) % n));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, top_monitor_update(&stats));
+    TEST_ASSERT_EQUAL_INT(n, stats.process_count);
+    TEST_ASSERT_EQUAL_INT(TOP_MAX_ROWS, stats.count);
+
+    long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    for (int i = 0; i < TOP_MAX_ROWS; i++) {
+        TEST_ASSERT_EQUAL_INT((n - 1 - i) * page_kb, (int)stats.rows[TOP_SORT_RSS][i].rss_kb);
+    }
+
+    // Equal CPU (all zero on the first tick) falls back to PID order
+    TEST_ASSERT_EQUAL_INT(1000, stats.rows[TOP_SORT_CPU][0].pid);
+    TEST_ASSERT_EQUAL_INT(1000 + TOP_MAX_ROWS - 1, stats.rows[TOP_SORT_CPU][TOP_MAX_ROWS - 1].pid);
+
+    for (int i = 0; i < n; i++) {
+        remove_pid(1000 + i);
+    }
+}
+
+int main(void) {
+    if (!mkdtemp(proc_dir)) {
+        printf("Failed to create test directory\n");
+        return 1;
+    }
+
+    UNITY_BEGIN();
+
+    RUN_TEST(test_parse_stat_fields);
+    RUN_TEST(test_parse_stat_rejects_truncated_lines);
+    RUN_TEST(test_known_pids_are_not_reopened);
+    RUN_TEST(test_vanished_pids_are_dropped_and_new_ones_opened);
+    RUN_TEST(test_reused_pid_starts_a_new_baseline);
+    RUN_TEST(test_top_rows_by_rss_are_the_largest_in_order);
+
+    top_monitor_cleanup();
+    rmdir(proc_dir);
+
+    UNITY_END();
+}
@@ -0,0 +1,134 @@
+/*
+ * Unit tests for the in-memory time-series store
+ */
+
+#include "unity.h"
+#include "../tsdb.h"
+#include <math.h>
+
+#define T0 1700000000LL   // Aligned to 1 min
+
+void test_tsdb_empty_series_reads_nan(void) {
+    tsdb_point_t pts[4];
+    tsdb_init();
+
+    TEST_ASSERT_EQUAL_INT(4, tsdb_query(0, TSDB_TIER_1S, T0, T0 + 3, pts, 4));
+    TEST_ASSERT_TRUE(isnan(pts[0].avg));
+    TEST_ASSERT_TRUE(isnan(pts[3].max));
+
+    int64_t t;
+    double v;
+    TEST_ASSERT_EQUAL_INT(-1, tsdb_last(0, &t, &v));
+}
+
+void test_tsdb_one_second_tier_keeps_samples(void) {
+    tsdb_point_t pts[3];
+    tsdb_init();
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, tsdb_append(1, T0 + i, 10.0 * (i + 1)));
+    }
+
+    TEST_ASSERT_EQUAL_INT(3, tsdb_query(1, TSDB_TIER_1S, T0, T0 + 2, pts, 3));
+    TEST_ASSERT_EQUAL_INT(T0 + 1, (int64_t)pts[1].time);
+    TEST_ASSERT_EQUAL_INT(20, (int)pts[1].avg);
+    TEST_ASSERT_EQUAL_INT(30, (int)pts[2].max);
+
+    int64_t t;
+    double v;
+    TEST_ASSERT_EQUAL_INT(0, tsdb_last(1, &t, &v));
+    TEST_ASSERT_EQUAL_INT(T0 + 2, t);
+    TEST_ASSERT_EQUAL_INT(30, (int)v);
+}
+
+void test_tsdb_downsamples_min_avg_max(void) {
+    tsdb_point_t pts[2];
+    tsdb_init();
+
+    // Ten samples 1..10 land in one 10 s bucket, then 100 opens the next
+    for (int i = 0; i < 10; i++) {
+        tsdb_append(2, T0 + i, i + 1);
+    }
+    tsdb_append(2, T0 + 10, 100);
+
+    TEST_ASSERT_EQUAL_INT(2, tsdb_query(2, TSDB_TIER_10S, T0, T0 + 10, pts, 2));
+    TEST_ASSERT_EQUAL_INT(1, (int)pts[0].min);
+    TEST_ASSERT_EQUAL_INT(55, (int)(pts[0].avg * 10 + 0.5f));
+    TEST_ASSERT_EQUAL_INT(10, (int)pts[0].max);
+    TEST_ASSERT_EQUAL_INT(100, (int)pts[1].avg);
+
+    // The minute tier holds all eleven so far
+    TEST_ASSERT_EQUAL_INT(1, tsdb_query(2, TSDB_TIER_1M, T0, T0, pts, 1));
+    TEST_ASSERT_EQUAL_INT(1, (int)pts[0].min);
+    TEST_ASSERT_EQUAL_INT(100, (int)pts[0].max);
+}
+
+void test_tsdb_gaps_and_nan_samples(void) {
+    tsdb_point_t pts[5];
+    tsdb_init();
+
+    tsdb_append(3, T0, 1.0);
+    tsdb_append(3, T0 + 1, NAN);        // Ignored
+    tsdb_append(3, T0 + 4, 4.0);
+
+    TEST_ASSERT_EQUAL_INT(5, tsdb_query(3, TSDB_TIER_1S, T0, T0 + 4, pts, 5));
+    TEST_ASSERT_EQUAL_INT(1, (int)pts[0].avg);
+    TEST_ASSERT_TRUE(isnan(pts[1].avg));
+    TEST_ASSERT_TRUE(isnan(pts[3].avg));
+    TEST_ASSERT_EQUAL_INT(4, (int)pts[4].avg);
+}
+
+void test_tsdb_rejects_out_of_order_and_bad_series(void) {
+    tsdb_init();
+    TEST_ASSERT_EQUAL_INT(0, tsdb_append(4, T0 + 10, 1.0));
+    TEST_ASSERT_EQUAL_INT(-1, tsdb_append(4, T0 + 5, 2.0));
+    TEST_ASSERT_EQUAL_INT(-1, tsdb_append(-1, T0, 1.0));
+    TEST_ASSERT_EQUAL_INT(-1, tsdb_append(TSDB_MAX_SERIES, T0, 1.0));
+}
+
+void test_tsdb_retention_wraps_ring(void) {
+    tsdb_point_t pts[2];
+    int cap = tsdb_tier_capacity(TSDB_TIER_1S);
+    tsdb_init();
+
+    tsdb_append(5, T0, 7.0);
+    tsdb_append(5, T0 + 5, 8.0);
+
+    // Jumping more than an hour ahead expires everything older
+    tsdb_append(5, T0 + cap + 5, 9.0);
+    TEST_ASSERT_EQUAL_INT(1, tsdb_query(5, TSDB_TIER_1S, T0 + 5, T0 + 5, pts, 1));
+    TEST_ASSERT_TRUE(isnan(pts[0].avg));
+    TEST_ASSERT_EQUAL_INT(1, tsdb_query(5, TSDB_TIER_1S, T0 + cap + 5, T0 + cap + 5, pts, 1));
+    TEST_ASSERT_EQUAL_INT(9, (int)pts[0].avg);
+
+    // The slot the old sample used must read empty, not stale
+    TEST_ASSERT_EQUAL_INT(1, tsdb_query(5, TSDB_TIER_1S, T0 + cap, T0 + cap, pts, 1));
+    TEST_ASSERT_TRUE(isnan(pts[0].avg));
+
+    // Coarser tiers still remember it
+    TEST_ASSERT_EQUAL_INT(1, tsdb_query(5, TSDB_TIER_10S, T0, T0, pts, 1));
+    TEST_ASSERT_EQUAL_INT(7, (int)pts[0].min);
+}
+
+void test_tsdb_tier_selection(void) {
+    TEST_ASSERT_EQUAL_INT(TSDB_TIER_1S, tsdb_tier_for_span(600));
+    TEST_ASSERT_EQUAL_INT(TSDB_TIER_1S, tsdb_tier_for_span(3600));
+    TEST_ASSERT_EQUAL_INT(TSDB_TIER_10S, tsdb_tier_for_span(3601));
+    TEST_ASSERT_EQUAL_INT(TSDB_TIER_1M, tsdb_tier_for_span(7 * 86400));
+    TEST_ASSERT_EQUAL_INT(TSDB_TIER_1M, tsdb_tier_for_span(30 * 86400));
+    TEST_ASSERT_EQUAL_INT(60, tsdb_tier_resolution(TSDB_TIER_1M));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_tsdb_empty_series_reads_nan);
+    RUN_TEST(test_tsdb_one_second_tier_keeps_samples);
+    RUN_TEST(test_tsdb_downsamples_min_avg_max);
+    RUN_TEST(test_tsdb_gaps_and_nan_samples);
+    RUN_TEST(test_tsdb_rejects_out_of_order_and_bad_series);
+    RUN_TEST(test_tsdb_retention_wraps_ring);
+    RUN_TEST(test_tsdb_tier_selection);
+
+    UNITY_END();
+}
@@ -0,0 +1,429 @@
+/*
+ * Host process list
+ * A top-style view of everything on the box, kept as a PID-indexed table
+ * across ticks. Each tick walks the PID directories once: a PID seen before
+ * re-reads its stat file through the descriptor cached when it was first
+ * opened (one pread, no open), a new PID is opened once, and entries whose
+ * directory is gone are dropped with their descriptor. CPU use is the tick
+ * delta of utime + stime; the top rows by CPU and by RSS are picked with a
+ * bounded heap instead of sorting every process.
+ */
+
+#define _GNU_SOURCE
+#include "top_monitor.h"
+#include "selfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define MAX_TOP_PATH 320
+#define MIN_CAPACITY 256
+#define MAX_CACHED_FDS 4096
+
+typedef struct {
+    pid_t pid;
+    int fd;                    // Cached stat descriptor, -1 if over the budget
+    uint32_t seen;             // Last tick whose walk listed the PID
+    int have_ticks;            // stat holds a baseline for the CPU delta
+    float cpu_percent;
+    top_stat_t stat;
+} top_entry_t;
+
+static char proc_root[256] = "/proc";
+
+static top_entry_t *entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+static int *index_slots = NULL;        // Entry index + 1, 0 = empty
+static uint32_t index_capacity = 0;    // Power of two, at least twice entry_capacity
+
+static uint32_t tick = 0;
+static uint64_t samples = 0;
+static uint64_t last_ns = 0;
+static int cached_fds = 0;
+static int fd_budget = -1;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Half the descriptor limit, leaving the rest to everything else emon opens
+static int compute_fd_budget(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0 || limit.rlim_cur == RLIM_INFINITY) {
+        return MAX_CACHED_FDS;
+    }
+    rlim_t budget = limit.rlim_cur / 2;
+    return (budget > MAX_CACHED_FDS) ? MAX_CACHED_FDS : (int)budget;
+}
+
+static uint32_t pid_hash(pid_t pid) {
+    return ((uint32_t)pid * 2654435761u) & (index_capacity - 1);
+}
+
+static int lookup(pid_t pid) {
+    if (!index_slots) {
+        return -1;
+    }
+    for (uint32_t i = pid_hash(pid);; i = (i + 1) & (index_capacity - 1)) {
+        int index = index_slots[i] - 1;
+        if (index < 0) {
+            return -1;
+        }
+        if (entries[index].pid == pid) {
+            return index;
+        }
+    }
+}
+
+static void index_place(int index) {
+    uint32_t i = pid_hash(entries[index].pid);
+    while (index_slots[i] != 0) {
+        i = (i + 1) & (index_capacity - 1);
+    }
+    index_slots[i] = index + 1;
+}
+
+static int rebuild_index(void) {
+    uint32_t want = 1;
+    while (want < (uint32_t)entry_capacity * 2) {
+        want *= 2;
+    }
+    if (want != index_capacity) {
+        int *slots = realloc(index_slots, want * sizeof(int));
+        if (!slots) {
+            return -1;
+        }
+        index_slots = slots;
+        index_capacity = want;
+    }
+    memset(index_slots, 0, index_capacity * sizeof(int));
+    for (int i = 0; i < entry_count; i++) {
+        index_place(i);
+    }
+    return 0;
+}
+
+static int add_entry(pid_t pid) {
+    if (entry_count == entry_capacity) {
+        int capacity = entry_capacity ? entry_capacity * 2 : MIN_CAPACITY;
+        top_entry_t *grown = realloc(entries, (size_t)capacity * sizeof(top_entry_t));
+        if (!grown) {
+            return -1;
+        }
+        entries = grown;
+        entry_capacity = capacity;
+        if (rebuild_index() < 0) {
+            return -1;
+        }
+    }
+
+    top_entry_t *e = &entries[entry_count];
+    memset(e, 0, sizeof(*e));
+    e->pid = pid;
+    e->fd = -1;
+    index_place(entry_count);
+    return entry_count++;
+}
+
+static void drop_fd(top_entry_t *e) {
+    if (e->fd >= 0) {
+        close(e->fd);
+        e->fd = -1;
+        cached_fds--;
+    }
+}
+
+// stat of one entry into stat; counts the open when it had to make one
+static int read_entry(top_entry_t *e, top_stat_t *stat, int *opened) {
+    char buffer[1024];
+    ssize_t len = -1;
+
+    if (e->fd >= 0) {
+        len = pread(e->fd, buffer, sizeof(buffer) - 1, 0);
+        if (len <= 0) {
+            // The task behind the descriptor exited; the PID may be a new one
+            drop_fd(e);
+            e->have_ticks = 0;
+        }
+    }
+
+    if (len <= 0) {
+        char path[MAX_TOP_PATH];
+        snprintf(path, sizeof(path), "%s/%d/stat", proc_root, e->pid);
+        selfstats_count_open();
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        (*opened)++;
+        len = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        if (cached_fds < fd_budget) {
+            e->fd = fd;
+            cached_fds++;
+        } else {
+            close(fd);
+        }
+        if (len <= 0) {
+            return -1;
+        }
+    }
+
+    buffer[len] = '\0';
+    return top_parse_stat(buffer, stat);
+}
+
+// Drop entries the last walk did not list (or could not read)
+static int sweep(void) {
+    int kept = 0;
+    for (int i = 0; i < entry_count; i++) {
+        if (entries[i].seen != tick) {
+            drop_fd(&entries[i]);
+            continue;
+        }
+        if (kept != i) {
+            entries[kept] = entries[i];
+        }
+        kept++;
+    }
+
+    int dropped = entry_count - kept;
+    entry_count = kept;
+    if (dropped > 0) {
+        rebuild_index();
+    }
+    return dropped;
+}
+
+// Whether a ranks above b: larger key first, then lower PID
+static int ranks_above(const top_entry_t *a, const top_entry_t *b, top_sort_t sort) {
+    if (sort == TOP_SORT_CPU) {
+        if (a->cpu_percent != b->cpu_percent) {
+            return a->cpu_percent > b->cpu_percent;
+        }
+    } else if (a->stat.rss_pages != b->stat.rss_pages) {
+        return a->stat.rss_pages > b->stat.rss_pages;
+    }
+    return a->pid < b->pid;
+}
+
+// Min-heap on rank: the root is the lowest-ranked row kept so far
+static void sift_down(int *heap, int size, int at, top_sort_t sort) {
+    for (;;) {
+        int lowest = at;
+        int left = 2 * at + 1;
+        int right = left + 1;
+        if (left < size && ranks_above(&entries[heap[lowest]], &entries[heap[left]], sort)) {
+            lowest = left;
+        }
+        if (right < size && ranks_above(&entries[heap[lowest]], &entries[heap[right]], sort)) {
+            lowest = right;
+        }
+        if (lowest == at) {
+            return;
+        }
+        int swap = heap[at];
+        heap[at] = heap[lowest];
+        heap[lowest] = swap;
+        at = lowest;
+    }
+}
+
+static void sift_up(int *heap, int at, top_sort_t sort) {
+    while (at > 0) {
+        int parent = (at - 1) / 2;
+        if (!ranks_above(&entries[heap[parent]], &entries[heap[at]], sort)) {
+            return;
+        }
+        int swap = heap[at];
+        heap[at] = heap[parent];
+        heap[parent] = swap;
+        at = parent;
+    }
+}
+
+// Top TOP_MAX_ROWS entries in rank order, O(n log k) instead of a full sort
+static int select_top(top_sort_t sort, top_process_t *out, long page_kb) {
+    int heap[TOP_MAX_ROWS];
+    int size = 0;
+
+    for (int i = 0; i < entry_count; i++) {
+        if (size < TOP_MAX_ROWS) {
+            heap[size] = i;
+            sift_up(heap, size++, sort);
+        } else if (ranks_above(&entries[i], &entries[heap[0]], sort)) {
+            heap[0] = i;
+            sift_down(heap, size, 0, sort);
+        }
+    }
+
+    // Popping yields the lowest first, so fill from the back
+    int count = size;
+    while (size > 0) {
+        const top_entry_t *e = &entries[heap[0]];
+        top_process_t *row = &out[--size];
+        row->pid = e->pid;
+        row->state = e->stat.state;
+        row->threads = e->stat.threads;
+        row->cpu_percent = e->cpu_percent;
+        row->rss_kb = e->stat.rss_pages * (uint64_t)page_kb;
+        memcpy(row->comm, e->stat.comm, sizeof(row->comm));
+
+        heap[0] = heap[size];
+        sift_down(heap, size, 0, sort);
+    }
+    return count;
+}
+
+int top_parse_stat(const char *line, top_stat_t *out) {
+    const char *open_paren = strchr(line, '(');
+    const char *close_paren = strrchr(line, ')');
+    if (!open_paren || !close_paren || close_paren < open_paren || close_paren[1] != ' ') {
+        return -1;
+    }
+
+    size_t len = (size_t)(close_paren - open_paren - 1);
+    if (len > TOP_MAX_COMM) {
+        len = TOP_MAX_COMM;
+    }
+    memcpy(out->comm, open_paren + 1, len);
+    out->comm[len] = '\0';
+
+    // Field 3 (state) follows ") "; walk to field 24 (rss)
+    const char *p = close_paren + 2;
+    out->state = *p;
+    uint64_t utime = 0;
+    for (int field = 3; field < 24;) {
+        while (*p && *p != ' ') {
+            p++;
+        }
+        while (*p == ' ') {
+            p++;
+        }
+        if (!*p) {
+            return -1;
+        }
+        field++;
+
+        switch (field) {
+        case 4:
+            out->ppid = (pid_t)strtol(p, NULL, 10);
+            break;
+        case 14:
+            utime = strtoull(p, NULL, 10);
+            break;
+        case 15:
+            out->cpu_ticks = utime + strtoull(p, NULL, 10);
+            break;
+        case 20:
+            out->threads = (int)strtol(p, NULL, 10);
+            break;
+        case 22:
+            out->starttime = strtoull(p, NULL, 10);
+            break;
+        case 24: {
+            long long rss = strtoll(p, NULL, 10);
+            out->rss_pages = (rss > 0) ? (uint64_t)rss : 0;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+int top_monitor_update(top_stats_t *stats) {
+    static long clock_ticks = 0;
+    static long page_kb = 0;
+    if (clock_ticks <= 0) {
+        clock_ticks = sysconf(_SC_CLK_TCK);
+        clock_ticks = (clock_ticks > 0) ? clock_ticks : 100;
+        long page = sysconf(_SC_PAGESIZE);
+        page_kb = (page > 0) ? page / 1024 : 4;
+    }
+    if (fd_budget < 0) {
+        fd_budget = compute_fd_budget();
+    }
+
+    selfstats_count_open();
+    DIR *dir = opendir(proc_root);
+    if (!dir) {
+        return -1;
+    }
+
+    uint64_t now = monotonic_ns();
+    double elapsed_ticks = last_ns ? (now - last_ns) / 1e9 * clock_ticks : 0.0;
+    last_ns = now;
+    tick++;
+
+    stats->opened = 0;
+    stats->cpu_percent = 0.0;
+
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL) {
+        if (!isdigit((unsigned char)dent->d_name[0])) {
+            continue;
+        }
+        pid_t pid = (pid_t)atoi(dent->d_name);
+        int index = lookup(pid);
+        if (index < 0 && (index = add_entry(pid)) < 0) {
+            continue;
+        }
+
+        top_entry_t *e = &entries[index];
+        top_stat_t stat;
+        if (read_entry(e, &stat, &stats->opened) < 0) {
+            continue; // Exited mid-walk: swept below
+        }
+
+        // A new PID, or an old one reused by a new process, starts a baseline
+        if (!e->have_ticks || stat.starttime != e->stat.starttime || elapsed_ticks <= 0.0) {
+            e->cpu_percent = 0.0f;
+        } else {
+            uint64_t delta = (stat.cpu_ticks >= e->stat.cpu_ticks) ? stat.cpu_ticks - e->stat.cpu_ticks : 0;
+            e->cpu_percent = (float)(100.0 * delta / elapsed_ticks);
+        }
+        e->stat = stat;
+        e->have_ticks = 1;
+        e->seen = tick;
+        stats->cpu_percent += e->cpu_percent;
+    }
+    closedir(dir);
+
+    stats->exited = sweep();
+    stats->process_count = entry_count;
+    stats->samples = ++samples;
+    stats->count = select_top(TOP_SORT_CPU, stats->rows[TOP_SORT_CPU], page_kb);
+    select_top(TOP_SORT_RSS, stats->rows[TOP_SORT_RSS], page_kb);
+    return 0;
+}
+
+void top_monitor_cleanup(void) {
+    for (int i = 0; i < entry_count; i++) {
+        drop_fd(&entries[i]);
+    }
+    free(entries);
+    free(index_slots);
+    entries = NULL;
+    index_slots = NULL;
+    entry_count = 0;
+    entry_capacity = 0;
+    index_capacity = 0;
+    cached_fds = 0;
+    samples = 0;
+    last_ns = 0;
+}
+
+void top_monitor_set_proc_root(const char *root) {
+    top_monitor_cleanup();
+    snprintf(proc_root, sizeof(proc_root), "%s", root ? root : "/proc");
+}
@@ -0,0 +1,62 @@
+#ifndef TOP_MONITOR_H
+#define TOP_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define TOP_MAX_ROWS 64            // Rows kept per ordering
+#define TOP_MAX_COMM 16            // Kernel comm length without the NUL
+
+typedef enum {
+    TOP_SORT_CPU,
+    TOP_SORT_RSS,
+    TOP_SORT_COUNT
+} top_sort_t;
+
+// Fields of one /proc/[pid]/stat line
+typedef struct {
+    char comm[TOP_MAX_COMM + 1];
+    char state;
+    pid_t ppid;
+    uint64_t cpu_ticks;            // utime + stime
+    int threads;
+    uint64_t starttime;            // Clock ticks after boot; tells a reused PID apart
+    uint64_t rss_pages;
+} top_stat_t;
+
+// One row of the process list
+typedef struct {
+    pid_t pid;
+    char state;
+    int threads;
+    float cpu_percent;             // Of one core, like top
+    uint64_t rss_kb;
+    char comm[TOP_MAX_COMM + 1];
+} top_process_t;
+
+typedef struct {
+    uint64_t samples;              // Ticks since the table was (re)built; CPU needs two
+    int process_count;             // PIDs in the table
+    int opened;                    // stat files opened this tick (new or uncached PIDs)
+    int exited;                    // Entries dropped this tick
+    double cpu_percent;            // Sum over all processes
+    int count;                     // Rows in each ordering
+    top_process_t rows[TOP_SORT_COUNT][TOP_MAX_ROWS];
+} top_stats_t;
+
+// Read /proc from another directory (fixtures, benchmarks); NULL restores
+// /proc. Drops the table.
+void top_monitor_set_proc_root(const char *root);
+
+// One tick: walk the PID directories, read stat for every live PID (on a
+// cached descriptor when it has one) and pick the top rows by CPU and RSS
+int top_monitor_update(top_stats_t *stats);
+
+// Close every cached descriptor and forget the table
+void top_monitor_cleanup(void);
+
+// Parse a /proc/[pid]/stat line; comm may hold spaces and ')'
+int top_parse_stat(const char *line, top_stat_t *out);
+
+#endif // TOP_MONITOR_H
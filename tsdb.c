@@ -0,0 +1,205 @@
+/*
+ * In-memory time-series store
+ * Every series owns a fixed row of float columns: min/avg/max rings for
+ * 1 s x 1 h, 10 s x 1 day and 1 min x 1 week. Each sample is folded into the
+ * open bucket of all three tiers, so downsampling needs no second pass and
+ * no memory is allocated after startup. Not thread-safe: append and query
+ * from the same loop.
+ */
+
+#include "tsdb.h"
+#include <math.h>
+#include <string.h>
+
+#define TIER_1S_SLOTS 3600
+#define TIER_10S_SLOTS 8640
+#define TIER_1M_SLOTS 10080
+#define SERIES_SLOTS (TIER_1S_SLOTS + TIER_10S_SLOTS + TIER_1M_SLOTS)
+
+enum { COL_MIN, COL_AVG, COL_MAX, COL_COUNT };
+
+typedef struct {
+    int resolution;     // Seconds per bucket
+    int capacity;       // Buckets kept
+    int offset;         // First float of the tier within a series row
+} tier_def_t;
+
+static const tier_def_t tier_defs[TSDB_TIER_COUNT] = {
+    { 1,  TIER_1S_SLOTS,  0 },
+    { 10, TIER_10S_SLOTS, COL_COUNT * TIER_1S_SLOTS },
+    { 60, TIER_1M_SLOTS,  COL_COUNT * (TIER_1S_SLOTS + TIER_10S_SLOTS) },
+};
+
+typedef struct {
+    int64_t first;      // Oldest bucket still held, -1 when empty
+    int64_t current;    // Bucket being filled
+    float acc_min;
+    float acc_max;
+    double acc_sum;
+    uint32_t acc_count;
+} tier_state_t;
+
+typedef struct {
+    tier_state_t tier[TSDB_TIER_COUNT];
+    int has_last;
+    int64_t last_time;
+    double last_value;
+} series_state_t;
+
+// Pages of a row are only touched once the series reaches them
+static float columns[TSDB_MAX_SERIES][COL_COUNT * SERIES_SLOTS];
+static series_state_t series_state[TSDB_MAX_SERIES];
+
+static int64_t bucket_of(int64_t t, int resolution) {
+    int64_t b = t / resolution;
+    return (t % resolution < 0) ? b - 1 : b;
+}
+
+static float *column(int series, tsdb_tier_t tier, int col) {
+    const tier_def_t *def = &tier_defs[tier];
+    return &columns[series][def->offset + col * def->capacity];
+}
+
+static void reset_accumulator(tier_state_t *ts) {
+    ts->acc_min = INFINITY;
+    ts->acc_max = -INFINITY;
+    ts->acc_sum = 0.0;
+    ts->acc_count = 0;
+}
+
+void tsdb_init(void) {
+    for (int s = 0; s < TSDB_MAX_SERIES; s++) {
+        memset(&series_state[s], 0, sizeof(series_state[s]));
+        for (int t = 0; t < TSDB_TIER_COUNT; t++) {
+            series_state[s].tier[t].first = -1;
+            reset_accumulator(&series_state[s].tier[t]);
+        }
+    }
+}
+
+// Move a tier to bucket b, marking skipped buckets empty
+static void advance(int series, tsdb_tier_t tier, int64_t b) {
+    tier_state_t *ts = &series_state[series].tier[tier];
+    int cap = tier_defs[tier].capacity;
+    float *mins = column(series, tier, COL_MIN);
+    float *avgs = column(series, tier, COL_AVG);
+    float *maxs = column(series, tier, COL_MAX);
+
+    // Only buckets that stay within retention need clearing
+    int64_t gap_start = (b - ts->current > cap) ? b - cap + 1 : ts->current + 1;
+    for (int64_t k = gap_start; k < b; k++) {
+        int slot = (int)(k % cap);
+        mins[slot] = avgs[slot] = maxs[slot] = NAN;
+    }
+
+    ts->current = b;
+    if (ts->first <= b - cap) {
+        ts->first = b - cap + 1;
+    }
+    reset_accumulator(ts);
+}
+
+int tsdb_append(int series, int64_t t, double value) {
+    if (series < 0 || series >= TSDB_MAX_SERIES) {
+        return -1;
+    }
+    if (isnan(value)) {
+        return 0;
+    }
+
+    series_state_t *ss = &series_state[series];
+    if (ss->has_last && t < ss->last_time) {
+        return -1;
+    }
+
+    float v = (float)value;
+    for (int tier = 0; tier < TSDB_TIER_COUNT; tier++) {
+        tier_state_t *ts = &ss->tier[tier];
+        int64_t b = bucket_of(t, tier_defs[tier].resolution);
+
+        if (ts->first < 0) {
+            ts->first = ts->current = b;
+            reset_accumulator(ts);
+        } else if (b > ts->current) {
+            advance(series, tier, b);
+        }
+
+        if (v < ts->acc_min) {
+            ts->acc_min = v;
+        }
+        if (v > ts->acc_max) {
+            ts->acc_max = v;
+        }
+        ts->acc_sum += value;
+        ts->acc_count++;
+
+        // The open bucket is always readable with its running aggregate
+        int slot = (int)(b % tier_defs[tier].capacity);
+        column(series, tier, COL_MIN)[slot] = ts->acc_min;
+        column(series, tier, COL_AVG)[slot] = (float)(ts->acc_sum / ts->acc_count);
+        column(series, tier, COL_MAX)[slot] = ts->acc_max;
+    }
+
+    ss->has_last = 1;
+    ss->last_time = t;
+    ss->last_value = value;
+    return 0;
+}
+
+int tsdb_query(int series, tsdb_tier_t tier, int64_t from, int64_t to,
+               tsdb_point_t *out, int max_points) {
+    if (series < 0 || series >= TSDB_MAX_SERIES || (int)tier < 0 ||
+        tier >= TSDB_TIER_COUNT || max_points <= 0) {
+        return 0;
+    }
+
+    const tier_def_t *def = &tier_defs[tier];
+    const tier_state_t *ts = &series_state[series].tier[tier];
+    const float *mins = column(series, tier, COL_MIN);
+    const float *avgs = column(series, tier, COL_AVG);
+    const float *maxs = column(series, tier, COL_MAX);
+
+    int count = 0;
+    for (int64_t b = bucket_of(from, def->resolution);
+         b <= bucket_of(to, def->resolution) && count < max_points; b++) {
+        tsdb_point_t *p = &out[count++];
+        p->time = b * def->resolution;
+
+        if (ts->first >= 0 && b >= ts->first && b <= ts->current) {
+            int slot = (int)(b % def->capacity);
+            p->min = mins[slot];
+            p->avg = avgs[slot];
+            p->max = maxs[slot];
+        } else {
+            p->min = p->avg = p->max = NAN;
+        }
+    }
+
+    return count;
+}
+
+int tsdb_last(int series, int64_t *t, double *value) {
+    if (series < 0 || series >= TSDB_MAX_SERIES || !series_state[series].has_last) {
+        return -1;
+    }
+    *t = series_state[series].last_time;
+    *value = series_state[series].last_value;
+    return 0;
+}
+
+tsdb_tier_t tsdb_tier_for_span(int64_t span) {
+    for (int tier = 0; tier < TSDB_TIER_COUNT; tier++) {
+        if (span <= (int64_t)tier_defs[tier].resolution * tier_defs[tier].capacity) {
+            return (tsdb_tier_t)tier;
+        }
+    }
+    return TSDB_TIER_1M;
+}
+
+int tsdb_tier_resolution(tsdb_tier_t tier) {
+    return tier_defs[tier].resolution;
+}
+
+int tsdb_tier_capacity(tsdb_tier_t tier) {
+    return tier_defs[tier].capacity;
+}
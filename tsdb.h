@@ -0,0 +1,47 @@
+#ifndef TSDB_H
+#define TSDB_H
+
+#include <stdint.h>
+
+// Fixed number of series; every slot is reserved up front, nothing is
+// allocated after tsdb_init()
+#define TSDB_MAX_SERIES 32
+
+typedef enum {
+    TSDB_TIER_1S,       // 1 s buckets for the last hour
+    TSDB_TIER_10S,      // 10 s buckets for the last day
+    TSDB_TIER_1M,       // 1 min buckets for the last week
+    TSDB_TIER_COUNT
+} tsdb_tier_t;
+
+typedef struct {
+    int64_t time;       // Start of the bucket (seconds)
+    float min;          // NaN when the bucket holds no samples
+    float avg;
+    float max;
+} tsdb_point_t;
+
+// Reset every series to empty
+void tsdb_init(void);
+
+// Add a sample at time t (seconds); NaN values are ignored.
+// Returns -1 for an unknown series or a sample older than the newest bucket.
+int tsdb_append(int series, int64_t t, double value);
+
+// Copy the buckets covering [from, to] at one tier, oldest first.
+// Buckets outside the tier's retention or without samples read as NaN.
+// Returns the number of points written.
+int tsdb_query(int series, tsdb_tier_t tier, int64_t from, int64_t to,
+               tsdb_point_t *out, int max_points);
+
+// Most recent sample of a series, returns -1 if it has none
+int tsdb_last(int series, int64_t *t, double *value);
+
+// Finest tier whose retention covers span seconds
+tsdb_tier_t tsdb_tier_for_span(int64_t span);
+
+// Bucket width and bucket count of a tier
+int tsdb_tier_resolution(tsdb_tier_t tier);
+int tsdb_tier_capacity(tsdb_tier_t tier);
+
+#endif // TSDB_H
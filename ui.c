@@ -0,0 +1,1493 @@
+/*
+ * ncurses renderer
+ * Draws one frame from an emon_snapshot_t. Nothing here touches /proc or
+ * the network, so a frame costs the same whatever the collectors are doing.
+ *
+ * The screen is a column of sections. Each frame a section hashes what it
+ * would show (values at display precision) and is only redrawn when that
+ * hash, its row or its shape changed; a frame where nothing changed skips
+ * refresh() altogether. Over SSH that is the difference between repainting
+ * the terminal every tick and sending the few cells that moved. History
+ * graphs go further: a new second deletes the leftmost cell and writes the
+ * newest, which ncurses can turn into a character delete on the terminal.
+ *
+ * The fleet view is a table over every --targets server. Only the rows in
+ * the scroll window are formatted and hashed, so a frame costs the same
+ * with fifty targets or five thousand. The process view likewise shows the
+ * top rows the collector already picked; nothing here sorts the host's PIDs.
+ */
+
+#define _GNU_SOURCE
+#include "ui.h"
+#include <ncurses.h>
+#include <langinfo.h>
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "formatting.h"
+#include "alerts.h"
+#include "fleet.h"
+#include "metrics.h"
+#include "selfstats.h"
+#include "sparkline.h"
+#include "tsdb.h"
+
+#define PSI_ALERT_HOLD_SECONDS 10
+#define BAR_WIDTH 40
+#define CORE_BAR_WIDTH 7
+#define CORE_CELL 12
+#define GRAPH_LABEL_WIDTH 18       // "Players    7/16  " before each graph
+#define GRAPH_MIN_CELLS 8
+#define FLEET_TABLE_TOP 3          // Summary on row 2, column headings on 3
+#define FLEET_MAX_PAGE 256
+#define FLEET_STATUS_COLUMN 48     // After the target and name columns
+
+// Top to bottom; a section whose shape changes invalidates the ones below
+typedef enum {
+    SECTION_HEADER,
+    SECTION_BARS,              // Also the waiting/error line before any sample
+    SECTION_HOST,
+    SECTION_CGROUP,
+    SECTION_DISK,
+    SECTION_PSI,
+    SECTION_CORES,
+    SECTION_GRAPHS,
+    SECTION_SERVER,
+    SECTION_INSTANCES,
+    SECTION_LOG,
+    SECTION_FLEET,             // Replaces everything above the footer in the fleet view
+    SECTION_TOP,               // Same for the process view
+    SECTION_FOOTER,
+    SECTION_COUNT
+} section_t;
+
+typedef struct {
+    int valid;
+    int top;
+    int rows;
+    uint64_t shape;            // Whatever decides the row count
+    uint64_t sig;              // Hash of the text and colours shown
+} section_cache_t;
+
+static section_cache_t sections[SECTION_COUNT];
+static int force_redraw = 1;
+static int frame_dirty = 0;
+
+static const char *footer_override = NULL;
+static int show_overhead = 0;
+static int show_fleet = 0;
+static int fleet_scroll = 0;
+static int show_top = 0;
+static top_sort_t top_sort = TOP_SORT_CPU;
+
+typedef struct {
+    metric_id_t metric;
+    const char *label;
+    spark_style_t style;
+} graph_desc_t;
+
+static const graph_desc_t graph_descs[] = {
+    { METRIC_CPU_PERCENT,   "CPU",     SPARK_BRAILLE },
+    { METRIC_SERVER_RSS_KB, "RSS",     SPARK_BRAILLE },
+    { METRIC_PLAYERS,       "Players", SPARK_BLOCK },
+    { METRIC_A2S_RTT_MS,    "RTT",     SPARK_BRAILLE },
+};
+
+#define GRAPH_COUNT (int)(sizeof(graph_descs) / sizeof(graph_descs[0]))
+
+static sparkline_t graphs[GRAPH_COUNT];
+static char graph_text[GRAPH_COUNT][16];   // Value shown left of each graph
+static int graph_cells = 0;
+static int utf8 = 0;
+
+#define SIG_INIT 14695981039346656037ULL
+
+// FNV-1a over what a section shows
+static uint64_t sig_bytes(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t sig_int(uint64_t h, int64_t value) {
+    return sig_bytes(h, &value, sizeof(value));
+}
+
+static uint64_t sig_str(uint64_t h, const char *text) {
+    return sig_bytes(h, text, strlen(text) + 1);
+}
+
+// A number as printed with the given decimals, so 41.02 and 41.04 match at %.1f
+static uint64_t sig_fixed(uint64_t h, double value, int decimals) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", decimals, value);
+    return sig_str(h, text);
+}
+
+static void clear_rows(int top, int rows) {
+    for (int y = top; y < top + rows && y < LINES; y++) {
+        move(y, 0);
+        clrtoeol();
+    }
+}
+
+// Whether section id, placed at row top, must be drawn this frame. Clears
+// the rows it used to cover; a moved or reshaped section clears everything
+// below it and makes the sections under it redraw too.
+static int section_begin(section_t id, int top, uint64_t shape, uint64_t sig) {
+    section_cache_t *c = &sections[id];
+    if (c->valid && c->top == top && c->shape == shape) {
+        if (c->sig == sig) {
+            return 0;
+        }
+        clear_rows(top, c->rows);
+    } else {
+        if (id != SECTION_FOOTER) {
+            clear_rows(top, LINES - 2 - top);
+        }
+        for (int s = id + 1; s < SECTION_FOOTER; s++) {
+            sections[s].valid = 0;
+        }
+    }
+
+    c->valid = 1;
+    c->top = top;
+    c->shape = shape;
+    c->sig = sig;
+    frame_dirty = 1;
+    return 1;
+}
+
+// Record where a drawn section ended; returns that row
+static int section_end(section_t id, int next) {
+    sections[id].rows = next - sections[id].top;
+    return next;
+}
+
+// Row after a section that was left as it was
+static int section_next(section_t id) {
+    return sections[id].top + sections[id].rows;
+}
+
+// Draw a progress bar
+static void draw_bar(int y, int x, const char *label, double percent, int width, int is_danger) {
+    mvprintw(y, x, "%s", label);
+
+    int bar_start = x + strlen(label);
+    int filled = (int)(width * percent / 100.0);
+
+    if (is_danger) {
+        attron(COLOR_PAIR(2)); // Red for danger
+    } else {
+        attron(COLOR_PAIR(1)); // Green for normal
+    }
+
+    for (int i = 0; i < width; i++) {
+        if (i < filled) {
+            mvaddch(y, bar_start + i, '|');
+        } else {
+            mvaddch(y, bar_start + i, '-');
+        }
+    }
+
+    if (is_danger) {
+        attroff(COLOR_PAIR(2));
+    } else {
+        attroff(COLOR_PAIR(1));
+    }
+
+    mvprintw(y, bar_start + width + 1, "%.1f%%", percent);
+}
+
+// Cores per row: mini bars up to 32 cores, one character each beyond that
+static int cores_per_row(int count) {
+    if (count <= 32) {
+        int per_row = COLS / CORE_CELL;
+        return (per_row < 1) ? 1 : per_row;
+    }
+    int per_row = (COLS > 16) ? ((COLS - 8) / 8) * 8 : 8;
+    return (per_row > 64) ? 64 : per_row;
+}
+
+// What one core's cell shows: bar length (or load digit) and danger colour
+static int core_cell(int count, float pct) {
+    int level = (count <= 32) ? (int)(CORE_BAR_WIDTH * pct / 100.0f + 0.5f) : (int)(pct / 10.0f);
+    return level * 2 + (pct >= 90.0f);
+}
+
+static uint64_t core_bars_sig(const system_stats_t *stats) {
+    uint64_t h = SIG_INIT;
+    for (int i = 0; i < stats->cpu_count; i++) {
+        h = sig_int(h, core_cell(stats->cpu_count, stats->core_percent[i]));
+    }
+    return h;
+}
+
+// Draw compact per-core utilization, returns the next free row
+static int draw_core_bars(int y, const system_stats_t *stats) {
+    int count = stats->cpu_count;
+    if (count <= 1) {
+        return y;
+    }
+
+    int per_row = cores_per_row(count);
+    if (count <= 32) {
+        // Mini bars: " 3[|||    ]"
+        for (int i = 0; i < count; i++) {
+            int row = y + i / per_row;
+            int col = (i % per_row) * CORE_CELL;
+            float pct = stats->core_percent[i];
+            int filled = (int)(CORE_BAR_WIDTH * pct / 100.0f + 0.5f);
+            int color = (pct >= 90.0f) ? COLOR_PAIR(2) : COLOR_PAIR(1);
+
+            mvprintw(row, col, "%2d[", i);
+            attron(color);
+            for (int j = 0; j < CORE_BAR_WIDTH; j++) {
+                addch(j < filled ? '|' : ' ');
+            }
+            attroff(color);
+            addch(']');
+        }
+
+        return y + (count + per_row - 1) / per_row;
+    }
+
+    // Many cores: one character per core, '.' idle through '9', '#' saturated
+    int rows = 0;
+    for (int base = 0; base < count; base += per_row, rows++) {
+        mvprintw(y + rows, 0, "%3d-%-3d ", base, base + per_row - 1);
+        for (int i = base; i < count && i < base + per_row; i++) {
+            float pct = stats->core_percent[i];
+            int level = (int)(pct / 10.0f);
+            char ch = (level <= 0) ? '.' : (level >= 10) ? '#' : (char)('0' + level);
+            int color = (pct >= 90.0f) ? COLOR_PAIR(2) : COLOR_PAIR(1);
+            attron(color);
+            addch(ch);
+            attroff(color);
+        }
+    }
+
+    return y + rows;
+}
+
+// Steal above a few percent means noisy neighbours on the hypervisor
+static int steal_color(double steal_percent) {
+    return (steal_percent >= 10.0) ? COLOR_PAIR(2) : (steal_percent >= 3.0) ? COLOR_PAIR(3) : 0;
+}
+
+static int temp_color(float celsius) {
+    return (celsius >= 90.0f) ? COLOR_PAIR(2) : (celsius >= 80.0f) ? COLOR_PAIR(3) : 0;
+}
+
+static uint64_t host_sig(const system_stats_t *stats, const hw_stats_t *hw) {
+    uint64_t h = sig_fixed(SIG_INIT, stats->steal_percent, 1);
+    h = sig_int(h, steal_color(stats->steal_percent));
+    h = sig_int(h, hw->freq_avg_mhz);
+    h = sig_int(h, hw->freq_min_mhz);
+    h = sig_int(h, hw->freq_max_mhz);
+    h = sig_int(h, hw->freq_limit_mhz);
+    if (hw->hottest >= 0) {
+        const thermal_sensor_t *hot = &hw->sensors[hw->hottest];
+        h = sig_fixed(h, hot->celsius, 0);
+        h = sig_int(h, temp_color(hot->celsius));
+        h = sig_str(h, hot->label);
+    }
+    h = sig_int(h, (int64_t)hw->throttle_count);
+    return sig_int(h, (int64_t)hw->throttle_new);
+}
+
+// Draw steal time, clock speed and temperature, returns the next free row
+static int draw_host(int y, const system_stats_t *stats, const hw_stats_t *hw) {
+    mvprintw(y, 0, "Host: ");
+
+    int steal = steal_color(stats->steal_percent);
+    attron(steal);
+    printw("steal %.1f%%", stats->steal_percent);
+    attroff(steal);
+
+    if (hw->freq_avg_mhz) {
+        printw("  freq %u MHz (%u-%u", hw->freq_avg_mhz, hw->freq_min_mhz, hw->freq_max_mhz);
+        if (hw->freq_limit_mhz) {
+            printw(" of %u", hw->freq_limit_mhz);
+        }
+        printw(")");
+    }
+
+    if (hw->hottest >= 0) {
+        const thermal_sensor_t *hot = &hw->sensors[hw->hottest];
+        int hot_color = temp_color(hot->celsius);
+        printw("  temp ");
+        attron(hot_color);
+        printw("%.0fC", hot->celsius);
+        attroff(hot_color);
+        printw(" (%s)", hot->label);
+    }
+
+    if (hw->throttle_count) {
+        if (hw->throttle_new) {
+            attron(COLOR_PAIR(2) | A_BOLD);
+        }
+        printw("  throttled %lu (+%lu)", (unsigned long)hw->throttle_count,
+               (unsigned long)hw->throttle_new);
+        if (hw->throttle_new) {
+            attroff(COLOR_PAIR(2) | A_BOLD);
+        }
+    }
+
+    return y + 1;
+}
+
+// Hash a kB quantity as format_bytes() prints it
+static uint64_t sig_kb(uint64_t h, uint64_t kb) {
+    char text[32];
+    format_bytes(kb, text, sizeof(text));
+    return sig_str(h, text);
+}
+
+static uint64_t cgroup_sig(const cgroup_stats_t *cgroup) {
+    if (!cgroup->available) {
+        return SIG_INIT;
+    }
+    uint64_t h = sig_kb(SIG_INIT, cgroup->memory_current / 1024);
+    h = cgroup->memory_high ? sig_kb(h, cgroup->memory_high / 1024) : sig_int(h, 0);
+    h = sig_fixed(h, cgroup->throttled_percent, 1);
+    h = sig_int(h, cgroup->throttled_percent > 0.0);
+    h = sig_fixed(h, cgroup->throttled_usec / 1e6, 1);
+    return sig_int(h, (int64_t)cgroup->events_oom_kill);
+}
+
+// Draw the server cgroup's accounting, returns the next free row
+static int draw_cgroup(int y, const cgroup_stats_t *cgroup) {
+    if (!cgroup->available) {
+        return y;
+    }
+
+    char current_str[32], high_str[32];
+    format_bytes(cgroup->memory_current / 1024, current_str, sizeof(current_str));
+    mvprintw(y, 0, "Cgrp: mem %s", current_str);
+    if (cgroup->memory_high) {
+        format_bytes(cgroup->memory_high / 1024, high_str, sizeof(high_str));
+        printw(" (high %s)", high_str);
+    }
+
+    int throttled = cgroup->throttled_percent > 0.0;
+    if (throttled) {
+        attron(COLOR_PAIR(3));
+    }
+    printw("  throttled %.1f%% (%.1fs total)", cgroup->throttled_percent,
+           cgroup->throttled_usec / 1e6);
+    if (throttled) {
+        attroff(COLOR_PAIR(3));
+    }
+
+    if (cgroup->events_oom_kill) {
+        attron(COLOR_PAIR(2) | A_BOLD);
+    }
+    printw("  OOM kills: %lu", (unsigned long)cgroup->events_oom_kill);
+    if (cgroup->events_oom_kill) {
+        attroff(COLOR_PAIR(2) | A_BOLD);
+    }
+
+    return y + 1;
+}
+
+static uint64_t disk_sig(const disk_stats_t *disk) {
+    if (!disk->available) {
+        return SIG_INIT;
+    }
+    uint64_t h = sig_str(SIG_INIT, disk->device);
+    h = sig_fixed(h, disk->read_iops, 0);
+    h = sig_kb(h, (uint64_t)(disk->read_bytes_per_sec / 1024));
+    h = sig_fixed(h, disk->write_iops, 0);
+    h = sig_kb(h, (uint64_t)(disk->write_bytes_per_sec / 1024));
+    h = sig_fixed(h, disk->await_ms, 1);
+    h = sig_fixed(h, disk->util_percent, 0);
+    h = sig_int(h, disk->util_percent >= 90.0);
+    return sig_fixed(h, disk->queue_depth, 1);
+}
+
+// Draw the save volume's throughput and latency, returns the next free row
+static int draw_disk(int y, const disk_stats_t *disk) {
+    if (!disk->available) {
+        return y;
+    }
+
+    char read_str[32], write_str[32];
+    format_bytes((uint64_t)(disk->read_bytes_per_sec / 1024), read_str, sizeof(read_str));
+    format_bytes((uint64_t)(disk->write_bytes_per_sec / 1024), write_str, sizeof(write_str));
+
+    mvprintw(y, 0, "Disk: %s  r %.0f IOPS %s/s  w %.0f IOPS %s/s  await %.1f ms  ",
+             disk->device, disk->read_iops, read_str, disk->write_iops, write_str,
+             disk->await_ms);
+
+    int saturated = disk->util_percent >= 90.0;
+    if (saturated) {
+        attron(COLOR_PAIR(2) | A_BOLD);
+    }
+    printw("util %.0f%%  qd %.1f", disk->util_percent, disk->queue_depth);
+    if (saturated) {
+        attroff(COLOR_PAIR(2) | A_BOLD);
+    }
+
+    return y + 1;
+}
+
+// A trigger fired recently enough to keep the value highlighted
+static int psi_alert(const time_t *last_trigger, int resource, time_t now) {
+    return last_trigger && last_trigger[resource] &&
+           now - last_trigger[resource] < PSI_ALERT_HOLD_SECONDS;
+}
+
+static uint64_t psi_row_sig(uint64_t h, const psi_resource_t *res, const time_t *last_trigger,
+                            time_t now) {
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        h = sig_int(h, psi_alert(last_trigger, i, now));
+        h = sig_fixed(h, res[i].some.avg10, 2);
+        if (res[i].has_full && i != PSI_CPU) {
+            h = sig_fixed(h, res[i].full.avg10, 2);
+        }
+    }
+    return h;
+}
+
+static uint64_t psi_sig(const psi_stats_t *psi, time_t now) {
+    if (!psi->host_available) {
+        return SIG_INIT;
+    }
+    uint64_t h = psi_row_sig(SIG_INIT, psi->host, psi->last_trigger, now);
+    return psi->cgroup_available ? psi_row_sig(h, psi->cgroup, NULL, now) : h;
+}
+
+// Draw one row of some/full avg10 pressure values
+static void draw_psi_row(int y, const char *label, const psi_resource_t *res,
+                         const time_t *last_trigger, time_t now) {
+    mvprintw(y, 0, "%s", label);
+    for (int i = 0; i < PSI_RESOURCE_COUNT; i++) {
+        int alert = psi_alert(last_trigger, i, now);
+        if (alert) {
+            attron(COLOR_PAIR(2) | A_BOLD);
+        }
+        if (res[i].has_full && i != PSI_CPU) {
+            printw("%s %5.2f/%-5.2f  ", psi_resource_name(i),
+                   res[i].some.avg10, res[i].full.avg10);
+        } else {
+            printw("%s %5.2f  ", psi_resource_name(i), res[i].some.avg10);
+        }
+        if (alert) {
+            attroff(COLOR_PAIR(2) | A_BOLD);
+        }
+    }
+}
+
+// Draw pressure stall rows, returns the next free row
+static int draw_psi(int y, const psi_stats_t *psi, time_t now) {
+    if (!psi->host_available) {
+        return y;
+    }
+
+    draw_psi_row(y++, "PSI:  ", psi->host, psi->last_trigger, now);
+    printw("(some/full avg10 %%)");
+
+    if (psi->cgroup_available) {
+        draw_psi_row(y++, "  cg: ", psi->cgroup, NULL, now);
+    }
+
+    return y;
+}
+
+static uint64_t instance_table_sig(const process_info_t *instances, const a2s_info_t *infos,
+                                   const int *info_ok, int count) {
+    uint64_t h = SIG_INIT;
+    for (int i = 0; i < count; i++) {
+        char uptime_str[64];
+        format_uptime(instances[i].uptime_seconds, uptime_str, sizeof(uptime_str));
+        h = sig_int(h, instances[i].pid);
+        h = sig_int(h, instances[i].query_port);
+        h = sig_str(h, uptime_str);
+        h = sig_kb(h, instances[i].rss_kb);
+        h = sig_int(h, info_ok[i]);
+        if (info_ok[i]) {
+            h = sig_int(h, infos[i].status);
+            h = sig_int(h, infos[i].players);
+            h = sig_int(h, infos[i].max_players);
+            h = sig_str(h, infos[i].name);
+        } else {
+            h = sig_str(h, instances[i].name);
+        }
+    }
+    return h;
+}
+
+// Draw one row per local server instance
+static int draw_instance_table(int y, const process_info_t *instances, const a2s_info_t *infos,
+                        const int *info_ok, int count) {
+    mvprintw(y++, 0, "--- Local Instances (%d) ---", count);
+    attron(A_BOLD);
+    mvprintw(y++, 0, "%-8s %-6s %-12s %-10s %-12s %-8s %s",
+             "PID", "QUERY", "UPTIME", "MEMORY", "STATUS", "PLAYERS", "NAME");
+    attroff(A_BOLD);
+
+    for (int i = 0; i < count && y < LINES - 2; i++) {
+        char uptime_str[64], mem_str[32], port_str[8], players_str[16];
+        format_uptime(instances[i].uptime_seconds, uptime_str, sizeof(uptime_str));
+        format_bytes(instances[i].rss_kb, mem_str, sizeof(mem_str));
+
+        if (instances[i].query_port) {
+            snprintf(port_str, sizeof(port_str), "%u", instances[i].query_port);
+        } else {
+            snprintf(port_str, sizeof(port_str), "?");
+        }
+
+        if (info_ok[i]) {
+            snprintf(players_str, sizeof(players_str), "%d/%d",
+                     infos[i].players, infos[i].max_players);
+            mvprintw(y++, 0, "%-8d %-6s %-12s %-10s %-12s %-8s %s",
+                     instances[i].pid, port_str, uptime_str, mem_str,
+                     a2s_status_string(infos[i].status), players_str, infos[i].name);
+        } else {
+            attron(COLOR_PAIR(3));
+            mvprintw(y++, 0, "%-8d %-6s %-12s %-10s %-12s %-8s %s",
+                     instances[i].pid, port_str, uptime_str, mem_str,
+                     "No Query", "-", instances[i].name);
+            attroff(COLOR_PAIR(3));
+        }
+    }
+
+    return y;
+}
+
+void ui_init(void) {
+    // Braille and block glyphs need a UTF-8 locale; otherwise graphs fall back to ASCII
+    setlocale(LC_ALL, "");
+    utf8 = strcmp(nl_langinfo(CODESET), "UTF-8") == 0;
+
+    initscr();
+    cbreak();
+    noecho();
+    curs_set(0);
+    keypad(stdscr, TRUE);
+    timeout(0); // Waiting happens in the caller's poll()
+
+    // Enable colors
+    if (has_colors()) {
+        start_color();
+        init_pair(1, COLOR_GREEN, COLOR_BLACK);
+        init_pair(2, COLOR_RED, COLOR_BLACK);
+        init_pair(3, COLOR_YELLOW, COLOR_BLACK);
+        init_pair(4, COLOR_CYAN, COLOR_BLACK);
+    }
+}
+
+void ui_set_footer(const char *text) {
+    footer_override = text;
+}
+
+int ui_getch(void) {
+    int ch = getch();
+    if (ch == KEY_RESIZE) {
+        force_redraw = 1;
+    }
+    return ch;
+}
+
+static uint64_t process_sig(uint64_t h, const process_info_t *process) {
+    char uptime_str[64];
+    format_uptime(process->uptime_seconds, uptime_str, sizeof(uptime_str));
+    h = sig_str(h, process->name);
+    h = sig_int(h, process->pid);
+    h = sig_str(h, uptime_str);
+    return sig_kb(h, process->rss_kb);
+}
+
+// Draw local process details, returns the next free row
+static int draw_process(int line, const process_info_t *process) {
+    mvprintw(line++, 0, "Process: %s", process->name);
+    mvprintw(line++, 0, "PID:     %d", process->pid);
+
+    char uptime_str[64];
+    format_uptime(process->uptime_seconds, uptime_str, sizeof(uptime_str));
+    mvprintw(line++, 0, "Uptime:  %s", uptime_str);
+
+    char mem_str[32];
+    format_bytes(process->rss_kb, mem_str, sizeof(mem_str));
+    mvprintw(line++, 0, "Memory:  %s", mem_str);
+
+    return line;
+}
+
+// What emon itself costs per pass, drawn over the bottom of the screen
+static void draw_overhead(void) {
+    int top = LINES - 3 - (SELFSTATS_COUNT + 2);
+    if (top < 2) {
+        return;
+    }
+
+    for (int y = top; y < LINES - 2; y++) {
+        move(y, 0);
+        clrtoeol();
+    }
+
+    attron(A_BOLD);
+    mvprintw(top, 0, "--- emon overhead ---");
+    attroff(A_BOLD);
+    mvprintw(top + 1, 0, "%-8s %8s %9s %9s %9s %9s %7s %7s", "pass", "count", "last", "p50",
+             "p99", "max", "sys", "opens");
+
+    for (int id = 0; id < SELFSTATS_COUNT; id++) {
+        selfstats_timer_t t;
+        selfstats_read((selfstats_id_t)id, &t);
+        mvprintw(top + 2 + id, 0, "%-8s %8lu %7.2fms %7.2fms %7.2fms %7.2fms %7lu %7lu",
+                 selfstats_name((selfstats_id_t)id), (unsigned long)t.count, t.last_ns / 1e6,
+                 selfstats_percentile_ns(&t, 0.50) / 1e6, selfstats_percentile_ns(&t, 0.99) / 1e6,
+                 t.max_ns / 1e6, (unsigned long)t.last_syscalls, (unsigned long)t.last_opens);
+    }
+}
+
+// Current value of a graphed metric as shown beside its graph
+static void graph_value(int g, const emon_snapshot_t *snap, char *text, size_t size) {
+    int64_t t;
+    double value;
+    if (tsdb_last(graph_descs[g].metric, &t, &value) < 0) {
+        snprintf(text, size, "-");
+        return;
+    }
+
+    switch (graph_descs[g].metric) {
+    case METRIC_CPU_PERCENT:
+        snprintf(text, size, "%.1f%%", value);
+        break;
+    case METRIC_SERVER_RSS_KB:
+        format_bytes((uint64_t)value, text, size);
+        break;
+    case METRIC_PLAYERS:
+        if (snap->a2s.info.max_players > 0) {
+            snprintf(text, size, "%.0f/%d", value, snap->a2s.info.max_players);
+        } else {
+            snprintf(text, size, "%.0f", value);
+        }
+        break;
+    default:
+        snprintf(text, size, "%.1f ms", value);
+        break;
+    }
+}
+
+// History graphs, one row per metric that has samples. Rows scroll in
+// place: only the value text and the newest cells are written.
+static int draw_graphs(int top, const emon_snapshot_t *snap) {
+    const system_snapshot_t *sys = &snap->system;
+
+    int cells = COLS - GRAPH_LABEL_WIDTH - 1;
+    cells = (cells > SPARK_MAX_CELLS) ? SPARK_MAX_CELLS : cells;
+    if (cells != graph_cells) {
+        for (int g = 0; g < GRAPH_COUNT; g++) {
+            sparkline_init(&graphs[g], graph_descs[g].metric,
+                           utf8 ? graph_descs[g].style : SPARK_ASCII, cells, 0.0);
+        }
+        graph_cells = cells;
+    }
+
+    // Fixed tops where the metric has a natural ceiling; RTT autoscales
+    uint64_t mem_top_kb = sys->stats.total_mem_kb;
+    if (sys->cgroup.available && sys->cgroup.memory_max > 0) {
+        mem_top_kb = sys->cgroup.memory_max / 1024;
+    }
+    sparkline_set_scale(&graphs[0], 100.0);
+    sparkline_set_scale(&graphs[1], (double)mem_top_kb);
+    sparkline_set_scale(&graphs[2], snap->a2s.info.max_players > 0 ? snap->a2s.info.max_players : 0.0);
+
+    spark_delta_t delta[GRAPH_COUNT];
+    uint64_t shown = 0;
+    for (int g = 0; g < GRAPH_COUNT; g++) {
+        delta[g] = sparkline_update(&graphs[g]);
+        if (cells >= GRAPH_MIN_CELLS && graphs[g].newest_cell >= 0) {
+            shown |= 1u << g;
+        }
+    }
+
+    int full = section_begin(SECTION_GRAPHS, top, shown | (uint64_t)cells << 8, SIG_INIT);
+    int y = top;
+    for (int g = 0; g < GRAPH_COUNT; g++) {
+        if (!(shown & (1u << g))) {
+            continue;
+        }
+
+        char text[sizeof(graph_text[g])];
+        graph_value(g, snap, text, sizeof(text));
+        if (full || strcmp(text, graph_text[g]) != 0) {
+            mvprintw(y, 0, "%-8s%9s ", graph_descs[g].label, text);
+            memcpy(graph_text[g], text, sizeof(text));
+            frame_dirty = 1;
+        }
+
+        int first = cells;
+        if (full || delta[g].full) {
+            first = 0;
+        } else if (delta[g].shift || delta[g].dirty) {
+            for (int i = 0; i < delta[g].shift; i++) {
+                mvdelch(y, GRAPH_LABEL_WIDTH);
+            }
+            first = cells - delta[g].dirty;
+        }
+        if (first < cells) {
+            move(y, GRAPH_LABEL_WIDTH + first);
+            for (int i = first; i < cells; i++) {
+                addstr(sparkline_glyph(&graphs[g], i));
+            }
+            frame_dirty = 1;
+        }
+        y++;
+    }
+    if (shown) {
+        y++;
+    }
+
+    if (full) {
+        section_end(SECTION_GRAPHS, y);
+    }
+    return y;
+}
+
+// Which of the three server layouts applies
+enum { SERVER_QUERIED, SERVER_UNQUERIED, SERVER_MISSING };
+
+static int server_layout(const collector_config_t *config, const emon_snapshot_t *snap) {
+    if (snap->a2s.success) {
+        return SERVER_QUERIED;
+    }
+    return (!config->is_remote && snap->process.primary >= 0) ? SERVER_UNQUERIED : SERVER_MISSING;
+}
+
+static uint64_t server_sig(const collector_config_t *config, const emon_snapshot_t *snap) {
+    const process_snapshot_t *proc = &snap->process;
+    const a2s_snapshot_t *a2s = &snap->a2s;
+    const a2s_info_t *info = &a2s->info;
+
+    uint64_t h = sig_str(SIG_INIT, config->query_host);
+    h = sig_int(h, config->query_port);
+    if (proc->primary >= 0) {
+        h = process_sig(h, &proc->instances[proc->primary]);
+    }
+
+    switch (server_layout(config, snap)) {
+    case SERVER_QUERIED:
+        h = sig_int(h, info->status);
+        h = sig_str(h, info->name);
+        h = sig_str(h, info->version);
+        h = sig_int(h, info->players);
+        h = sig_int(h, info->max_players);
+        h = sig_str(h, info->map);
+        h = sig_str(h, info->game);
+        return sig_fixed(h, a2s->rtt_ms, 1);
+    case SERVER_UNQUERIED:
+        return sig_int(h, a2s->sequence == 0);
+    default:
+        return h;
+    }
+}
+
+// Draw the separator, server status and details, returns the next free row
+static int draw_server(int top, const collector_config_t *config, const emon_snapshot_t *snap) {
+    const process_snapshot_t *proc = &snap->process;
+    const a2s_snapshot_t *a2s = &snap->a2s;
+
+    // Separator
+    mvprintw(top, 0, "================================");
+
+    int server_found = proc->primary >= 0;
+    const process_info_t *server_process = server_found ? &proc->instances[proc->primary] : NULL;
+    const a2s_info_t *server_info = &a2s->info;
+
+    // Display server status and info
+    int line = top + 4;
+    switch (server_layout(config, snap)) {
+    case SERVER_QUERIED: {
+        // Status indicator based on A2S query
+        int color = COLOR_PAIR(1); // Green
+        if (server_info->status == SERVER_STATUS_LOADING) {
+            color = COLOR_PAIR(3); // Yellow
+        } else if (server_info->status == SERVER_STATUS_LOBBY) {
+            color = COLOR_PAIR(4); // Cyan
+        }
+
+        attron(A_BOLD | color);
+        mvprintw(top + 2, 0, "Server Status: %s", a2s_status_string(server_info->status));
+        attroff(A_BOLD | color);
+
+        if (config->is_remote) {
+            attron(COLOR_PAIR(4));
+            mvprintw(top + 3, 0, "Mode: Remote Monitoring");
+            attroff(COLOR_PAIR(4));
+        }
+
+        // Local process info (only if found)
+        if (server_found) {
+            line = draw_process(line, server_process) + 1;
+        }
+
+        // Separator
+        mvprintw(line++, 0, "--- Server Details (A2S Query) ---");
+
+        // Server details from A2S query
+        mvprintw(line++, 0, "Server Name: %s", server_info->name);
+        mvprintw(line++, 0, "Version:     %s", server_info->version);
+        mvprintw(line++, 0, "Players:     %d/%d", server_info->players, server_info->max_players);
+        mvprintw(line++, 0, "Map:         %s", server_info->map);
+        mvprintw(line++, 0, "Game:        %s", server_info->game);
+        mvprintw(line++, 0, "Query RTT:   %.1f ms", a2s->rtt_ms);
+        break;
+    }
+
+    case SERVER_UNQUERIED:
+        // Local server found but A2S query failed
+        attron(A_BOLD | COLOR_PAIR(3));
+        mvprintw(top + 2, 0, "Server Status: RUNNING (Query Unavailable)");
+        attroff(A_BOLD | COLOR_PAIR(3));
+
+        // Process info
+        draw_process(top + 4, server_process);
+
+        // Separator
+        mvprintw(top + 9, 0, "--- Server Details (A2S Query) ---");
+        attron(COLOR_PAIR(3));
+        if (a2s->sequence == 0) {
+            mvprintw(top + 10, 0, "A2S Query: waiting for %s:%d", config->query_host, config->query_port);
+        } else {
+            mvprintw(top + 10, 0, "A2S Query: No response from %s:%d", config->query_host, config->query_port);
+            mvprintw(top + 11, 0, "Server may not have query port enabled or firewall blocking.");
+        }
+        attroff(COLOR_PAIR(3));
+        line = top + 12;
+        break;
+
+    default:
+        // No A2S response and no local process
+        attron(A_BOLD | COLOR_PAIR(2));
+        mvprintw(top + 2, 0, "Server Status: NOT FOUND");
+        attroff(A_BOLD | COLOR_PAIR(2));
+
+        if (config->is_remote) {
+            attron(COLOR_PAIR(4));
+            mvprintw(top + 3, 0, "Mode: Remote Monitoring");
+            attroff(COLOR_PAIR(4));
+            mvprintw(top + 5, 0, "No A2S response from %s:%d", config->query_host, config->query_port);
+            mvprintw(top + 6, 0, "Server may be offline or query port blocked.");
+        } else {
+            mvprintw(top + 4, 0, "Searching for 'EnshroudedServer.exe' process...");
+            mvprintw(top + 5, 0, "Make sure the server is running via Wine/Proton.");
+        }
+        line = top + 7;
+        break;
+    }
+
+    return line;
+}
+
+// Match every local instance with its own A2S answer
+static void instance_answers(const collector_config_t *config, const emon_snapshot_t *snap,
+                             a2s_info_t *infos, int *info_ok) {
+    const process_snapshot_t *proc = &snap->process;
+    const a2s_snapshot_t *a2s = &snap->a2s;
+
+    for (int i = 0; i < proc->instance_count; i++) {
+        uint16_t port = proc->instances[i].query_port;
+        info_ok[i] = 0;
+        if (port == config->query_port) {
+            info_ok[i] = a2s->success;
+            infos[i] = a2s->info;
+            continue;
+        }
+        for (int j = 0; j < a2s->instance_count; j++) {
+            if (a2s->instance_port[j] == port) {
+                info_ok[i] = a2s->instance_ok[j];
+                infos[i] = a2s->instance_info[j];
+                break;
+            }
+        }
+    }
+}
+
+static void draw_footer(const a2s_snapshot_t *a2s, int fleet, int local) {
+    mvprintw(LINES - 2, 0, "================================");
+    if (footer_override) {
+        attron(A_REVERSE);
+        mvprintw(LINES - 1, 0, "%-*.*s", COLS, COLS, footer_override);
+        attroff(A_REVERSE);
+    } else if (show_fleet) {
+        mvprintw(LINES - 1, 0, "f: back | 1-7: sort by column (again: reverse) | "
+                 "arrows/PgUp/PgDn/g/G: scroll | q: quit");
+    } else if (show_top) {
+        mvprintw(LINES - 1, 0, "p: back | c: sort by CPU | m: sort by memory | q: quit");
+    } else {
+        mvprintw(LINES - 1, 0, "Phase 2: A2S Query Integration | Query: %s | o: overhead%s%s",
+                 a2s->available ? "Enabled" : "Unavailable", fleet ? " | f: fleet" : "",
+                 local ? " | p: processes" : "");
+    }
+}
+
+// Data rows that fit between the column headings and the footer
+static int fleet_page_rows(void) {
+    int rows = LINES - 2 - (FLEET_TABLE_TOP + 1);
+    return (rows < 1) ? 1 : (rows > FLEET_MAX_PAGE) ? FLEET_MAX_PAGE : rows;
+}
+
+static void clamp_fleet_scroll(void) {
+    int last = fleet_table_rows() - fleet_page_rows();
+    if (fleet_scroll > last) {
+        fleet_scroll = last;
+    }
+    if (fleet_scroll < 0) {
+        fleet_scroll = 0;
+    }
+}
+
+// "12s", "5m", "3h" since the last answer, "-" if never
+static void format_seen(uint64_t seen_ns, uint64_t now_ns, char *text, size_t size) {
+    if (seen_ns == 0 || seen_ns > now_ns) {
+        snprintf(text, size, "%s", seen_ns ? "0s" : "-");
+        return;
+    }
+    unsigned long age = (unsigned long)((now_ns - seen_ns) / 1000000000ULL);
+    if (age < 120) {
+        snprintf(text, size, "%lus", age);
+    } else if (age < 120 * 60) {
+        snprintf(text, size, "%lum", age / 60);
+    } else {
+        snprintf(text, size, "%luh", age / 3600);
+    }
+}
+
+// Event counters from the log matcher, with the latest player and save age
+static void format_log_events(const log_snapshot_t *log, uint64_t now_ns, char *line, size_t size) {
+    char saved[16];
+    format_seen(log->event_ns[LOG_EVENT_SAVE], now_ns, saved, sizeof(saved));
+    int len = snprintf(line, size, "Events: %lu joins, %lu leaves",
+                       (unsigned long)log->events[LOG_EVENT_JOIN],
+                       (unsigned long)log->events[LOG_EVENT_LEAVE]);
+    if (log->last_player[0] && len >= 0 && (size_t)len < size) {
+        len += snprintf(line + len, size - (size_t)len, " (%s %s)", log->last_player,
+                        log->last_player_event == LOG_EVENT_JOIN ? "joined" : "left");
+    }
+    if (len >= 0 && (size_t)len < size) {
+        snprintf(line + len, size - (size_t)len, "  saved %s%s  errors %lu  disconnects %lu",
+                 saved, log->event_ns[LOG_EVENT_SAVE] ? " ago" : "",
+                 (unsigned long)log->events[LOG_EVENT_ERROR],
+                 (unsigned long)log->events[LOG_EVENT_DISCONNECT]);
+    }
+}
+
+static uint64_t log_sig(const log_snapshot_t *log, const char *events) {
+    uint64_t h = sig_int(SIG_INIT, log->tail.open);
+    h = sig_int(h, (int64_t)log->tail.lines);
+    h = sig_int(h, (int64_t)(log->tail.bytes / 1024));
+    h = sig_int(h, (int64_t)log->tail.rotations);
+    h = sig_int(h, (int64_t)log->tail.truncations);
+    h = sig_str(h, events);
+    h = sig_str(h, log->last_error);
+    return sig_str(h, log->last_line);
+}
+
+// Server log counters, matched events, the latest error and the latest
+// line; returns the next free row
+static int draw_log(int top, const collector_config_t *config, const log_snapshot_t *log,
+                    const char *events) {
+    if (!log->tail.open) {
+        attron(COLOR_PAIR(3));
+        mvprintw(top, 0, "Log: waiting for %s", config->log_path);
+        attroff(COLOR_PAIR(3));
+        return top + 1;
+    }
+
+    char read_str[32];
+    format_bytes(log->tail.bytes / 1024, read_str, sizeof(read_str));
+    mvprintw(top, 0, "Log: %lu lines (%s) since start  rotated %lu  truncated %lu",
+             (unsigned long)log->tail.lines, read_str, (unsigned long)log->tail.rotations,
+             (unsigned long)log->tail.truncations);
+    mvprintw(top + 1, 2, "%s", events);
+
+    int y = top + 2;
+    int width = COLS > 2 ? COLS - 2 : 0;
+    if (log->last_error[0]) {
+        attron(COLOR_PAIR(2));
+        mvprintw(y++, 2, "%.*s", width, log->last_error);
+        attroff(COLOR_PAIR(2));
+    }
+    if (log->last_line[0]) {
+        attron(A_DIM);
+        mvprintw(y++, 2, "%.*s", width, log->last_line);
+        attroff(A_DIM);
+    }
+    return y;
+}
+
+static void format_fleet_row(int index, uint64_t now_ns, char *line, size_t size) {
+    const fleet_target_t *target = fleet_target(index);
+    const fleet_result_t *r = fleet_table_result(index);
+    char address[FLEET_MAX_HOST + 8];
+    char players[16] = "-";
+    char rtt[16] = "-";
+    char seen[16];
+
+    snprintf(address, sizeof(address), "%s:%u", target->host, target->port);
+    if (r->seen_ns) {
+        snprintf(players, sizeof(players), "%u/%u", r->players, r->max_players);
+        snprintf(rtt, sizeof(rtt), "%.0fms", r->rtt_ms);
+    }
+    format_seen(r->seen_ns, now_ns, seen, sizeof(seen));
+    snprintf(line, size, "%-22.22s %-24.24s %-9s %10s %-10.10s %8s %8s", address, r->name,
+             fleet_status_name((fleet_status_t)r->status), players, r->version, rtt, seen);
+}
+
+// Column headings with the sort column marked
+static void format_fleet_headings(char *line, size_t size) {
+    static const char *formats[FLEET_COL_COUNT] = {
+        "%-22s ", "%-24s ", "%-9s ", "%10s ", "%-10s ", "%8s ", "%8s"
+    };
+    size_t len = 0;
+    for (int c = 0; c < FLEET_COL_COUNT && len < size; c++) {
+        char heading[32];
+        snprintf(heading, sizeof(heading), "%d:%s%s", c + 1, fleet_column_name((fleet_column_t)c),
+                 (c == (int)fleet_table_column()) ? (fleet_table_descending() ? "v" : "^") : "");
+        len += (size_t)snprintf(line + len, size - len, formats[c], heading);
+    }
+}
+
+// Targets table: the summary, the headings and one page of rows
+static void draw_fleet(void) {
+    clamp_fleet_scroll();
+
+    int total = fleet_table_rows();
+    int page = fleet_page_rows();
+    int shown = (total - fleet_scroll < page) ? total - fleet_scroll : page;
+    int up, down;
+    fleet_table_counts(&up, &down);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+
+    char summary[160];
+    char headings[160];
+    static char lines[FLEET_MAX_PAGE][160];
+    snprintf(summary, sizeof(summary), "Fleet: %d targets  %d up  %d down  %d waiting  | rows %d-%d",
+             total, up, down, total - up - down, total ? fleet_scroll + 1 : 0, fleet_scroll + shown);
+    format_fleet_headings(headings, sizeof(headings));
+
+    uint64_t sig = sig_str(sig_str(SIG_INIT, summary), headings);
+    for (int i = 0; i < shown; i++) {
+        int index = fleet_table_row(fleet_scroll + i);
+        format_fleet_row(index, now_ns, lines[i], sizeof(lines[i]));
+        sig = sig_int(sig_str(sig, lines[i]), fleet_table_result(index)->status);
+    }
+
+    if (!section_begin(SECTION_FLEET, 2, (uint64_t)LINES << 16 | (uint64_t)COLS, sig)) {
+        return;
+    }
+
+    attron(A_BOLD);
+    mvprintw(2, 0, "%s", summary);
+    attroff(A_BOLD);
+    attron(A_REVERSE);
+    mvprintw(FLEET_TABLE_TOP, 0, "%-*.*s", COLS, COLS, headings);
+    attroff(A_REVERSE);
+
+    for (int i = 0; i < shown; i++) {
+        int y = FLEET_TABLE_TOP + 1 + i;
+        mvprintw(y, 0, "%.*s", COLS, lines[i]);
+        uint8_t status = fleet_table_result(fleet_table_row(fleet_scroll + i))->status;
+        if (status != FLEET_WAITING && COLS > FLEET_STATUS_COLUMN) {
+            mvchgat(y, FLEET_STATUS_COLUMN, (int)strlen(fleet_status_name((fleet_status_t)status)),
+                    A_BOLD, status == FLEET_UP ? 1 : 2, NULL);
+        }
+    }
+    section_end(SECTION_FLEET, FLEET_TABLE_TOP + 1 + shown);
+}
+
+// Overlay the live overhead panel and push the frame out if anything changed
+static void finish_frame(void) {
+    if (show_overhead) {
+        draw_overhead();
+        frame_dirty = 1;
+    }
+    if (frame_dirty) {
+        refresh();
+    }
+}
+
+// Whether pid is one of the local server instances
+static int is_server_pid(const process_snapshot_t *proc, pid_t pid) {
+    for (int i = 0; i < proc->instance_count; i++) {
+        if (proc->instances[i].pid == pid) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Host process list: summary, headings and as many rows as fit
+static void draw_top(const process_snapshot_t *proc) {
+    const top_stats_t *top = &proc->top;
+    int page = LINES - 2 - 4;
+    int shown = (top->samples >= 2) ? top->count : 0;
+    shown = (shown > page) ? (page > 0 ? page : 0) : shown;
+
+    char summary[160];
+    if (top->samples < 2) {
+        snprintf(summary, sizeof(summary), "Processes: sampling...");
+    } else {
+        snprintf(summary, sizeof(summary),
+                 "Processes: %d  CPU %.1f%%  | last tick: %d opened, %d exited | sorted by %s",
+                 top->process_count, top->cpu_percent, top->opened, top->exited,
+                 top_sort == TOP_SORT_CPU ? "CPU" : "memory");
+    }
+
+    const top_process_t *rows = top->rows[top_sort];
+    char lines[TOP_MAX_ROWS][96];
+    uint64_t sig = sig_str(SIG_INIT, summary);
+    for (int i = 0; i < shown; i++) {
+        char rss[32];
+        format_bytes(rows[i].rss_kb, rss, sizeof(rss));
+        snprintf(lines[i], sizeof(lines[i]), "%7d %c %4d %6.1f %10s  %s", rows[i].pid,
+                 rows[i].state, rows[i].threads, rows[i].cpu_percent, rss, rows[i].comm);
+        sig = sig_int(sig_str(sig, lines[i]), is_server_pid(proc, rows[i].pid));
+    }
+
+    if (!section_begin(SECTION_TOP, 2, (uint64_t)LINES << 16 | (uint64_t)COLS, sig)) {
+        return;
+    }
+
+    attron(A_BOLD);
+    mvprintw(2, 0, "%s", summary);
+    attroff(A_BOLD);
+    attron(A_REVERSE);
+    mvprintw(3, 0, "%-*.*s", COLS, COLS, "    PID S  THR   CPU%        RSS  COMMAND");
+    attroff(A_REVERSE);
+
+    // The game server stands out among everything else on the box
+    for (int i = 0; i < shown; i++) {
+        int server = is_server_pid(proc, rows[i].pid);
+        if (server) {
+            attron(A_BOLD | COLOR_PAIR(4));
+        }
+        mvprintw(4 + i, 0, "%.*s", COLS, lines[i]);
+        if (server) {
+            attroff(A_BOLD | COLOR_PAIR(4));
+        }
+    }
+    section_end(SECTION_TOP, 4 + shown);
+}
+
+// Header, the fleet table or the process list, and the footer
+static void draw_alternate_view(const collector_config_t *config, const emon_snapshot_t *snap) {
+    if (section_begin(SECTION_HEADER, 0, 1, SIG_INIT)) {
+        attron(A_BOLD | COLOR_PAIR(4));
+        mvprintw(0, 0, "=== Enshrouded Monitor (EMon) - %s ===", show_fleet ? "Fleet" : "Processes");
+        attroff(A_BOLD | COLOR_PAIR(4));
+        mvprintw(0, 60, "Press 'q' to quit");
+        section_end(SECTION_HEADER, 2);
+    }
+
+    if (show_fleet) {
+        draw_fleet();
+    } else {
+        draw_top(&snap->process);
+    }
+
+    if (section_begin(SECTION_FOOTER, LINES - 2, (uint64_t)COLS,
+                      sig_int(sig_int(SIG_INIT, show_fleet), show_top))) {
+        draw_footer(&snap->a2s, config->fleet, !config->is_remote);
+        section_end(SECTION_FOOTER, LINES);
+    }
+}
+
+void ui_draw(const collector_config_t *config, const emon_snapshot_t *snap) {
+    const system_snapshot_t *sys = &snap->system;
+    const process_snapshot_t *proc = &snap->process;
+    const a2s_snapshot_t *a2s = &snap->a2s;
+    const system_stats_t *stats = &sys->stats;
+    const cgroup_stats_t *cgroup = &sys->cgroup;
+
+    if (force_redraw) {
+        erase();
+        memset(sections, 0, sizeof(sections));
+        graph_cells = 0;
+        force_redraw = 0;
+    }
+    frame_dirty = 0;
+
+    if (show_fleet || show_top) {
+        draw_alternate_view(config, snap);
+        finish_frame();
+        return;
+    }
+
+    // Draw header
+    if (section_begin(SECTION_HEADER, 0, 0,
+                      sig_int(sig_str(SIG_INIT, config->query_host), config->query_port))) {
+        attron(A_BOLD | COLOR_PAIR(4));
+        mvprintw(0, 0, "=== Enshrouded Monitor (EMon) ===");
+        attroff(A_BOLD | COLOR_PAIR(4));
+        mvprintw(0, 60, "Press 'q' to quit");
+
+        // Show query target
+        attron(COLOR_PAIR(4));
+        mvprintw(1, 0, "Query Target: %s:%d", config->query_host, config->query_port);
+        attroff(COLOR_PAIR(4));
+        section_end(SECTION_HEADER, 2);
+    }
+
+    if (sys->sequence == 0 || !sys->ok) {
+        int waiting = sys->sequence == 0;
+        if (section_begin(SECTION_BARS, 2, waiting ? 1 : 2, SIG_INIT)) {
+            mvprintw(2, 0, "%s", waiting ? "Waiting for first sample..." : "Error reading system stats");
+            section_end(SECTION_BARS, 3);
+        }
+        finish_frame();
+        return;
+    }
+
+    // Inside a limited cgroup the host's totals are the wrong yardstick
+    int cpu_limited = cgroup->available && cgroup->cpu_quota_cores > 0.0;
+    int mem_limited = cgroup->available && cgroup->memory_max > 0;
+
+    uint64_t mem_used_kb = stats->used_mem_kb;
+    uint64_t mem_total_kb = stats->total_mem_kb;
+    // RAM danger comes from the alert engine (with hysteresis): the host
+    // rule, or inside a limit the cgroup rule that warns before its OOM killer
+    int ram_rule = alerts_find(ALERTS_RAM_DANGER);
+    uint64_t rule_unit_kb = 1;
+    if (mem_limited) {
+        mem_used_kb = cgroup->memory_current / 1024;
+        mem_total_kb = cgroup->memory_max / 1024;
+        ram_rule = alerts_find(ALERTS_CGROUP_RAM_DANGER);
+        rule_unit_kb = 1024;
+    }
+    int ram_danger = alerts_state(ram_rule) == ALERT_FIRING;
+    uint64_t danger_kb = ram_rule >= 0 ? (uint64_t)alerts_threshold(ram_rule) / rule_unit_kb : 0;
+
+    double cpu_percent = cpu_limited ? cgroup->cpu_percent : stats->cpu_percent;
+    double ram_percent = 100.0 * mem_used_kb / mem_total_kb;
+
+    uint64_t bars = sig_fixed(SIG_INIT, cpu_percent, 1);
+    bars = sig_int(bars, (int)(BAR_WIDTH * cpu_percent / 100.0));
+    bars = cpu_limited ? sig_fixed(bars, cgroup->cpu_quota_cores, 2) : sig_int(bars, 0);
+    bars = sig_fixed(bars, ram_percent, 1);
+    bars = sig_int(bars, (int)(BAR_WIDTH * ram_percent / 100.0));
+    bars = sig_int(bars, mem_limited);
+    bars = sig_kb(bars, mem_used_kb);
+    bars = sig_kb(bars, mem_total_kb);
+    bars = ram_danger ? sig_kb(bars, danger_kb) : sig_int(bars, 0);
+    bars = sig_kb(bars, stats->used_swap_kb);
+    bars = sig_kb(bars, stats->total_swap_kb);
+    bars = sig_fixed(bars, stats->swap_in_rate, 0);
+    bars = sig_fixed(bars, stats->swap_out_rate, 0);
+    bars = sig_int(bars, (int64_t)stats->oom_kills);
+
+    if (section_begin(SECTION_BARS, 2, 0, bars)) {
+        // Draw CPU bar
+        draw_bar(2, 0, "CPU:  ", cpu_percent, BAR_WIDTH, 0);
+        if (cpu_limited) {
+            printw("  (cgroup quota %.2f cores)", cgroup->cpu_quota_cores);
+        }
+
+        // Draw RAM bar
+        draw_bar(3, 0, "RAM:  ", ram_percent, BAR_WIDTH, ram_danger);
+        if (mem_limited) {
+            printw("  (cgroup limit)");
+        }
+
+        // RAM details
+        char used_str[32], total_str[32];
+        format_bytes(mem_used_kb, used_str, sizeof(used_str));
+        format_bytes(mem_total_kb, total_str, sizeof(total_str));
+        mvprintw(4, 6, "%s / %s", used_str, total_str);
+
+        if (ram_danger) {
+            char danger_str[32];
+            format_bytes(danger_kb, danger_str, sizeof(danger_str));
+            attron(COLOR_PAIR(2) | A_BOLD);
+            mvprintw(4, 30, "[DANGER: >%s]", danger_str);
+            attroff(COLOR_PAIR(2) | A_BOLD);
+        }
+
+        // Swap activity and OOM kills
+        char swap_used_str[32], swap_total_str[32];
+        format_bytes(stats->used_swap_kb, swap_used_str, sizeof(swap_used_str));
+        format_bytes(stats->total_swap_kb, swap_total_str, sizeof(swap_total_str));
+        mvprintw(5, 0, "Swap: %s / %s  in %.0f pg/s  out %.0f pg/s  OOM kills: %lu",
+                 swap_used_str, swap_total_str, stats->swap_in_rate, stats->swap_out_rate,
+                 (unsigned long)stats->oom_kills);
+        section_end(SECTION_BARS, 6);
+    }
+
+    // cgroup accounting, pressure and per-core rows push everything below down
+    int top = 6;
+    if (section_begin(SECTION_HOST, top, 0, host_sig(stats, &sys->hw))) {
+        section_end(SECTION_HOST, draw_host(top, stats, &sys->hw));
+    }
+    top = section_next(SECTION_HOST);
+
+    if (section_begin(SECTION_CGROUP, top, cgroup->available, cgroup_sig(cgroup))) {
+        section_end(SECTION_CGROUP, draw_cgroup(top, cgroup));
+    }
+    top = section_next(SECTION_CGROUP);
+
+    if (section_begin(SECTION_DISK, top, sys->disk.available, disk_sig(&sys->disk))) {
+        section_end(SECTION_DISK, draw_disk(top, &sys->disk));
+    }
+    top = section_next(SECTION_DISK);
+
+    time_t now = time(NULL);
+    uint64_t psi_shape = (uint64_t)sys->psi.host_available | (uint64_t)sys->psi.cgroup_available << 1;
+    if (section_begin(SECTION_PSI, top, psi_shape, psi_sig(&sys->psi, now))) {
+        section_end(SECTION_PSI, draw_psi(top, &sys->psi, now));
+    }
+    top = section_next(SECTION_PSI);
+
+    uint64_t cores_shape = (uint64_t)stats->cpu_count << 16 | (uint64_t)COLS;
+    if (section_begin(SECTION_CORES, top, cores_shape, core_bars_sig(stats))) {
+        section_end(SECTION_CORES, draw_core_bars(top, stats) + 1);
+    }
+    top = section_next(SECTION_CORES);
+
+    top = draw_graphs(top, snap);
+
+    uint64_t server_shape = (uint64_t)server_layout(config, snap) << 2 |
+                            (uint64_t)(proc->primary >= 0) << 1 | (uint64_t)config->is_remote;
+    if (section_begin(SECTION_SERVER, top, server_shape, server_sig(config, snap))) {
+        section_end(SECTION_SERVER, draw_server(top, config, snap));
+    }
+    top = section_next(SECTION_SERVER) + 1;
+
+    // Several instances on this host: list them all with their own answers
+    int listed = (proc->instance_count > 1) ? proc->instance_count : 0;
+    a2s_info_t infos[MAX_SERVER_INSTANCES];
+    int info_ok[MAX_SERVER_INSTANCES] = { 0 };
+    instance_answers(config, snap, infos, info_ok);
+    uint64_t table_shape = (uint64_t)listed << 16 | (uint64_t)LINES;
+    if (section_begin(SECTION_INSTANCES, top, table_shape,
+                      instance_table_sig(proc->instances, infos, info_ok, listed))) {
+        section_end(SECTION_INSTANCES,
+                    listed ? draw_instance_table(top, proc->instances, infos, info_ok, listed) : top);
+    }
+    top = section_next(SECTION_INSTANCES);
+
+    // Server log, once LOG_PATH is being watched
+    int log_shown = snap->log.available && top + 4 <= LINES - 2;
+    char log_events[160] = "";
+    if (log_shown) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        format_log_events(&snap->log, (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec,
+                          log_events, sizeof(log_events));
+    }
+    if (section_begin(SECTION_LOG, top, (uint64_t)log_shown << 16 | (uint64_t)COLS,
+                      log_shown ? log_sig(&snap->log, log_events) : SIG_INIT)) {
+        section_end(SECTION_LOG, log_shown ? draw_log(top, config, &snap->log, log_events) : top);
+    }
+
+    // Footer
+    uint64_t footer = footer_override ? sig_str(SIG_INIT, footer_override)
+                                      : sig_int(sig_int(sig_int(SIG_INIT, a2s->available),
+                                                        config->fleet), config->is_remote);
+    if (section_begin(SECTION_FOOTER, LINES - 2, (uint64_t)COLS, footer)) {
+        draw_footer(a2s, config->fleet, !config->is_remote);
+        section_end(SECTION_FOOTER, LINES);
+    }
+
+    finish_frame();
+}
+
+void ui_toggle_overhead(void) {
+    show_overhead = !show_overhead;
+    force_redraw = 1;
+}
+
+void ui_toggle_fleet(void) {
+    show_fleet = !show_fleet;
+    show_top = 0;
+    force_redraw = 1;
+}
+
+void ui_toggle_top(void) {
+    show_top = !show_top;
+    show_fleet = 0;
+    force_redraw = 1;
+}
+
+int ui_top_shown(void) {
+    return show_top;
+}
+
+int ui_top_key(int ch) {
+    if (!show_top) {
+        return 0;
+    }
+    switch (ch) {
+    case 'c':
+    case 'P':
+        top_sort = TOP_SORT_CPU;
+        return 1;
+    case 'm':
+    case 'M':
+        top_sort = TOP_SORT_RSS;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+int ui_fleet_key(int ch) {
+    if (!show_fleet) {
+        return 0;
+    }
+
+    if (ch >= '1' && ch < '1' + FLEET_COL_COUNT) {
+        fleet_column_t column = (fleet_column_t)(ch - '1');
+        // Counts and recency read best largest first
+        int descending = (column == FLEET_COL_PLAYERS || column == FLEET_COL_SEEN);
+        if (column == fleet_table_column()) {
+            descending = !fleet_table_descending();
+        }
+        fleet_table_sort(column, descending);
+        return 1;
+    }
+
+    int page = fleet_page_rows();
+    switch (ch) {
+    case KEY_UP:
+    case 'k':
+        fleet_scroll--;
+        break;
+    case KEY_DOWN:
+    case 'j':
+        fleet_scroll++;
+        break;
+    case KEY_PPAGE:
+        fleet_scroll -= page;
+        break;
+    case KEY_NPAGE:
+    case ' ':
+        fleet_scroll += page;
+        break;
+    case KEY_HOME:
+    case 'g':
+        fleet_scroll = 0;
+        break;
+    case KEY_END:
+    case 'G':
+        fleet_scroll = fleet_table_rows();
+        break;
+    default:
+        return 0;
+    }
+    clamp_fleet_scroll();
+    return 1;
+}
+
+void ui_cleanup(void) {
+    endwin();
+}
@@ -0,0 +1,37 @@
+#ifndef UI_H
+#define UI_H
+
+#include "collector.h"
+
+// Set up ncurses (non-blocking input, colour pairs)
+void ui_init(void);
+
+// Read a pending key press, ERR if none
+int ui_getch(void);
+
+// Replace the footer line with caller-owned text (NULL restores it)
+void ui_set_footer(const char *text);
+
+// Show or hide the "emon overhead" panel
+void ui_toggle_overhead(void);
+
+// Switch between the host view and the fleet table
+void ui_toggle_fleet(void);
+
+// Sort and scroll keys of the fleet table; returns 1 if ch was one of them
+int ui_fleet_key(int ch);
+
+// Switch between the host view and the host process list
+void ui_toggle_top(void);
+int ui_top_shown(void);
+
+// Sort keys of the process list; returns 1 if ch was one of them
+int ui_top_key(int ch);
+
+// Draw one full frame from a snapshot
+void ui_draw(const collector_config_t *config, const emon_snapshot_t *snap);
+
+// Restore the terminal
+void ui_cleanup(void);
+
+#endif // UI_H